@@ -0,0 +1,153 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef BOUNDEDQUEUE_HPP
+#define BOUNDEDQUEUE_HPP
+
+#include <QMutex>
+#include <QQueue>
+#include <QWaitCondition>
+
+
+/** \brief Thread-safe FIFO queue of limited capacity.
+  *
+  * The queue joins pipeline stages working in separate threads. Producer
+  * blocks in push() while the queue is full, so fast stage can't run too
+  * far ahead of slow one and memory used by queued items stays bounded.
+  * Consumer may wait for items with timeout.
+  *
+  * \sa ConvertScheduler
+  */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity = 16);
+    void setCapacity(int capacity);
+    int capacity() const;
+    void push(const T &item);
+    bool tryPop(T *item);
+    bool waitForItems(unsigned long time = ULONG_MAX);
+    int clear();
+    int count() const;
+    bool isEmpty() const;
+    void wakeAll();
+
+private:
+    QQueue<T> items;
+    int maxCount;
+    mutable QMutex mutex;
+    QWaitCondition notEmpty;
+    QWaitCondition notFull;
+
+    Q_DISABLE_COPY(BoundedQueue)
+};
+
+/** Creates empty queue of \a capacity items. */
+template <typename T>
+BoundedQueue<T>::BoundedQueue(int capacity) {
+    maxCount = qMax(1, capacity);
+}
+
+/** Sets maximum count of queued items. Items already queued are kept. */
+template <typename T>
+void BoundedQueue<T>::setCapacity(int capacity) {
+    QMutexLocker locker(&mutex);
+    maxCount = qMax(1, capacity);
+    notFull.wakeAll();
+}
+
+/** Returns maximum count of queued items. */
+template <typename T>
+int BoundedQueue<T>::capacity() const {
+    QMutexLocker locker(&mutex);
+    return maxCount;
+}
+
+/** Appends \a item at the end of the queue. Blocks the calling thread while
+  * the queue is full.
+  */
+template <typename T>
+void BoundedQueue<T>::push(const T &item) {
+    QMutexLocker locker(&mutex);
+    while (items.count() >= maxCount)
+        notFull.wait(&mutex);
+    items.enqueue(item);
+    notEmpty.wakeOne();
+}
+
+/** Takes the first item from the queue into \a item without blocking.
+  * \return False if the queue is empty, otherwise true.
+  */
+template <typename T>
+bool BoundedQueue<T>::tryPop(T *item) {
+    QMutexLocker locker(&mutex);
+    if (items.isEmpty())
+        return false;
+    *item = items.dequeue();
+    notFull.wakeOne();
+    return true;
+}
+
+/** Blocks the calling thread until the queue isn't empty, wakeAll() is
+  * called or \a time milliseconds has elapsed.
+  * \return True if the queue isn't empty, otherwise false.
+  */
+template <typename T>
+bool BoundedQueue<T>::waitForItems(unsigned long time) {
+    QMutexLocker locker(&mutex);
+    if (items.isEmpty())
+        notEmpty.wait(&mutex, time);
+    return !items.isEmpty();
+}
+
+/** Removes all items and wakes up blocked producers.
+  * \return Count of removed items.
+  */
+template <typename T>
+int BoundedQueue<T>::clear() {
+    QMutexLocker locker(&mutex);
+    int count = items.count();
+    items.clear();
+    notFull.wakeAll();
+    return count;
+}
+
+/** Returns count of queued items. */
+template <typename T>
+int BoundedQueue<T>::count() const {
+    QMutexLocker locker(&mutex);
+    return items.count();
+}
+
+/** Returns true if there is no queued item. */
+template <typename T>
+bool BoundedQueue<T>::isEmpty() const {
+    return count() == 0;
+}
+
+/** Wakes up all threads waiting for items. */
+template <typename T>
+void BoundedQueue<T>::wakeAll() {
+    QMutexLocker locker(&mutex);
+    notEmpty.wakeAll();
+}
+
+#endif // BOUNDEDQUEUE_HPP
@@ -0,0 +1,54 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CANCELLATIONTOKEN_HPP
+#define CANCELLATIONTOKEN_HPP
+
+#include <QAtomicInt>
+
+
+/** \brief Thread-safe cancellation request flag.
+  *
+  * The token is set by the GUI thread and polled by worker threads at safe
+  * points: between pipeline stages and inside long pixel loops. Workers stop
+  * current job there, remove partial output files and take next jobs, so
+  * threads are never terminated and may be reused.
+  *
+  * \sa ConvertScheduler::cancel()
+  */
+class CancellationToken {
+public:
+    CancellationToken() : cancelled(0) {}
+
+    /** Requests cancellation. */
+    void cancel() { cancelled.storeRelease(1); }
+    /** Clears cancellation request. */
+    void reset() { cancelled.storeRelease(0); }
+    /** Returns true if cancellation was requested. */
+    bool isCancelled() const { return cancelled.loadAcquire() != 0; }
+
+private:
+    QAtomicInt cancelled;
+
+    Q_DISABLE_COPY(CancellationToken)
+};
+
+#endif // CANCELLATIONTOKEN_HPP
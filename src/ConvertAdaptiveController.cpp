@@ -0,0 +1,178 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertAdaptiveController.hpp"
+
+#include <QFile>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+
+
+namespace {
+
+/** Minimal relative throughput gain which justifies one more step. */
+const double tolerance = 0.05;
+/** CPU utilisation below this value means workers wait for I/O. */
+const double lowCpuUsage = 0.75;
+/** CPU utilisation above this value means CPUs are saturated. */
+const double highCpuUsage = 0.95;
+/** Count of updates between probes after the controller settled. */
+const int probeInterval = 5;
+
+}
+
+
+/** Creates controller of single thread. \sa start() */
+ConvertAdaptiveController::ConvertAdaptiveController() {
+    start(1, 1);
+}
+
+/** Resets the controller state. Threads count starts from \a initialCount
+  * and never exceeds \a maximumCount.
+  */
+void ConvertAdaptiveController::start(int initialCount, int maximumCount) {
+    maximum = qMax(1, maximumCount);
+    current = qBound(1, initialCount, maximum);
+    best = current;
+    bestThroughput = 0.;
+    direction = 1;
+    reversals = 0;
+    holdRounds = 0;
+    settled = false;
+}
+
+/** Takes \a throughput measured with threadCount() threads and CPU utilisation
+  * \a cpuUsage in range [0, 1] (negative if unknown).
+  * \return Threads count for the next measurement.
+  */
+int ConvertAdaptiveController::update(double throughput, double cpuUsage) {
+    if (current == best)
+        bestThroughput = throughput;
+    else if (throughput > bestThroughput * (1. + tolerance)) {
+        best = current;
+        bestThroughput = throughput;
+    }
+    else {
+        // the step didn't help, go back
+        direction = -direction;
+        current = best;
+        reversals++;
+        return current;
+    }
+
+    if (reversals >= 2) {
+        settled = true;
+        if (++holdRounds < probeInterval)
+            return current;
+        holdRounds = 0;
+        reversals = 0;
+    }
+
+    if (cpuUsage >= 0.) {
+        if (cpuUsage < lowCpuUsage)
+            direction = 1;
+        else if (cpuUsage > highCpuUsage && current >= logicalCpuCount())
+            direction = -1;
+    }
+
+    int next = qBound(1, current + direction, maximum);
+    if (next == current) {
+        direction = -direction;
+        next = qBound(1, current + direction, maximum);
+    }
+    current = next;
+    return current;
+}
+
+/** Returns threads count which should be active now. */
+int ConvertAdaptiveController::threadCount() const {
+    return current;
+}
+
+/** Returns threads count with the highest measured throughput. */
+int ConvertAdaptiveController::settledCount() const {
+    return best;
+}
+
+/** Returns true if both directions around settledCount() were probed. */
+bool ConvertAdaptiveController::isSettled() const {
+    return settled;
+}
+
+/** Returns count of logical CPUs including hyperthreads. */
+int ConvertAdaptiveController::logicalCpuCount() {
+    return qMax(1, QThread::idealThreadCount());
+}
+
+/** Returns count of physical CPU cores. Hyperthreads sharing a core are
+  * counted once. Returns logicalCpuCount() if the count can't be detected.
+  * \note Physical cores are detected on Linux only.
+  */
+int ConvertAdaptiveController::physicalCoreCount() {
+    static int count = 0;
+    if (count > 0)
+        return count;
+
+    QFile file("/proc/cpuinfo");
+    QSet<QString> cores;
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QString physicalId;
+        foreach (const QByteArray &line, file.readAll().split('\n')) {
+            QList<QByteArray> pair = line.split(':');
+            if (pair.count() != 2)
+                continue;
+            QByteArray key = pair.first().trimmed();
+            if (key == "physical id")
+                physicalId = pair.last().trimmed();
+            else if (key == "core id")
+                cores.insert(physicalId + ':' + pair.last().trimmed());
+        }
+    }
+    count = cores.isEmpty() ? logicalCpuCount()
+                            : qMin(cores.count(), logicalCpuCount());
+    return count;
+}
+
+/** Reads cumulative CPU times of all CPUs into \a busy and \a total.
+  * \return False if CPU times aren't available, otherwise true.
+  * \note CPU times are available on Linux only.
+  */
+bool ConvertAdaptiveController::readCpuTimes(qint64 *busy, qint64 *total) {
+    QFile file("/proc/stat");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QList<QByteArray> fields = file.readLine().simplified().split(' ');
+    // cpu user nice system idle iowait irq softirq steal ...
+    if (fields.count() < 5 || fields.first() != "cpu")
+        return false;
+    qint64 sum = 0;
+    qint64 idle = 0;
+    for (int i=1; i<fields.count() && i<=8; i++) {
+        qint64 value = fields[i].toLongLong();
+        sum += value;
+        if (i == 4 || i == 5) // idle and iowait
+            idle += value;
+    }
+    *busy = sum - idle;
+    *total = sum;
+    return true;
+}
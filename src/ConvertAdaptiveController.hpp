@@ -0,0 +1,65 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTADAPTIVECONTROLLER_HPP
+#define CONVERTADAPTIVECONTROLLER_HPP
+
+#include <QtGlobal>
+
+
+/** \brief Hill climbing controller of active worker threads count.
+  *
+  * The controller is fed with convertion throughput and CPU utilisation
+  * measured periodically. It moves the threads count one step at a time and
+  * keeps the step if throughput grew at least by tolerance; otherwise it goes
+  * back to the best known count and probes the other direction. Low CPU
+  * utilisation means workers wait for I/O, so more threads are probed; high
+  * utilisation above logical CPUs count leads to less threads. When both
+  * directions around the best count were probed the controller settles and
+  * probes again after several rounds only.
+  *
+  * \sa ConvertScheduler::setAdaptive()
+  */
+class ConvertAdaptiveController {
+public:
+    ConvertAdaptiveController();
+    void start(int initialCount, int maximumCount);
+    int update(double throughput, double cpuUsage = -1.);
+    int threadCount() const;
+    int settledCount() const;
+    bool isSettled() const;
+
+    static int logicalCpuCount();
+    static int physicalCoreCount();
+    static bool readCpuTimes(qint64 *busy, qint64 *total);
+
+private:
+    int maximum; /**< Maximum threads count. */
+    int current; /**< Currently used threads count. */
+    int best; /**< Threads count with the highest throughput. */
+    double bestThroughput;
+    int direction; /**< Next probe direction: +1 or -1. */
+    int reversals; /**< Count of failed probes since last settlement. */
+    int holdRounds; /**< Count of updates since the controller settled. */
+    bool settled;
+};
+
+#endif // CONVERTADAPTIVECONTROLLER_HPP
@@ -0,0 +1,272 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertAffinity.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif // Q_OS_LINUX
+
+
+namespace {
+
+/** Returns integer read from \a filePath file or \a defaultValue if the
+  * file can't be read.
+  */
+int readInt(const QString &filePath, int defaultValue) {
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return defaultValue;
+    bool ok = false;
+    int value = file.readAll().trimmed().toInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+/** Returns CPU indexes of \a list in Linux cpulist format, e.g. "0-3,8". */
+QList<int> parseCpuList(const QByteArray &list) {
+    QList<int> cpus;
+    foreach (const QByteArray &range, list.trimmed().split(',')) {
+        QList<QByteArray> bounds = range.split('-');
+        bool ok = false;
+        int first = bounds.first().toInt(&ok);
+        if (!ok)
+            continue;
+        int last = (bounds.count() > 1) ? bounds.last().toInt() : first;
+        for (int i=first; i<=last; i++)
+            cpus << i;
+    }
+    return cpus;
+}
+
+#ifdef Q_OS_LINUX
+/** Returns CPUs of affinity mask of the calling thread. */
+QList<int> threadCpus() {
+    QList<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0)
+        return cpus;
+    for (int i=0; i<CPU_SETSIZE; i++) {
+        if (CPU_ISSET(i, &set))
+            cpus << i;
+    }
+    return cpus;
+}
+
+/** CPUs the process was allowed to use at startup, before any thread was
+  * pinned.
+  */
+const QList<int> startupCpus = threadCpus();
+#endif // Q_OS_LINUX
+
+bool compactLessThan(const ConvertAffinity::Cpu &a,
+                     const ConvertAffinity::Cpu &b) {
+    if (a.node != b.node)
+        return a.node < b.node;
+    if (a.package != b.package)
+        return a.package < b.package;
+    if (a.core != b.core)
+        return a.core < b.core;
+    return a.id < b.id;
+}
+
+}
+
+
+/** Creates affinity without thread pinning. */
+ConvertAffinity::ConvertAffinity() : currentPolicy(NoAffinity) {}
+
+/** Sets \a policy of CPUs of this machine.
+  * \sa topology()
+  */
+void ConvertAffinity::setPolicy(Policy policy) {
+    setPolicy(policy, (policy == NoAffinity) ? QList<Cpu>() : topology());
+}
+
+/** Sets \a policy assigning threads to \a cpus. */
+void ConvertAffinity::setPolicy(Policy policy, const QList<Cpu> &cpus) {
+    currentPolicy = cpus.isEmpty() ? NoAffinity : policy;
+    cpuOrder = order(currentPolicy, cpus);
+}
+
+/** Returns current policy. It's NoAffinity if CPU topology is unknown. */
+ConvertAffinity::Policy ConvertAffinity::policy() const {
+    return currentPolicy;
+}
+
+/** Returns count of logical CPUs used for pinning. */
+int ConvertAffinity::cpuCount() const {
+    return cpuOrder.count();
+}
+
+/** Returns logical CPU of convert thread \a tid or -1 if the thread isn't
+  * pinned. Threads above CPUs count wrap around.
+  */
+int ConvertAffinity::cpuForThread(int tid) const {
+    if (cpuOrder.isEmpty() || tid < 0)
+        return -1;
+    return cpuOrder.at(tid % cpuOrder.count()).id;
+}
+
+/** Returns NUMA node of convert thread \a tid or -1 if the thread isn't
+  * pinned.
+  */
+int ConvertAffinity::nodeForThread(int tid) const {
+    if (cpuOrder.isEmpty() || tid < 0)
+        return -1;
+    return cpuOrder.at(tid % cpuOrder.count()).node;
+}
+
+/** Returns logical CPUs of the process affinity mask read at startup.
+  * Returns empty list if the mask is unknown.
+  */
+QList<int> ConvertAffinity::allowedCpus() {
+#ifdef Q_OS_LINUX
+    return startupCpus;
+#else
+    return QList<int>();
+#endif // Q_OS_LINUX
+}
+
+/** Returns online logical CPUs of this machine read from sysfs, limited to
+  * allowedCpus() if the mask is known. Returns empty list if the topology is
+  * unknown.
+  */
+QList<ConvertAffinity::Cpu> ConvertAffinity::topology() {
+    QList<Cpu> cpus;
+#ifdef Q_OS_LINUX
+    const QString cpuPath = "/sys/devices/system/cpu/";
+    QFile online(cpuPath + "online");
+    if (!online.open(QIODevice::ReadOnly | QIODevice::Text))
+        return cpus;
+    // NUMA nodes of CPUs
+    QMap<int, int> nodes;
+    QDir nodeDir("/sys/devices/system/node/");
+    foreach (const QString &name,
+             nodeDir.entryList(QStringList("node*"), QDir::Dirs)) {
+        bool ok = false;
+        int node = name.mid(4).toInt(&ok);
+        if (!ok)
+            continue;
+        QFile list(nodeDir.filePath(name + "/cpulist"));
+        if (list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            foreach (int cpu, parseCpuList(list.readAll()))
+                nodes.insert(cpu, node);
+        }
+    }
+    const QList<int> allowed = allowedCpus();
+    foreach (int id, parseCpuList(online.readAll())) {
+        if (!allowed.isEmpty() && !allowed.contains(id))
+            continue;
+        const QString topologyPath =
+                cpuPath + QString("cpu%1/topology/").arg(id);
+        cpus << Cpu(id, readInt(topologyPath + "physical_package_id", 0),
+                    readInt(topologyPath + "core_id", id),
+                    nodes.value(id, 0));
+    }
+#endif // Q_OS_LINUX
+    return cpus;
+}
+
+/** Returns \a cpus in order of assignment to threads following \a policy.
+  *
+  * Compact policy lists CPUs node by node and package by package, so
+  * consecutive threads share caches. Spread policy takes one CPU of each
+  * package in turn and uses second hardware thread of a core only when all
+  * cores have a thread, so memory bandwidth of all nodes is used.
+  */
+QList<ConvertAffinity::Cpu> ConvertAffinity::order(Policy policy,
+                                                   const QList<Cpu> &cpus) {
+    if (policy == NoAffinity)
+        return QList<Cpu>();
+    QList<Cpu> sorted = cpus;
+    qSort(sorted.begin(), sorted.end(), compactLessThan);
+    if (policy == Compact)
+        return sorted;
+
+    // spread: split CPUs into packages and hardware threads of cores
+    QMap<int, QList<QList<Cpu> > > levels; // package -> smt level -> cpus
+    QMap<QPair<int, int>, int> coreThreads; // (package, core) -> count
+    foreach (const Cpu &cpu, sorted) {
+        QPair<int, int> key(cpu.package, cpu.core);
+        int level = coreThreads.value(key, 0);
+        coreThreads.insert(key, level + 1);
+        QList<QList<Cpu> > &packageLevels = levels[cpu.package];
+        while (packageLevels.count() <= level)
+            packageLevels << QList<Cpu>();
+        packageLevels[level] << cpu;
+    }
+    QList<Cpu> result;
+    for (int level=0; result.count() < sorted.count(); level++) {
+        for (int i=0; ; i++) {
+            bool taken = false;
+            foreach (const QList<QList<Cpu> > &packageLevels, levels) {
+                if (level < packageLevels.count()
+                        && i < packageLevels.at(level).count()) {
+                    result << packageLevels.at(level).at(i);
+                    taken = true;
+                }
+            }
+            if (!taken)
+                break;
+        }
+    }
+    return result;
+}
+
+/** Pins the calling thread to logical \a cpu. Negative \a cpu unpins the
+  * thread, i.e. restores allowedCpus() mask of the process.
+  * \return True if the affinity was changed, otherwise false. CPUs outside
+  *         of allowedCpus() are refused.
+  */
+bool ConvertAffinity::pinCurrentThread(int cpu) {
+#ifdef Q_OS_LINUX
+    const QList<int> allowed = allowedCpus();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu < 0) {
+        if (allowed.isEmpty()) {
+            foreach (const Cpu &c, topology())
+                CPU_SET(c.id, &set);
+        }
+        else {
+            foreach (int id, allowed)
+                CPU_SET(id, &set);
+        }
+    }
+    else if (cpu < CPU_SETSIZE
+             && (allowed.isEmpty() || allowed.contains(cpu)))
+        CPU_SET(cpu, &set);
+    else
+        return false;
+    if (CPU_COUNT(&set) == 0)
+        return false;
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    Q_UNUSED(cpu);
+    return false;
+#endif // Q_OS_LINUX
+}
@@ -0,0 +1,82 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTAFFINITY_HPP
+#define CONVERTAFFINITY_HPP
+
+#include <QList>
+
+
+/** \brief CPU affinity of convert threads.
+  *
+  * Maps convert threads to logical CPUs following a Policy. Pinned thread
+  * stays on one NUMA node, so pixel buffers it allocates and first touches
+  * are placed in local memory by the operating system. ConvertScheduler
+  * lets only threads of the same node help with bands of an image, so the
+  * buffers aren't first touched remotely either.
+  *
+  * Only CPUs of the process affinity mask read at startup are used, so
+  * threads of process started by \e taskset or in a cpuset are pinned to
+  * allowed CPUs only and unpinned threads get the initial mask back.
+  *
+  * \note Affinity is supported on Linux only. On other systems threads
+  *       aren't pinned.
+  * \sa ConvertScheduler::setAffinityPolicy()
+  */
+class ConvertAffinity {
+public:
+    //! Thread placement policy.
+    enum Policy {
+        NoAffinity, /**< Threads float between CPUs. */
+        Compact, /**< Threads fill cores of one package before next one. */
+        Spread /**< Threads are distributed across packages and cores. */
+    };
+
+    //! Logical CPU placement.
+    struct Cpu {
+        Cpu(int id = 0, int package = 0, int core = 0, int node = 0)
+            : id(id), package(package), core(core), node(node) {}
+
+        int id; /**< Logical CPU index. */
+        int package; /**< Physical package (socket) index. */
+        int core; /**< Core index within the package. */
+        int node; /**< NUMA node index. */
+    };
+
+    ConvertAffinity();
+    void setPolicy(Policy policy);
+    void setPolicy(Policy policy, const QList<Cpu> &cpus);
+    Policy policy() const;
+    int cpuCount() const;
+    int cpuForThread(int tid) const;
+    int nodeForThread(int tid) const;
+
+    static QList<int> allowedCpus();
+    static QList<Cpu> topology();
+    static QList<Cpu> order(Policy policy, const QList<Cpu> &cpus);
+    static bool pinCurrentThread(int cpu);
+
+private:
+    Policy currentPolicy;
+    QList<Cpu> cpuOrder; /**< Logical CPUs in order of assignment. */
+};
+
+#endif // CONVERTAFFINITY_HPP
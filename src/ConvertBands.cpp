@@ -0,0 +1,93 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertBands.hpp"
+
+
+/** Returns count of bands for \a count rows of image containing \a pixels
+  * pixels. Each band contains at least minBandPixels pixels and there is
+  * at most one band per idle thread plus one for the calling thread.
+  */
+int ConvertBands::bandCount(ConvertBandExecutor *executor, int count,
+                            qint64 pixels) {
+    if (!executor || count < 2)
+        return 1;
+    qint64 bands = qMin<qint64>(pixels / minBandPixels,
+                                executor->idleThreadCount() + 1);
+    return qBound(1, int(qMin<qint64>(bands, count)), count);
+}
+
+/** Runs \a task for \a count rows of image containing \a pixels pixels.
+  * The rows are split into bands if \a executor has idle threads.
+  * \sa bandCount()
+  */
+void ConvertBands::run(ConvertBandExecutor *executor, ConvertBandTask *task,
+                       int count, qint64 pixels) {
+    if (task->isCancelled())
+        return;
+    int bands = bandCount(executor, count, pixels);
+    if (bands <= 1)
+        task->run(0, count);
+    else
+        executor->runBands(task, count, bands);
+}
+
+/** Computes range of band \a index of \a count rows split into \a bands
+  * bands of nearly equal size.
+  */
+void ConvertBands::bandRange(int count, int bands, int index,
+                             int *begin, int *end) {
+    *begin = qint64(count) * index / bands;
+    *end = qint64(count) * (index + 1) / bands;
+}
+
+/** Returns image sharing rows from \a begin to \a end of \a image.
+  * \a bits must be the result of \a image bits() function called before the
+  * bands are started, because detaching the image isn't thread-safe.
+  */
+QImage ConvertBands::bandImage(uchar *bits, const QImage &image,
+                               int begin, int end) {
+    QImage band(bits + begin * image.bytesPerLine(), image.width(),
+                end - begin, image.bytesPerLine(), image.format());
+    if (image.colorCount() > 0)
+        band.setColorTable(image.colorTable());
+    return band;
+}
+
+/** Returns true if \a image pixels are 32-bit QRgb values, so band tasks may
+  * read its rows directly.
+  */
+bool ConvertBands::isRgb32(const QImage &image) {
+    return image.format() == QImage::Format_RGB32
+            || image.format() == QImage::Format_ARGB32
+            || image.format() == QImage::Format_ARGB32_Premultiplied;
+}
+
+/** Returns \a image converted to 32-bit format if it isn't 32-bit image.
+  * \sa isRgb32()
+  */
+QImage ConvertBands::rgb32Image(const QImage &image) {
+    if (isRgb32(image))
+        return image;
+    return image.convertToFormat(image.hasAlphaChannel()
+                                 ? QImage::Format_ARGB32
+                                 : QImage::Format_RGB32);
+}
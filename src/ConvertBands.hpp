@@ -0,0 +1,96 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTBANDS_HPP
+#define CONVERTBANDS_HPP
+
+#include <QImage>
+
+#include "CancellationToken.hpp"
+
+/** \brief Work on range of image rows or columns.
+  * \sa ConvertBands
+  */
+class ConvertBandTask {
+public:
+    ConvertBandTask() : cancellation(0) {}
+    virtual ~ConvertBandTask() {}
+    /** Processes rows (or columns) from \a begin to \a end exclusive.
+      * This function is called concurrently for disjoint ranges.
+      */
+    virtual void run(int begin, int end) = 0;
+
+    /** Sets token stopping the task. Null \a token means the task can't be
+      * cancelled.
+      */
+    void setCancellationToken(const CancellationToken *token) {
+        cancellation = token;
+    }
+    /** Returns true if the task should stop. Long running tasks check it
+      * for each row; bands of cancelled task aren't started.
+      */
+    bool isCancelled() const {
+        return cancellation && cancellation->isCancelled();
+    }
+
+private:
+    const CancellationToken *cancellation;
+};
+
+/** \brief Interface of threads executing bands of single image.
+  * \sa ConvertScheduler
+  */
+class ConvertBandExecutor {
+public:
+    virtual ~ConvertBandExecutor() {}
+    /** Returns count of threads able to help with bands at the moment. */
+    virtual int idleThreadCount() const = 0;
+    /** Runs \a task for \a count rows split into \a bands bands and blocks
+      * the calling thread until all bands are done. The calling thread
+      * processes bands too.
+      */
+    virtual void runBands(ConvertBandTask *task, int count, int bands) = 0;
+};
+
+/** \brief Helpers splitting large image into row bands processed in parallel.
+  *
+  * Bands are processed by idle threads of ConvertBandExecutor, so converting
+  * few huge images still uses all cores. Small images and calls without
+  * executor are processed in the calling thread.
+  */
+class ConvertBands {
+public:
+    static int bandCount(ConvertBandExecutor *executor, int count,
+                         qint64 pixels);
+    static void run(ConvertBandExecutor *executor, ConvertBandTask *task,
+                    int count, qint64 pixels);
+    static void bandRange(int count, int bands, int index,
+                          int *begin, int *end);
+    static QImage bandImage(uchar *bits, const QImage &image,
+                            int begin, int end);
+    static bool isRgb32(const QImage &image);
+    static QImage rgb32Image(const QImage &image);
+
+    /** Minimal pixels count of single band. */
+    static const int minBandPixels = 256 * 1024;
+};
+
+#endif // CONVERTBANDS_HPP
@@ -0,0 +1,128 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertCostModel.hpp"
+
+#include "ImageFormatRegistry.hpp"
+
+#include <algorithm>
+
+
+namespace {
+
+/** Initial cost factors relative to regular images. */
+const double defaultFactors[ConvertCostModel::FormatClassCount] = {
+    1.0, // regular
+    4.0, // RAW
+    3.0  // SVG
+};
+
+/** Estimated pixels per byte of file if image dimensions are unknown. */
+const double pixelsPerByte[ConvertCostModel::FormatClassCount] = {
+    3.0, // regular, typical JPEG compression
+    0.7, // RAW
+    1.0  // SVG
+};
+
+/** Weight of new sample in exponential moving average of factors. */
+const double sampleWeight = 0.2;
+
+/** Returns true if \a left job is more expensive than \a right. */
+bool isMoreExpensive(const ConvertJob &left, const ConvertJob &right) {
+    return left.cost > right.cost;
+}
+
+}
+
+
+/** Creates model with default cost factors. */
+ConvertCostModel::ConvertCostModel() {
+    for (int i=0; i<FormatClassCount; i++) {
+        factors[i] = defaultFactors[i];
+        samples[i] = 0;
+    }
+}
+
+/** Returns format class of image file with \a extension suffix. */
+ConvertCostModel::FormatClass ConvertCostModel::formatClass(
+        const QString &extension) {
+    const QString ext = extension.toLower();
+    if (ext == "svg" || ext == "svgz")
+        return SvgFormat;
+    // the same rule as in RawLoader: not supported by Qt means RAW
+    if (!ImageFormatRegistry::instance()->isReadable(ext.toLatin1()))
+        return RawFormat;
+    return RegularFormat;
+}
+
+/** Returns format independent work units of \a job: megapixels plus half of
+  * file size in MiB.
+  */
+double ConvertCostModel::workUnits(const ConvertJob &job) {
+    const double megabytes = job.fileSize / (1024. * 1024.);
+    double megapixels = job.pixels / 1e6;
+    if (job.pixels <= 0) {
+        FormatClass c = formatClass(job.imageData.value(1));
+        megapixels = job.fileSize * pixelsPerByte[c] / 1e6;
+    }
+    return megapixels + 0.5 * megabytes;
+}
+
+/** Returns cost per work unit of \a formatClass. If the class wasn't measured
+  * yet, its default factor is scaled by measured factor of regular images.
+  */
+double ConvertCostModel::factor(FormatClass formatClass) const {
+    if (samples[formatClass] > 0)
+        return factors[formatClass];
+    if (samples[RegularFormat] > 0)
+        return factors[RegularFormat] * defaultFactors[formatClass];
+    return defaultFactors[formatClass];
+}
+
+/** Returns estimated convertion cost of \a job. */
+double ConvertCostModel::estimate(const ConvertJob &job) const {
+    return workUnits(job) * factor(formatClass(job.imageData.value(1)));
+}
+
+/** Computes ConvertJob::cost of all \a jobs and sorts them most expensive
+  * first. Order of jobs with equal cost is kept.
+  */
+void ConvertCostModel::sort(QList<ConvertJob> *jobs) const {
+    for (QList<ConvertJob>::iterator it = jobs->begin(); it != jobs->end(); ++it)
+        it->cost = estimate(*it);
+    std::stable_sort(jobs->begin(), jobs->end(), isMoreExpensive);
+}
+
+/** Refines cost factor of \a job format class using measured convertion
+  * time \a elapsedMs in milliseconds.
+  */
+void ConvertCostModel::addSample(const ConvertJob &job, double elapsedMs) {
+    const double units = workUnits(job);
+    if (units <= 0. || elapsedMs < 0.)
+        return;
+    FormatClass c = formatClass(job.imageData.value(1));
+    const double measured = elapsedMs / units;
+    if (samples[c] == 0)
+        factors[c] = measured;
+    else
+        factors[c] += sampleWeight * (measured - factors[c]);
+    samples[c]++;
+}
@@ -0,0 +1,62 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTCOSTMODEL_HPP
+#define CONVERTCOSTMODEL_HPP
+
+#include "ConvertQueue.hpp"
+
+
+/** \brief Estimator of image convertion time.
+  *
+  * Cost of a job is proportional to work units computed from source pixels
+  * count and file size; the pixels count is estimated from the file size if
+  * it's unknown. Work units are multiplied by a factor of the format class.
+  * Initial factors weight RAW and SVG images higher than regular images and
+  * are refined from measured convertion times by addSample().
+  *
+  * Jobs sorted by sort() are converted most expensive first, so a huge image
+  * at the end of the list doesn't leave one worker busy while others idle.
+  */
+class ConvertCostModel {
+public:
+    //! Format classes with different convertion cost per work unit.
+    enum FormatClass {
+        RegularFormat,
+        RawFormat,
+        SvgFormat,
+        FormatClassCount
+    };
+
+    ConvertCostModel();
+    static FormatClass formatClass(const QString &extension);
+    static double workUnits(const ConvertJob &job);
+    double factor(FormatClass formatClass) const;
+    double estimate(const ConvertJob &job) const;
+    void sort(QList<ConvertJob> *jobs) const;
+    void addSample(const ConvertJob &job, double elapsedMs);
+
+private:
+    double factors[FormatClassCount]; /**< Measured milliseconds per work unit. */
+    int samples[FormatClassCount]; /**< Count of measured jobs. */
+};
+
+#endif // CONVERTCOSTMODEL_HPP
@@ -21,12 +21,315 @@
 
 #include <QPainter>
 #include "ConvertEffects.hpp"
+#include "ConvertBands.hpp"
+#include "ImageStatistics.hpp"
+#include "Simd.hpp"
+
+#include <cstring>
+
+
+namespace {
+
+/** Base class of tasks modifying row bands of an image. */
+class ImageBandTask : public ConvertBandTask {
+public:
+    explicit ImageBandTask(QImage *image)
+        : image(image), bits(image->bits()) {}
+
+protected:
+    /** Returns image sharing rows from \a begin to \a end of #image. */
+    QImage band(int begin, int end) const {
+        return ConvertBands::bandImage(bits, *image, begin, end);
+    }
+
+    QImage *image;
+    uchar *bits;
+};
+
+/** Base class of tasks reading or modifying colors of row bands of 32-bit
+  * image. Rows are passed to subclasses as straight, not premultiplied
+  * pixels; rows of premultiplied image are converted in a row buffer.
+  */
+class ColorBandTask : public ConvertBandTask {
+public:
+    /** Creates task modifying \a image. */
+    explicit ColorBandTask(QImage *image)
+        : image(image), bits(image->bits()),
+          premultiplied(image->format()
+                        == QImage::Format_ARGB32_Premultiplied) {}
+
+    /** Creates task only reading \a image. */
+    explicit ColorBandTask(const QImage &image)
+        : image(&image), bits(const_cast<uchar *>(image.constBits())),
+          premultiplied(image.format()
+                        == QImage::Format_ARGB32_Premultiplied) {}
+
+protected:
+    /** Returns straight pixels of row \a y. \a buffer is used if the image
+      * is premultiplied.
+      */
+    QRgb *row(int y, QVector<QRgb> *buffer) const {
+        QRgb *line = reinterpret_cast<QRgb *>(bits
+                                              + y * image->bytesPerLine());
+        if (!premultiplied)
+            return line;
+        buffer->resize(image->width());
+        QRgb *pixels = buffer->data();
+        for (int x=0; x<image->width(); x++)
+            pixels[x] = qUnpremultiply(line[x]);
+        return pixels;
+    }
+
+    /** Stores straight \a pixels returned by row() for row \a y. */
+    void storeRow(int y, const QRgb *pixels) const {
+        if (!premultiplied)
+            return;
+        QRgb *line = reinterpret_cast<QRgb *>(bits
+                                              + y * image->bytesPerLine());
+        for (int x=0; x<image->width(); x++)
+            line[x] = qPremultiply(pixels[x]);
+    }
+
+    const QImage *image;
+    uchar *bits;
+    const bool premultiplied;
+};
+
+/** Converts \a width \a pixels to gray scale keeping alpha channel. Gray
+  * values are the same as qGray() results.
+  */
+void grayRow(QRgb *pixels, int width) {
+    int x = 0;
+#ifdef SIR_SIMD
+    // weights of blue, green, red and alpha bytes of qGray()
+    const __m128i weights = _mm_setr_epi16(5, 16, 11, 0, 5, 16, 11, 0);
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    const __m128i zero = _mm_setzero_si128();
+    for (; x+4<=width; x+=4) {
+        __m128i *p = reinterpret_cast<__m128i *>(pixels + x);
+        const __m128i v = _mm_loadu_si128(p);
+        // pairs of sums of each pixel
+        __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights);
+        __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights);
+        low = _mm_add_epi32(low, _mm_srli_epi64(low, 32));
+        high = _mm_add_epi32(high, _mm_srli_epi64(high, 32));
+        low = _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 3, 2, 0));
+        high = _mm_shuffle_epi32(high, _MM_SHUFFLE(3, 3, 2, 0));
+        __m128i gray = _mm_srli_epi32(_mm_unpacklo_epi64(low, high), 5);
+        gray = _mm_or_si128(gray, _mm_slli_epi32(gray, 8));
+        gray = _mm_or_si128(gray, _mm_slli_epi32(gray, 8));
+        _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(v, alpha), gray));
+    }
+#endif // SIR_SIMD
+    for (; x<width; x++) {
+        const int gray = qGray(pixels[x]);
+        pixels[x] = qRgba(gray, gray, gray, qAlpha(pixels[x]));
+    }
+}
+
+/** Maps color channels of \a width \a pixels by \a lut look up table of
+  * red, green and blue values. Alpha channel is kept.
+  */
+void lutRow(QRgb *pixels, int width, const uchar lut[3][256]) {
+    for (int x=0; x<width; x++) {
+        const QRgb rgb = pixels[x];
+        pixels[x] = qRgba(lut[0][qRed(rgb)], lut[1][qGreen(rgb)],
+                          lut[2][qBlue(rgb)], qAlpha(rgb));
+    }
+}
+
+/** Returns average of premultiplied \a a and \a b pixels rounded up like
+  * SSE2 average instruction.
+  */
+inline QRgb averagePixel(QRgb a, QRgb b) {
+    return ((a | b) & 0x01010101) + ((a >> 1) & 0x7f7f7f7f)
+            + ((b >> 1) & 0x7f7f7f7f);
+}
+
+/** Returns \a pixel covered by opaque \a color with 50% opacity.
+  * \a straight means the pixel isn't premultiplied.
+  */
+inline QRgb blendPixel(QRgb pixel, QRgb color, bool straight) {
+    if (straight && qAlpha(pixel) != 255)
+        return qUnpremultiply(averagePixel(qPremultiply(pixel), color));
+    return averagePixel(pixel, color);
+}
+
+/** Draws opaque \a color over \a width \a pixels with 50% opacity.
+  * \a straight means the pixels aren't premultiplied.
+  */
+void blendRow(QRgb *pixels, int width, QRgb color, bool straight) {
+    int x = 0;
+#ifdef SIR_SIMD
+    const __m128i c = _mm_set1_epi32(int(color));
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    for (; x+4<=width; x+=4) {
+        __m128i *p = reinterpret_cast<__m128i *>(pixels + x);
+        const __m128i v = _mm_loadu_si128(p);
+        // straight and premultiplied opaque pixels are equal
+        if (straight && _mm_movemask_epi8(_mm_cmpeq_epi32(
+                    _mm_and_si128(v, alpha), alpha)) != 0xffff) {
+            for (int i=x; i<x+4; i++)
+                pixels[i] = blendPixel(pixels[i], color, straight);
+            continue;
+        }
+        _mm_storeu_si128(p, _mm_avg_epu8(v, c));
+    }
+#endif // SIR_SIMD
+    for (; x<width; x++)
+        pixels[x] = blendPixel(pixels[x], color, straight);
+}
+
+/** Maps colors of row bands using look up table.
+  * \sa ConvertEffects::stretchHistogram() ConvertEffects::equalizeHistogram()
+  */
+class LookUpTask : public ColorBandTask {
+public:
+    LookUpTask(QImage *image, const uchar lut[3][256])
+        : ColorBandTask(image) {
+        std::memcpy(this->lut, lut, sizeof(this->lut));
+    }
+
+    void run(int begin, int end) {
+        QVector<QRgb> buffer;
+        for (int y=begin; y<end && !isCancelled(); y++) {
+            QRgb *pixels = row(y, &buffer);
+            lutRow(pixels, image->width(), lut);
+            storeRow(y, pixels);
+        }
+    }
+
+private:
+    uchar lut[3][256];
+};
+
+/** Converts row bands to gray scale. */
+class GrayscaleTask : public ColorBandTask {
+public:
+    explicit GrayscaleTask(QImage *image) : ColorBandTask(image) {}
+
+    void run(int begin, int end) {
+        QVector<QRgb> buffer;
+        for (int y=begin; y<end && !isCancelled(); y++) {
+            QRgb *pixels = row(y, &buffer);
+            grayRow(pixels, image->width());
+            storeRow(y, pixels);
+        }
+    }
+};
+
+/** Draws opaque color over row bands with 50% opacity. Premultiplied rows
+  * are blended in place.
+  */
+class BlendTask : public ImageBandTask {
+public:
+    BlendTask(QImage *image, const QColor &color)
+        : ImageBandTask(image), color(color.rgb()) {}
+
+    void run(int begin, int end) {
+        const bool straight = (image->format() == QImage::Format_ARGB32);
+        for (int y=begin; y<end && !isCancelled(); y++)
+            blendRow(reinterpret_cast<QRgb *>(bits
+                                              + y * image->bytesPerLine()),
+                     image->width(), color, straight);
+    }
+
+private:
+    const QRgb color;
+};
+
+/** Color filter operation of EffectsTask. */
+enum FilterOperation {
+    NoFilterOperation,
+    GrayOperation,
+    BlendOperation
+};
+
+/** Applies histogram look up table and color filter to row bands in single
+  * pass. Operations are selected by template parameters, so each
+  * combination compiles to a row loop containing only active operations.
+  * \sa ConvertEffects::modifyColors()
+  */
+template <bool LookUp, int Filter>
+class EffectsTask : public ColorBandTask {
+public:
+    EffectsTask(QImage *image, const uchar lut[3][256], QRgb color)
+        : ColorBandTask(image), color(color) {
+        if (LookUp)
+            std::memcpy(this->lut, lut, sizeof(this->lut));
+    }
+
+    void run(int begin, int end) {
+        const int width = image->width();
+        QVector<QRgb> buffer;
+        for (int y=begin; y<end && !isCancelled(); y++) {
+            if (LookUp || Filter == GrayOperation) {
+                QRgb *pixels = row(y, &buffer);
+                if (LookUp)
+                    lutRow(pixels, width, lut);
+                if (Filter == GrayOperation)
+                    grayRow(pixels, width);
+                storeRow(y, pixels);
+            }
+            // premultiplied rows are blended in place like by BlendTask
+            if (Filter == BlendOperation)
+                blendRow(reinterpret_cast<QRgb *>(bits
+                                                  + y * image->bytesPerLine()),
+                         width, color, !premultiplied);
+        }
+    }
+
+private:
+    uchar lut[3][256];
+    const QRgb color;
+};
+
+/** Fills row bands with half transparent brush. */
+class CombineTask : public ImageBandTask {
+public:
+    CombineTask(QImage *image, const QBrush &brush)
+        : ImageBandTask(image), brush(brush) {}
+
+    void run(int begin, int end) {
+        QImage img = band(begin, end);
+        QPainter painter(&img);
+        painter.setOpacity(0.5);
+        // keep brush origin of whole image
+        painter.translate(0, -begin);
+        painter.fillRect(QRect(0, begin, image->width(), end - begin), brush);
+    }
+
+private:
+    const QBrush brush;
+};
+
+}
+
+
+/** Paints frame on row bands of framed image. */
+class ConvertEffects::FrameTask : public ImageBandTask {
+public:
+    FrameTask(ConvertEffects *effects, QImage *result)
+        : ImageBandTask(result), effects(effects) {}
+
+    void run(int begin, int end) {
+        QImage img = band(begin, end);
+        QPainter painter(&img);
+        painter.translate(0, -begin);
+        effects->paintFrame(&painter, *image);
+    }
+
+private:
+    ConvertEffects *effects;
+};
 
 /** Creates ConvertEffects object.
   * \sa setSharedInfo()
   */
 ConvertEffects::ConvertEffects(SharedInformation *shared) {
     img = 0;
+    bandExecutor = 0;
+    cancellation = 0;
     setSharedInfo(shared);
 }
 
@@ -34,6 +337,8 @@ ConvertEffects::ConvertEffects(SharedInformation *shared) {
   * \sa setImage() setSharedInfo()
   */
 ConvertEffects::ConvertEffects(QImage *image, SharedInformation *shared) {
+    bandExecutor = 0;
+    cancellation = 0;
     setImage(image);
     setSharedInfo(shared);
 }
@@ -61,6 +366,37 @@ QImage * ConvertEffects::image() const {
     return img;
 }
 
+/** Sets threads processing row bands of large images. Null \a executor means
+  * effects are made in the calling thread only.
+  */
+void ConvertEffects::setBandExecutor(ConvertBandExecutor *executor) {
+    bandExecutor = executor;
+}
+
+/** Sets token stopping pixel loops of effects. The image is left partially
+  * processed if the \a token is cancelled, so it should be dropped then.
+  */
+void ConvertEffects::setCancellationToken(const CancellationToken *token) {
+    cancellation = token;
+}
+
+/** Runs \a task for rows of \a image, split into bands if the image is large.
+  * \sa setBandExecutor() setCancellationToken()
+  */
+void ConvertEffects::runBands(ConvertBandTask *task, const QImage &image) {
+    task->setCancellationToken(cancellation);
+    ConvertBands::run(bandExecutor, task, image.height(),
+                      qint64(image.width()) * image.height());
+}
+
+/** Converts #img to 32-bit format unless its pixels are 32-bit already, so
+  * pixel loops may read rows of QRgb values.
+  */
+void ConvertEffects::prepareImage() {
+    if (!ConvertBands::isRgb32(*img))
+        *img = ConvertBands::rgb32Image(*img);
+}
+
 void ConvertEffects::modifyHistogram() {
     switch (shared->effectsConfiguration().getHistogramOperation()) {
     case 1:
@@ -74,46 +410,144 @@ void ConvertEffects::modifyHistogram() {
     }
 }
 
+/** Stretches values of each color channel to full range. Channels of single
+  * value are left unchanged.
+  */
 void ConvertEffects::stretchHistogram() {
     Q_ASSERT(img != NULL);
     Q_ASSERT(!img->isNull());
 
-    const QPair<QColor, QColor> &range = colorRange();
-    const qreal rMul = 255. / (range.second.red() - range.first.red());
-    const qreal gMul = 255. / (range.second.green() - range.first.green());
-    const qreal bMul = 255. / (range.second.blue() - range.first.blue());
+    prepareImage();
+    uchar lut[3][256];
+    stretchTable(lut);
+    LookUpTask task(img, lut);
+    runBands(&task, *img);
+}
 
-    for (int x=0; x<img->width(); x++) {
-        for (int y=0; y<img->height(); y++) {
-            QRgb rgb = img->pixel(x,y);
-            QColor c(rgb);
-            c.setRed(rMul * (qRed(rgb) - range.first.red()) );
-            c.setGreen(gMul * (qGreen(rgb) - range.first.green()) );
-            c.setBlue(bMul * (qBlue(rgb) - range.first.blue()) );
-            img->setPixel(x, y, c.rgb());
+void ConvertEffects::equalizeHistogram() {
+    Q_ASSERT(img != NULL);
+    Q_ASSERT(!img->isNull());
+
+    prepareImage();
+    uchar lut[3][256];
+    equalizeTable(lut);
+    LookUpTask task(img, lut);
+    runBands(&task, *img);
+}
+
+/** Fills \a lut look up table of red, green and blue values stretching
+  * color channels of #img to full range. \sa stretchHistogram()
+  */
+void ConvertEffects::stretchTable(uchar lut[3][256]) {
+    const QPair<QColor, QColor> range = colorRange();
+    const int min[3] = { range.first.red(), range.first.green(),
+                         range.first.blue() };
+    const int max[3] = { range.second.red(), range.second.green(),
+                         range.second.blue() };
+    for (int c=0; c<3; c++) {
+        const qreal mul = (max[c] > min[c]) ? 255. / (max[c] - min[c]) : 0.;
+        for (int i=0; i<256; i++) {
+            if (mul > 0.)
+                lut[c][i] = qBound(0, int(mul * (i - min[c])), 255);
+            else
+                lut[c][i] = i;
         }
     }
 }
 
-void ConvertEffects::equalizeHistogram() {
+/** Fills \a lut look up table of red, green and blue values equalizing
+  * histogram of #img. \sa equalizeHistogram() lookUpTable()
+  */
+void ConvertEffects::equalizeTable(uchar lut[3][256]) {
+    const QVector<Rgb> LUT = lookUpTable();
+    for (int i=0; i<256; i++) {
+        lut[0][i] = LUT[i].red;
+        lut[1][i] = LUT[i].green;
+        lut[2][i] = LUT[i].blue;
+    }
+}
+
+/** Runs EffectsTask specialized for \a filter operation. \a LookUp means
+  * colors are mapped by \a lut before the filter.
+  */
+template <bool LookUp>
+void ConvertEffects::runEffects(int filter, const uchar lut[3][256],
+                                QRgb color) {
+    switch (filter) {
+    case GrayOperation: {
+        EffectsTask<LookUp, GrayOperation> task(img, lut, color);
+        runBands(&task, *img);
+        break;
+    }
+    case BlendOperation: {
+        EffectsTask<LookUp, BlendOperation> task(img, lut, color);
+        runBands(&task, *img);
+        break;
+    }
+    default: {
+        EffectsTask<LookUp, NoFilterOperation> task(img, lut, color);
+        runBands(&task, *img);
+        break;
+    }
+    }
+}
+
+/** Applies histogram operation and color filter of effects configuration in
+  * single pass over pixels of the image. Each row is transformed by all the
+  * operations at once, so it's read and written only once. Histogram
+  * statistics are still computed by a separate reading pass.
+  *
+  * Gradient filter and filter colors which aren't opaque are painted by
+  * QPainter after the pass.
+  * \sa modifyHistogram() filtrate()
+  */
+void ConvertEffects::modifyColors() {
     Q_ASSERT(img != NULL);
     Q_ASSERT(!img->isNull());
 
-    const QVector<Rgb> &LUT = lookUpTable();
-    int i;
-
-    for (int x=0; x<img->width(); x++) {
-        for (int y=0; y<img->height(); y++) {
-            QColor c(img->pixel(x,y));
-            i = c.red();
-            c.setRed(LUT[i].red);
-            i = c.green();
-            c.setGreen(LUT[i].green);
-            i = c.blue();
-            c.setBlue(LUT[i].blue);
-            img->setPixel(x, y, c.rgb());
-        }
+    const EffectsConfiguration configuration = shared->effectsConfiguration();
+    prepareImage();
+    bool lookUp = true;
+    uchar lut[3][256];
+    switch (configuration.getHistogramOperation()) {
+    case 1:
+        stretchTable(lut);
+        break;
+    case 2:
+        equalizeTable(lut);
+        break;
+    default:
+        lookUp = false;
+        break;
     }
+
+    int filter = NoFilterOperation;
+    QColor color;
+    switch (configuration.getFilterType()) {
+    case BlackAndWhite:
+        filter = GrayOperation;
+        break;
+    case Sepia:
+        color = QColor(112, 66, 20);
+        break;
+    case CustomColor:
+        color = configuration.getFilterBrush().color();
+        break;
+    default:
+        break;
+    }
+    if (color.isValid() && color.alpha() == 255)
+        filter = BlendOperation;
+
+    if (lookUp)
+        runEffects<true>(filter, lut, color.rgb());
+    else if (filter != NoFilterOperation)
+        runEffects<false>(filter, lut, color.rgb());
+
+    // filters which can't be blended per pixel
+    const int type = configuration.getFilterType();
+    if (filter == NoFilterOperation && type != NoFilter)
+        filtrate();
 }
 
 void ConvertEffects::filtrate() {
@@ -121,14 +555,12 @@ void ConvertEffects::filtrate() {
     Q_ASSERT(!img->isNull());
 
     switch (shared->effectsConfiguration().getFilterType()) {
-    case BlackAndWhite:
-        for (int y=0; y<img->height(); y++) {
-            for (int x=0; x<img->width(); x++) {
-                int gray = qGray(img->pixel(x,y));
-                img->setPixel(x, y, qRgb(gray, gray, gray));
-            }
-        }
+    case BlackAndWhite: {
+        prepareImage();
+        GrayscaleTask task(img);
+        runBands(&task, *img);
         break;
+    }
     case Sepia:
         combine(QColor(112, 66, 20));
         break;
@@ -160,36 +592,45 @@ QImage ConvertEffects::framedImage() {
     }
     else
         result = *img;
-    QPainter painter(&result);
+    FrameTask task(this, &result);
+    runBands(&task, result);
+    return result;
+}
+
+/** Paints frame and #img image (if the frame is added around) on \a result
+  * image using \a painter.
+  * \sa framedImage()
+  */
+void ConvertEffects::paintFrame(QPainter *painter, const QImage &result) {
+    int w2 = 2 * shared->effectsConfiguration().getFrameWidth(); // double frame width
     QPen pen(Qt::SolidLine);
     if (shared->effectsConfiguration().getBorderInsideWidth()
             + shared->effectsConfiguration().getBorderOutsideWidth()
             < shared->effectsConfiguration().getFrameWidth()) {
         pen.setWidth(w2);
         pen.setColor(shared->effectsConfiguration().getFrameColor());
-        painter.setPen(pen);
-        painter.drawRect(result.rect());
+        painter->setPen(pen);
+        painter->drawRect(result.rect());
     }
     if (shared->effectsConfiguration().getBorderOutsideWidth() > 0) {
         pen.setWidth(2 * shared->effectsConfiguration().getBorderOutsideWidth());
         pen.setColor(shared->effectsConfiguration().getBorderOutsideColor());
-        painter.setPen(pen);
-        painter.drawRect(result.rect());
+        painter->setPen(pen);
+        painter->drawRect(result.rect());
     }
     if (shared->effectsConfiguration().getBorderInsideWidth() > 0) {
         pen.setWidth(shared->effectsConfiguration().getBorderInsideWidth());
         pen.setColor(shared->effectsConfiguration().getBorderInsideColor());
-        painter.setPen(pen);
+        painter->setPen(pen);
         int ih = shared->effectsConfiguration().getFrameWidth()
                 - shared->effectsConfiguration().getBorderInsideWidth() * 0.5; // half of inside border
         int sub = w2 - ih + 1;
-        painter.drawRect(ih, ih, result.width()-sub, result.height()-sub);
+        painter->drawRect(ih, ih, result.width()-sub, result.height()-sub);
     }
     if (shared->effectsConfiguration().getFrameAddAround())
-        painter.drawImage(shared->effectsConfiguration().getFrameWidth(),
-                          shared->effectsConfiguration().getFrameWidth(),
-                          *img);
-    return result;
+        painter->drawImage(shared->effectsConfiguration().getFrameWidth(),
+                           shared->effectsConfiguration().getFrameWidth(),
+                           *img);
 }
 
 /** Draws text on #img image.
@@ -339,58 +780,80 @@ void ConvertEffects::combineLoop(const QColor &color) {
         }
     }
 }
+
+// for benchmark test only
+void ConvertEffects::grayscaleLoop() {
+    for (int y=0; y<img->height(); y++) {
+        for (int x=0; x<img->width(); x++) {
+            int gray = qGray(img->pixel(x,y));
+            img->setPixel(x, y, qRgb(gray, gray, gray));
+        }
+    }
+}
+
+// for benchmark test only
+QVector<Rgb> ConvertEffects::histogramLoop() {
+    QVector<Rgb> h(256);
+    for (int y=0; y<img->height(); y++) {
+        for (int x=0; x<img->width(); x++) {
+            QRgb rgb = img->pixel(x,y);
+            h[qRed(rgb)].red++;
+            h[qGreen(rgb)].green++;
+            h[qBlue(rgb)].blue++;
+        }
+    }
+    return h;
+}
 #endif // SIR_TESTS
 
+/** Draws \a color over the image with 50% opacity. Opaque colors are blended
+  * without QPainter.
+  */
 void ConvertEffects::combine(const QColor &color) {
-    QPainter painter(img);
-    painter.setOpacity(0.5);
-    painter.fillRect(img->rect(), color);
+    if (color.alpha() != 255) {
+        combine(QBrush(color));
+        return;
+    }
+    prepareImage();
+    BlendTask task(img, color);
+    runBands(&task, *img);
 }
 
 void ConvertEffects::combine(const QBrush &brush) {
-    QPainter painter(img);
-    painter.setOpacity(0.5);
-    painter.fillRect(img->rect(), brush);
+    CombineTask task(img, brush);
+    runBands(&task, *img);
 }
 
-QPair<QColor, QColor> ConvertEffects::colorRange() {
-    QPair<QColor, QColor> range(Qt::white, Qt::black);
-
-    for (int x=0; x<img->width(); x++) {
-        for (int y=0; y<img->height(); y++) {
-            QRgb rgb = img->pixel(x,y);
-            int v = qRed(rgb);
-            if (v < range.first.red())
-                range.first.setRed(v);
-            else if (v > range.second.red())
-                range.second.setRed(v);
-            v = qGreen(rgb);
-            if (v < range.first.green())
-                range.first.setGreen(v);
-            else if (v > range.second.green())
-                range.second.setGreen(v);
-            v = qBlue(rgb);
-            if (v < range.first.blue())
-                range.first.setBlue(v);
-            else if (v > range.second.blue())
-                range.second.setBlue(v);
-        }
-    }
+/** Returns statistics of #img. Statistics are cached, so histogram
+  * operations don't rescan pixels until the image is modified. #img is
+  * converted by prepareImage() first; converted copy would get new cache key
+  * on each call.
+  */
+ImageStatistics ConvertEffects::statistics() {
+    prepareImage();
+    return ImageStatistics::cached(*img, bandExecutor, cancellation);
+}
 
-    return range;
+/** Returns pair of minimum and maximum values of each color channel. */
+QPair<QColor, QColor> ConvertEffects::colorRange() {
+    const ImageStatistics stats = statistics();
+    return qMakePair(stats.minimum(), stats.maximum());
 }
 
 /** Create vector of image distribution function.
   * \return Distribution vector object.
-  * \sa histogram() sumRgb()
+  * \sa histogram() ImageStatistics::cumulativeHistogram()
   */
 QVector<RgbF> ConvertEffects::distribution() {
     QVector<RgbF> D(256);
-    const QVector<Rgb> &h = histogram();
-    const int lp = img->width() * img->height();
+    const ImageStatistics stats = statistics();
+    const QVector<Rgb> &sum = stats.cumulativeHistogram();
+    if (sum.isEmpty())
+        return D;
+    const qint64 lp = stats.pixelCount();
 
     for (int n=0; n<D.size(); n++)
-        D[n] = sumRgb(h, n) / lp;
+        D[n] = Rgb(sum[n]) / lp;
 
     return D;
 }
@@ -405,33 +868,7 @@ QVector<RgbF> ConvertEffects::distribution() {
   * \return Vector of count values.
   */
 QVector<Rgb> ConvertEffects::histogram() {
-    QVector<Rgb> h(256);
-
-    for (int x=0; x<img->width(); x++) {
-        for (int y=0; y<img->height(); y++) {
-            QRgb rgb = img->pixel(x,y);
-            int n = qRed(rgb);
-            h[n].red++;
-            n = qGreen(rgb);
-            h[n].green++;
-            n = qBlue(rgb);
-            h[n].blue++;
-        }
-    }
-
-    return h;
-}
-
-/** Sums first \a n values of \a h histogram.
-  * \return Rgb object.
-  */
-Rgb ConvertEffects::sumRgb(const QVector<Rgb> &h, int n) {
-    Rgb rgb;
-
-    for (int u=0; u<n; u++)
-        rgb += h[u];
-
-    return rgb;
+    return statistics().histogram();
 }
 
 /** Create look up table (LUT) for histogram equalization.
@@ -25,6 +25,11 @@
 #include "SharedInformation.hpp"
 #include "Rgb.hpp"
 
+class CancellationToken;
+class ConvertBandExecutor;
+class ConvertBandTask;
+class ImageStatistics;
+
 /** \brief Convertion effects class.
   *
   * Effects are made on #img QImage object using data from #shared SharedInformation
@@ -36,6 +41,11 @@
   * \li \link #framedImage() \em "Add Frame" \endlink
   * \li \link #addText() \em "Add Text" \endlink
   * \li \link #addImage() \em "Add Image" \endlink
+  *
+  * Histogram, filter and frame effects of large images are split into row
+  * bands processed in parallel by band executor threads. Histogram and filter
+  * effects may be applied in single pass by modifyColors().
+  * \sa setBandExecutor() ConvertBands
   */
 class ConvertEffects {
     friend class ConvertEffectsTest;
@@ -48,8 +58,11 @@ public:
     SharedInformation *sharedInfo() const;
     void setImage(QImage *image);
     QImage *image() const;
+    void setBandExecutor(ConvertBandExecutor *executor);
+    void setCancellationToken(const CancellationToken *token);
     void modifyHistogram();
     void filtrate();
+    void modifyColors();
     QImage framedImage();
     void addText();
     void addImage();
@@ -64,20 +77,38 @@ private:
       * \sa sharedInfo() setSharedInfo()
       */
     SharedInformation *shared;
+    /** Threads processing row bands or null pointer.
+      * \sa setBandExecutor()
+      */
+    ConvertBandExecutor *bandExecutor;
+    /** Token stopping pixel loops or null pointer.
+      * \sa setCancellationToken()
+      */
+    const CancellationToken *cancellation;
+    class FrameTask;
     // methods
     void rotate(QPainter *painter, const QPoint &originPoint, int angle);
     QPoint getTransformOriginPoint(const QPoint &position, const PosUnitPair &units);
     QRect getEffectBoundingRect(const QRect &rect, const QPoint &pos,
                                 PosModifier modifier);
     void combineLoop(const QColor &color);
+    void grayscaleLoop();
+    QVector<Rgb> histogramLoop();
     void combine(const QColor &color);
     void combine(const QBrush &brush);
+    void paintFrame(QPainter *painter, const QImage &result);
+    void runBands(ConvertBandTask *task, const QImage &image);
+    void prepareImage();
+    ImageStatistics statistics();
     QPair<QColor, QColor> colorRange();
     void stretchHistogram();
     void equalizeHistogram();
+    void stretchTable(uchar lut[3][256]);
+    void equalizeTable(uchar lut[3][256]);
+    template <bool LookUp>
+    void runEffects(int filter, const uchar lut[3][256], QRgb color);
     QVector<RgbF> distribution();
     QVector<Rgb> histogram();
-    Rgb sumRgb(const QVector<Rgb> &h, int n);
     QVector<Rgb> lookUpTable();
 };
 
@@ -0,0 +1,241 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertPreflight.hpp"
+
+#include "SharedInformation.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+
+#include <cmath>
+
+
+/** Creates checker of batch converted using \a shared information. */
+ConvertPreflight::ConvertPreflight(const SharedInformation *shared)
+    : shared(shared) {}
+
+/** Computes target file path, reads source file size and dimensions of
+  * \a job and marks questions which must be
+  * answered by the user before convertion as ConvertJob::Pending.
+  * \return True if any question is pending, otherwise false.
+  */
+bool ConvertPreflight::check(ConvertJob *job) {
+    job->targetFilePath = targetFilePath(job->imageData);
+
+    // overwrite existing file or file written by previous job of this batch
+    if (QFile::exists(job->targetFilePath) || targets.contains(job->targetFilePath))
+        job->decisions[ConvertJob::Overwrite] = ConvertJob::Pending;
+    targets.insert(job->targetFilePath);
+
+    const QString imagePath = job->imageData.at(2) + QDir::separator()
+            + job->imageData.at(0) + '.' + job->imageData.at(1);
+    const QString format = job->imageData.at(1).toLower();
+    job->fileSize = QFileInfo(imagePath).size();
+    if (format == "svg" || format == "svgz") {
+        // SVG image is rendered in desired size, so it's never enlarged
+        if (shared->svgModifiersEnabled && shared->svgSave) {
+            QString svgTargetFilePath = job->targetFilePath.left(
+                        job->targetFilePath.lastIndexOf('.') + 1) + "svg";
+            if (QFile::exists(svgTargetFilePath))
+                job->decisions[ConvertJob::SvgOverwrite] = ConvertJob::Pending;
+        }
+    }
+    else {
+        // dimensions are also used by ConvertCostModel
+        QSize sourceSize = imageSize(imagePath);
+        if (sourceSize.isValid())
+            job->pixels = qint64(sourceSize.width()) * sourceSize.height();
+        // the image is scaled after cropping
+        const QRect crop = cropRect(sourceSize);
+        if (crop.isValid())
+            sourceSize = crop.size();
+        if (isEnlarging(sourceSize, job->fileSize))
+            job->decisions[ConvertJob::Enlarge] = ConvertJob::Pending;
+    }
+
+    for (int i=0; i<ConvertJob::QuestionCount; i++) {
+        if (job->decisions[i] == ConvertJob::Pending)
+            return true;
+    }
+    return false;
+}
+
+/** Returns target file path of image described by \a imageData list
+  * containing file name, extension and path.
+  */
+QString ConvertPreflight::targetFilePath(const QStringList &imageData) const {
+    QString filePath = shared->destFolder.absolutePath() + QDir::separator();
+    if (!shared->prefix.isEmpty())
+        filePath += shared->prefix + "_";
+    filePath += imageData.at(0);
+    if (!shared->suffix.isEmpty())
+        filePath += "_" + shared->suffix;
+    filePath += "." + shared->format;
+    return filePath;
+}
+
+/** Returns true if the image of \a sourceSize dimensions and \a sourceFileSize
+  * bytes will be enlarged. Invalid \a sourceSize means unknown dimensions; in
+  * this case the result is true only if it doesn't depend on dimensions.
+  * \note This is the same condition as checked by worker thread after
+  *       decoding the image, but desired file size in bytes of non-linear
+  *       formats is estimated from file size ratio.
+  */
+bool ConvertPreflight::isEnlarging(const QSize &sourceSize,
+                                   qint64 sourceFileSize) const {
+    double width = 0.;
+    double height = 0.;
+    double destSize = shared->sizeBytes;
+
+    if (shared->sizeUnit == 0) { // px
+        if (shared->hasWidth)
+            width = shared->width;
+        if (shared->hasHeight)
+            height = shared->height;
+    }
+    else if (shared->sizeUnit == 1) { // %
+        if (!sourceSize.isValid())
+            return false;
+        width = shared->width * sourceSize.width() / 100.;
+        height = shared->height * sourceSize.height() / 100.;
+    }
+    else if (shared->sizeUnit == 2) { // bytes
+        if (isLinearFileSizeFormat(&destSize)) {
+            if (!sourceSize.isValid())
+                return false;
+            return sourceSize.width() * sourceSize.height() < destSize;
+        }
+        // non-linear size relationship
+        if (sourceFileSize <= 0 || shared->sizeBytes <= 0)
+            return false;
+        return sourceFileSize < 0.97412 * 0.97412 * shared->sizeBytes;
+    }
+    else
+        return false;
+
+    if (!sourceSize.isValid())
+        return false;
+    const int w = sourceSize.width();
+    const int h = sourceSize.height();
+    return (w < width && w >= h) || (h < height && w <= h);
+}
+
+/** Returns true if desired file format is corresponding file size to image size
+  * as linear function, otherwise returns false.\n
+  * Following file formats are linear size: BMP, PPM, ICO, TIFF and XBM.
+  * In this case \a destSize will be changed to count of pixels.
+  */
+bool ConvertPreflight::isLinearFileSizeFormat(double *destSize) const {
+    bool linearSize = false;
+    const QString &format = shared->format;
+    if (format == "bmp") {
+        *destSize -= 54;
+        *destSize /= 3;
+        linearSize = true;
+    }
+    else if (format == "ppm") {
+        *destSize -= 17;
+        *destSize /= 3;
+        linearSize = true;
+    }
+    else if (format == "ico") {
+        *destSize -= 1422;
+        *destSize /= 4;
+        linearSize = true;
+    }
+    else if (format == "tif" || format == "tiff") {
+        *destSize -= 14308;
+        *destSize /= 4;
+        linearSize = true;
+    }
+    else if (format == "xbm") {
+        *destSize -= 60;
+        *destSize /= 0.65;
+        linearSize = true;
+    }
+    return linearSize;
+}
+
+/** Returns region of image of \a sourceSize dimensions cropped before scaling
+  * or invalid rectangle if the image isn't cropped. The region is limited to
+  * the image rectangle; if the region is outside the image the result is
+  * invalid too.
+  * \sa SharedInformation::setDesiredCrop()
+  */
+QRect ConvertPreflight::cropRect(const QSize &sourceSize) const {
+    if (shared->cropMode == 0 || sourceSize.isEmpty())
+        return QRect();
+    const qreal w = sourceSize.width();
+    const qreal h = sourceSize.height();
+    QRectF crop = shared->cropRect;
+    if (shared->cropMode == 1) ; // px
+    else if (shared->cropMode == 2) // %
+        crop = QRectF(crop.x() * w / 100., crop.y() * h / 100.,
+                      crop.width() * w / 100., crop.height() * h / 100.);
+    else if (shared->cropMode == 3) { // aspect ratio
+        if (crop.width() <= 0. || crop.height() <= 0.)
+            return QRect();
+        const QSizeF size = crop.size().scaled(w, h, Qt::KeepAspectRatio);
+        crop = QRectF(QPointF((w - size.width()) / 2.,
+                              (h - size.height()) / 2.), size);
+    }
+    else
+        return QRect();
+    // zero width or height reaches the image edge
+    if (crop.width() <= 0.)
+        crop.setRight(w);
+    if (crop.height() <= 0.)
+        crop.setBottom(h);
+    const QRect rect = crop.toRect() & QRect(QPoint(0, 0), sourceSize);
+    if (rect.isEmpty())
+        return QRect();
+    return rect;
+}
+
+/** Returns dimensions of image stored in \a imagePath file read from the file
+  * header without decoding. Returns invalid size if the format isn't supported
+  * by Qt image plugins, e.g. for RAW images.
+  */
+QSize ConvertPreflight::imageSize(const QString &imagePath) {
+    QImageReader reader(imagePath);
+    return reader.size();
+}
+
+/** Returns size of \a source image reduced by a power of two divisor so it
+  * still is at least twice as large as \a target size in both dimensions.
+  * The divisor is up to 8, which corresponds to DCT domain scaling of JPEG
+  * decoder. Returns \a source if any size is empty.
+  * \note The decoded image is finally resampled to target size, so keeping
+  *       twice larger image preserves quality of the result.
+  */
+QSize ConvertPreflight::decodeSize(const QSize &source, const QSize &target) {
+    if (source.isEmpty() || target.isEmpty())
+        return source;
+    int divisor = 1;
+    while (divisor < 8
+           && source.width() >= 4 * divisor * target.width()
+           && source.height() >= 4 * divisor * target.height())
+        divisor *= 2;
+    return QSize((source.width() + divisor - 1) / divisor,
+                 (source.height() + divisor - 1) / divisor);
+}
@@ -0,0 +1,59 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTPREFLIGHT_HPP
+#define CONVERTPREFLIGHT_HPP
+
+#include <QRect>
+#include <QSet>
+#include <QSize>
+
+#include "ConvertQueue.hpp"
+
+class SharedInformation;
+
+
+/** \brief Convertion batch checker run before worker threads start.
+  *
+  * Computes target file paths and reads source file size and image dimensions
+  * from file headers only, so all questions about overwriting and enlarging files can be
+  * asked before convertion. Worker threads use decisions stored in ConvertJob
+  * objects and never wait for the user.
+  *
+  * \sa ConvertJob::Question widgets/ConvertDecisionDialog
+  */
+class ConvertPreflight {
+public:
+    explicit ConvertPreflight(const SharedInformation *shared);
+    bool check(ConvertJob *job);
+    QString targetFilePath(const QStringList &imageData) const;
+    bool isEnlarging(const QSize &sourceSize, qint64 sourceFileSize) const;
+    bool isLinearFileSizeFormat(double *destSize) const;
+    QRect cropRect(const QSize &sourceSize) const;
+    static QSize imageSize(const QString &imagePath);
+    static QSize decodeSize(const QSize &source, const QSize &target);
+
+private:
+    const SharedInformation *shared;
+    QSet<QString> targets; /**< Target paths of already checked jobs. */
+};
+
+#endif // CONVERTPREFLIGHT_HPP
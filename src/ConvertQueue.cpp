@@ -0,0 +1,94 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertQueue.hpp"
+
+
+/** Creates empty queue. */
+ConvertQueue::ConvertQueue() : head(0), tail(0) {}
+
+/** Deallocates all segments. */
+ConvertQueue::~ConvertQueue() {
+    for (int i=0; i<MaxSegments; i++)
+        delete segments[i].load();
+}
+
+/** Appends \a job at the end of the queue.
+  * \note Call this function from the producer thread only.
+  * \return False if the queue is full, otherwise true.
+  */
+bool ConvertQueue::enqueue(const ConvertJob &job) {
+    const int index = tail.load();
+    const int segmentIndex = index / SegmentSize;
+    if (segmentIndex >= MaxSegments)
+        return false;
+
+    Segment *segment = segments[segmentIndex].load();
+    if (!segment) {
+        segment = new Segment;
+        segments[segmentIndex].storeRelease(segment);
+    }
+    segment->jobs[index % SegmentSize] = job;
+    // publish the job
+    tail.storeRelease(index + 1);
+    return true;
+}
+
+/** Takes the first job from the queue and copies it into \a job.
+  * This function is thread-safe and lock-free.
+  * \return False if the queue is empty, otherwise true.
+  */
+bool ConvertQueue::dequeue(ConvertJob *job) {
+    forever {
+        const int index = head.loadAcquire();
+        if (index >= tail.loadAcquire())
+            return false;
+        if (head.testAndSetOrdered(index, index + 1)) {
+            Segment *segment = segments[index / SegmentSize].loadAcquire();
+            *job = segment->jobs[index % SegmentSize];
+            return true;
+        }
+    }
+}
+
+/** Returns true if there is no job to take. */
+bool ConvertQueue::isEmpty() const {
+    return head.loadAcquire() >= tail.loadAcquire();
+}
+
+/** Returns count of jobs enqueued since last clear() call. */
+int ConvertQueue::count() const {
+    return tail.loadAcquire();
+}
+
+/** Returns count of jobs already taken from the queue. */
+int ConvertQueue::takenCount() const {
+    return qMin(head.loadAcquire(), tail.loadAcquire());
+}
+
+/** Forgets all jobs. Allocated segments are kept for reuse.
+  * \note Call this function from the producer thread when none of taken jobs
+  *       is still copied by consumers, i.e. between batches.
+  */
+void ConvertQueue::clear() {
+    tail.storeRelease(0);
+    head.storeRelease(0);
+}
@@ -0,0 +1,119 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTQUEUE_HPP
+#define CONVERTQUEUE_HPP
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QStringList>
+
+class MappedFile;
+
+
+//! Single image convertion order.
+struct ConvertJob {
+    //! Questions resolved by the user before convertion starts.
+    enum Question {
+        Overwrite, /**< Overwrite existing target file? */
+        Enlarge, /**< Enlarge image smaller than desired size? */
+        SvgOverwrite, /**< Overwrite existing modified SVG file? */
+        QuestionCount
+    };
+    //! User decision about single question.
+    enum Decision {
+        NotAsked, /**< The question isn't necessary. */
+        Pending, /**< The question must be asked before convertion. */
+        Accepted,
+        Rejected
+    };
+
+    ConvertJob() : id(-1), fileSize(0), pixels(0), cost(0.) {
+        for (int i=0; i<QuestionCount; i++)
+            decisions[i] = NotAsked;
+    }
+
+    int id; /**< Index of the job within the batch. */
+    QStringList imageData; /**< List of strings: file name, extension and path. */
+    /** Target file path computed before convertion. Empty if unknown. */
+    QString targetFilePath;
+    quint8 decisions[QuestionCount]; /**< Decision values indexed by Question. */
+    qint64 fileSize; /**< Source file size in bytes. */
+    qint64 pixels; /**< Source image pixels count or 0 if unknown. */
+    double cost; /**< Estimated convertion time. \sa ConvertCostModel */
+};
+
+//! Convertion job passed between pipeline stages. \sa ConvertScheduler
+struct ConvertPipelineItem {
+    ConvertPipelineItem() : elapsed(0) {}
+
+    ConvertJob job;
+    /** Memory mapping of the source file referenced by #sourceData or null
+      * pointer if the file isn't mapped.
+      */
+    QSharedPointer<MappedFile> mapping;
+    QByteArray sourceData; /**< Prefetched source file or empty if not read. */
+    QByteArray targetData; /**< Encoded target image waiting for write. */
+    QString targetFilePath;
+    qint64 elapsed; /**< Processing time of previous stages in milliseconds. */
+};
+
+/** \brief Lock-free queue of convertion jobs.
+  *
+  * Jobs are appended by single producer (the GUI thread) and taken by any
+  * number of worker threads. A worker claims the next job by atomic
+  * compare-and-swap of the head index, so taking a job never locks a mutex
+  * nor touches the GUI thread.
+  *
+  * Jobs are stored in fixed size segments which are never moved, so already
+  * published job can be read safely while the producer appends next ones.
+  */
+class ConvertQueue {
+public:
+    ConvertQueue();
+    ~ConvertQueue();
+    bool enqueue(const ConvertJob &job);
+    bool dequeue(ConvertJob *job);
+    bool isEmpty() const;
+    int count() const;
+    int takenCount() const;
+    void clear();
+
+private:
+    enum {
+        SegmentSize = 1024,
+        MaxSegments = 4096
+    };
+    struct Segment {
+        ConvertJob jobs[SegmentSize];
+    };
+
+    /** Segments directory. Segments are allocated on demand by producer. */
+    QAtomicPointer<Segment> segments[MaxSegments];
+    QAtomicInt head; /**< Index of the next job to take. */
+    QAtomicInt tail; /**< Count of published jobs. */
+
+    Q_DISABLE_COPY(ConvertQueue)
+};
+
+#endif // CONVERTQUEUE_HPP
@@ -0,0 +1,717 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertScheduler.hpp"
+
+#include "ConvertThread.hpp"
+
+#include <QTimer>
+
+/** Maximum time of waiting for items of the previous stage in milliseconds.
+  * It bounds reaction time of threads waiting for the pipeline queues.
+  */
+static const unsigned long stageWaitTime = 100;
+
+/** Bands of single image being processed by runBands(). */
+struct ConvertScheduler::BandBatch {
+    BandBatch(ConvertBandTask *task, int count, int bands, int node)
+        : task(task), count(count), bands(bands), node(node), next(0),
+          done(0) {}
+
+    ConvertBandTask *task;
+    int count; /**< Count of rows to process. */
+    int bands; /**< Count of bands. */
+    /** NUMA node of the image owner or -1 if any thread may help. */
+    int node;
+    QAtomicInt next; /**< Index of next band to take. */
+    QAtomicInt done; /**< Count of processed bands. */
+};
+
+
+/** Creates scheduler without worker threads.
+  * \sa setThreadCount()
+  */
+ConvertScheduler::ConvertScheduler(QObject *parent)
+    : QObject(parent), readersCount(0), writersCount(0), finishedCount(0),
+      finishedCost(0), activeCount(0), bandBatchCount(0), idleCount(0),
+      cpuPercent(100) {
+    adaptive = false;
+    isolated = false;
+    adaptiveTimer = new QTimer(this);
+    adaptiveTimer->setInterval(2000);
+    connect(adaptiveTimer, SIGNAL(timeout()), SLOT(adaptThreadCount()));
+    lastFinishedCount = 0;
+    lastFinishedCost = 0;
+    lastCpuBusy = 0;
+    lastCpuTotal = 0;
+}
+
+/** Cancels pending jobs, stops and deletes all worker threads.
+  * Threads are stopped in pipeline order, so no thread waits for a queue
+  * of stopped stage.
+  */
+ConvertScheduler::~ConvertScheduler() {
+    cancel();
+    while (!readers.isEmpty())
+        removeThread(&readers);
+    while (!pool.isEmpty())
+        removeThread(&pool);
+    while (!writers.isEmpty())
+        removeThread(&writers);
+}
+
+/** Resizes worker threads pool to \a count threads.
+  *
+  * New threads are started immediately and wait for jobs. Surplus threads
+  * are stopped only if the scheduler isn't busy; otherwise the pool will be
+  * shrinked on next call of this function.
+  */
+void ConvertScheduler::setThreadCount(int count) {
+    while (pool.count() < count)
+        addThread(&pool, ConvertThread::ConvertStage);
+    if (!isBusy()) {
+        while (pool.count() > count)
+            removeThread(&pool);
+    }
+    setActiveThreadCount(count);
+}
+
+/** Returns count of convert threads in the pool. */
+int ConvertScheduler::threadCount() const {
+    return pool.count();
+}
+
+/** Resizes pool of reader threads prefetching source files to \a count
+  * threads. 0 means convert threads read source files itself.
+  * \sa setThreadCount()
+  */
+void ConvertScheduler::setReaderCount(int count) {
+    while (readers.count() < count)
+        addThread(&readers, ConvertThread::ReadStage);
+    if (!isBusy()) {
+        while (readers.count() > count)
+            removeThread(&readers);
+    }
+    readersCount.storeRelease(readers.count());
+}
+
+/** Returns count of reader threads. */
+int ConvertScheduler::readerCount() const {
+    return readersCount.loadAcquire();
+}
+
+/** Resizes pool of writer threads writing encoded images to \a count
+  * threads. 0 means convert threads write target files itself.
+  * \sa setThreadCount()
+  */
+void ConvertScheduler::setWriterCount(int count) {
+    while (writers.count() < count)
+        addThread(&writers, ConvertThread::WriteStage);
+    if (!isBusy()) {
+        while (writers.count() > count)
+            removeThread(&writers);
+    }
+    writersCount.storeRelease(writers.count());
+}
+
+/** Returns count of writer threads. */
+int ConvertScheduler::writerCount() const {
+    return writersCount.loadAcquire();
+}
+
+/** Returns list of threads of all pipeline stages. */
+QList<ConvertThread *> ConvertScheduler::threads() const {
+    return readers + pool + writers;
+}
+
+/** Returns count of threads taking jobs. */
+int ConvertScheduler::activeThreadCount() const {
+    return activeCount.loadAcquire();
+}
+
+/** Enables or disables adaptive threads count mode.
+  * In adaptive mode the pool is extended to twice of logical CPUs count and
+  * batch starts with physical cores count active threads.
+  * \sa start() ConvertAdaptiveController
+  */
+void ConvertScheduler::setAdaptive(bool enabled) {
+    adaptive = enabled;
+}
+
+/** Returns true if adaptive threads count mode is enabled. */
+bool ConvertScheduler::isAdaptive() const {
+    return adaptive;
+}
+
+/** Returns threads count giving the best throughput in adaptive mode or
+  * active threads count otherwise.
+  */
+int ConvertScheduler::settledThreadCount() const {
+    if (adaptive)
+        return controller.settledCount();
+    return activeThreadCount();
+}
+
+/** Sets CPU affinity \a policy of convert threads. Threads change their
+  * affinity before taking next job.
+  * \sa ConvertAffinity
+  */
+void ConvertScheduler::setAffinityPolicy(ConvertAffinity::Policy policy) {
+    if (policy == affinity.policy() && policy == ConvertAffinity::NoAffinity)
+        return;
+    affinity.setPolicy(policy);
+    foreach (ConvertThread *thread, pool)
+        updateAffinity(thread);
+}
+
+/** Returns CPU affinity policy of convert threads. It's
+  * ConvertAffinity::NoAffinity if CPU topology is unknown.
+  */
+ConvertAffinity::Policy ConvertScheduler::affinityPolicy() const {
+    return affinity.policy();
+}
+
+/** Limits memory reserved for decoded images by convert threads to \a bytes
+  * bytes. 0 means unlimited memory.
+  * \sa memoryBudget()
+  */
+void ConvertScheduler::setMemoryLimit(qint64 bytes) {
+    budget.setCapacity(bytes);
+}
+
+/** Limits bytes read from source files to \a bytesPerSecond bytes per
+  * second. 0 means unlimited reading. It may be called while converting.
+  * \sa readThrottle()
+  */
+void ConvertScheduler::setReadLimit(qint64 bytesPerSecond) {
+    readBucket.setRate(bytesPerSecond);
+}
+
+/** Returns limit of bytes read per second or 0 if reading is unlimited. */
+qint64 ConvertScheduler::readLimit() const {
+    return readBucket.rate();
+}
+
+/** Limits bytes written to target files to \a bytesPerSecond bytes per
+  * second. 0 means unlimited writing. It may be called while converting.
+  * \sa writeThrottle()
+  */
+void ConvertScheduler::setWriteLimit(qint64 bytesPerSecond) {
+    writeBucket.setRate(bytesPerSecond);
+}
+
+/** Returns limit of bytes written per second or 0 if writing is unlimited.
+  */
+qint64 ConvertScheduler::writeLimit() const {
+    return writeBucket.rate();
+}
+
+/** Limits CPU time used by worker threads to \a percent percent of all
+  * logical CPUs. 100 means no limit. It may be called while converting.
+  * \sa cpuThrottle()
+  */
+void ConvertScheduler::setCpuShare(int percent) {
+    percent = qBound(1, percent, 100);
+    cpuPercent.storeRelease(percent);
+    // microseconds of CPU time per second
+    const qint64 cpus = ConvertAdaptiveController::logicalCpuCount();
+    cpuBucket.setRate(percent < 100 ? percent * cpus * 10000 : 0);
+}
+
+/** Returns CPU share limit in percent of all logical CPUs. */
+int ConvertScheduler::cpuShare() const {
+    return cpuPercent.loadAcquire();
+}
+
+/** Returns throttle of bytes read by worker threads. \sa setReadLimit() */
+TokenBucket *ConvertScheduler::readThrottle() {
+    return &readBucket;
+}
+
+/** Returns throttle of bytes written by worker threads.
+  * \sa setWriteLimit()
+  */
+TokenBucket *ConvertScheduler::writeThrottle() {
+    return &writeBucket;
+}
+
+/** Returns throttle of CPU time in microseconds used by worker threads.
+  * \sa setCpuShare()
+  */
+TokenBucket *ConvertScheduler::cpuThrottle() {
+    return &cpuBucket;
+}
+
+/** Enables or disables convertion in worker processes. Isolated convert
+  * threads pass jobs to their own worker process, so crash while decoding
+  * broken file kills the worker only; the job is reported as failed and
+  * the worker is restarted for the next job.
+  * \note Call this function when the scheduler isn't busy.
+  * \sa ConvertWorkerProcess
+  */
+void ConvertScheduler::setProcessIsolation(bool enabled) {
+    isolated = enabled;
+}
+
+/** Returns true if jobs are converted in worker processes. */
+bool ConvertScheduler::isProcessIsolated() const {
+    return isolated;
+}
+
+/** Sets \a program started with \a arguments as worker process of isolated
+  * convert threads. Empty \a program means the default program, see
+  * ConvertWorkerProcess::setProgram().
+  * \note Call this function when the scheduler isn't busy.
+  */
+void ConvertScheduler::setWorkerProgram(const QString &program,
+                                        const QStringList &arguments) {
+    workerPath = program;
+    workerArguments = arguments;
+}
+
+/** Returns worker program set by setWorkerProgram(). */
+QString ConvertScheduler::workerProgram() const {
+    return workerPath;
+}
+
+/** Returns arguments of workerProgram(). */
+QStringList ConvertScheduler::workerProgramArguments() const {
+    return workerArguments;
+}
+
+/** Returns serial number of current batch. It changes when start() is
+  * called, so worker processes know when to reload shared information.
+  */
+int ConvertScheduler::batchSerial() const {
+    return serial.loadAcquire();
+}
+
+/** Returns budget of memory for decoded images shared by convert threads.
+  * \sa setMemoryLimit()
+  */
+MemoryBudget *ConvertScheduler::memoryBudget() {
+    return &budget;
+}
+
+/** Returns sum of pixel buffer counters of convert threads, including
+  * threads already removed from the pool. Allocations and page faults
+  * growing much slower than finished jobs count mean the buffers are reused.
+  * \sa ConvertThread::bufferPool() batchBufferStatistics()
+  */
+PixelBufferPool::Statistics ConvertScheduler::bufferStatistics() const {
+    PixelBufferPool::Statistics statistics = retiredBuffers;
+    foreach (ConvertThread *thread, pool)
+        statistics += thread->bufferPool()->statistics();
+    return statistics;
+}
+
+/** Returns pixel buffer counters of current or last batch.
+  * \sa bufferStatistics()
+  */
+PixelBufferPool::Statistics ConvertScheduler::batchBufferStatistics() const {
+    PixelBufferPool::Statistics statistics = bufferStatistics();
+    statistics -= batchBuffers;
+    return statistics;
+}
+
+/** Starts new batch of \a jobs and wakes up sleeping worker threads.
+  * \note Call this function when the scheduler isn't busy.
+  * \sa isBusy() batchFinished()
+  */
+void ConvertScheduler::start(const QList<ConvertJob> &jobs) {
+    adaptiveTimer->stop();
+    batchBuffers = bufferStatistics();
+    if (adaptive) {
+        int maximum = 2 * ConvertAdaptiveController::logicalCpuCount();
+        while (pool.count() < maximum)
+            addThread(&pool, ConvertThread::ConvertStage);
+        controller.start(ConvertAdaptiveController::physicalCoreCount(),
+                         maximum);
+        setActiveThreadCount(controller.threadCount());
+        lastFinishedCount = 0;
+        lastFinishedCost = 0;
+        ConvertAdaptiveController::readCpuTimes(&lastCpuBusy, &lastCpuTotal);
+        adaptiveClock.start();
+        adaptiveTimer->start();
+    }
+
+    // two items per convert thread keep it busy and bound memory usage
+    readQueue.setCapacity(2 * pool.count());
+    writeQueue.setCapacity(2 * pool.count());
+
+    QMutexLocker locker(&idleMutex);
+    token.reset();
+    serial.ref();
+    queue.clear();
+    finishedCount.storeRelease(0);
+    finishedCost.storeRelease(0);
+    foreach (const ConvertJob &job, jobs) {
+        if (!queue.enqueue(job)) {
+            qWarning("ConvertScheduler: jobs queue is full, %d images skipped",
+                     jobs.count() - queue.count());
+            break;
+        }
+    }
+    jobsAvailable.wakeAll();
+    if (jobs.isEmpty())
+        emit batchFinished();
+}
+
+/** Appends \a jobs to current batch and wakes up sleeping worker threads.
+  * Warm threads take the jobs as soon as they finish current ones. Appended
+  * jobs postpone batchFinished() signal, but the signal may be already
+  * emitted if the batch had been finished before; check isBusy() on receive.
+  * \return Count of appended jobs.
+  * \sa start()
+  */
+int ConvertScheduler::append(const QList<ConvertJob> &jobs) {
+    QMutexLocker locker(&idleMutex);
+    int count = 0;
+    foreach (const ConvertJob &job, jobs) {
+        if (!queue.enqueue(job)) {
+            qWarning("ConvertScheduler: jobs queue is full, %d images skipped",
+                     jobs.count() - count);
+            break;
+        }
+        count++;
+    }
+    jobsAvailable.wakeAll();
+    return count;
+}
+
+/** Cancels current batch. Pending and prefetched jobs are removed. Threads
+  * converting or writing images stop at the next checkpoint and remove
+  * partial target files; the threads are kept for next batch.
+  * \sa cancellationToken()
+  */
+void ConvertScheduler::cancel() {
+    token.cancel();
+    ConvertJob job;
+    int drained = 0;
+    while (queue.dequeue(&job))
+        drained++;
+    drained += readQueue.clear();
+    if (drained > 0)
+        finishJobs(drained);
+}
+
+/** Returns token checked by worker threads. The token is cancelled by
+  * cancel() and reset by start().
+  */
+const CancellationToken *ConvertScheduler::cancellationToken() const {
+    return &token;
+}
+
+/** Blocks the calling thread until all jobs of current batch are finished
+  * or \a time milliseconds has elapsed.
+  * \return True if all jobs are finished, otherwise false.
+  * \sa cancel()
+  */
+bool ConvertScheduler::waitForDone(unsigned long time) {
+    QMutexLocker locker(&idleMutex);
+    if (isBusy())
+        batchDone.wait(&idleMutex, time);
+    return !isBusy();
+}
+
+/** Returns true if any job of current batch isn't finished yet. */
+bool ConvertScheduler::isBusy() const {
+    return finishedCount.loadAcquire() < queue.count();
+}
+
+/** Returns count of jobs in current batch. */
+int ConvertScheduler::jobsCount() const {
+    return queue.count();
+}
+
+/** Returns count of finished jobs in current batch. */
+int ConvertScheduler::finishedJobsCount() const {
+    return finishedCount.loadAcquire();
+}
+
+/** Takes next job for \a thread into \a item. Reader threads and convert
+  * threads without readers take jobs from the batch queue; other threads
+  * take items of the previous pipeline stage.
+  * This function is called from worker threads and doesn't block.
+  * \return False if there is no job to take or \a thread isn't active.
+  * \sa passJob()
+  */
+bool ConvertScheduler::takeJob(ConvertThread *thread,
+                               ConvertPipelineItem *item) {
+    switch (thread->stage()) {
+    case ConvertThread::ConvertStage:
+        if (!isActive(thread))
+            return false;
+        if (readerCount() > 0)
+            return readQueue.tryPop(item);
+        break;
+    case ConvertThread::WriteStage:
+        return writeQueue.tryPop(item);
+    default:
+        break;
+    }
+    *item = ConvertPipelineItem();
+    return queue.dequeue(&item->job);
+}
+
+/** Passes \a item processed by \a thread to the next pipeline stage. Blocks
+  * the calling thread while the queue of the next stage is full.
+  * \sa takeJob()
+  */
+void ConvertScheduler::passJob(ConvertThread *thread,
+                               const ConvertPipelineItem &item) {
+    if (thread->stage() == ConvertThread::ReadStage)
+        readQueue.push(item);
+    else
+        writeQueue.push(item);
+}
+
+/** Marks \a job as finished. Emits batchFinished() signal if it was the last
+  * job of current batch.
+  */
+void ConvertScheduler::finishJob(const ConvertJob &job) {
+    finishedCost.fetchAndAddRelaxed(qMax(1, qRound(job.cost * 100)));
+    finishJobs(1);
+}
+
+/** Puts \a thread to sleep until new jobs are available for it.
+  * \return False if \a thread should exit, otherwise true.
+  */
+bool ConvertScheduler::waitForJobs(ConvertThread *thread) {
+    if (thread->stage() == ConvertThread::WriteStage) {
+        writeQueue.waitForItems(stageWaitTime);
+        return thread->isAcceptingWork();
+    }
+    const bool converter = (thread->stage() == ConvertThread::ConvertStage);
+    const bool prefetched = (converter && readerCount() > 0);
+    if (converter)
+        idleCount.ref();
+    idleMutex.lock();
+    forever {
+        if (!thread->isAcceptingWork())
+            break;
+        if (isActive(thread)) {
+            if (converter && hasBandsFor(thread))
+                break;
+            if (prefetched || !queue.isEmpty())
+                break;
+        }
+        jobsAvailable.wait(&idleMutex);
+    }
+    idleMutex.unlock();
+    if (prefetched && bandBatchCount.loadAcquire() == 0)
+        readQueue.waitForItems(stageWaitTime);
+    if (converter)
+        idleCount.deref();
+    return thread->isAcceptingWork();
+}
+
+/** Returns count of convert threads waiting for jobs. */
+int ConvertScheduler::idleThreadCount() const {
+    return idleCount.loadAcquire();
+}
+
+/** Publishes \a bands bands of \a task for idle convert threads and
+  * processes bands in the calling thread until none is left. Next waits
+  * for bands taken by other threads.
+  * \sa runBandTask()
+  */
+void ConvertScheduler::runBands(ConvertBandTask *task, int count, int bands) {
+    ConvertThread *owner = qobject_cast<ConvertThread *>(
+                QThread::currentThread());
+    BandBatch batch(task, count, bands, owner ? owner->numaNode() : -1);
+    idleMutex.lock();
+    bandBatches.append(&batch);
+    bandBatchCount.ref();
+    jobsAvailable.wakeAll();
+    idleMutex.unlock();
+    readQueue.wakeAll();
+
+    int index;
+    while ((index = batch.next.fetchAndAddOrdered(1)) < bands)
+        runBand(&batch, index);
+
+    QMutexLocker locker(&idleMutex);
+    bandBatches.removeOne(&batch);
+    bandBatchCount.deref();
+    while (batch.done.loadAcquire() < bands)
+        bandsDone.wait(&idleMutex);
+}
+
+/** Processes single band published by runBands() if \a thread is active.
+  * \return True if a band was processed, otherwise false.
+  */
+bool ConvertScheduler::runBandTask(ConvertThread *thread) {
+    if (bandBatchCount.loadAcquire() == 0 || !isActive(thread))
+        return false;
+    BandBatch *batch = 0;
+    int index = -1;
+    // the band is claimed under the mutex, so the batch can't be removed
+    // before the band is done
+    idleMutex.lock();
+    const int node = thread->numaNode();
+    foreach (BandBatch *candidate, bandBatches) {
+        // pixel buffers of the image are local to the owner's node
+        if (candidate->node >= 0 && candidate->node != node)
+            continue;
+        index = candidate->next.fetchAndAddOrdered(1);
+        if (index < candidate->bands) {
+            batch = candidate;
+            break;
+        }
+    }
+    idleMutex.unlock();
+    if (!batch)
+        return false;
+    runBand(batch, index);
+    return true;
+}
+
+/** Sets count of threads taking jobs and wakes up sleeping threads. */
+void ConvertScheduler::setActiveThreadCount(int count) {
+    QMutexLocker locker(&idleMutex);
+    activeCount.storeRelease(qMax(1, count));
+    jobsAvailable.wakeAll();
+}
+
+/** Returns true if any band batch has bands to take by \a thread.
+  * \note Call this function with locked #idleMutex.
+  */
+bool ConvertScheduler::hasBandsFor(ConvertThread *thread) const {
+    const int node = thread->numaNode();
+    foreach (BandBatch *batch, bandBatches) {
+        if ((batch->node < 0 || batch->node == node)
+                && batch->next.loadAcquire() < batch->bands)
+            return true;
+    }
+    return false;
+}
+
+/** Sets CPU of convert \a thread following current affinity policy. */
+void ConvertScheduler::updateAffinity(ConvertThread *thread) {
+    const int tid = thread->threadId();
+    thread->setCpu(affinity.cpuForThread(tid), affinity.nodeForThread(tid));
+}
+
+/** Returns false if \a thread is convert thread above active threads count.
+  * \sa activeThreadCount()
+  */
+bool ConvertScheduler::isActive(ConvertThread *thread) const {
+    return thread->stage() != ConvertThread::ConvertStage
+            || thread->threadId() < activeCount.loadAcquire();
+}
+
+/** Measures throughput of finished jobs cost per second and CPU utilisation
+  * since last call and changes active threads count.
+  * \sa ConvertAdaptiveController::update()
+  */
+void ConvertScheduler::adaptThreadCount() {
+    if (!isBusy()) {
+        adaptiveTimer->stop();
+        return;
+    }
+    const int finished = finishedCount.loadAcquire();
+    // wait for enough finished jobs to measure throughput
+    if (finished - lastFinishedCount < activeThreadCount())
+        return;
+    const int cost = finishedCost.loadAcquire();
+    const double seconds = adaptiveClock.restart() / 1000.;
+    if (seconds <= 0.)
+        return;
+    const double throughput = (cost - lastFinishedCost) / seconds;
+    lastFinishedCount = finished;
+    lastFinishedCost = cost;
+
+    double cpuUsage = -1.;
+    qint64 busy = 0;
+    qint64 total = 0;
+    if (ConvertAdaptiveController::readCpuTimes(&busy, &total)
+            && total > lastCpuTotal) {
+        cpuUsage = double(busy - lastCpuBusy) / (total - lastCpuTotal);
+        lastCpuBusy = busy;
+        lastCpuTotal = total;
+    }
+
+    setActiveThreadCount(controller.update(throughput, cpuUsage));
+}
+
+/** Creates and starts new worker thread of pipeline \a stage and appends
+  * it to \a threads list.
+  * \sa ConvertThread::Stage
+  */
+void ConvertScheduler::addThread(QList<ConvertThread *> *threads, int stage) {
+    ConvertThread *thread = new ConvertThread(this, threads->count());
+    thread->setStage(static_cast<ConvertThread::Stage>(stage));
+    thread->setScheduler(this);
+    if (threads == &pool)
+        updateAffinity(thread);
+    threads->append(thread);
+    thread->start();
+}
+
+/** Stops and deletes the last worker thread of \a threads list. */
+void ConvertScheduler::removeThread(QList<ConvertThread *> *threads) {
+    ConvertThread *thread = threads->takeLast();
+    idleMutex.lock();
+    thread->setAcceptWork(false);
+    jobsAvailable.wakeAll();
+    idleMutex.unlock();
+    readQueue.wakeAll();
+    writeQueue.wakeAll();
+    thread->wait();
+    if (threads == &pool) {
+        // idle buffers are freed with the thread
+        PixelBufferPool::Statistics statistics =
+                thread->bufferPool()->statistics();
+        statistics.cachedBytes = 0;
+        retiredBuffers += statistics;
+    }
+    delete thread;
+}
+
+/** Runs band \a index of \a batch and wakes up owner of the batch if it was
+  * the last band.
+  */
+void ConvertScheduler::runBand(BandBatch *batch, int index) {
+    int begin;
+    int end;
+    const int bands = batch->bands;
+    ConvertBands::bandRange(batch->count, bands, index, &begin, &end);
+    // bands of cancelled task are only marked as done
+    if (!batch->task->isCancelled())
+        batch->task->run(begin, end);
+    // the batch may be destroyed after the last band is marked as done
+    if (batch->done.fetchAndAddOrdered(1) + 1 == bands) {
+        idleMutex.lock();
+        bandsDone.wakeAll();
+        idleMutex.unlock();
+    }
+}
+
+/** Increases finished jobs counter by \a count. */
+void ConvertScheduler::finishJobs(int count) {
+    if (finishedCount.fetchAndAddOrdered(count) + count == queue.count()) {
+        idleMutex.lock();
+        batchDone.wakeAll();
+        idleMutex.unlock();
+        emit batchFinished();
+    }
+}
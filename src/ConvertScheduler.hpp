@@ -0,0 +1,216 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTSCHEDULER_HPP
+#define CONVERTSCHEDULER_HPP
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include <QWaitCondition>
+
+#include "BoundedQueue.hpp"
+#include "CancellationToken.hpp"
+#include "ConvertAffinity.hpp"
+#include "ConvertAdaptiveController.hpp"
+#include "ConvertBands.hpp"
+#include "ConvertQueue.hpp"
+#include "MemoryBudget.hpp"
+#include "PixelBufferPool.hpp"
+#include "TokenBucket.hpp"
+
+class ConvertThread;
+class QTimer;
+
+/** \brief Owner of convertion batch and persistent pool of worker threads.
+  *
+  * Batch jobs are stored in lock-free ConvertQueue. Worker threads take jobs
+  * directly from the queue, so they never wait for the GUI thread. Threads
+  * are kept alive between batches and sleep while the queue is empty.
+  *
+  * Convertion is split into pipeline stages. Optional reader threads prefetch
+  * source files, convert threads decode, process and encode images and
+  * optional writer threads write encoded images. The stages are joined by
+  * BoundedQueue objects, so disk latency overlaps with computation. Each
+  * stage has its own threads count; if a stage has no threads its work is
+  * done by convert threads.
+  *
+  * Only first activeThreadCount() convert threads take jobs. In adaptive
+  * mode the active count is changed during the batch by
+  * ConvertAdaptiveController basing on measured throughput.
+  *
+  * Convert threads reserve memory for decoded images in memoryBudget(), so
+  * many threads converting large images don't exhaust physical memory.
+  * Pixel buffers of decoded images are reused by next jobs of the same
+  * thread, see bufferStatistics().
+  *
+  * The scheduler is also ConvertBandExecutor: idle convert threads help to
+  * process row bands of large images converted by busy threads. Convert
+  * threads may be pinned to CPUs, see setAffinityPolicy(); pinned threads
+  * help with bands of images converted on the same NUMA node only.
+  *
+  * Optionally convert threads pass jobs to worker processes, see
+  * setProcessIsolation().
+  *
+  * In background mode bytes read and written and CPU time used by worker
+  * threads are limited by TokenBucket throttles, see setReadLimit(),
+  * setWriteLimit() and setCpuShare(). The limits may be changed while
+  * converting.
+  *
+  * \sa ConvertThread ConvertQueue
+  */
+class ConvertScheduler : public QObject, public ConvertBandExecutor {
+    Q_OBJECT
+
+public:
+    explicit ConvertScheduler(QObject *parent = 0);
+    ~ConvertScheduler();
+
+    void setThreadCount(int count);
+    int threadCount() const;
+    void setReaderCount(int count);
+    int readerCount() const;
+    void setWriterCount(int count);
+    int writerCount() const;
+    QList<ConvertThread*> threads() const;
+    int activeThreadCount() const;
+    void setAdaptive(bool enabled);
+    bool isAdaptive() const;
+    int settledThreadCount() const;
+    void setAffinityPolicy(ConvertAffinity::Policy policy);
+    ConvertAffinity::Policy affinityPolicy() const;
+    void setMemoryLimit(qint64 bytes);
+    MemoryBudget *memoryBudget();
+    PixelBufferPool::Statistics bufferStatistics() const;
+    PixelBufferPool::Statistics batchBufferStatistics() const;
+    void setReadLimit(qint64 bytesPerSecond);
+    qint64 readLimit() const;
+    void setWriteLimit(qint64 bytesPerSecond);
+    qint64 writeLimit() const;
+    void setCpuShare(int percent);
+    int cpuShare() const;
+    TokenBucket *readThrottle();
+    TokenBucket *writeThrottle();
+    TokenBucket *cpuThrottle();
+    void setProcessIsolation(bool enabled);
+    bool isProcessIsolated() const;
+    void setWorkerProgram(const QString &program,
+                          const QStringList &arguments = QStringList());
+    QString workerProgram() const;
+    QStringList workerProgramArguments() const;
+    int batchSerial() const;
+
+    void start(const QList<ConvertJob> &jobs);
+    int append(const QList<ConvertJob> &jobs);
+    void cancel();
+    const CancellationToken *cancellationToken() const;
+    bool waitForDone(unsigned long time = ULONG_MAX);
+    bool isBusy() const;
+    int jobsCount() const;
+    int finishedJobsCount() const;
+
+    bool takeJob(ConvertThread *thread, ConvertPipelineItem *item);
+    void passJob(ConvertThread *thread, const ConvertPipelineItem &item);
+    void finishJob(const ConvertJob &job);
+    bool waitForJobs(ConvertThread *thread);
+
+    int idleThreadCount() const;
+    void runBands(ConvertBandTask *task, int count, int bands);
+    bool runBandTask(ConvertThread *thread);
+
+signals:
+    /** Emitted from worker thread when the last job of the batch is done. */
+    void batchFinished();
+
+private slots:
+    void adaptThreadCount();
+
+private:
+    struct BandBatch;
+
+    ConvertQueue queue;
+    QList<ConvertThread*> pool; /**< Convert threads. */
+    QList<ConvertThread*> readers; /**< Prefetching reader threads. */
+    QList<ConvertThread*> writers; /**< Write-behind writer threads. */
+    /** Count of reader threads readable from worker threads. */
+    QAtomicInt readersCount;
+    /** Count of writer threads readable from worker threads. */
+    QAtomicInt writersCount;
+    BoundedQueue<ConvertPipelineItem> readQueue; /**< Prefetched jobs. */
+    BoundedQueue<ConvertPipelineItem> writeQueue; /**< Encoded jobs. */
+    QAtomicInt finishedCount; /**< Count of finished jobs of current batch. */
+    /** Sum of estimated costs of finished jobs in hundredths.
+      * \sa ConvertJob::cost
+      */
+    QAtomicInt finishedCost;
+    QAtomicInt activeCount; /**< Count of threads taking jobs. */
+    /** Mutex protecting sleep of idle workers.
+      * \sa jobsAvailable waitForJobs()
+      */
+    QMutex idleMutex;
+    QWaitCondition jobsAvailable;
+    QWaitCondition batchDone;
+    // row bands
+    QList<BandBatch*> bandBatches; /**< Band batches with bands to take. */
+    QAtomicInt bandBatchCount; /**< Count of #bandBatches items. */
+    QAtomicInt idleCount; /**< Count of convert threads waiting for jobs. */
+    QWaitCondition bandsDone;
+    MemoryBudget budget; /**< Memory for decoded images. */
+    /** Buffer counters of removed convert threads. */
+    PixelBufferPool::Statistics retiredBuffers;
+    /** Buffer counters at start of current batch. */
+    PixelBufferPool::Statistics batchBuffers;
+    // background mode throttling
+    TokenBucket readBucket; /**< Bytes read per second. */
+    TokenBucket writeBucket; /**< Bytes written per second. */
+    TokenBucket cpuBucket; /**< CPU time in microseconds per second. */
+    QAtomicInt cpuPercent; /**< CPU share in percent. \sa setCpuShare() */
+    CancellationToken token; /**< Cancellation of current batch. */
+    ConvertAffinity affinity; /**< CPUs of convert threads. */
+    bool isolated; /**< Convertion in worker processes indicator. */
+    /** Worker program or empty string for the default program.
+      * \sa setWorkerProgram()
+      */
+    QString workerPath;
+    QStringList workerArguments; /**< Arguments of #workerPath program. */
+    QAtomicInt serial; /**< Serial number of current batch. */
+    // adaptive threads count
+    bool adaptive;
+    ConvertAdaptiveController controller;
+    QTimer *adaptiveTimer;
+    QElapsedTimer adaptiveClock;
+    int lastFinishedCount;
+    int lastFinishedCost;
+    qint64 lastCpuBusy;
+    qint64 lastCpuTotal;
+
+    void setActiveThreadCount(int count);
+    void updateAffinity(ConvertThread *thread);
+    bool hasBandsFor(ConvertThread *thread) const;
+    bool isActive(ConvertThread *thread) const;
+    void addThread(QList<ConvertThread*> *threads, int stage);
+    void removeThread(QList<ConvertThread*> *threads);
+    void finishJobs(int count);
+    void runBand(BandBatch *batch, int index);
+};
+
+#endif // CONVERTSCHEDULER_HPP
@@ -0,0 +1,62 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertStatusRing.hpp"
+
+
+/** Creates empty ring. */
+ConvertStatusRing::ConvertStatusRing() : head(0), tail(0) {}
+
+/** Appends \a record into the ring.
+  * \note Call this function from the producer thread only.
+  * \return False if the ring is full, otherwise true.
+  */
+bool ConvertStatusRing::push(const ConvertStatusRecord &record) {
+    const uint t = tail.load();
+    if (t - uint(head.loadAcquire()) >= uint(Capacity))
+        return false;
+    records[t & (Capacity - 1)] = record;
+    tail.storeRelease(int(t + 1));
+    return true;
+}
+
+/** Takes the oldest record from the ring into \a record.
+  * \note Call this function from the consumer thread only.
+  * \return False if the ring is empty, otherwise true.
+  */
+bool ConvertStatusRing::pop(ConvertStatusRecord *record) {
+    const uint h = head.load();
+    if (h == uint(tail.loadAcquire()))
+        return false;
+    *record = records[h & (Capacity - 1)];
+    head.storeRelease(int(h + 1));
+    return true;
+}
+
+/** Returns true if there is no record to take. */
+bool ConvertStatusRing::isEmpty() const {
+    return head.loadAcquire() == tail.loadAcquire();
+}
+
+/** Returns count of records waiting for the consumer. */
+int ConvertStatusRing::count() const {
+    return int(uint(tail.loadAcquire()) - uint(head.loadAcquire()));
+}
@@ -0,0 +1,66 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTSTATUSRING_HPP
+#define CONVERTSTATUSRING_HPP
+
+#include <QAtomicInt>
+
+
+//! Compact record of convertion status change of single image.
+struct ConvertStatusRecord {
+    ConvertStatusRecord() : jobId(-1), status(0), message(0), elapsed(0) {}
+
+    int jobId; /**< Index of the job within the batch. \sa ConvertJob::id */
+    quint8 status; /**< ConvertThread::Status value. */
+    quint8 message; /**< ConvertThread::StatusMessage value. */
+    quint32 elapsed; /**< Milliseconds since the job was taken. */
+};
+
+/** \brief Fixed size single producer, single consumer ring buffer of
+  *        ConvertStatusRecord objects.
+  *
+  * Each worker thread writes records of its own ring and the GUI thread
+  * drains all rings in bulk on timer tick, so the cost of user interface
+  * updates doesn't depend on count of images converted per second.
+  * Neither push() nor pop() locks a mutex.
+  */
+class ConvertStatusRing {
+public:
+    ConvertStatusRing();
+    bool push(const ConvertStatusRecord &record);
+    bool pop(ConvertStatusRecord *record);
+    bool isEmpty() const;
+    int count() const;
+
+    enum {
+        Capacity = 4096 /**< Count of records; must be power of 2. */
+    };
+
+private:
+    ConvertStatusRecord records[Capacity];
+    QAtomicInt head; /**< Count of records taken by the consumer. */
+    QAtomicInt tail; /**< Count of records published by the producer. */
+
+    Q_DISABLE_COPY(ConvertStatusRing)
+};
+
+#endif // CONVERTSTATUSRING_HPP
@@ -21,29 +21,86 @@
 
 #include "ConvertThread.hpp"
 
+#include "ConvertAffinity.hpp"
 #include "ConvertEffects.hpp"
+#include "ConvertPreflight.hpp"
+#include "ConvertScheduler.hpp"
+#include "ConvertWorker.hpp"
+#include "ImageFormatRegistry.hpp"
+#include "ImageTransform.hpp"
+#include "MappedFile.hpp"
+#include "MemoryBudget.hpp"
+#include "Resampler.hpp"
 #include "Settings.hpp"
+#include "StripReader.hpp"
+#include "StripResampler.hpp"
+#include "StripWriter.hpp"
 #include "SvgModifier.hpp"
+#include "TiffStripReader.hpp"
+#include "TokenBucket.hpp"
 #include "raw/RawImageLoader.hpp"
 #include "raw/RawModel.hpp"
-#include "widgets/MessageBox.hpp"
 
+#include <QBuffer>
 #include <QDebug>
 #include <QDir>
 #include <QImage>
 #include <QPainter>
+#include <QScopedPointer>
 #include <QtSvg/QSvgRenderer>
 
 #include <QImageReader>
 
 #include <cmath>
 
+#ifdef Q_OS_LINUX
+#include <time.h>
+#endif // Q_OS_LINUX
+
 
 using namespace sir;
 
 
 SharedInformation ConvertThread::shared = SharedInformation();
 
+/** Maximum time of single wait for memory budget in milliseconds. It bounds
+  * reaction time of threads waiting for memory on cancel.
+  */
+static const unsigned long memoryWaitTime = 100;
+
+/** Suffix of files being written. The file is renamed to target file path
+  * when it's complete, so cancelled or failed jobs never leave partially
+  * written target file.
+  */
+const char ConvertThread::partFileSuffix[] = ".part";
+
+/** Maximum time of single wait for throttle in milliseconds. */
+static const unsigned long throttleWaitTime = 100;
+
+/** Minimal size of decoded image in bytes converted strip by strip even if
+  * it fits the memory budget. QImage can't hold much larger images.
+  * \sa isStreamed()
+  */
+static const qint64 streamThreshold = Q_INT64_C(1) << 30;
+
+/** Count of bytes read from source file between read throttle calls while
+  * converting strip by strip.
+  */
+static const qint64 stripThrottleChunk = 1 << 20;
+
+/** Returns CPU time used by the calling thread in microseconds or -1 if it's
+  * unknown.
+  * \note Thread CPU time is available on Linux only.
+  */
+static qint64 threadCpuTime() {
+#ifdef Q_OS_LINUX
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+        return qint64(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+#endif // Q_OS_LINUX
+    return -1;
+}
+
 
 // access method to static fields
 /** Returns pointer to static SharedInformation object. */
@@ -60,191 +117,746 @@ void ConvertThread::setSharedInfo(const SharedInformation &info)
   * \param parent parent object
   * \param tid thread ID
   */
-ConvertThread::ConvertThread(QObject *parent, int tid) : QThread(parent) {
+ConvertThread::ConvertThread(QObject *parent, int tid)
+    : QThread(parent), cpu(-1), node(-1) {
     this->tid = tid;
+    pinnedCpu = -1;
+    scheduler = NULL;
+    workerProcess = NULL;
+    usedCpuTime = -1;
+    stageType = ConvertStage;
     work = true;
+    elapsedBefore = 0;
+    cropped = false;
+}
+
+/** Sets scheduler object providing jobs for this thread. */
+void ConvertThread::setScheduler(ConvertScheduler *scheduler) {
+    this->scheduler = scheduler;
+}
+
+/** Sets pipeline \a stage of this thread. Call this function before start().
+  * \sa stage()
+  */
+void ConvertThread::setStage(Stage stage) {
+    stageType = stage;
+}
+
+/** Returns pipeline stage of this thread. Default stage is ConvertStage.
+  * \sa setStage()
+  */
+ConvertThread::Stage ConvertThread::stage() const {
+    return stageType;
 }
 
 void ConvertThread::setAcceptWork(bool work) {
     this->work = work;
 }
 
-void ConvertThread::convertImage(const QString& name, const QString& extension,
-                                 const QString& path) {
-    imageData.clear();
-    imageData << name << extension << path;
-    if(!isRunning())
-        start();
+/** Pins this thread to logical \a cpu of NUMA \a node. The thread changes
+  * its affinity before taking next job. Negative \a cpu unpins the thread.
+  * \sa ConvertAffinity
+  */
+void ConvertThread::setCpu(int cpu, int node) {
+    this->node.storeRelease(cpu < 0 ? -1 : node);
+    this->cpu.storeRelease(cpu);
+}
+
+/** Returns NUMA node this thread is pinned to or -1 if it isn't pinned. */
+int ConvertThread::numaNode() const {
+    return node.loadAcquire();
+}
+
+/** Returns the thread ID, i.e. index of the thread in scheduler's pool. */
+int ConvertThread::threadId() const {
+    return tid;
+}
+
+/** Returns ring buffer of status records reported by this thread.
+  * \sa reportStatus()
+  */
+ConvertStatusRing *ConvertThread::statusRing() {
+    return &statusRecords;
+}
+
+/** Returns pool of pixel buffers of images decoded by this thread.
+  * \sa ConvertScheduler::bufferStatistics()
+  */
+PixelBufferPool *ConvertThread::bufferPool() {
+    return &buffers;
+}
+
+/** Returns translated text of status \a message code.
+  * \sa StatusMessage
+  */
+QString ConvertThread::statusMessage(int message) {
+    switch (message) {
+    case CancelledMessage:
+        return tr("Cancelled");
+    case ConvertingMessage:
+        return tr("Converting");
+    case ConvertedMessage:
+        return tr("Converted");
+    case SkippedMessage:
+        return tr("Skipped");
+    case OpenFailedMessage:
+        return tr("Failed to open original image");
+    case ConvertFailedMessage:
+        return tr("Failed to convert");
+    case SizeComputeFailedMessage:
+        return tr("Failed to compute image size");
+    case SaveFailedMessage:
+        return tr("Failed to save");
+    case SvgOpenFailedMessage:
+        return tr("Failed to open SVG file");
+    case SvgSaveFailedMessage:
+        return tr("Failed to save new SVG file");
+    case ChangedSvgOpenFailedMessage:
+        return tr("Failed to open changed SVG file");
+    case MemoryLimitMessage:
+        return tr("Image is too large for memory limit");
+    case WorkerFailedMessage:
+        return tr("Convertion process crashed");
+    default:
+        return QString();
+    }
+}
+
+/** Returns true if this thread should take next jobs. */
+bool ConvertThread::isAcceptingWork() const {
+    return work;
 }
 
 /** This is main function of thread.\n
-  * Converts selected images to desired size, format and quality.
+  * Takes jobs from the scheduler and processes them as pipeline stage() until
+  * setAcceptWork() is called with false value. The thread sleeps while there
+  * is no job.
+  * \sa readJob() convertJob() writeJob()
   */
 void ConvertThread::run()
 {
-    while(work) {
-        pd.imgData = this->imageData; // imageData change protection by convertImage()
-        sizeComputed = 0;
-        width = shared.width;
-        height = shared.height;
-        hasWidth = shared.hasWidth;
-        hasHeight = shared.hasHeight;
-        bool maintainAspect = shared.maintainAspect;
-        rotate = shared.rotate;
-        angle = shared.angle;
-
-        if (shared.abort) {
-            emit imageStatus(pd.imgData, tr("Cancelled"), Cancelled);
-            getNextOrStop();
+    Q_ASSERT(scheduler != NULL);
+
+    ConvertPipelineItem item;
+    while (work) {
+        updateAffinity();
+        throttleCpu();
+        // help other convert threads with bands of large images
+        if (stageType == ConvertStage && scheduler->runBandTask(this))
             continue;
+        if (!scheduler->takeJob(this, &item)) {
+            // don't keep idle buffers between batches
+            if (!scheduler->isBusy())
+                buffers.trim();
+            scheduler->waitForJobs(this);
+            continue;
+        }
+        job = item.job;
+        switch (stageType) {
+        case ReadStage:
+            readJob(&item);
+            scheduler->passJob(this, item);
+            break;
+        case ConvertStage:
+            if (scheduler->isProcessIsolated()) {
+                // the worker reports statuses only; the job ends here
+                convertInWorker(&item);
+                scheduler->finishJob(job);
+            }
+            else {
+                const qint64 faults = PixelBufferPool::threadPageFaults();
+                const bool passed = convertJob(&item);
+                if (faults >= 0)
+                    buffers.addPageFaults(
+                                PixelBufferPool::threadPageFaults() - faults);
+                if (passed)
+                    scheduler->passJob(this, item);
+                else
+                    scheduler->finishJob(job);
+            }
+            break;
+        case WriteStage:
+            writeJob(item);
+            scheduler->finishJob(job);
+            break;
         }
+        // don't keep the source file mapped while waiting for next job
+        item.sourceData.clear();
+        item.mapping.clear();
+    }
+    // the process must be destroyed in thread which created it
+    delete workerProcess;
+    workerProcess = NULL;
+}
 
-        emit imageStatus(pd.imgData, tr("Converting"), Converting);
+/** Pins this thread to CPU set by setCpu() if it was changed. Buffers of
+  * pinned thread are allocated and first touched on its NUMA node.
+  */
+void ConvertThread::updateAffinity() {
+    const int wanted = cpu.loadAcquire();
+    if (wanted == pinnedCpu)
+        return;
+    ConvertAffinity::pinCurrentThread(wanted);
+    pinnedCpu = wanted;
+}
 
-        QString imageName = pd.imgData.at(0);
-        QString originalFormat = pd.imgData.at(1);
+/** Writes \a status change of current job into status ring buffer.
+  * If the ring is full final statuses wait for the GUI thread drain it,
+  * but transient \em Converting status is dropped.
+  * \sa statusRing()
+  */
+void ConvertThread::reportStatus(Status status, StatusMessage message) {
+    ConvertStatusRecord record;
+    record.jobId = job.id;
+    record.status = status;
+    record.message = message;
+    record.elapsed = elapsedBefore + jobTimer.elapsed();
+    reportStatus(record);
+}
 
-        targetFilePath = shared.destFolder.absolutePath() + QDir::separator();
-        if (!shared.prefix.isEmpty())
-            targetFilePath += shared.prefix + "_";
-        targetFilePath += imageName;
-        if (!shared.suffix.isEmpty())
-            targetFilePath += "_" + shared.suffix;
-        targetFilePath += "." + shared.format;
+/** Writes status \a record into status ring buffer.
+  * \sa reportStatus(Status,StatusMessage)
+  */
+void ConvertThread::reportStatus(const ConvertStatusRecord &record) {
+    while (!statusRecords.push(record)) {
+        if (record.status == Converting || !scheduler)
+            return;
+        msleep(1);
+    }
+}
 
-        pd.imagePath = pd.imgData.at(2) + QDir::separator() + pd.imgData.at(0)
-                     + "." + originalFormat;
-        originalFormat = originalFormat.toLower();
-        bool svgSource(originalFormat == "svg" || originalFormat == "svgz");
+/** Maps source file of \a item into memory and starts reading it in
+  * background unless the job will be skipped or the file isn't regular image.
+  * If the file can't be mapped it's read into buffer of \a item.
+  * \sa convertJob()
+  */
+void ConvertThread::readJob(ConvertPipelineItem *item) {
+    jobTimer.start();
+    bool rejected =
+            job.decisions[ConvertJob::Overwrite] == ConvertJob::Rejected ||
+            job.decisions[ConvertJob::Enlarge] == ConvertJob::Rejected;
+    if (!isCancelled() && !rejected) {
+        const QStringList &imageData = job.imageData;
+        QString imagePath = imageData.at(2) + QDir::separator()
+                + imageData.at(0) + "." + imageData.at(1);
+        QSharedPointer<MappedFile> mapping(new MappedFile(imagePath));
+        sourceData = mapping->data();
+        sourceFormat.clear();
+        // RAW and SVG files are loaded by external libraries from path
+        if (isRegularImageToLoad(imagePath) &&
+                throttle(readThrottle(), QFileInfo(imagePath).size())) {
+            if (mapping->isMapped()) {
+                mapping->prefetch();
+                item->mapping = mapping;
+                item->sourceData = sourceData;
+            }
+            // files larger than byte array limit are read strip by strip
+            else if (QFileInfo(imagePath).size() <= INT_MAX) {
+                QFile file(imagePath);
+                if (file.open(QIODevice::ReadOnly))
+                    item->sourceData = file.readAll();
+            }
+        }
+        sourceData.clear();
+    }
+    item->elapsed = jobTimer.elapsed();
+}
 
-        QImage *image = loadImage(pd.imagePath, &shared.rawModel, svgSource);
+/** Starts processing \a item job: resets job timer and copies convertion
+  * parameters of the job.
+  */
+void ConvertThread::beginJob(ConvertPipelineItem *item) {
+    jobTimer.start();
+    elapsedBefore = item->elapsed;
+    sourceData = item->sourceData;
+    sourceFormat.clear();
+    pd.imgData = job.imageData;
+    pd.imagePath = pd.imgData.at(2) + QDir::separator() + pd.imgData.at(0)
+                 + "." + pd.imgData.at(1);
+    sizeComputed = 0;
+    regionSize = QSize();
+    cropped = false;
+    streamed = false;
+    width = shared.width;
+    height = shared.height;
+    hasWidth = shared.hasWidth;
+    hasHeight = shared.hasHeight;
+    rotate = shared.rotate;
+    angle = shared.angle;
+}
 
-        if (!image) {
-            getNextOrStop();
-            continue;
-        }
-        if(image->isNull()) {
-            //For some reason we where not able to open the image file
-            emit imageStatus(pd.imgData, tr("Failed to open original image"),
-                             Failed);
-            delete image;
-            //Ask for the next image and go to the beginning of the loop
-            getNextOrStop();
-            continue;
-        }
+/** Converts image described by \a item to desired size, format and quality.
+  * If writer threads are available the encoded image is stored in \a item
+  * instead of writing into target file.
+  * \return True if \a item must be passed to writer thread, otherwise false.
+  * \sa readJob() writeJob()
+  */
+bool ConvertThread::convertJob(ConvertPipelineItem *item)
+{
+    beginJob(item);
+    // the mapping of source file is released when this function returns
+    QSharedPointer<MappedFile> mapping = item->mapping;
+    item->mapping.clear();
+    item->sourceData.clear();
+    bool maintainAspect = shared.maintainAspect;
+
+    if (cancelCheckpoint())
+        return false;
+
+    // rejected by the user before convertion
+    if (job.decisions[ConvertJob::Overwrite] == ConvertJob::Rejected ||
+            job.decisions[ConvertJob::Enlarge] == ConvertJob::Rejected) {
+        reportStatus(Skipped, SkippedMessage);
+        return false;
+    }
+
+    reportStatus(Converting, ConvertingMessage);
+
+    QString originalFormat = pd.imgData.at(1);
+
+    targetFilePath = job.targetFilePath;
+    if (targetFilePath.isEmpty())
+        targetFilePath = ConvertPreflight(&shared).targetFilePath(pd.imgData);
+
+    originalFormat = originalFormat.toLower();
+    bool svgSource(originalFormat == "svg" || originalFormat == "svgz");
+
+    // decoders and Exiv2 read the same mapping of not prefetched file
+    const bool prefetched = !sourceData.isEmpty();
+    if (!prefetched && !svgSource) {
+        mapping = QSharedPointer<MappedFile>(new MappedFile(pd.imagePath));
+        sourceData = mapping->data();
+    }
+
+    // the reservation is released when this function returns
+    MemoryReservation reservation(scheduler ? scheduler->memoryBudget() : 0);
+    if (!reserveMemory(&reservation, svgSource))
+        return false;
+    // huge images are never decoded as a whole
+    if (streamed) {
+        QScopedPointer<StripReader> reader(
+                    StripReader::open(pd.imagePath, sourceFormat));
+        if (reader)
+            return convertStrips(item, reader.data());
+    }
+    if (!prefetched &&
+            !throttle(readThrottle(), QFileInfo(pd.imagePath).size())) {
+        reportStatus(Cancelled, CancelledMessage);
+        return false;
+    }
+
+    QImage *image = loadImage(pd.imagePath, &shared.rawModel, svgSource);
+
+    if (!image)
+        return false;
+    if(image->isNull()) {
+        //For some reason we where not able to open the image file
+        reportStatus(Failed, OpenFailedMessage);
+        delete image;
+        return false;
+    }
+    if (cancelCheckpoint()) {
+        delete image;
+        return false;
+    }
+    // SVG image is rendered in desired size, so it isn't cropped
+    if (!svgSource)
+        cropImage(image);
 #ifdef SIR_METADATA_SUPPORT
-        // read metadata
-        saveMetadata = false;
-        if (shared.metadataEnabled) {
+    // read metadata
+    saveMetadata = false;
+    if (shared.metadataEnabled) {
+        if (sourceData.isEmpty())
             saveMetadata = metadata.read(pd.imagePath, true, svgSource);
-            int beta = MetadataUtils::Exif::rotationAngle(
-                        metadata.exifStruct()->orientation);
-            if (!saveMetadata)
-                printError();
-            // flip-flap width-height (px only)
-            else if (angle == 0 && shared.sizeUnit != 1 && beta%90 == 0 && beta%180 != 0) {
-                int temp = width;
-                width = height;
-                height = temp;
-                bool tmp = hasWidth;
-                hasWidth = hasHeight;
-                hasHeight = tmp;
-            }
-            if (saveMetadata)
-                saveMetadata = shared.saveMetadata;
+        else
+            saveMetadata = metadata.read(pd.imagePath, sourceData, true);
+        int beta = MetadataUtils::Exif::rotationAngle(
+                    metadata.exifStruct()->orientation);
+        if (!saveMetadata)
+            printError();
+        // flip-flap width-height (px only)
+        else if (angle == 0 && shared.sizeUnit != 1 && beta%90 == 0 && beta%180 != 0) {
+            int temp = width;
+            width = height;
+            height = temp;
+            bool tmp = hasWidth;
+            hasWidth = hasHeight;
+            hasHeight = tmp;
         }
+        if (saveMetadata)
+            saveMetadata = shared.saveMetadata;
+    }
 #endif // SIR_METADATA_SUPPORT
-        // compute dest size in px
-        if (sizeComputed == 0) { // false if converting from SVG file
-                sizeComputed = computeSize(image,pd.imagePath);
-            if (sizeComputed == 1) { // image saved
-                delete image;
-                getNextOrStop();
-                continue;
-            }
-        }
-        // ask enlarge
-        if (sizeComputed == -3 || askEnlarge(*image,pd.imagePath) < 0) {
+    sourceData.clear();
+    // compute dest size in px
+    if (sizeComputed == 0) { // false if converting from SVG file
+        sizeComputed = computeSize(image,pd.imagePath);
+        if (sizeComputed == 1 || sizeComputed == -5) { // saved or cancelled
             delete image;
-            getNextOrStop();
-            continue;
-        }
-        // create null destination image object
-        QImage destImg;
-        // scale image
-        if (hasWidth && hasHeight) {
-            if (maintainAspect)
-                destImg = image->scaled(width, height, Qt::KeepAspectRatio,
-                                        Qt::SmoothTransformation);
-            else
-                destImg = image->scaled(width, height, Qt::IgnoreAspectRatio,
-                                        Qt::SmoothTransformation);
+            return false;
         }
-        else if (hasWidth && !hasHeight)
-            destImg = image->scaledToWidth(width, Qt::SmoothTransformation);
-        else if (!hasWidth && hasHeight)
-            destImg = image->scaledToHeight(height, Qt::SmoothTransformation);
-        else if (!hasWidth && !hasHeight)
-            destImg = *image;
-        // paint effects
-        destImg = paintEffects(&destImg);
-        // rotate image and update thumbnail
-        destImg = rotateImage(destImg);
+    }
+    // check enlarge
+    if (sizeComputed == -3 || checkEnlarge(image->size()) < 0) {
+        delete image;
+        return false;
+    }
+    // create null destination image object
+    QImage destImg;
+    // scale image; large images are scaled in bands by idle threads
+    QSize destSize;
+    if (hasWidth && hasHeight) {
+        if (maintainAspect)
+            destSize = image->size().scaled(width, height, Qt::KeepAspectRatio);
+        else
+            destSize = QSize(width, height);
+    }
+    else if (hasWidth && !hasHeight)
+        destSize = QSize(width, qRound(image->height() * (qreal(width)
+                                                          / image->width())));
+    else if (!hasWidth && hasHeight)
+        destSize = QSize(qRound(image->width() * (qreal(height)
+                                                  / image->height())), height);
+    if (destSize.isValid())
+        destImg = scaledImage(*image, destSize);
+    else
+        destImg = *image;
+    delete image;
+    if (cancelCheckpoint())
+        return false;
+    return saveImage(item, &destImg);
+}
+
+/** Paints effects on scaled \a destImg image of current job, rotates it and
+  * saves it into target file. If writer threads are available the encoded
+  * image is stored in \a item instead.
+  * \return True if \a item must be passed to writer thread, otherwise false.
+  * \sa convertJob() convertStrips()
+  */
+bool ConvertThread::saveImage(ConvertPipelineItem *item, QImage *destImg) {
+    // paint effects
+    paintEffects(destImg);
+    if (cancelCheckpoint())
+        return false;
+    // rotate image and update thumbnail
+    *destImg = rotateImage(*destImg);
 #ifdef SIR_METADATA_SUPPORT
-        updateThumbnail(destImg);
+    updateThumbnail(*destImg);
 #endif // SIR_METADATA_SUPPORT
-        // ask overwrite
-        if ( QFile::exists( targetFilePath ) &&
-             !(shared.overwriteAll || shared.abort || shared.noOverwriteAll)) {
-            if (!(shared.overwriteAll || shared.abort || shared.noOverwriteAll)) {
-                shared.mutex.lock();
-                emit question(targetFilePath, Overwrite);
-                shared.mutex.unlock();
-            }
-            if(shared.overwriteResult == QMessageBox::Yes ||
-                    shared.overwriteResult == QMessageBox::YesToAll) {
-                if (destImg.save(targetFilePath, 0, shared.quality)) {
+    // images with metadata are written here, because exiv2 edits saved file
+    bool writeBehind = scheduler && scheduler->writerCount() > 0;
 #ifdef SIR_METADATA_SUPPORT
-                    if (saveMetadata && !metadata.write(targetFilePath, destImg))
-                        printError();
+    writeBehind = writeBehind && !saveMetadata;
 #endif // SIR_METADATA_SUPPORT
-                    emit imageStatus(pd.imgData, tr("Converted"), Converted);
-                }
-                else
-                    emit imageStatus(pd.imgData, tr("Failed to convert"), Failed);
-            }
-            else if (shared.overwriteResult == QMessageBox::Cancel)
-                emit imageStatus(pd.imgData, tr("Cancelled"), Cancelled);
-            else
-                emit imageStatus(pd.imgData, tr("Skipped"), Skipped);
+    bool passed = false;
+    // save image
+    if (isCancelled())
+        reportStatus(Cancelled, CancelledMessage);
+    else if (isOverwriteRejected())
+        reportStatus(Skipped, SkippedMessage);
+    else if (writeBehind) {
+        item->targetData.clear();
+        QBuffer buffer(&item->targetData);
+        buffer.open(QIODevice::WriteOnly);
+        QByteArray format = QFileInfo(targetFilePath).suffix().toLatin1();
+        if (destImg->save(&buffer, format.constData(), shared.quality)) {
+            item->targetFilePath = targetFilePath;
+            item->elapsed = elapsedBefore + jobTimer.elapsed();
+            passed = true;
         }
-        else if (shared.noOverwriteAll)
-            emit imageStatus(pd.imgData, tr("Skipped"), Skipped);
-        else if (shared.abort)
-            emit imageStatus(pd.imgData, tr("Cancelled"), Cancelled);
-        else { // when overwriteAll is true or file not exists
-            if (destImg.save(targetFilePath, 0, shared.quality)) {
+        else
+            reportStatus(Failed, ConvertFailedMessage);
+    }
+    else {
+        const QString partFilePath = targetFilePath + partFileSuffix;
+        QByteArray format = QFileInfo(targetFilePath).suffix().toLatin1();
+        bool saved = destImg->save(partFilePath, format.constData(),
+                                   shared.quality);
+#ifdef SIR_METADATA_SUPPORT
+        if (saved && saveMetadata && !metadata.write(partFilePath, *destImg))
+            printError();
+#endif // SIR_METADATA_SUPPORT
+        if (!saved)
+            reportStatus(Failed, ConvertFailedMessage);
+        else
+            throttle(writeThrottle(), QFileInfo(partFilePath).size());
+        finishPartFile(partFilePath, saved);
+    }
+    return passed;
+}
+
+/** Converts huge image of current job read by \a reader strip by strip.
+  * Source rows are cropped and resampled by StripResampler as soon as they
+  * are read, so the source image is never decoded as a whole. Resampled rows
+  * are written directly into target file if it's possible, see
+  * isStripWritable(); otherwise they are assembled into destination image
+  * saved by saveImage().
+  * \note Metadata aren't copied into target file written row by row.
+  * \return True if \a item must be passed to writer thread, otherwise false.
+  * \sa isStreamed()
+  */
+bool ConvertThread::convertStrips(ConvertPipelineItem *item,
+                                  StripReader *reader) {
+    QRect region(QPoint(0, 0), reader->size());
+    const QRect crop = ConvertPreflight(&shared).cropRect(region.size());
+    if (crop.isValid()) {
+        region = crop;
+        cropped = true;
+    }
+    QSize destSize = plannedSize(region.size(), false);
+    if (!destSize.isValid())
+        destSize = region.size();
+    width = destSize.width();
+    height = destSize.height();
+    if (checkEnlarge(region.size()) < 0)
+        return false;
 #ifdef SIR_METADATA_SUPPORT
-                if (saveMetadata && !metadata.write(targetFilePath, destImg))
-                    printError();
+    saveMetadata = false;
+    if (shared.metadataEnabled) {
+        saveMetadata = metadata.read(pd.imagePath, true, false);
+        if (!saveMetadata)
+            printError();
+        saveMetadata = saveMetadata && shared.saveMetadata;
+    }
 #endif // SIR_METADATA_SUPPORT
-                emit imageStatus(pd.imgData, tr("Converted"), Converted);
+    if (isOverwriteRejected()) {
+        reportStatus(Skipped, SkippedMessage);
+        return false;
+    }
+
+    const QString partFilePath = targetFilePath + partFileSuffix;
+    const bool alpha = reader->hasAlphaChannel();
+    QScopedPointer<StripWriter> writer;
+    if (isStripWritable())
+        writer.reset(StripWriter::create(
+                         partFilePath,
+                         QFileInfo(targetFilePath).suffix().toLower().toLatin1(),
+                         destSize, alpha));
+    ImageStripWriter *imageWriter = 0;
+    if (!writer) {
+        imageWriter = new ImageStripWriter(destSize, alpha);
+        writer.reset(imageWriter);
+    }
+
+    // TIFF blocks are decoded by idle threads
+    reader->setBandExecutor(scheduler);
+    reader->setCancellationToken(cancellationToken());
+    StripResampler resampler(region.size(), destSize,
+                             Resampler::toFilter(shared.resamplingFilter));
+    QVector<QRgb> sourceRow(reader->size().width());
+    QVector<QRgb> destRow(destSize.width());
+    reader->skipRows(region.top());
+    qint64 readBytes = 0;
+    bool failed = false;
+    for (int y=0; y<region.height() && !failed; y++) {
+        if (!reader->readRow(sourceRow.data())) {
+            // decoding stops when the batch is cancelled
+            if (!cancelCheckpoint())
+                reportStatus(Failed, OpenFailedMessage);
+            failed = true;
+        }
+        else
+            resampler.pushRow(sourceRow.constData() + region.left());
+        while (!failed && resampler.takeRow(destRow.data())) {
+            if (!writer->writeRow(destRow.constData())) {
+                reportStatus(Failed, ConvertFailedMessage);
+                failed = true;
             }
-            else
-                emit imageStatus(pd.imgData, tr("Failed to convert"), Failed);
         }
-        delete image;
-        getNextOrStop();
+        readBytes += 4 * sourceRow.size();
+        if (!failed && readBytes >= stripThrottleChunk) {
+            // the throttle fails only if the batch was cancelled
+            throttle(readThrottle(), readBytes);
+            failed = cancelCheckpoint();
+            readBytes = 0;
+        }
+    }
+    if (failed || cancelCheckpoint()) {
+        writer.reset();
+        if (!imageWriter)
+            finishPartFile(partFilePath, false);
+        return false;
     }
+    if (imageWriter) {
+        QImage destImg = imageWriter->image();
+        writer.reset();
+        return saveImage(item, &destImg);
+    }
+    const bool written = writer->finish();
+    if (!written)
+        reportStatus(Failed, ConvertFailedMessage);
+    else
+        throttle(writeThrottle(), QFileInfo(partFilePath).size());
+    finishPartFile(partFilePath, written);
+    return false;
+}
+
+/** Converts \a item job in worker process and reports its status. Memory
+  * for decoded image is reserved in this process, so worker processes share
+  * the memory budget of the scheduler. The caller finishes the job on each
+  * path, including cancellation and rejected memory reservation.
+  * \sa ConvertScheduler::setProcessIsolation() ConvertWorkerProcess
+  */
+void ConvertThread::convertInWorker(ConvertPipelineItem *item) {
+    beginJob(item);
+    if (cancelCheckpoint())
+        return;
+    bool rejected =
+            job.decisions[ConvertJob::Overwrite] == ConvertJob::Rejected ||
+            job.decisions[ConvertJob::Enlarge] == ConvertJob::Rejected;
+    const QString originalFormat = pd.imgData.at(1).toLower();
+    MemoryReservation reservation(scheduler->memoryBudget());
+    bool reserved = rejected || reserveMemory(&reservation,
+                                              originalFormat == "svg" ||
+                                              originalFormat == "svgz");
+    sourceData.clear();
+    if (!reserved)
+        return;
+    if (!rejected && item->sourceData.isEmpty() &&
+            !throttle(readThrottle(), QFileInfo(pd.imagePath).size())) {
+        reportStatus(Cancelled, CancelledMessage);
+        return;
+    }
+    if (!workerProcess) {
+        workerProcess = new ConvertWorkerProcess();
+        if (!scheduler->workerProgram().isEmpty())
+            workerProcess->setProgram(scheduler->workerProgram(),
+                                      scheduler->workerProgramArguments());
+    }
+    QElapsedTimer workerTimer;
+    workerTimer.start();
+    foreach (const ConvertStatusRecord &record,
+             workerProcess->convert(*item, scheduler->batchSerial(),
+                                    cancellationToken())) {
+        if (record.status == Converted && !job.targetFilePath.isEmpty())
+            throttle(writeThrottle(), QFileInfo(job.targetFilePath).size());
+        reportStatus(record);
+    }
+    item->sourceData.clear();
+    // CPU time of the worker process isn't measured; charge its wall time
+    throttle(cpuThrottle(), workerTimer.elapsed() * 1000);
+}
+
+/** Writes image encoded by convert thread into target file of \a item.
+  * \sa convertJob()
+  */
+void ConvertThread::writeJob(const ConvertPipelineItem &item) {
+    jobTimer.start();
+    elapsedBefore = item.elapsed;
+    targetFilePath = item.targetFilePath;
+    if (isCancelled())
+        reportStatus(Cancelled, CancelledMessage);
+    else if (isOverwriteRejected())
+        reportStatus(Skipped, SkippedMessage);
+    else if (!throttle(writeThrottle(), item.targetData.size()))
+        reportStatus(Cancelled, CancelledMessage);
+    else {
+        QFile file(targetFilePath + partFileSuffix);
+        bool written = file.open(QIODevice::WriteOnly)
+                && file.write(item.targetData) == item.targetData.size();
+        file.close();
+        if (!written)
+            reportStatus(Failed, SaveFailedMessage);
+        finishPartFile(file.fileName(), written);
+    }
+}
+
+/** Returns throttle of read bytes or null pointer if this thread has no
+  * scheduler.
+  */
+TokenBucket *ConvertThread::readThrottle() const {
+    return scheduler ? scheduler->readThrottle() : 0;
 }
 
-/** Gets next image for converting or stops this thread. */
-void ConvertThread::getNextOrStop() {
-    static QMutex m;
-    QMutexLocker locker(&m);
-    emit getNextImage(this->tid);
+/** Returns throttle of written bytes or null pointer if this thread has no
+  * scheduler.
+  */
+TokenBucket *ConvertThread::writeThrottle() const {
+    return scheduler ? scheduler->writeThrottle() : 0;
 }
 
+/** Returns throttle of CPU time or null pointer if this thread has no
+  * scheduler.
+  */
+TokenBucket *ConvertThread::cpuThrottle() const {
+    return scheduler ? scheduler->cpuThrottle() : 0;
+}
+
+/** Takes \a amount tokens from \a bucket and waits while the bucket is in
+  * debt. Null \a bucket means no throttling.
+  * \return False if the batch was cancelled while waiting, otherwise true.
+  */
+bool ConvertThread::throttle(TokenBucket *bucket, qint64 amount) {
+    if (!bucket || amount <= 0)
+        return true;
+    bucket->consume(amount);
+    while (!bucket->wait(throttleWaitTime)) {
+        if (isCancelled())
+            return false;
+    }
+    return true;
+}
+
+/** Charges CPU throttle with CPU time used by this thread since the last
+  * call and waits if CPU share of worker threads is exceeded.
+  * \sa ConvertScheduler::setCpuShare()
+  */
+void ConvertThread::throttleCpu() {
+    const qint64 cpuTime = threadCpuTime();
+    if (usedCpuTime >= 0 && cpuTime > usedCpuTime)
+        throttle(cpuThrottle(), cpuTime - usedCpuTime);
+    usedCpuTime = cpuTime;
+}
+
+/** Returns token of current batch cancellation or null pointer if this
+  * thread has no scheduler.
+  */
+const CancellationToken *ConvertThread::cancellationToken() const {
+    return scheduler ? scheduler->cancellationToken() : 0;
+}
+
+/** Returns true if current batch was cancelled. */
+bool ConvertThread::isCancelled() const {
+    const CancellationToken *token = cancellationToken();
+    return token && token->isCancelled();
+}
+
+/** Checks cancellation between convertion steps. Reports current job as
+  * cancelled if the batch was cancelled.
+  * \return True if the job must be stopped, otherwise false.
+  */
+bool ConvertThread::cancelCheckpoint() {
+    if (!isCancelled())
+        return false;
+    reportStatus(Cancelled, CancelledMessage);
+    return true;
+}
+
+/** Replaces target file with complete \a partFilePath file if it was
+  * \a written and the batch wasn't cancelled meanwhile; otherwise removes
+  * the partial file. Reports final status of the job except failed writing.
+  */
+void ConvertThread::finishPartFile(const QString &partFilePath, bool written) {
+    if (!written) {
+        QFile::remove(partFilePath);
+        return;
+    }
+    if (isCancelled()) {
+        QFile::remove(partFilePath);
+        reportStatus(Cancelled, CancelledMessage);
+        return;
+    }
+    if (QFile::exists(targetFilePath))
+        QFile::remove(targetFilePath);
+    if (QFile::rename(partFilePath, targetFilePath))
+        reportStatus(Converted, ConvertedMessage);
+    else {
+        QFile::remove(partFilePath);
+        reportStatus(Failed, SaveFailedMessage);
+    }
+}
+
+
 #ifdef SIR_METADATA_SUPPORT
 /** Prints metadata error message on standard error output. This function is
   * available if SIR_METADATA_SUPPORT is defined only.
@@ -259,7 +871,21 @@ void ConvertThread::printError() {
 }
 #endif // SIR_METADATA_SUPPORT
 
-/** Rotates \a image object and returns new QImage object.
+/** Returns \a image scaled to \a size by Resampler using the filter chosen
+  * by the user. Large images are scaled in bands by idle threads and the
+  * result is allocated from pixel buffers of this thread.
+  * \return Scaled image or null image if the batch was cancelled.
+  */
+QImage ConvertThread::scaledImage(const QImage &image, const QSize &size) {
+    Resampler resampler(Resampler::toFilter(shared.resamplingFilter));
+    resampler.setBandExecutor(scheduler);
+    resampler.setCancellationToken(cancellationToken());
+    resampler.setBufferPool(&buffers);
+    return resampler.scaled(image, size);
+}
+
+/** Rotates \a image object and returns new QImage object. Rotations by
+  * multiples of 90 degrees and mirrors are exact, see ImageTransform.
   * \return Rotated image if just rotated, without metadata manipulation.
   *         Otherwise returns a copy of \a image object.
   */
@@ -339,7 +965,11 @@ QImage ConvertThread::rotateImage(const QImage &image) {
         }
 #endif // SIR_METADATA_SUPPORT
         transform.rotate(angle);
-        return image.transformed(transform, Qt::SmoothTransformation);
+        // quarter turns and mirrors only move pixels
+        ImageTransform transformation;
+        transformation.setBandExecutor(scheduler);
+        transformation.setBufferPool(&buffers);
+        return transformation.transformed(image, transform);
 #ifdef SIR_METADATA_SUPPORT
     }
 #endif // SIR_METADATA_SUPPORT
@@ -359,8 +989,8 @@ void ConvertThread::updateThumbnail(const QImage &image) {
         MetadataUtils::ExifStruct *exifStruct = metadata.exifStruct();
         int w = exifStruct->thumbnailWidth.split(' ').first().toInt();
         int h = exifStruct->thumbnailHeight.split(' ').first().toInt();
-        QImage tmpImg = image.scaled(w,h, Qt::KeepAspectRatio,
-                                      Qt::SmoothTransformation);
+        QImage tmpImg = scaledImage(image, image.size().scaled(
+                                        w, h, Qt::KeepAspectRatio));
         bool specialRotate = (rotate && (int)angle%90 != 0);
         QImage *thumbnail = &exifStruct->thumbnailImage;
         if (specialRotate) {
@@ -389,7 +1019,7 @@ void ConvertThread::updateThumbnail(const QImage &image) {
                 transform.scale(1.0,-1.0);
             else if (flip == MetadataUtils::Horizontal)
                 transform.scale(-1.0,1.0);
-            *thumbnail = thumbnail->transformed(transform);
+            *thumbnail = ImageTransform().transformed(*thumbnail, transform);
         }
         if (!metadata.setExifThumbnail(thumbnail,tid))
             printError();
@@ -400,7 +1030,8 @@ void ConvertThread::updateThumbnail(const QImage &image) {
 /** This is overloaded function. It's version for \e normal, raster image.
   *
   * Sets required image size.
-  * \return negative value when an error has occured
+  * \return negative value when an error has occured; -5 when the convertion
+  *         was cancelled
   * \return 0 when an unsupported SharedInformation::sizeUnit value was set
   * \return 1 when success (for 2 (\e bytes) value of SharedInformation::sizeUnit only)
   */
@@ -408,8 +1039,10 @@ char ConvertThread::computeSize(const QImage *image, const QString &imagePath) {
     if (shared.sizeUnit == 0) ; // px
     // compute size when it wasn't typed in pixels
     else if (shared.sizeUnit == 1) { // %
-        width *= image->width() / 100.;
-        height *= image->height() / 100.;
+        // percents of the source image, which could be scaled on decode
+        const QSize size = regionSize.isValid() ? regionSize : image->size();
+        width *= size.width() / 100.;
+        height *= size.height() / 100.;
     }
     else if (shared.sizeUnit == 2) { // bytes
         width = image->width();
@@ -417,7 +1050,7 @@ char ConvertThread::computeSize(const QImage *image, const QString &imagePath) {
         hasWidth = true;
         hasHeight = true;
         double destSize = shared.sizeBytes;
-        if (isLinearFileSizeFormat(&destSize)) {
+        if (ConvertPreflight(&shared).isLinearFileSizeFormat(&destSize)) {
             double sourceSizeSqrt = sqrt(width * height);
             double sourceWidthRatio = width / sourceSizeSqrt;
             double sourceHeightRatio = height / sourceSizeSqrt;
@@ -435,13 +1068,19 @@ char ConvertThread::computeSize(const QImage *image, const QString &imagePath) {
             fileSizeRatio = sqrt(fileSizeRatio);
             QFile tempFile(tempFilePath);
             for (uchar i=0; i<10 && (fileSizeRatio<0.97412 || fileSizeRatio>1.); i++) {
+                if (cancelCheckpoint()) {
+                    tempFile.remove();
+                    return -5;
+                }
                 tempFile.open(QIODevice::WriteOnly);
                 tempFile.seek(0);
                 width = size.width() / fileSizeRatio;
                 height = size.height() / fileSizeRatio;
-                tempImage = image->scaled(width, height, Qt::IgnoreAspectRatio,
-                                             Qt::SmoothTransformation);
-                tempImage = paintEffects(&tempImage);
+                tempImage = scaledImage(*image, QSize(width, height));
+                // scaling stops when the batch is cancelled
+                if (tempImage.isNull())
+                    continue;
+                paintEffects(&tempImage);
                 tempImage = rotateImage(tempImage);
 #ifdef SIR_METADATA_SUPPORT
                 updateThumbnail(tempImage);
@@ -456,8 +1095,7 @@ char ConvertThread::computeSize(const QImage *image, const QString &imagePath) {
                     qWarning("tid %d: Save temporary image file "
                              "into %s failed", tid,
                              String(targetFilePath).toNativeStdString().data() );
-                    emit imageStatus(imageData, tr("Failed to compute image size"),
-                                     Failed);
+                    reportStatus(Failed, SizeComputeFailedMessage);
                     return -4;
                 }
                 tempFile.close();
@@ -466,11 +1104,11 @@ char ConvertThread::computeSize(const QImage *image, const QString &imagePath) {
                 fileSizeRatio = (double) fileSize / shared.sizeBytes;
                 fileSizeRatio = sqrt(fileSizeRatio);
             }
-            // ask enlarge
-            if (askEnlarge(*image,imagePath) < 0)
+            // check enlarge
+            if (checkEnlarge(image->size()) < 0)
                 return -3;
-            // ask overwrite
-            char answer = askOverwrite(&tempFile);
+            // save target file
+            char answer = copyTempFile(&tempFile);
             if (answer < 0)
                 return answer;
         }
@@ -482,7 +1120,8 @@ char ConvertThread::computeSize(const QImage *image, const QString &imagePath) {
 /** This is overloaded function. It's version for SVG vector image.
   *
   * Sets required image size.
-  * \return negative value when an error has occured
+  * \return negative value when an error has occured; -5 when the convertion
+  *         was cancelled
   * \return 0 when an unsupported SharedInformation::sizeUnit value was set
   * \return 1 when success (for 2 (\e bytes) value of SharedInformation::sizeUnit only)
   */
@@ -502,7 +1141,7 @@ char ConvertThread::computeSize(QSvgRenderer *renderer, const QString &imagePath
         hasWidth = true;
         hasHeight = true;
         double destSize = shared.sizeBytes;
-        if (isLinearFileSizeFormat(&destSize)) {
+        if (ConvertPreflight(&shared).isLinearFileSizeFormat(&destSize)) {
             double sourceSizeSqrt = sqrt(width * height);
             double sourceWidthRatio = width / sourceSizeSqrt;
             double sourceHeightRatio = height / sourceSizeSqrt;
@@ -520,6 +1159,10 @@ char ConvertThread::computeSize(QSvgRenderer *renderer, const QString &imagePath
             QFile tempFile(tempFilePath);
             QPainter painter;
             for (uchar i=0; i<10 && (fileSizeRatio<0.97412 || fileSizeRatio>1.); i++) {
+                if (cancelCheckpoint()) {
+                    tempFile.remove();
+                    return -5;
+                }
                 tempFile.open(QIODevice::WriteOnly);
                 tempFile.seek(0);
                 width = size.width() / fileSizeRatio;
@@ -529,7 +1172,7 @@ char ConvertThread::computeSize(QSvgRenderer *renderer, const QString &imagePath
                 painter.begin(&tempImage);
                 renderer->render(&painter);
                 painter.end();
-                tempImage = paintEffects(&tempImage);
+                paintEffects(&tempImage);
                 tempImage = rotateImage(tempImage);
 #ifdef SIR_METADATA_SUPPORT
                 updateThumbnail(tempImage);
@@ -545,8 +1188,7 @@ char ConvertThread::computeSize(QSvgRenderer *renderer, const QString &imagePath
                              "into %s failed", tid,
                              String(targetFilePath).
                                 toNativeStdString().data());
-                    emit imageStatus(imageData, tr("Failed to compute image size"),
-                                     Failed);
+                    reportStatus(Failed, SizeComputeFailedMessage);
                     return -4;
                 }
                 tempFile.close();
@@ -555,8 +1197,8 @@ char ConvertThread::computeSize(QSvgRenderer *renderer, const QString &imagePath
                 fileSizeRatio = (double) fileSize / shared.sizeBytes;
                 fileSizeRatio = sqrt(fileSizeRatio);
             }
-            // ask overwrite
-            char answer = askOverwrite(&tempFile);
+            // save target file
+            char answer = copyTempFile(&tempFile);
             if (answer < 0)
                 return answer;
         }
@@ -565,60 +1207,18 @@ char ConvertThread::computeSize(QSvgRenderer *renderer, const QString &imagePath
     return 0;
 }
 
-/** Returns true if desired file format is corresponding file size to image size
-  * as linear function, otherwise returns false.\n
-  * Following file formats are linear size: BMP, PPM, ICO, TIFF and XBM.
-  */
-bool ConvertThread::isLinearFileSizeFormat(double *destSize) {
-    bool linearSize = false;
-    if (shared.format == "bmp") {
-        *destSize -= 54;
-        *destSize /= 3;
-        linearSize = true;
-    }
-    else if (shared.format == "ppm") {
-        *destSize -= 17;
-        *destSize /= 3;
-        linearSize = true;
-    }
-    else if (shared.format == "ico") {
-        *destSize -= 1422;
-        *destSize /= 4;
-        linearSize = true;
-    }
-    else if (shared.format == "tif" || shared.format == "tiff") {
-        *destSize -= 14308;
-        *destSize /= 4;
-        linearSize = true;
-    }
-    else if (shared.format == "xbm") {
-        *destSize -= 60;
-        *destSize /= 0.65;
-        linearSize = true;
-    }
-    return linearSize;
-}
-
-/** Asks the user in message box if enlarge image by emiting question() signal.\n
-  * \return -1 when the user didn't answered \em yes\n
-  * \return 0  when the user answered \em yes\n
+/** Checks whether the image of \a image size must be enlarged and if the
+  * user allowed it before convertion.
+  * \return -1 when the user rejected enlarging of the image\n
+  * \return 0  when enlarging of the image is allowed\n
   * \return 1  when enlarge of image isn't necessary
-  * \sa askOverwrite() question()
+  * \sa ConvertPreflight isOverwriteRejected()
   */
-char ConvertThread::askEnlarge(const QImage &image, const QString &imagePath) {
+char ConvertThread::checkEnlarge(const QSize &image) {
     if ( (image.width()<width && image.width()>=image.height()) ||
          (image.height()<height && image.width()<=image.height()) ) {
-        if (!(shared.enlargeAll || shared.noEnlargeAll || shared.abort)) {
-            shared.mutex.lock();
-            emit question(imagePath, Enlarge);
-            shared.mutex.unlock();
-        }
-        if (shared.enlargeResult != QMessageBox::Yes &&
-                shared.enlargeResult != QMessageBox::YesToAll) {
-            if (shared.enlargeResult == QMessageBox::Cancel)
-                emit imageStatus(imageData, tr("Cancelled"), Cancelled);
-            else
-                emit imageStatus(imageData, tr("Skipped"), Skipped);
+        if (job.decisions[ConvertJob::Enlarge] == ConvertJob::Rejected) {
+            reportStatus(Skipped, SkippedMessage);
             return -1;
         }
         return 0;
@@ -626,50 +1226,178 @@ char ConvertThread::askEnlarge(const QImage &image, const QString &imagePath) {
     return 1;
 }
 
-/** Asks the user in message box if overwrite file by emiting question() signal.\n
-  * Returns negative value if overwriting failed, otherwise returns 0.
+/** Returns true if the target file exists and the user rejected overwriting
+  * it before convertion.
+  * \sa ConvertPreflight checkEnlarge()
+  */
+bool ConvertThread::isOverwriteRejected() const {
+    return job.decisions[ConvertJob::Overwrite] == ConvertJob::Rejected
+            && QFile::exists(targetFilePath);
+}
+
+/** Copies \a tempFile into target file path if it's allowed.
+  * Returns negative value if copying failed, otherwise returns 0.
   * \note This function was created for SVG images.
-  * \sa askEnlarge() question()
-  */
-char ConvertThread::askOverwrite(QFile *tempFile) {
-    if ( QFile::exists( targetFilePath ) &&
-         !(shared.overwriteAll || shared.abort || shared.noOverwriteAll)) {
-        if (!(shared.overwriteAll || shared.abort || shared.noOverwriteAll)) {
-            shared.mutex.lock();
-            emit question(targetFilePath, Overwrite);
-            shared.mutex.unlock();
-        }
-        if(shared.overwriteResult == QMessageBox::Yes ||
-                shared.overwriteResult == QMessageBox::YesToAll) {
-            QFile::remove(targetFilePath);
-            if (tempFile->copy(targetFilePath))
-                emit imageStatus(imageData, tr("Converted"), Converted);
-            else {
-                emit imageStatus(imageData, tr("Failed to save"), Failed);
-                return -1;
-            }
-        }
-        else if (shared.overwriteResult == QMessageBox::Cancel)
-            emit imageStatus(imageData, tr("Cancelled"), Cancelled);
-        else
-            emit imageStatus(imageData, tr("Skipped"), Skipped);
-    }
-    else if (shared.noOverwriteAll)
-        emit imageStatus(imageData, tr("Skipped"), Skipped);
-    else if (shared.abort)
-        emit imageStatus(imageData, tr("Cancelled"), Cancelled);
-    else { // when overwriteAll is true or file not exists
+  * \sa isOverwriteRejected()
+  */
+char ConvertThread::copyTempFile(QFile *tempFile) {
+    if (isCancelled())
+        reportStatus(Cancelled, CancelledMessage);
+    else if (isOverwriteRejected())
+        reportStatus(Skipped, SkippedMessage);
+    else {
         QFile::remove(targetFilePath);
         if (tempFile->copy(targetFilePath))
-            emit imageStatus(imageData, tr("Converted"), Converted);
+            reportStatus(Converted, ConvertedMessage);
         else {
-            emit imageStatus(imageData, tr("Failed to save"), Failed);
-            return -2;
+            reportStatus(Failed, SaveFailedMessage);
+            return -1;
         }
     }
     return 0;
 }
 
+/** Returns estimated count of bytes used by decoded image of current job and
+  * its copies made while converting or 0 if the image size is unknown.
+  * Dimensions of the source image are read from its header without decoding.
+  * Estimate of image converted strip by strip counts row buffers and the
+  * destination image only, see isStreamed().
+  * \sa reserveMemory()
+  */
+qint64 ConvertThread::memoryEstimate(bool isSvgSource) {
+    const qint64 bytesPerPixel = 4;
+    if (isSvgSource) {
+        // SVG image is rendered in desired size
+        if (shared.sizeUnit == 0 && hasWidth && hasHeight)
+            return 2 * bytesPerPixel * width * height;
+        return 0;
+    }
+    QSize sourceSize;
+    QSize decodedSize;
+    bool readable = true;
+    if (isRegularImageToLoad(pd.imagePath)) {
+        QBuffer buffer(&sourceData);
+        QImageReader reader;
+        if (sourceData.isEmpty())
+            reader.setFileName(pd.imagePath);
+        else
+            reader.setDevice(&buffer);
+        reader.setFormat(sourceFormat);
+        sourceSize = reader.size();
+        decodedSize = decodeSize(&reader);
+        // Qt plugins may not read some huge images, e.g. BigTIFF files
+        if (sourceSize.isEmpty() && StripReader::isStreamable(sourceFormat)) {
+            QScopedPointer<StripReader> strips(
+                        StripReader::open(pd.imagePath, sourceFormat));
+            if (strips) {
+                sourceSize = decodedSize = strips->size();
+                readable = false;
+            }
+        }
+    }
+    if (sourceSize.isEmpty())
+        return 0;
+    const qreal sourceWidth = sourceSize.width();
+    const qreal sourceHeight = sourceSize.height();
+    QSizeF destSize(sourceSize);
+    if (shared.sizeUnit == 0) { // px
+        if (hasWidth && hasHeight)
+            destSize = QSizeF(width, height);
+        else if (hasWidth)
+            destSize = QSizeF(width, sourceHeight * width / sourceWidth);
+        else if (hasHeight)
+            destSize = QSizeF(sourceWidth * height / sourceHeight, height);
+    }
+    else if (shared.sizeUnit == 1) // %
+        destSize = QSizeF(sourceWidth * width / 100.,
+                          sourceHeight * height / 100.);
+    // decoded image and its converted copy, horizontally scaled temporary
+    // image and destination image copies made by scaling, effects and rotation
+    qreal pixels = 2. * decodedSize.width() * decodedSize.height()
+            + destSize.width() * decodedSize.height()
+            + 3. * destSize.width() * destSize.height();
+    streamed = !readable
+            || isStreamed(decodedSize, bytesPerPixel * qint64(pixels));
+    if (!streamed)
+        return bytesPerPixel * qint64(pixels);
+    // source rows, band of decoded TIFF blocks, sliding window of
+    // horizontally scaled rows and destination image unless it's written
+    // row by row; the window holds filter taps of a row like StripResampler,
+    // which are at least 2*support+1 rows when upscaling
+    const qreal support = qMax(sourceHeight / destSize.height(), 1.)
+            * Resampler::filterSupport(
+                Resampler::toFilter(shared.resamplingFilter));
+    const qreal windowRows = 2. * std::ceil(support) + 2.;
+    pixels = (2. + TiffStripReader::minBandRows) * sourceWidth
+            + windowRows * destSize.width();
+    if (!isStripWritable())
+        pixels += 3. * destSize.width() * destSize.height();
+    return bytesPerPixel * qint64(pixels);
+}
+
+/** Returns true if the image of current job decoded in \a decodedSize size
+  * must be converted strip by strip, because it's larger than
+  * streamThreshold or \a bytes needed to convert it don't fit the memory
+  * budget. The image is streamed only if StripReader can read it.
+  * \sa memoryEstimate() convertStrips()
+  */
+bool ConvertThread::isStreamed(const QSize &decodedSize, qint64 bytes) {
+    if (shared.sizeUnit == 2 || !StripReader::isStreamable(sourceFormat))
+        return false;
+    MemoryBudget *budget = scheduler ? scheduler->memoryBudget() : 0;
+    const qint64 decodedBytes =
+            4 * qint64(decodedSize.width()) * decodedSize.height();
+    if (decodedBytes < streamThreshold && (!budget || budget->fits(bytes)))
+        return false;
+    QScopedPointer<StripReader> reader(
+                StripReader::open(pd.imagePath, sourceFormat));
+    return !reader.isNull();
+}
+
+/** Returns true if scaled image of current job may be written into target
+  * file row by row, i.e. the target format is supported by StripWriter and
+  * no effects nor rotation are painted on the image.
+  */
+bool ConvertThread::isStripWritable() const {
+    const EffectsConfiguration effects = shared.effectsConfiguration();
+    const bool painted = effects.getHistogramOperation() > 0
+            || effects.getFilterType() != NoFilter
+            || effects.getFrameWidth() > 0
+            || !effects.getImage().isNull()
+            || !effects.getTextString().isEmpty();
+    return !painted && !(rotate && angle != 0.0) && shared.flip == 0
+            && StripWriter::isStreamable(shared.format.toLower().toLatin1());
+}
+
+/** Reserves memory for decoded image of current job in memory budget of the
+  * scheduler and remembers it in \a reservation. Waits while the budget is
+  * exhausted. Reports the job as failed if the image never fits the budget
+  * or as cancelled if the convertion was cancelled while waiting.
+  * \return True if the job may be converted, otherwise false.
+  * \sa memoryEstimate() ConvertScheduler::memoryBudget()
+  */
+bool ConvertThread::reserveMemory(MemoryReservation *reservation,
+                                  bool isSvgSource) {
+    MemoryBudget *budget = scheduler ? scheduler->memoryBudget() : 0;
+    // the estimate decides whether the image is streamed also without budget
+    const qint64 bytes = memoryEstimate(isSvgSource);
+    if (!budget || bytes <= 0)
+        return true;
+    while (!budget->acquire(bytes, memoryWaitTime)) {
+        if (!budget->fits(bytes)) {
+            qWarning("tid %d: %s needs %lld MiB, memory limit is %lld MiB",
+                     tid, String(pd.imagePath).toNativeStdString().data(),
+                     bytes >> 20, budget->capacity() >> 20);
+            reportStatus(Failed, MemoryLimitMessage);
+            return false;
+        }
+        if (cancelCheckpoint())
+            return false;
+    }
+    reservation->reserved(bytes);
+    return true;
+}
+
 QImage *ConvertThread::loadImage(const QString &imagePath, RawModel *rawModel,
                                  bool isSvgSource)
 {
@@ -686,43 +1414,159 @@ QImage *ConvertThread::loadImage(const QString &imagePath, RawModel *rawModel,
     return image;
 }
 
+/** Returns true if the image stored in \a imagePath file is readable by Qt
+  * image plugins. SVG images are rendered by loadSvgImage() instead.
+  * The format is detected from first bytes of the image once per job.
+  * \sa #sourceFormat ImageFormatRegistry::format()
+  */
 bool ConvertThread::isRegularImageToLoad(const QString &imagePath)
 {
-    QFileInfo imageFileInfo(imagePath);
-    QString fileExtension = imageFileInfo.fileName().split('.').last();
-    fileExtension = fileExtension.toLower();
+    const ImageFormatRegistry *registry = ImageFormatRegistry::instance();
+    if (sourceFormat.isEmpty())
+        sourceFormat = registry->format(imagePath, sourceData);
 
-    if (fileExtension == "svg" || fileExtension == "svgz") {
+    if (sourceFormat == "svg" || sourceFormat == "svgz") {
         return false;
     }
 
-    QByteArray format = fileExtension.toLatin1();
-    return QImageReader::supportedImageFormats().contains(format);
+    return registry->isReadable(sourceFormat);
 }
 
 QImage *ConvertThread::loadRegularImage(const QString &imagePath)
 {
     QImage *image = NULL;
 
-    QFileInfo imageFileInfo(imagePath);
-    QString fileExtension = imageFileInfo.fileName().split('.').last();
-    fileExtension = fileExtension.toLower();
-
-    if (fileExtension == "png" || fileExtension == "gif") {
+    if (sourceFormat == "png" || sourceFormat == "gif") {
         QImage loadedImage;
-        loadedImage.load(imagePath);
-        image = new QImage(loadedImage.size(), loadedImage.format());
+        if (sourceData.isEmpty())
+            loadedImage.load(imagePath, sourceFormat.constData());
+        else
+            loadedImage.loadFromData(sourceData, sourceFormat.constData());
+        image = new QImage(buffers.image(loadedImage.size(),
+                                         loadedImage.format()));
         fillImage(image);
         QPainter painter(image);
         painter.drawImage(image->rect(), loadedImage);
     } else {
         image = new QImage();
-        image->load(imagePath);
+        QBuffer buffer(&sourceData);
+        QImageReader reader;
+        if (sourceData.isEmpty())
+            reader.setFileName(imagePath);
+        else
+            reader.setDevice(&buffer);
+        reader.setFormat(sourceFormat);
+        setDecodeRegion(&reader);
+        // image plugins decode into the buffer if its size and format match
+        QSize size = reader.scaledSize();
+        if (!size.isValid())
+            size = reader.clipRect().size();
+        if (!size.isValid())
+            size = reader.size();
+        *image = buffers.image(size, reader.imageFormat());
+        if (!reader.read(image))
+            *image = QImage();
     }
 
     return image;
 }
 
+/** Returns size of the image of current job scaled to desired size in px or
+  * invalid size if it isn't known before decoding. \a source is size of the
+  * source image. If \a swapAxes is true desired width and height are swapped
+  * as for image rotated by EXIF orientation.
+  * \sa decodeSize()
+  */
+QSize ConvertThread::plannedSize(const QSize &source, bool swapAxes) const {
+    if (source.isEmpty())
+        return QSize();
+    const bool byWidth = swapAxes ? hasHeight : hasWidth;
+    const bool byHeight = swapAxes ? hasWidth : hasHeight;
+    qreal w = swapAxes ? height : width;
+    qreal h = swapAxes ? width : height;
+    if (shared.sizeUnit == 1) { // %
+        w *= source.width() / 100.;
+        h *= source.height() / 100.;
+    }
+    else if (shared.sizeUnit != 0) // bytes are computed from decoded image
+        return QSize();
+    if (byWidth && byHeight) {
+        if (shared.maintainAspect)
+            return source.scaled(qRound(w), qRound(h), Qt::KeepAspectRatio);
+        return QSize(qRound(w), qRound(h));
+    }
+    if (byWidth)
+        return QSize(qRound(w), qRound(source.height() * w / source.width()));
+    if (byHeight)
+        return QSize(qRound(source.width() * h / source.height()), qRound(h));
+    return QSize();
+}
+
+/** Returns size of the image read by \a reader after cropping and scaling on
+  * decode. The image is scaled on decode only if the image format plugin
+  * supports QImageIOHandler::ScaledSize option, e.g. JPEG plugin uses DCT
+  * domain scaling of libjpeg. A cropped image is scaled on decode only if the
+  * plugin supports QImageIOHandler::ClipRect option also, otherwise the whole
+  * image is decoded and cropped later.
+  * \sa setDecodeRegion() ConvertPreflight::decodeSize()
+  */
+QSize ConvertThread::decodeSize(QImageReader *reader) const {
+    QSize source = reader->size();
+    if (!source.isValid())
+        return source;
+    const QRect crop = ConvertPreflight(&shared).cropRect(source);
+    if (crop.isValid()) {
+        if (!reader->supportsOption(QImageIOHandler::ClipRect))
+            return source;
+        source = crop.size();
+    }
+    if (!reader->supportsOption(QImageIOHandler::ScaledSize))
+        return source;
+    // EXIF orientation is unknown until the image is decoded,
+    // so the image must fit both orientations
+    const QSize size = ConvertPreflight::decodeSize(
+                source, plannedSize(source, false));
+    const QSize swappedSize = ConvertPreflight::decodeSize(
+                source, plannedSize(source, true));
+    return size.width() > swappedSize.width() ? size : swappedSize;
+}
+
+/** Sets region and scaled size of image read by \a reader, so only needed
+  * pixels are decoded. The cropped region is decoded only if the image format
+  * plugin supports it. The region is scaled on decode when it's much larger
+  * than desired size, but the decoded image is still at least twice larger
+  * than desired size and it's resampled to the desired size later. Remembers
+  * size of the region in #regionSize if it's scaled.
+  * \sa decodeSize() cropImage()
+  */
+void ConvertThread::setDecodeRegion(QImageReader *reader) {
+    QSize region = reader->size();
+    const QRect crop = ConvertPreflight(&shared).cropRect(region);
+    if (crop.isValid() && reader->supportsOption(QImageIOHandler::ClipRect)) {
+        reader->setClipRect(crop);
+        region = crop.size();
+        cropped = true;
+    }
+    const QSize size = decodeSize(reader);
+    if (size == region)
+        return;
+    regionSize = region;
+    reader->setScaledSize(size);
+}
+
+/** Crops \a image to desired region unless it was cropped on decode.
+  * \sa setDecodeRegion() ConvertPreflight::cropRect()
+  */
+void ConvertThread::cropImage(QImage *image) {
+    if (cropped)
+        return;
+    const QRect crop = ConvertPreflight(&shared).cropRect(image->size());
+    if (!crop.isValid())
+        return;
+    *image = image->copy(crop);
+    cropped = true;
+}
+
 QImage *ConvertThread::loadSvgImage(const QString &imagePath)
 {
     QSvgRenderer renderer;
@@ -738,17 +1582,10 @@ QImage *ConvertThread::loadSvgImage(const QString &imagePath)
             QString svgTargetFileName =
                     targetFilePath.left(targetFilePath.lastIndexOf('.')+1) + "svg";
             QFile file(svgTargetFileName);
-            // ask overwrite
-            if (file.exists()) {
-                shared.mutex.lock();
-                emit question(svgTargetFileName, Overwrite);
-                shared.mutex.unlock();
-            }
-            if (shared.overwriteResult == QMessageBox::Yes ||
-                    shared.overwriteResult == QMessageBox::YesToAll) {
+            if (!file.exists() || job.decisions[ConvertJob::SvgOverwrite]
+                    != ConvertJob::Rejected) {
                 if (!file.open(QIODevice::WriteOnly)) {
-                    emit imageStatus(pd.imgData, tr("Failed to save new SVG file"),
-                                     Failed);
+                    reportStatus(Failed, SvgSaveFailedMessage);
                     return NULL;
                 }
                 file.write(modifier.content());
@@ -756,17 +1593,16 @@ QImage *ConvertThread::loadSvgImage(const QString &imagePath)
         }
         // and load QByteArray buffer to renderer
         if (!renderer.load(modifier.content())) {
-            emit imageStatus(pd.imgData, tr("Failed to open changed SVG file"),
-                             Failed);
+            reportStatus(Failed, ChangedSvgOpenFailedMessage);
             return NULL;
         }
     }
     else if (!renderer.load(pd.imagePath)) {
-        emit imageStatus(pd.imgData, tr("Failed to open SVG file"), Failed);
+        reportStatus(Failed, SvgOpenFailedMessage);
         return NULL;
     }
     sizeComputed = computeSize(&renderer, pd.imagePath);
-    if (sizeComputed == 2)
+    if (sizeComputed == 2 || sizeComputed == -5)
         return NULL;
     // keep aspect ratio
     if (shared.maintainAspect) {
@@ -823,24 +1659,24 @@ void ConvertThread::fillImage(QImage *img)
     }
 }
 
-/** Draws effects into new image.
-  * \return New image object.
+/** Draws effects into \a image. The image is modified in place, so its
+  * pixel buffer isn't copied unless the image is shared.
   */
-QImage ConvertThread::paintEffects(QImage *image) {
-    QImage destImg(*image);
-    ConvertEffects effectPainter(&destImg, &shared);
-    if (shared.effectsConfiguration().getHistogramOperation() > 0)
-        effectPainter.modifyHistogram();
-    if (shared.effectsConfiguration().getFilterType() != NoFilter)
-        effectPainter.filtrate();
+void ConvertThread::paintEffects(QImage *image) {
+    ConvertEffects effectPainter(image, &shared);
+    effectPainter.setBandExecutor(scheduler);
+    effectPainter.setCancellationToken(cancellationToken());
+    // histogram and filter are applied in single pass
+    if (shared.effectsConfiguration().getHistogramOperation() > 0
+            || shared.effectsConfiguration().getFilterType() != NoFilter)
+        effectPainter.modifyColors();
     if (shared.effectsConfiguration().getFrameWidth() > 0
             && shared.effectsConfiguration().getFrameColor().isValid()) {
-        destImg = effectPainter.framedImage();
-        effectPainter.setImage(&destImg);
+        *image = effectPainter.framedImage();
+        effectPainter.setImage(image);
     }
     if (!shared.effectsConfiguration().getImage().isNull())
         effectPainter.addImage();
     if (!shared.effectsConfiguration().getTextString().isEmpty())
         effectPainter.addText();
-    return destImg;
 }
@@ -26,12 +26,22 @@
 #define SIR_METADATA_SUPPORT
 #endif // SIR_CMAKE
 
+#include <QElapsedTimer>
 #include <QThread>
-#include <QMutex>
 #include "metadata/MetadataUtils.hpp"
+#include "ConvertQueue.hpp"
+#include "ConvertStatusRing.hpp"
+#include "PixelBufferPool.hpp"
 #include "SharedInformation.hpp"
 
+class CancellationToken;
+class ConvertScheduler;
+class ConvertWorkerProcess;
+class MemoryReservation;
+class QImageReader;
 class QSvgRenderer;
+class StripReader;
+class TokenBucket;
 
 #ifndef SIR_CMAKE
 #define SIR_METADATA_SUPPORT
@@ -44,30 +54,43 @@ class QImage;
 /** \brief Image convertion thread class.
   *
   * Threads converting images work in main loop implemented in run() method.
-  * \sa run()
+  * Jobs are taken from ConvertScheduler object set by setScheduler().
+  * Each thread works as single convertion pipeline stage, see Stage.
+  * Convert threads may pass jobs to worker processes, see
+  * ConvertScheduler::setProcessIsolation().
+  * \sa run() convertJob()
   */
 class ConvertThread : public QThread {
     Q_OBJECT
     friend class ConvertDialog;
     friend class ConvertThreadTest;
+    friend class ConvertWorker;
 
 public:
+    //! Describes convertion pipeline stage of the thread.
+    enum Stage {
+        ConvertStage, /**< Decodes, processes and encodes images. */
+        ReadStage, /**< Prefetches source files. */
+        WriteStage /**< Writes encoded images into target files. */
+    };
+
     ConvertThread(QObject *parent, int tid);
-    void convertImage(const QString& name, const QString& extension,
-                      const QString& path);
+    void setScheduler(ConvertScheduler *scheduler);
+    void setStage(Stage stage);
+    Stage stage() const;
     void setAcceptWork(bool work);
-    void getNextOrStop();
+    bool isAcceptingWork() const;
+    int threadId() const;
+    void setCpu(int cpu, int node);
+    int numaNode() const;
+    ConvertStatusRing *statusRing();
+    PixelBufferPool *bufferPool();
 #ifdef SIR_METADATA_SUPPORT
     void printError();
 #endif // SIR_METADATA_SUPPORT
     static SharedInformation *sharedInfo();
     static void setSharedInfo(const SharedInformation &info);
 
-    //! Enumerator for ConvertThread::question() signal.
-    enum Question {
-        Overwrite,
-        Enlarge
-    };
     //! Describes status of file convertion.
     enum Status {
         NotConverted,
@@ -78,11 +101,25 @@ public:
         Converting,
         Cancelled
     };
+    //! Describes reason of status change. \sa statusMessage()
+    enum StatusMessage {
+        CancelledMessage,
+        ConvertingMessage,
+        ConvertedMessage,
+        SkippedMessage,
+        OpenFailedMessage,
+        ConvertFailedMessage,
+        SizeComputeFailedMessage,
+        SaveFailedMessage,
+        SvgOpenFailedMessage,
+        SvgSaveFailedMessage,
+        ChangedSvgOpenFailedMessage,
+        MemoryLimitMessage,
+        WorkerFailedMessage
+    };
+    static QString statusMessage(int message);
 
-signals:
-    void imageStatus(QStringList imageData, QString status, int statusNum);
-    void question(const QString& targetFilePath, int questionCode);
-    void getNextImage(int tid);
+    static const char partFileSuffix[];
 
 protected:
     void run();
@@ -90,8 +127,34 @@ protected:
 private:
     // fields
     static SharedInformation shared; /**< The theads shared information. */
+    ConvertScheduler *scheduler; /**< Source of convertion jobs. */
+    Stage stageType; /**< Pipeline stage of this thread. */
     bool work; /**< True means this thread still working. */
-    QStringList imageData; /**< List of strings: file name, extension and path. */
+    ConvertJob job; /**< Currently converting job. */
+    QElapsedTimer jobTimer; /**< Measures convertion time of current job. */
+    /** Processing time of current job in previous pipeline stages. */
+    qint64 elapsedBefore;
+    /** Source file content prefetched by reader thread or empty buffer. */
+    QByteArray sourceData;
+    /** Source image format detected from its first bytes or empty byte array
+      * if it wasn't detected yet.
+      * \sa isRegularImageToLoad()
+      */
+    QByteArray sourceFormat;
+    ConvertStatusRing statusRecords; /**< Status changes waiting for GUI. */
+    /** Pixel buffers reused by images of consecutive jobs. */
+    PixelBufferPool buffers;
+    /** Worker process converting jobs of this thread or null pointer.
+      * \sa convertInWorker()
+      */
+    ConvertWorkerProcess *workerProcess;
+    /** CPU time of this thread charged to CPU throttle in microseconds.
+      * \sa throttleCpu()
+      */
+    qint64 usedCpuTime;
+    QAtomicInt cpu; /**< Logical CPU to pin this thread or -1. \sa setCpu() */
+    QAtomicInt node; /**< NUMA node of #cpu or -1. */
+    int pinnedCpu; /**< Logical CPU this thread is pinned to or -1. */
     int tid; /**< The thread ID. */
     /** If it's true the converting image will be scaled to #width value. */
     bool hasWidth;
@@ -109,6 +172,20 @@ private:
       * \sa computeSize()
       */
     char sizeComputed;
+    /** Size of the source image region scaled on decode or invalid size if
+      * the image wasn't scaled on decode.
+      * \sa setDecodeRegion()
+      */
+    QSize regionSize;
+    /** If it's true the converting image was cropped on decode.
+      * \sa cropImage()
+      */
+    bool cropped;
+    /** If it's true the converting image is too large to be decoded as a
+      * whole and it's converted strip by strip.
+      * \sa isStreamed() convertStrips()
+      */
+    bool streamed;
     /** If it's true the converting image will be rotated by #angle value. */
     bool rotate;
     /** Desired rotation angle of the converting image in degree.
@@ -125,25 +202,53 @@ private:
 #endif // SIR_METADATA_SUPPORT
     QString targetFilePath;
     // methods
+    void readJob(ConvertPipelineItem *item);
+    void beginJob(ConvertPipelineItem *item);
+    bool convertJob(ConvertPipelineItem *item);
+    bool convertStrips(ConvertPipelineItem *item, StripReader *reader);
+    bool saveImage(ConvertPipelineItem *item, QImage *destImg);
+    void convertInWorker(ConvertPipelineItem *item);
+    void writeJob(const ConvertPipelineItem &item);
+    void reportStatus(Status status, StatusMessage message);
+    void reportStatus(const ConvertStatusRecord &record);
+    void updateAffinity();
+    TokenBucket *readThrottle() const;
+    TokenBucket *writeThrottle() const;
+    TokenBucket *cpuThrottle() const;
+    bool throttle(TokenBucket *bucket, qint64 amount);
+    void throttleCpu();
+    const CancellationToken *cancellationToken() const;
+    bool isCancelled() const;
+    bool cancelCheckpoint();
+    void finishPartFile(const QString &partFilePath, bool written);
+    QImage scaledImage(const QImage &image, const QSize &size);
     QImage rotateImage(const QImage &image);
 #ifdef SIR_METADATA_SUPPORT
     void updateThumbnail(const QImage &image);
 #endif // SIR_METADATA_SUPPORT
     char computeSize(const QImage *image, const QString &imagePath);
     char computeSize(QSvgRenderer *renderer, const QString &imagePath);
-    bool isLinearFileSizeFormat(double *destSize);
-    char askEnlarge(const QImage &image, const QString &imagePath);
-    char askOverwrite(QFile *tempFile);
+    char checkEnlarge(const QSize &image);
+    bool isOverwriteRejected() const;
+    char copyTempFile(QFile *tempFile);
+    qint64 memoryEstimate(bool isSvgSource);
+    bool isStreamed(const QSize &decodedSize, qint64 bytes);
+    bool isStripWritable() const;
+    bool reserveMemory(MemoryReservation *reservation, bool isSvgSource);
 
     QImage *loadImage(const QString &imagePath, RawModel *rawModel,
                       bool isSvgSource);
     bool isRegularImageToLoad(const QString &imagePath);
+    QSize plannedSize(const QSize &source, bool swapAxes) const;
+    QSize decodeSize(QImageReader *reader) const;
+    void setDecodeRegion(QImageReader *reader);
+    void cropImage(QImage *image);
     QImage *loadRegularImage(const QString &imagePath);
     QImage *loadSvgImage(const QString &imagePath);
     QImage *loadRawImage(const QString &imagePath, RawModel *rawModel);
 
     void fillImage(QImage *img);
-    QImage paintEffects(QImage *image);
+    void paintEffects(QImage *image);
 };
 
 #endif // CONVERTTHREAD_HPP
@@ -0,0 +1,438 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ConvertWorker.hpp"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QProcess>
+
+#include <cstring>
+
+#include "CancellationToken.hpp"
+#include "ConvertThread.hpp"
+
+
+/** Command line argument starting SIR in worker process mode. */
+const char ConvertWorker::argument[] = "--convert-worker";
+
+//! First bytes of each message frame: "SIRW".
+static const quint32 messageMagic = 0x53495257;
+//! Size of message frame header: magic and payload size.
+static const int messageHeaderSize = 8;
+//! Time slice of waiting for the worker in milliseconds.
+static const int workerWaitTime = 100;
+
+static void writeJob(QDataStream &stream, const ConvertJob &job) {
+    stream << qint32(job.id) << job.imageData << job.targetFilePath;
+    for (int i=0; i<ConvertJob::QuestionCount; i++)
+        stream << job.decisions[i];
+    stream << job.fileSize << job.pixels << job.cost;
+}
+
+static void readJob(QDataStream &stream, ConvertJob *job) {
+    qint32 id;
+    stream >> id >> job->imageData >> job->targetFilePath;
+    job->id = id;
+    for (int i=0; i<ConvertJob::QuestionCount; i++)
+        stream >> job->decisions[i];
+    stream >> job->fileSize >> job->pixels >> job->cost;
+}
+
+/** Creates worker which converts jobs using ConvertThread object without
+  * starting the thread.
+  */
+ConvertWorker::ConvertWorker() {
+    thread = new ConvertThread(0, 0);
+}
+
+ConvertWorker::~ConvertWorker() {
+    delete thread;
+}
+
+/** Runs the worker on standard input and output.
+  * \sa exec(QIODevice*,QIODevice*)
+  */
+int ConvertWorker::exec() {
+    QFile input;
+    QFile output;
+    if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered) ||
+            !output.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered))
+        return 1;
+    return exec(&input, &output);
+}
+
+/** Reads messages from \a input and writes results of converted jobs into
+  * \a output until end of the input.
+  * \return 0 if the input was closed or 1 on protocol error.
+  */
+int ConvertWorker::exec(QIODevice *input, QIODevice *output) {
+    QByteArray message;
+    while (readMessage(input, &message)) {
+        QDataStream stream(message);
+        quint8 type;
+        stream >> type;
+        switch (type) {
+        case SharedMessage: {
+            SharedInformation info;
+            stream >> info;
+            ConvertThread::setSharedInfo(info);
+            break;
+        }
+        case JobMessage:
+            if (!processJob(stream, output))
+                return 1;
+            break;
+        default:
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/** Writes framed \a message into \a device.
+  * \return True on success, otherwise false.
+  */
+bool ConvertWorker::writeMessage(QIODevice *device, const QByteArray &message) {
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+    stream << messageMagic << quint32(message.size());
+    frame.append(message);
+    if (device->write(frame) != frame.size())
+        return false;
+    while (device->bytesToWrite() > 0) {
+        if (!device->waitForBytesWritten(-1))
+            return false;
+    }
+    return true;
+}
+
+/** Converts the \a item job. Status changes are read by takeStatusRecords()
+  * after this function returns.
+  */
+void ConvertWorker::convert(ConvertPipelineItem *item) {
+    thread->job = item->job;
+    thread->convertJob(item);
+}
+
+/** Returns status records reported while converting the last job. */
+QList<ConvertStatusRecord> ConvertWorker::takeStatusRecords() {
+    QList<ConvertStatusRecord> records;
+    ConvertStatusRecord record;
+    while (thread->statusRing()->pop(&record))
+        records << record;
+    return records;
+}
+
+/** Reads single message frame from \a device into \a message. Blocks until
+  * whole frame is read.
+  * \return False on end of input or invalid frame, otherwise true.
+  */
+bool ConvertWorker::readMessage(QIODevice *device, QByteArray *message) {
+    char header[messageHeaderSize];
+    if (!readBytes(device, header, messageHeaderSize))
+        return false;
+    QDataStream stream(QByteArray::fromRawData(header, messageHeaderSize));
+    quint32 magic, size;
+    stream >> magic >> size;
+    if (magic != messageMagic)
+        return false;
+    message->resize(size);
+    return readBytes(device, message->data(), size);
+}
+
+/** Reads exactly \a size bytes from \a device into \a data. */
+bool ConvertWorker::readBytes(QIODevice *device, char *data, qint64 size) {
+    while (size > 0) {
+        qint64 count = device->read(data, size);
+        if (count < 0)
+            return false;
+        if (count == 0 && !device->waitForReadyRead(-1))
+            return false;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+/** Converts job read from \a stream and writes its status records into
+  * \a output. Source file passed through shared memory isn't copied.
+  * \return False if the result wasn't written, otherwise true.
+  */
+bool ConvertWorker::processJob(QDataStream &stream, QIODevice *output) {
+    ConvertPipelineItem item;
+    readJob(stream, &item.job);
+    QString memoryKey;
+    qint64 sourceSize;
+    stream >> item.elapsed >> memoryKey >> sourceSize >> item.sourceData;
+    if (!memoryKey.isEmpty()) {
+        if (sourceMemory.key() != memoryKey) {
+            sourceMemory.detach();
+            sourceMemory.setKey(memoryKey);
+        }
+        if (!sourceMemory.isAttached())
+            sourceMemory.attach(QSharedMemory::ReadOnly);
+        // the parent doesn't touch the segment until the job is done
+        if (sourceMemory.isAttached() && sourceMemory.size() >= sourceSize)
+            item.sourceData = QByteArray::fromRawData(
+                        static_cast<const char *>(sourceMemory.constData()),
+                        sourceSize);
+    }
+    convert(&item);
+    // don't keep reference to the shared memory
+    thread->sourceData.clear();
+
+    QList<ConvertStatusRecord> records = takeStatusRecords();
+    QByteArray message;
+    QDataStream result(&message, QIODevice::WriteOnly);
+    result << quint8(DoneMessage) << qint32(records.count());
+    foreach (const ConvertStatusRecord &record, records) {
+        result << qint32(record.jobId) << record.status << record.message
+               << record.elapsed;
+    }
+    return writeMessage(output, message);
+}
+
+
+/** Creates worker process object. The process is started by convert(). */
+ConvertWorkerProcess::ConvertWorkerProcess() {
+    process = 0;
+    sentSerial = -1;
+    crashes = 0;
+    setProgram(QCoreApplication::applicationFilePath(),
+               QStringList(ConvertWorker::argument));
+}
+
+/** Stops the worker process. */
+ConvertWorkerProcess::~ConvertWorkerProcess() {
+    stop();
+    delete process;
+}
+
+/** Sets \a program started as worker process with \a arguments. Default
+  * program is current executable with ConvertWorker::argument argument.
+  */
+void ConvertWorkerProcess::setProgram(const QString &program,
+                                      const QStringList &arguments) {
+    stop();
+    programPath = program;
+    programArguments = arguments;
+}
+
+/** Returns path of worker program. */
+QString ConvertWorkerProcess::program() const {
+    return programPath;
+}
+
+/** Returns true if the worker process is running. */
+bool ConvertWorkerProcess::isRunning() const {
+    return process && process->state() == QProcess::Running;
+}
+
+/** Returns count of worker processes crashed while converting. */
+int ConvertWorkerProcess::crashCount() const {
+    return crashes;
+}
+
+/** Converts \a item job in the worker process. Starts the worker process if
+  * it isn't running. Shared information of the batch is sent if
+  * \a sharedSerial differs from the last sent one.
+  *
+  * If the worker crashes the job is reported as failed. If \a token is
+  * cancelled while converting, the worker is killed and the job is reported
+  * as cancelled. Partial target file is removed in both cases.
+  *
+  * \return Status records of the job.
+  */
+QList<ConvertStatusRecord> ConvertWorkerProcess::convert(
+        const ConvertPipelineItem &item, int sharedSerial,
+        const CancellationToken *token) {
+    timer.start();
+    QList<ConvertStatusRecord> records;
+    if (!start() || !sendShared(sharedSerial) || !sendJob(item)) {
+        stop();
+        records << record(item, ConvertThread::Failed,
+                          ConvertThread::WorkerFailedMessage);
+        return records;
+    }
+    QByteArray message;
+    forever {
+        if (readMessage(&message))
+            break;
+        if (!isRunning()) {
+            crashes++;
+            qWarning("Convert worker crashed on %s",
+                     qPrintable(item.job.imageData.join(" ")));
+            records << record(item, ConvertThread::Failed,
+                              ConvertThread::WorkerFailedMessage);
+            break;
+        }
+        if (token && token->isCancelled()) {
+            process->kill();
+            process->waitForFinished(-1);
+            records << record(item, ConvertThread::Cancelled,
+                              ConvertThread::CancelledMessage);
+            break;
+        }
+    }
+    if (!records.isEmpty()) {
+        stop();
+        if (!item.job.targetFilePath.isEmpty())
+            QFile::remove(item.job.targetFilePath
+                          + ConvertThread::partFileSuffix);
+        return records;
+    }
+
+    QDataStream stream(message);
+    quint8 type;
+    qint32 count;
+    stream >> type >> count;
+    for (int i=0; i<count && type == ConvertWorker::DoneMessage; i++) {
+        ConvertStatusRecord status;
+        qint32 jobId;
+        stream >> jobId >> status.status >> status.message >> status.elapsed;
+        status.jobId = jobId;
+        records << status;
+    }
+    return records;
+}
+
+/** Starts the worker process unless it's running.
+  * \return True if the worker is running, otherwise false.
+  */
+bool ConvertWorkerProcess::start() {
+    if (isRunning())
+        return true;
+    if (!process) {
+        process = new QProcess();
+        process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    }
+    sentSerial = -1;
+    process->start(programPath, programArguments);
+    if (process->waitForStarted(-1))
+        return true;
+    qWarning("Failed to start convert worker %s", qPrintable(programPath));
+    return false;
+}
+
+/** Closes input of the worker process and waits for its end. */
+void ConvertWorkerProcess::stop() {
+    if (!process || process->state() == QProcess::NotRunning)
+        return;
+    process->closeWriteChannel();
+    if (!process->waitForFinished(1000)) {
+        process->kill();
+        process->waitForFinished(-1);
+    }
+}
+
+/** Sends shared information of the batch if the worker has older one. */
+bool ConvertWorkerProcess::sendShared(int sharedSerial) {
+    if (sentSerial == sharedSerial)
+        return true;
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream << quint8(ConvertWorker::SharedMessage)
+           << *ConvertThread::sharedInfo();
+    if (!ConvertWorker::writeMessage(process, message))
+        return false;
+    sentSerial = sharedSerial;
+    return true;
+}
+
+/** Sends \a item job to the worker. Large source file is copied into
+  * shared memory segment which grows on demand.
+  */
+bool ConvertWorkerProcess::sendJob(const ConvertPipelineItem &item) {
+    static QAtomicInt segmentCounter;
+    QString memoryKey;
+    QByteArray inlineData;
+    const qint64 sourceSize = item.sourceData.size();
+    if (sourceSize > inlineDataLimit) {
+        if (sourceMemory.size() < sourceSize) {
+            sourceMemory.detach();
+            // segments are rounded up to MiB to avoid frequent growing
+            const int size = (sourceSize + 0xfffff) & ~0xfffff;
+            sourceMemory.setKey(QString("sir_worker_%1_%2")
+                                .arg(QCoreApplication::applicationPid())
+                                .arg(segmentCounter.fetchAndAddRelaxed(1)));
+            sourceMemory.create(size);
+        }
+        if (sourceMemory.isAttached() && sourceMemory.lock()) {
+            memcpy(sourceMemory.data(), item.sourceData.constData(),
+                   sourceSize);
+            sourceMemory.unlock();
+            memoryKey = sourceMemory.key();
+        }
+    }
+    if (memoryKey.isEmpty())
+        inlineData = item.sourceData;
+
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream << quint8(ConvertWorker::JobMessage);
+    writeJob(stream, item.job);
+    stream << item.elapsed << memoryKey << sourceSize << inlineData;
+    return ConvertWorker::writeMessage(process, message);
+}
+
+/** Reads message of the worker into \a message. Waits for the message one
+  * time slice at most.
+  * \return True if whole message was read, otherwise false.
+  */
+bool ConvertWorkerProcess::readMessage(QByteArray *message) {
+    QByteArray header;
+    forever {
+        header = process->peek(messageHeaderSize);
+        if (header.size() == messageHeaderSize) {
+            QDataStream stream(header);
+            quint32 magic, size;
+            stream >> magic >> size;
+            if (magic != messageMagic) {
+                // garbage on output; treat the worker as crashed
+                process->kill();
+                process->waitForFinished(-1);
+                return false;
+            }
+            if (process->bytesAvailable() >= messageHeaderSize + size) {
+                process->read(messageHeaderSize);
+                *message = process->read(size);
+                return true;
+            }
+        }
+        if (!process->waitForReadyRead(workerWaitTime))
+            return false;
+    }
+}
+
+/** Returns status record of \a item job with \a status and \a message
+  * reported by this object.
+  */
+ConvertStatusRecord ConvertWorkerProcess::record(
+        const ConvertPipelineItem &item, int status, int message) const {
+    ConvertStatusRecord result;
+    result.jobId = item.job.id;
+    result.status = status;
+    result.message = message;
+    result.elapsed = item.elapsed + timer.elapsed();
+    return result;
+}
@@ -0,0 +1,134 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTWORKER_HPP
+#define CONVERTWORKER_HPP
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QSharedMemory>
+#include <QStringList>
+
+#include "ConvertQueue.hpp"
+#include "ConvertStatusRing.hpp"
+
+class CancellationToken;
+class ConvertThread;
+class QDataStream;
+class QIODevice;
+class QProcess;
+
+/** \brief Convertion in separate worker process.
+  *
+  * Worker process is SIR executable started with \em --convert-worker
+  * argument. It reads messages from standard input, converts jobs one by one
+  * and writes status records to standard output. Prefetched source files
+  * larger than ConvertWorkerProcess::inlineDataLimit are passed through
+  * shared memory instead of the pipe.
+  *
+  * Crash inside image plugin or metadata library kills the worker process
+  * only, so the batch goes on.
+  *
+  * \sa ConvertWorkerProcess
+  */
+class ConvertWorker {
+public:
+    //! Type of message passed between worker and its parent process.
+    enum MessageType {
+        SharedMessage, /**< Shared information of the batch. */
+        JobMessage, /**< Job to convert. */
+        StatusMessage, /**< Status change of the job. */
+        DoneMessage /**< The job is finished. */
+    };
+
+    static const char argument[];
+
+    ConvertWorker();
+    virtual ~ConvertWorker();
+    int exec();
+    int exec(QIODevice *input, QIODevice *output);
+
+    static bool writeMessage(QIODevice *device, const QByteArray &message);
+
+protected:
+    virtual void convert(ConvertPipelineItem *item);
+    QList<ConvertStatusRecord> takeStatusRecords();
+
+private:
+    ConvertThread *thread; /**< Convertion engine; never started. */
+    QSharedMemory sourceMemory; /**< Attached shared memory of source file. */
+
+    bool readMessage(QIODevice *device, QByteArray *message);
+    bool readBytes(QIODevice *device, char *data, qint64 size);
+    bool processJob(QDataStream &stream, QIODevice *output);
+
+    Q_DISABLE_COPY(ConvertWorker)
+};
+
+/** \brief Parent side of ConvertWorker process.
+  *
+  * Starts the worker process on demand and sends jobs to it. If the worker
+  * crashes the job is reported as failed and next job starts new worker.
+  * The object must be used in single thread.
+  *
+  * \sa ConvertThread ConvertScheduler::setProcessIsolation()
+  */
+class ConvertWorkerProcess {
+public:
+    enum {
+        /** Source files larger than this count of bytes are passed through
+          * shared memory.
+          */
+        inlineDataLimit = 64 * 1024
+    };
+
+    ConvertWorkerProcess();
+    ~ConvertWorkerProcess();
+    void setProgram(const QString &program,
+                    const QStringList &arguments = QStringList());
+    QString program() const;
+    bool isRunning() const;
+    int crashCount() const;
+    QList<ConvertStatusRecord> convert(const ConvertPipelineItem &item,
+                                       int sharedSerial,
+                                       const CancellationToken *token = 0);
+
+private:
+    QProcess *process;
+    QString programPath;
+    QStringList programArguments;
+    int sentSerial; /**< Serial of shared information sent to the worker. */
+    int crashes; /**< Count of crashed workers. */
+    QSharedMemory sourceMemory; /**< Source files passed to the worker. */
+    QElapsedTimer timer; /**< Measures time of current job. */
+
+    bool start();
+    void stop();
+    bool sendShared(int sharedSerial);
+    bool sendJob(const ConvertPipelineItem &item);
+    bool readMessage(QByteArray *message);
+    ConvertStatusRecord record(const ConvertPipelineItem &item, int status,
+                               int message) const;
+
+    Q_DISABLE_COPY(ConvertWorkerProcess)
+};
+
+#endif // CONVERTWORKER_HPP
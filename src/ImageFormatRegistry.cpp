@@ -0,0 +1,137 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "ImageFormatRegistry.hpp"
+
+#include <QFile>
+#include <QImageReader>
+
+
+/** Returns pointer to the instance of ImageFormatRegistry class. The registry
+  * is created on first call; it's safe to call this function from many
+  * threads.
+  */
+const ImageFormatRegistry *ImageFormatRegistry::instance() {
+    static const ImageFormatRegistry object;
+    return &object;
+}
+
+/** Creates the registry of formats supported by Qt image plugins. */
+ImageFormatRegistry::ImageFormatRegistry() {
+    foreach (const QByteArray &format, QImageReader::supportedImageFormats())
+        readable.insert(format.toLower());
+}
+
+/** Returns list of lower case readable formats. */
+QList<QByteArray> ImageFormatRegistry::formats() const {
+    return readable.toList();
+}
+
+/** Returns true if lower case \a format is readable by Qt image plugins,
+  * otherwise returns false.
+  */
+bool ImageFormatRegistry::isReadable(const QByteArray &format) const {
+    return readable.contains(format);
+}
+
+/** Returns lower case format of image stored in \a filePath file. The format
+  * is detected from first bytes of \a data if it isn't empty, otherwise from
+  * first bytes of the file. If the bytes don't match any known readable
+  * format the file name extension is returned.
+  * \note Many RAW formats are TIFF containers, so TIFF detected in a file with
+  *       an extension not readable by Qt is treated as RAW image.
+  * \sa detectFormat() extensionFormat()
+  */
+QByteArray ImageFormatRegistry::format(const QString &filePath,
+                                       const QByteArray &data) const {
+    const QByteArray extension = extensionFormat(filePath);
+    if (extension == "svg" || extension == "svgz")
+        return extension;
+    QByteArray header = data.left(HeaderSize);
+    if (header.isEmpty()) {
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly))
+            header = file.read(HeaderSize);
+    }
+    const QByteArray detected = detectFormat(header);
+    if (!isReadable(detected))
+        return extension;
+    if (detected == "tiff" && !isReadable(extension))
+        return extension;
+    return detected;
+}
+
+/** Returns lower case format of image starting with \a header bytes or empty
+  * byte array if the format isn't recognized.
+  */
+QByteArray ImageFormatRegistry::detectFormat(const QByteArray &header) {
+    if (header.startsWith("\xFF\xD8\xFF"))
+        return "jpeg";
+    if (header.startsWith("\x89PNG\r\n\x1A\n"))
+        return "png";
+    if (header.startsWith("GIF87a") || header.startsWith("GIF89a"))
+        return "gif";
+    if (header.startsWith("II*") || header.startsWith(QByteArray("MM\0*", 4))
+            || header.startsWith("II+") || header.startsWith(QByteArray("MM\0+", 4)))
+        return "tiff";
+    if (header.startsWith("RIFF") && header.mid(8, 4) == "WEBP")
+        return "webp";
+    if (header.startsWith("BM"))
+        return "bmp";
+    // icon directory with at least one image
+    if (header.startsWith(QByteArray("\0\0\1\0", 4)) && header.size() >= 6
+            && (header.at(4) != 0 || header.at(5) != 0))
+        return "ico";
+    if (header.startsWith("icns"))
+        return "icns";
+    if (header.startsWith("DDS "))
+        return "dds";
+    if (header.startsWith(QByteArray("\0\0\0\x0CjP  ", 8)))
+        return "jp2";
+    if (header.startsWith("/* XPM */"))
+        return "xpm";
+    if (header.startsWith("#define"))
+        return "xbm";
+    if (header.size() >= 3 && header.at(0) == 'P'
+            && header.at(1) >= '1' && header.at(1) <= '6'
+            && QByteArray(" \t\r\n#").contains(header.at(2))) {
+        switch (header.at(1)) {
+        case '1':
+        case '4':
+            return "pbm";
+        case '2':
+        case '5':
+            return "pgm";
+        default:
+            return "ppm";
+        }
+    }
+    return QByteArray();
+}
+
+/** Returns lower case extension of \a filePath file name. */
+QByteArray ImageFormatRegistry::extensionFormat(const QString &filePath) {
+    const int dot = filePath.lastIndexOf('.');
+    if (dot < 0 || filePath.indexOf('/', dot) >= 0
+            || filePath.indexOf('\\', dot) >= 0)
+        return QByteArray();
+    return filePath.mid(dot + 1).toLower().toLatin1();
+}
@@ -0,0 +1,63 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef IMAGEFORMATREGISTRY_HPP
+#define IMAGEFORMATREGISTRY_HPP
+
+#include <QByteArray>
+#include <QList>
+#include <QSet>
+
+
+/** \brief Registry of image formats readable by Qt image plugins.
+  *
+  * The registry is built once per process, so checking the format of each
+  * converted image doesn't query image plugins again. The format of an image
+  * is detected from its first bytes (magic numbers); the file name extension
+  * is used only if the bytes don't match any known format. Mislabelled files
+  * are therefore decoded by the right plugin without a failed decode.
+  *
+  * \sa ConvertThread::isRegularImageToLoad() RawLoader::isRawImage()
+  */
+class ImageFormatRegistry {
+public:
+    static const ImageFormatRegistry *instance();
+
+    enum {
+        HeaderSize = 16 /**< Count of first bytes used for detection. */
+    };
+
+    QList<QByteArray> formats() const;
+    bool isReadable(const QByteArray &format) const;
+    QByteArray format(const QString &filePath,
+                      const QByteArray &data = QByteArray()) const;
+    static QByteArray detectFormat(const QByteArray &header);
+    static QByteArray extensionFormat(const QString &filePath);
+
+private:
+    ImageFormatRegistry();
+
+    QSet<QByteArray> readable; /**< Lower case readable formats. */
+
+    Q_DISABLE_COPY(ImageFormatRegistry)
+};
+
+#endif // IMAGEFORMATREGISTRY_HPP
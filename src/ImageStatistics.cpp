@@ -0,0 +1,206 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "ImageStatistics.hpp"
+
+#include "CancellationToken.hpp"
+#include "ConvertBands.hpp"
+
+#include <QImage>
+#include <QImageReader>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+
+#include <cstring>
+
+
+namespace {
+
+/** Counts color values of row bands of 32-bit image. Each band counts into
+  * its own bins, which are added to #bins when the band is done.
+  */
+class HistogramTask : public ConvertBandTask {
+public:
+    explicit HistogramTask(const QImage &image)
+        : image(image), bins(256) {}
+
+    void run(int begin, int end) {
+        int counts[3][256];
+        std::memset(counts, 0, sizeof(counts));
+        const int width = image.width();
+        const bool premultiplied =
+                (image.format() == QImage::Format_ARGB32_Premultiplied);
+        for (int y=begin; y<end && !isCancelled(); y++) {
+            const QRgb *pixels =
+                    reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            for (int x=0; x<width; x++) {
+                const QRgb rgb = premultiplied ? qUnpremultiply(pixels[x])
+                                               : pixels[x];
+                counts[0][qRed(rgb)]++;
+                counts[1][qGreen(rgb)]++;
+                counts[2][qBlue(rgb)]++;
+            }
+        }
+        QMutexLocker locker(&mutex);
+        for (int i=0; i<bins.size(); i++) {
+            bins[i].red += counts[0][i];
+            bins[i].green += counts[1][i];
+            bins[i].blue += counts[2][i];
+        }
+    }
+
+    const QImage &image;
+    QVector<Rgb> bins;
+
+private:
+    QMutex mutex;
+};
+
+}
+
+
+/** Creates null statistics object. */
+ImageStatistics::ImageStatistics() : count(0) {}
+
+/** Computes statistics of \a image. Rows of large images are split into
+  * bands processed by \a executor threads. If \a token is cancelled during
+  * the pass, null statistics are returned.
+  */
+ImageStatistics::ImageStatistics(const QImage &image,
+                                 ConvertBandExecutor *executor,
+                                 const CancellationToken *token) : count(0) {
+    if (image.isNull())
+        return;
+    const QImage source = ConvertBands::rgb32Image(image);
+    HistogramTask task(source);
+    task.setCancellationToken(token);
+    ConvertBands::run(executor, &task, source.height(),
+                      qint64(source.width()) * source.height());
+    if (task.isCancelled())
+        return;
+
+    count = qint64(source.width()) * source.height();
+    bins = task.bins;
+    cumulative.resize(bins.size());
+    Rgb sum;
+    for (int i=0; i<bins.size(); i++) {
+        cumulative[i] = sum;
+        sum += bins[i];
+    }
+
+    int min[3] = { -1, -1, -1 };
+    int max[3] = { 0, 0, 0 };
+    for (int i=0; i<bins.size(); i++) {
+        const int counts[3] = { bins[i].red, bins[i].green, bins[i].blue };
+        for (int c=0; c<3; c++) {
+            if (counts[c] == 0)
+                continue;
+            if (min[c] < 0)
+                min[c] = i;
+            max[c] = i;
+        }
+    }
+    lowest.setRgb(min[0], min[1], min[2]);
+    highest.setRgb(max[0], max[1], max[2]);
+}
+
+/** Returns true if the statistics weren't computed. */
+bool ImageStatistics::isNull() const {
+    return count == 0;
+}
+
+/** Returns count of pixels of the image. */
+qint64 ImageStatistics::pixelCount() const {
+    return count;
+}
+
+/** Returns counts of pixel values. Index of vector is brightness and field
+  * of Rgb object is count of the value within a color channel.
+  */
+const QVector<Rgb> &ImageStatistics::histogram() const {
+    return bins;
+}
+
+/** Returns counts of pixel values lower than index of vector, so
+  * cumulativeHistogram()[n] is sum of first \a n histogram() items.
+  */
+const QVector<Rgb> &ImageStatistics::cumulativeHistogram() const {
+    return cumulative;
+}
+
+/** Returns color of minimum values of each color channel. */
+QColor ImageStatistics::minimum() const {
+    return lowest;
+}
+
+/** Returns color of maximum values of each color channel. */
+QColor ImageStatistics::maximum() const {
+    return highest;
+}
+
+/** Returns statistics of \a image. Statistics of last cacheSize images are
+  * kept, so the histogram effects and their color ranges computed for the
+  * same image data don't rescan pixels.
+  * \sa ImageStatistics(const QImage &, ConvertBandExecutor *,
+  *                     const CancellationToken *)
+  */
+ImageStatistics ImageStatistics::cached(const QImage &image,
+                                        ConvertBandExecutor *executor,
+                                        const CancellationToken *token) {
+    static QMutex mutex;
+    static QList<QPair<qint64, ImageStatistics> > cache;
+
+    const qint64 key = image.cacheKey();
+    {
+        QMutexLocker locker(&mutex);
+        for (int i=0; i<cache.size(); i++) {
+            if (cache[i].first == key) {
+                cache.move(i, 0);
+                return cache.first().second;
+            }
+        }
+    }
+
+    const ImageStatistics statistics(image, executor, token);
+    if (statistics.isNull())
+        return statistics;
+    QMutexLocker locker(&mutex);
+    cache.prepend(qMakePair(key, statistics));
+    if (cache.size() > cacheSize)
+        cache.removeLast();
+    return statistics;
+}
+
+/** Returns statistics of image file \a path. Images larger than \a maxSize
+  * pixels in width or height are downsampled while decoding, which is much
+  * faster than reading full image for formats like JPEG.
+  * \return Null statistics if the file can't be read.
+  */
+ImageStatistics ImageStatistics::fromFile(const QString &path, int maxSize) {
+    QImageReader reader(path);
+    const QSize size = reader.size();
+    if (size.isValid() && (size.width() > maxSize || size.height() > maxSize))
+        reader.setScaledSize(size.scaled(maxSize, maxSize,
+                                         Qt::KeepAspectRatio));
+    return ImageStatistics(reader.read());
+}
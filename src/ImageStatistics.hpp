@@ -0,0 +1,80 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef IMAGESTATISTICS_HPP
+#define IMAGESTATISTICS_HPP
+
+#include <QColor>
+#include <QVector>
+
+#include "Rgb.hpp"
+
+class CancellationToken;
+class ConvertBandExecutor;
+class QImage;
+class QString;
+
+/** \brief Color statistics of an image computed in single pixel pass.
+  *
+  * Histogram of each color channel is counted once. Channel ranges and
+  * cumulative histogram are derived from the histogram, so the image isn't
+  * scanned again. Large images are split into row bands processed in
+  * parallel; each band counts into its own bins merged at the end.
+  *
+  * cached() returns statistics computed for the same image data before.
+  * Modifying an image changes its QImage::cacheKey(), so the cache never
+  * returns statistics of old pixels.
+  *
+  * \sa ConvertEffects DetailsThumbnail
+  */
+class ImageStatistics {
+public:
+    ImageStatistics();
+    explicit ImageStatistics(const QImage &image,
+                             ConvertBandExecutor *executor = 0,
+                             const CancellationToken *token = 0);
+
+    bool isNull() const;
+    qint64 pixelCount() const;
+    const QVector<Rgb> &histogram() const;
+    const QVector<Rgb> &cumulativeHistogram() const;
+    QColor minimum() const;
+    QColor maximum() const;
+
+    static ImageStatistics cached(const QImage &image,
+                                  ConvertBandExecutor *executor = 0,
+                                  const CancellationToken *token = 0);
+    static ImageStatistics fromFile(const QString &path, int maxSize);
+
+    static const int cacheSize = 16; /**< Count of cached statistics. */
+
+private:
+    qint64 count; /**< Count of pixels. */
+    /** Counts of values of each color channel. \sa ConvertEffects::histogram() */
+    QVector<Rgb> bins;
+    /** Counts of values lower than index of each color channel. */
+    QVector<Rgb> cumulative;
+    QColor lowest;
+    QColor highest;
+};
+
+#endif // IMAGESTATISTICS_HPP
@@ -0,0 +1,221 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "ImageTransform.hpp"
+
+#include "ConvertBands.hpp"
+#include "PixelBufferPool.hpp"
+
+#include <QStringList>
+#include <QtMath>
+
+#include <cstring>
+
+
+namespace {
+
+/** Pixel of 24-bit image formats. */
+struct Pixel24 {
+    uchar bytes[3];
+};
+
+/** Returns true if \a value is 0, 1 or -1. */
+bool isUnit(qreal value) {
+    const qreal epsilon = 1e-9;
+    return qAbs(value) < epsilon || qAbs(qAbs(value) - 1.) < epsilon;
+}
+
+/** Copies pixels of source image into target image. Target pixel (x, y) is
+  * read from source byte offset \a origin + x * \a stepX + y * \a stepY.
+  */
+template <typename T>
+class PermuteTask : public ConvertBandTask {
+public:
+    PermuteTask(const QImage &source, QImage *target, qptrdiff origin,
+                qptrdiff stepX, qptrdiff stepY)
+        : source(source.constBits() + origin), target(target),
+          bits(target->bits()), stepX(stepX), stepY(stepY) {}
+
+    void run(int begin, int end) {
+        const int width = target->width();
+        const int bytesPerLine = target->bytesPerLine();
+        // mirrored rows are contiguous in the source too
+        if (stepX == qptrdiff(sizeof(T))) {
+            for (int y=begin; y<end; y++)
+                std::memcpy(bits + y * bytesPerLine, source + y * stepY,
+                            width * sizeof(T));
+            return;
+        }
+        const int blockSize = ImageTransform::blockSize;
+        for (int top=begin; top<end; top+=blockSize) {
+            const int bottom = qMin(top + blockSize, end);
+            for (int left=0; left<width; left+=blockSize) {
+                const int right = qMin(left + blockSize, width);
+                for (int y=top; y<bottom; y++) {
+                    T *pixel = reinterpret_cast<T *>(bits + y * bytesPerLine)
+                            + left;
+                    const uchar *sourcePixel = source + y * stepY
+                            + left * stepX;
+                    for (int x=left; x<right; x++, sourcePixel += stepX)
+                        *pixel++ = *reinterpret_cast<const T *>(sourcePixel);
+                }
+            }
+        }
+    }
+
+private:
+    const uchar *source;
+    QImage *target;
+    uchar *bits;
+    qptrdiff stepX;
+    qptrdiff stepY;
+};
+
+/** Runs PermuteTask of \a T pixels in bands. */
+template <typename T>
+void permute(ConvertBandExecutor *executor, const QImage &source,
+             QImage *target, qptrdiff origin, qptrdiff stepX, qptrdiff stepY) {
+    PermuteTask<T> task(source, target, origin, stepX, stepY);
+    ConvertBands::run(executor, &task, target->height(),
+                      qint64(target->width()) * target->height());
+}
+
+/** Returns source pixel of target pixel (\a x, \a y) center. */
+QPoint sourcePixel(const QTransform &inverse, const QPointF &topLeft,
+                   int x, int y) {
+    const QPointF point = inverse.map(topLeft + QPointF(x + .5, y + .5));
+    return QPoint(qFloor(point.x()), qFloor(point.y()));
+}
+
+}
+
+
+/** Creates transformation working in the calling thread. */
+ImageTransform::ImageTransform() : bandExecutor(0), pool(0) {}
+
+/** Sets threads copying row bands of large images. Null \a executor means
+  * images are transformed in the calling thread.
+  */
+void ImageTransform::setBandExecutor(ConvertBandExecutor *executor) {
+    bandExecutor = executor;
+}
+
+/** Sets \a pool of pixel buffers of exactly transformed images. */
+void ImageTransform::setBufferPool(PixelBufferPool *pool) {
+    this->pool = pool;
+}
+
+/** Returns \a image transformed by \a transform like QImage::transformed()
+  * with smooth transformation. Translation is ignored, the result contains
+  * the whole transformed image.
+  *
+  * Exact transformations keep pixels and format of \a image unchanged,
+  * see isExact().
+  */
+QImage ImageTransform::transformed(const QImage &image,
+                                   const QTransform &transform) const {
+    if (image.isNull() || transform.type() <= QTransform::TxTranslate)
+        return image;
+    if (isExact(transform)) {
+        const QImage result = permuted(image, transform);
+        if (!result.isNull())
+            return result;
+    }
+    return image.transformed(transform, Qt::SmoothTransformation);
+}
+
+/** Returns true if \a transform only rotates by a multiple of 90 degrees,
+  * mirrors or translates, so it's a permutation of pixels.
+  */
+bool ImageTransform::isExact(const QTransform &transform) {
+    if (!isUnit(transform.m11()) || !isUnit(transform.m12())
+            || !isUnit(transform.m21()) || !isUnit(transform.m22()))
+        return false;
+    if (transform.type() == QTransform::TxProject)
+        return false;
+    const bool straight = qAbs(transform.m11()) > .5
+            && qAbs(transform.m22()) > .5 && qAbs(transform.m12()) < .5
+            && qAbs(transform.m21()) < .5;
+    const bool transposed = qAbs(transform.m11()) < .5
+            && qAbs(transform.m22()) < .5 && qAbs(transform.m12()) > .5
+            && qAbs(transform.m21()) > .5;
+    return straight || transposed;
+}
+
+/** Returns \a image transformed by exact \a transform or null image if the
+  * image format isn't supported or the memory can't be allocated.
+  */
+QImage ImageTransform::permuted(const QImage &image,
+                                const QTransform &transform) const {
+    const int depth = image.depth();
+    if (depth != 8 && depth != 16 && depth != 24 && depth != 32
+            && depth != 64)
+        return QImage();
+    const QTransform linear(qRound(transform.m11()), qRound(transform.m12()),
+                            qRound(transform.m21()), qRound(transform.m22()),
+                            0., 0.);
+    const QRectF bounds = linear.mapRect(QRectF(QPointF(), image.size()));
+    const QSize size = bounds.size().toSize();
+    QImage result = pool ? pool->image(size, image.format())
+                         : QImage(size, image.format());
+    if (result.isNull())
+        return QImage();
+    result.setColorTable(image.colorTable());
+    const bool swapAxes = qAbs(linear.m11()) < .5;
+    result.setDotsPerMeterX(swapAxes ? image.dotsPerMeterY()
+                                     : image.dotsPerMeterX());
+    result.setDotsPerMeterY(swapAxes ? image.dotsPerMeterX()
+                                     : image.dotsPerMeterY());
+    foreach (const QString &key, image.textKeys())
+        result.setText(key, image.text(key));
+
+    // source pixels of the first target pixel and its neighbours
+    const QTransform inverse = linear.inverted();
+    const QPoint origin = sourcePixel(inverse, bounds.topLeft(), 0, 0);
+    const QPoint right = sourcePixel(inverse, bounds.topLeft(), 1, 0)
+            - origin;
+    const QPoint down = sourcePixel(inverse, bounds.topLeft(), 0, 1) - origin;
+    const int bytesPerPixel = depth / 8;
+    const qptrdiff bytesPerLine = image.bytesPerLine();
+    const qptrdiff offset = origin.y() * bytesPerLine
+            + origin.x() * bytesPerPixel;
+    const qptrdiff stepX = right.y() * bytesPerLine + right.x() * bytesPerPixel;
+    const qptrdiff stepY = down.y() * bytesPerLine + down.x() * bytesPerPixel;
+    switch (depth) {
+    case 8:
+        permute<quint8>(bandExecutor, image, &result, offset, stepX, stepY);
+        break;
+    case 16:
+        permute<quint16>(bandExecutor, image, &result, offset, stepX, stepY);
+        break;
+    case 24:
+        permute<Pixel24>(bandExecutor, image, &result, offset, stepX, stepY);
+        break;
+    case 32:
+        permute<quint32>(bandExecutor, image, &result, offset, stepX, stepY);
+        break;
+    default:
+        permute<quint64>(bandExecutor, image, &result, offset, stepX, stepY);
+        break;
+    }
+    return result;
+}
@@ -0,0 +1,70 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef IMAGETRANSFORM_HPP
+#define IMAGETRANSFORM_HPP
+
+#include <QImage>
+#include <QTransform>
+
+class ConvertBandExecutor;
+class PixelBufferPool;
+
+/** \brief Image transformation with exact quarter turns and mirrors.
+  *
+  * Rotations by multiples of 90 degrees, mirrors and their combinations
+  * don't need interpolation, they only move pixels. Such transformations are
+  * made by copying the pixels in square blocks of #blockSize pixels, so
+  * both source and target rows of each block stay in CPU cache. Other
+  * transformations are made by QImage::transformed() with smooth
+  * transformation.
+  *
+  * Large images are split into row bands processed in parallel by band
+  * executor threads, see setBandExecutor().
+  *
+  * \sa ConvertBands
+  */
+class ImageTransform {
+    friend class ImageTransformTest;
+
+public:
+    ImageTransform();
+    void setBandExecutor(ConvertBandExecutor *executor);
+    void setBufferPool(PixelBufferPool *pool);
+    QImage transformed(const QImage &image, const QTransform &transform) const;
+
+    static bool isExact(const QTransform &transform);
+
+    /** Width and height of pixel blocks copied at once. */
+    static const int blockSize = 64;
+
+private:
+    /** Threads processing row bands or null pointer.
+      * \sa setBandExecutor()
+      */
+    ConvertBandExecutor *bandExecutor;
+    PixelBufferPool *pool; /**< Pool of target images or null pointer. */
+
+    QImage permuted(const QImage &image, const QTransform &transform) const;
+};
+
+#endif // IMAGETRANSFORM_HPP
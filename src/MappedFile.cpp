@@ -0,0 +1,88 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "MappedFile.hpp"
+
+#include <climits>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#endif // Q_OS_UNIX
+
+
+/** Maps \a filePath file into memory. Empty files, files larger than byte
+  * array limit and files which can't be opened or mapped aren't mapped; see
+  * isMapped().
+  */
+MappedFile::MappedFile(const QString &filePath)
+    : file(filePath), address(0), length(0) {
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const qint64 fileSize = file.size();
+    if (fileSize <= 0 || fileSize > INT_MAX)
+        return;
+    address = file.map(0, fileSize);
+    if (address) {
+        length = fileSize;
+#ifdef Q_OS_UNIX
+        // decoders read images sequentially
+        posix_madvise(address, length, POSIX_MADV_SEQUENTIAL);
+#endif // Q_OS_UNIX
+    }
+    // the mapping stays valid after closing the file
+    file.close();
+}
+
+/** Unmaps the file. */
+MappedFile::~MappedFile() {
+    if (address)
+        file.unmap(address);
+}
+
+/** Returns true if the file is mapped, otherwise returns false. */
+bool MappedFile::isMapped() const {
+    return address != 0;
+}
+
+/** Returns size of the mapped file in bytes. */
+qint64 MappedFile::size() const {
+    return length;
+}
+
+/** Returns byte array referencing the mapping without copying, or empty byte
+  * array if the file isn't mapped.
+  */
+QByteArray MappedFile::data() const {
+    if (!address)
+        return QByteArray();
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(address),
+                                   int(length));
+}
+
+/** Asks the system to read the mapped file into the page cache in
+  * background. It's used by reader threads prefetching source files.
+  */
+void MappedFile::prefetch() {
+#ifdef Q_OS_UNIX
+    if (address)
+        posix_madvise(address, length, POSIX_MADV_WILLNEED);
+#endif // Q_OS_UNIX
+}
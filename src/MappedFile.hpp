@@ -0,0 +1,57 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <QByteArray>
+#include <QFile>
+
+
+/** \brief Read-only memory mapping of whole file.
+  *
+  * Image decoders and Exiv2 read the mapped file through data() byte array
+  * referencing the mapping, so file bytes are read from the page cache once
+  * and never copied into a heap buffer. The mapping may be shared by pipeline
+  * stages through QSharedPointer.
+  *
+  * \note Byte arrays returned by data() must not be used after the mapping
+  *       is destroyed.
+  * \sa ConvertPipelineItem::mapping
+  */
+class MappedFile {
+public:
+    explicit MappedFile(const QString &filePath);
+    ~MappedFile();
+    bool isMapped() const;
+    qint64 size() const;
+    QByteArray data() const;
+    void prefetch();
+
+private:
+    QFile file;
+    uchar *address; /**< Mapped file content or null pointer. */
+    qint64 length; /**< Size of the mapping in bytes. */
+
+    Q_DISABLE_COPY(MappedFile)
+};
+
+#endif // MAPPEDFILE_HPP
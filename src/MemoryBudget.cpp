@@ -0,0 +1,119 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "MemoryBudget.hpp"
+
+#include <QElapsedTimer>
+#include <QFile>
+
+
+/** Creates budget of \a capacity bytes. 0 means unlimited budget. */
+MemoryBudget::MemoryBudget(qint64 capacity) : total(capacity), used(0) {}
+
+/** Sets capacity of the budget to \a bytes and wakes up waiting threads.
+  * 0 means unlimited budget.
+  */
+void MemoryBudget::setCapacity(qint64 bytes) {
+    QMutexLocker locker(&mutex);
+    total = qMax<qint64>(0, bytes);
+    released.wakeAll();
+}
+
+/** Returns capacity in bytes or 0 if the budget is unlimited. */
+qint64 MemoryBudget::capacity() const {
+    QMutexLocker locker(&mutex);
+    return total;
+}
+
+/** Returns count of reserved bytes. */
+qint64 MemoryBudget::usedBytes() const {
+    QMutexLocker locker(&mutex);
+    return used;
+}
+
+/** Returns true if \a bytes bytes may be ever reserved. */
+bool MemoryBudget::fits(qint64 bytes) const {
+    QMutexLocker locker(&mutex);
+    return total == 0 || bytes <= total;
+}
+
+/** Reserves \a bytes bytes. Blocks the calling thread until enough bytes
+  * are released by other threads or \a time milliseconds has elapsed.
+  * \return True if the bytes were reserved, otherwise false. False is returned
+  *         immediately if the reservation never fits the budget.
+  * \sa release() fits()
+  */
+bool MemoryBudget::acquire(qint64 bytes, unsigned long time) {
+    QMutexLocker locker(&mutex);
+    QElapsedTimer timer;
+    timer.start();
+    forever {
+        if (total > 0 && bytes > total)
+            return false;
+        if (total == 0 || used + bytes <= total)
+            break;
+        unsigned long left = ULONG_MAX;
+        if (time != ULONG_MAX) {
+            const qint64 elapsed = timer.elapsed();
+            if (elapsed >= qint64(time))
+                return false;
+            left = time - elapsed;
+        }
+        released.wait(&mutex, left);
+    }
+    used += bytes;
+    return true;
+}
+
+/** Releases \a bytes bytes reserved by acquire() and wakes up waiting
+  * threads.
+  */
+void MemoryBudget::release(qint64 bytes) {
+    QMutexLocker locker(&mutex);
+    used = qMax<qint64>(0, used - bytes);
+    released.wakeAll();
+}
+
+/** Returns size of physical memory in bytes or 0 if it's unknown.
+  * \note Physical memory size is available on Linux only.
+  */
+qint64 MemoryBudget::physicalMemorySize() {
+    QFile file("/proc/meminfo");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return 0;
+    foreach (const QByteArray &line, file.readAll().split('\n')) {
+        // MemTotal:       16309856 kB
+        QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.count() >= 2 && fields.first() == "MemTotal:")
+            return fields.at(1).toLongLong() * 1024;
+    }
+    return 0;
+}
+
+/** Returns budget capacity used if the user didn't set it: half of physical
+  * memory or 2 GiB if physical memory size is unknown.
+  */
+qint64 MemoryBudget::defaultCapacity() {
+    const qint64 physical = physicalMemorySize();
+    if (physical > 0)
+        return physical / 2;
+    return Q_INT64_C(2) << 30;
+}
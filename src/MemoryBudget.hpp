@@ -0,0 +1,86 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <climits>
+
+
+/** \brief Admission control of memory used by decoded images.
+  *
+  * Before decoding an image each convert thread reserves estimated count of
+  * bytes needed by the image and its copies. If the budget is exhausted the
+  * thread waits until other threads release their reservations. Reservation
+  * bigger than whole capacity never fits, so such images are rejected before
+  * decoding; it also guards against decompression bombs.
+  *
+  * \sa MemoryReservation ConvertScheduler::memoryBudget()
+  */
+class MemoryBudget {
+public:
+    explicit MemoryBudget(qint64 capacity = 0);
+    void setCapacity(qint64 bytes);
+    qint64 capacity() const;
+    qint64 usedBytes() const;
+    bool fits(qint64 bytes) const;
+    bool acquire(qint64 bytes, unsigned long time = ULONG_MAX);
+    void release(qint64 bytes);
+
+    static qint64 physicalMemorySize();
+    static qint64 defaultCapacity();
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition released;
+    qint64 total; /**< Capacity in bytes or 0 if the budget is unlimited. */
+    qint64 used; /**< Reserved bytes. */
+
+    Q_DISABLE_COPY(MemoryBudget)
+};
+
+/** \brief Releases bytes reserved in MemoryBudget when goes out of scope. */
+class MemoryReservation {
+public:
+    explicit MemoryReservation(MemoryBudget *budget = 0)
+        : budget(budget), bytes(0) {}
+    ~MemoryReservation() { release(); }
+
+    /** Remembers \a count bytes acquired by the caller. */
+    void reserved(qint64 count) { bytes += count; }
+    /** Releases all remembered bytes. */
+    void release() {
+        if (budget && bytes > 0)
+            budget->release(bytes);
+        bytes = 0;
+    }
+
+private:
+    MemoryBudget *budget;
+    qint64 bytes;
+
+    Q_DISABLE_COPY(MemoryReservation)
+};
+
+#endif // MEMORYBUDGET_HPP
@@ -0,0 +1,236 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "PixelBufferPool.hpp"
+
+#include <QMultiMap>
+#include <QMutex>
+
+#include <climits>
+#include <cstdlib>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif // Q_OS_LINUX
+
+
+/** Buffers of the pool. The shelf is destroyed when the pool and all images
+  * taken from the pool are destroyed.
+  */
+struct PixelBufferPool::Shelf {
+    //! Header stored before pixels of each buffer.
+    struct Header {
+        Shelf *shelf;
+        qint64 size; /**< Size class of the buffer. */
+    };
+
+    explicit Shelf(qint64 capacity) : ref(1), capacity(capacity) {}
+    uchar *take(qint64 size);
+    void release(uchar *buffer);
+    void evict(qint64 limit);
+
+    /** Count of references held by the pool and not released buffers. */
+    QAtomicInt ref;
+    QMutex mutex;
+    qint64 capacity; /**< Maximal bytes of idle buffers. */
+    QMultiMap<qint64, uchar*> idle; /**< Idle buffers by size class. */
+    Statistics counters;
+};
+
+/** Size of buffer header in bytes. Pixels following the header are aligned
+  * as well as the buffer.
+  */
+static const int headerSize = 64;
+
+/** Returns idle buffer of \a size bytes or allocates new one. Returns null
+  * pointer if the allocation failed.
+  */
+uchar *PixelBufferPool::Shelf::take(qint64 size) {
+    QMutexLocker locker(&mutex);
+    QMultiMap<qint64, uchar*>::iterator it = idle.find(size);
+    uchar *buffer = 0;
+    if (it != idle.end()) {
+        buffer = it.value();
+        idle.erase(it);
+        counters.cachedBytes -= size;
+        counters.reuses++;
+    }
+    else {
+        buffer = static_cast<uchar*>(malloc(size_t(headerSize + size)));
+        if (!buffer)
+            return 0;
+        Header *header = reinterpret_cast<Header*>(buffer);
+        header->shelf = this;
+        header->size = size;
+        counters.allocations++;
+    }
+    ref.ref();
+    return buffer;
+}
+
+/** Puts \a buffer back on the shelf if it fits the capacity. */
+void PixelBufferPool::Shelf::release(uchar *buffer) {
+    const qint64 size = reinterpret_cast<Header*>(buffer)->size;
+    QMutexLocker locker(&mutex);
+    idle.insert(size, buffer);
+    counters.cachedBytes += size;
+    evict(capacity);
+}
+
+/** Frees the largest idle buffers until idle bytes don't exceed \a limit.
+  * \note The caller must lock the mutex.
+  */
+void PixelBufferPool::Shelf::evict(qint64 limit) {
+    while (counters.cachedBytes > limit && !idle.isEmpty()) {
+        QMultiMap<qint64, uchar*>::iterator it = idle.end();
+        --it;
+        counters.cachedBytes -= it.key();
+        free(it.value());
+        idle.erase(it);
+    }
+}
+
+
+/** Creates empty pool keeping up to \a capacity bytes of idle buffers. */
+PixelBufferPool::PixelBufferPool(qint64 capacity)
+    : shelf(new Shelf(qMax<qint64>(0, capacity))) {}
+
+/** Frees idle buffers. Buffers of images still alive are freed when the
+  * images are destroyed.
+  */
+PixelBufferPool::~PixelBufferPool() {
+    setCapacity(0);
+    if (!shelf->ref.deref())
+        delete shelf;
+}
+
+/** Sets capacity of idle buffers to \a bytes and frees buffers above it. */
+void PixelBufferPool::setCapacity(qint64 bytes) {
+    QMutexLocker locker(&shelf->mutex);
+    shelf->capacity = qMax<qint64>(0, bytes);
+    shelf->evict(shelf->capacity);
+}
+
+/** Returns capacity of idle buffers in bytes. */
+qint64 PixelBufferPool::capacity() const {
+    QMutexLocker locker(&shelf->mutex);
+    return shelf->capacity;
+}
+
+/** Returns uninitialized image of \a size and \a format. Pixels of large
+  * image are stored in buffer of the pool, which is released when the last
+  * copy of the image is destroyed. Returns null image if \a size is empty or
+  * the memory can't be allocated.
+  * \note The returned image may be passed to QImageReader::read(), because
+  *       image plugins reuse the image of the same size and format.
+  */
+QImage PixelBufferPool::image(const QSize &size, QImage::Format format) {
+    if (size.isEmpty() || format == QImage::Format_Invalid)
+        return QImage();
+    const int depth = QImage::toPixelFormat(format).bitsPerPixel();
+    const qint64 bytesPerLine = ((qint64(size.width()) * depth + 31) >> 5) << 2;
+    const qint64 bytes = bytesPerLine * size.height();
+    if (bytes < minPooledBytes || bytesPerLine > INT_MAX)
+        return QImage(size, format);
+    uchar *buffer = shelf->take(sizeClass(bytes));
+    if (!buffer)
+        return QImage();
+    return QImage(buffer + headerSize, size.width(), size.height(),
+                  int(bytesPerLine), format, releaseBuffer, buffer);
+}
+
+/** Frees all idle buffers, e.g. when the batch is finished. */
+void PixelBufferPool::trim() {
+    QMutexLocker locker(&shelf->mutex);
+    shelf->evict(0);
+}
+
+/** Returns counters of the pool. */
+PixelBufferPool::Statistics PixelBufferPool::statistics() const {
+    QMutexLocker locker(&shelf->mutex);
+    return shelf->counters;
+}
+
+/** Adds \a count page faults to the statistics. The owner thread counts page
+  * faults of converted images, see threadPageFaults().
+  */
+void PixelBufferPool::addPageFaults(qint64 count) {
+    QMutexLocker locker(&shelf->mutex);
+    shelf->counters.pageFaults += qMax<qint64>(0, count);
+}
+
+/** Returns size class of buffer of \a bytes bytes. Size classes are spaced
+  * by quarters of powers of two, so at most 25% of a buffer is wasted.
+  */
+qint64 PixelBufferPool::sizeClass(qint64 bytes) {
+    if (bytes <= minPooledBytes)
+        return minPooledBytes;
+    qint64 power = minPooledBytes;
+    while (power * 2 < bytes)
+        power *= 2;
+    const qint64 step = power / 4;
+    return (bytes + step - 1) / step * step;
+}
+
+/** Returns count of page faults of the calling thread or -1 if it's unknown.
+  * \note Thread page faults are available on Linux only.
+  */
+qint64 PixelBufferPool::threadPageFaults() {
+#ifdef Q_OS_LINUX
+    rusage usage;
+    if (getrusage(RUSAGE_THREAD, &usage) == 0)
+        return qint64(usage.ru_minflt) + usage.ru_majflt;
+#endif // Q_OS_LINUX
+    return -1;
+}
+
+/** Returns \a buffer to its pool. Called when the last copy of an image
+  * returned by image() is destroyed.
+  */
+void PixelBufferPool::releaseBuffer(void *buffer) {
+    uchar *data = static_cast<uchar*>(buffer);
+    Shelf *shelf = reinterpret_cast<Shelf::Header*>(data)->shelf;
+    shelf->release(data);
+    if (!shelf->ref.deref())
+        delete shelf;
+}
+
+/** Adds counters of \a other pool. */
+PixelBufferPool::Statistics &PixelBufferPool::Statistics::operator+=(
+        const Statistics &other) {
+    allocations += other.allocations;
+    reuses += other.reuses;
+    pageFaults += other.pageFaults;
+    cachedBytes += other.cachedBytes;
+    return *this;
+}
+
+/** Subtracts counters of \a other statistics taken earlier. #cachedBytes
+  * isn't a counter, so it's left unchanged.
+  */
+PixelBufferPool::Statistics &PixelBufferPool::Statistics::operator-=(
+        const Statistics &other) {
+    allocations -= other.allocations;
+    reuses -= other.reuses;
+    pageFaults -= other.pageFaults;
+    return *this;
+}
@@ -0,0 +1,83 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef PIXELBUFFERPOOL_HPP
+#define PIXELBUFFERPOOL_HPP
+
+#include <QImage>
+
+
+/** \brief Cache of pixel buffers reused by images of consecutive jobs.
+  *
+  * Each convert thread owns its pool. image() returns QImage object sharing
+  * pixel buffer taken from the pool; the buffer goes back to the pool when
+  * the last copy of the image is destroyed. Buffer sizes are rounded up to
+  * size classes, so images of similar size reuse the same buffers and their
+  * pages are faulted in once instead of for each image.
+  *
+  * Idle buffers above capacity() bytes are freed. Small images aren't pooled.
+  *
+  * \sa statistics()
+  */
+class PixelBufferPool {
+public:
+    //! Counters of pool buffers.
+    struct Statistics {
+        Statistics()
+            : allocations(0), reuses(0), pageFaults(0), cachedBytes(0) {}
+        Statistics &operator+=(const Statistics &other);
+        Statistics &operator-=(const Statistics &other);
+
+        qint64 allocations; /**< Count of buffers allocated from the heap. */
+        qint64 reuses; /**< Count of buffers reused from the pool. */
+        /** Count of page faults of the owner thread. \sa addPageFaults() */
+        qint64 pageFaults;
+        qint64 cachedBytes; /**< Bytes of idle buffers kept by the pool. */
+    };
+
+    explicit PixelBufferPool(qint64 capacity = defaultCapacity);
+    ~PixelBufferPool();
+    void setCapacity(qint64 bytes);
+    qint64 capacity() const;
+    QImage image(const QSize &size, QImage::Format format);
+    void trim();
+    Statistics statistics() const;
+    void addPageFaults(qint64 count);
+
+    static qint64 sizeClass(qint64 bytes);
+    static qint64 threadPageFaults();
+
+    /** Default capacity of idle buffers in bytes. */
+    static const qint64 defaultCapacity = Q_INT64_C(256) << 20;
+    /** Minimal size of pooled buffer in bytes. */
+    static const int minPooledBytes = 64 * 1024;
+
+private:
+    struct Shelf;
+    Shelf *shelf; /**< Buffers shared with images taken from the pool. */
+
+    static void releaseBuffer(void *buffer);
+
+    Q_DISABLE_COPY(PixelBufferPool)
+};
+
+#endif // PIXELBUFFERPOOL_HPP
@@ -0,0 +1,697 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "Resampler.hpp"
+
+#include "ConvertBands.hpp"
+#include "PixelBufferPool.hpp"
+#include "Simd.hpp"
+
+#include <QVector>
+
+#include <cmath>
+
+
+namespace {
+
+typedef Resampler::FilterTable FilterTable;
+
+/** Rounding term added to sums of fixed point products. */
+const int half = 1 << (Resampler::precisionBits - 1);
+
+/** Returns value of sinc function of \a x. */
+double sinc(double x) {
+    if (x == 0.)
+        return 1.;
+    x *= 3.14159265358979323846;
+    return std::sin(x) / x;
+}
+
+/** Returns pixel of fixed point channel \a sums stored in QRgb order: blue,
+  * green, red and alpha.
+  */
+inline QRgb packPixel(const int *sums) {
+    int channels[4];
+    for (int c=0; c<4; c++)
+        channels[c] = qBound(0, sums[c] >> Resampler::precisionBits, 255);
+    // premultiplied colors never exceed alpha
+    const int alpha = channels[3];
+    return qRgba(qMin(channels[2], alpha), qMin(channels[1], alpha),
+                 qMin(channels[0], alpha), alpha);
+}
+
+/** Adds \a pixel multiplied by \a weight to channel \a sums. */
+inline void addPixel(int *sums, QRgb pixel, int weight) {
+    sums[0] += weight * int(pixel & 0xff);
+    sums[1] += weight * int((pixel >> 8) & 0xff);
+    sums[2] += weight * int((pixel >> 16) & 0xff);
+    sums[3] += weight * int(pixel >> 24);
+}
+
+/** Scales \a source row into \a width pixels of \a target row. */
+typedef void (*HorizontalFunction)(const QRgb *source, QRgb *target,
+                                   int width, const FilterTable &table);
+/** Computes \a width pixels of \a target row as sum of \a count \a rows
+  * multiplied by \a weights.
+  */
+typedef void (*VerticalFunction)(const QRgb *const *rows,
+                                 const qint16 *weights, int count,
+                                 QRgb *target, int width);
+
+void horizontalGeneric(const QRgb *source, QRgb *target, int width,
+                       const FilterTable &table) {
+    for (int x=0; x<width; x++) {
+        const QRgb *pixel = source + table.firsts.at(x);
+        const qint16 *weights = table.weights.constData() + x * table.taps;
+        const int count = table.counts.at(x);
+        int sums[4] = { half, half, half, half };
+        for (int i=0; i<count; i++)
+            addPixel(sums, pixel[i], weights[i]);
+        target[x] = packPixel(sums);
+    }
+}
+
+/** Computes pixels from \a begin to \a end exclusive of vertical pass.
+  * \sa VerticalFunction
+  */
+void verticalRangeGeneric(const QRgb *const *rows, const qint16 *weights,
+                          int count, QRgb *target, int begin, int end) {
+    for (int x=begin; x<end; x++) {
+        int sums[4] = { half, half, half, half };
+        for (int i=0; i<count; i++)
+            addPixel(sums, rows[i][x], weights[i]);
+        target[x] = packPixel(sums);
+    }
+}
+
+void verticalGeneric(const QRgb *const *rows, const qint16 *weights,
+                     int count, QRgb *target, int width) {
+    verticalRangeGeneric(rows, weights, count, target, 0, width);
+}
+
+#ifdef SIR_SIMD
+/** Returns \a first and \a second weights packed in 16-bit halves. */
+inline int weightBits(qint16 first, qint16 second) {
+    return int(quint32(quint16(first)) | (quint32(quint16(second)) << 16));
+}
+
+/** Returns \a first and \a second weights repeated in 16-bit lanes. */
+inline __m128i weightPair(qint16 first, qint16 second) {
+    return _mm_set1_epi32(weightBits(first, second));
+}
+
+/** Limits colors of premultiplied \a pixels to their alpha. */
+inline __m128i clampToAlpha(__m128i pixels) {
+    __m128i alpha = _mm_srli_epi32(pixels, 24);
+    alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+    alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+    return _mm_min_epu8(pixels, alpha);
+}
+
+/** Returns pixel of fixed point channel \a sums. \sa packPixel() */
+inline QRgb packPixelSse2(__m128i sums) {
+    sums = _mm_srai_epi32(sums, Resampler::precisionBits);
+    sums = _mm_packs_epi32(sums, sums);
+    sums = _mm_packus_epi16(sums, sums);
+    return QRgb(_mm_cvtsi128_si32(clampToAlpha(sums)));
+}
+
+/** Adds source pixels from \a index to \a count of horizontal pass to
+  * \a sums taking two pixels at once.
+  */
+inline __m128i addPixelsSse2(__m128i sums, const QRgb *pixel,
+                             const qint16 *weights, int index, int count) {
+    const __m128i zero = _mm_setzero_si128();
+    for (; index + 2 <= count; index += 2) {
+        __m128i pixels = _mm_unpacklo_epi8(
+                    _mm_loadl_epi64(
+                        reinterpret_cast<const __m128i *>(pixel + index)),
+                    zero);
+        // channels of both pixels in adjacent lanes
+        pixels = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+        sums = _mm_add_epi32(sums, _mm_madd_epi16(
+                                 pixels, weightPair(weights[index],
+                                                    weights[index + 1])));
+    }
+    if (index < count) {
+        __m128i pixels = _mm_unpacklo_epi8(
+                    _mm_cvtsi32_si128(int(pixel[index])), zero);
+        pixels = _mm_unpacklo_epi16(pixels, zero);
+        sums = _mm_add_epi32(sums, _mm_madd_epi16(
+                                 pixels, weightPair(weights[index], 0)));
+    }
+    return sums;
+}
+
+void horizontalSse2(const QRgb *source, QRgb *target, int width,
+                    const FilterTable &table) {
+    for (int x=0; x<width; x++) {
+        const qint16 *weights = table.weights.constData() + x * table.taps;
+        const __m128i sums = addPixelsSse2(
+                    _mm_set1_epi32(half), source + table.firsts.at(x),
+                    weights, 0, table.counts.at(x));
+        target[x] = packPixelSse2(sums);
+    }
+}
+
+/** Computes pixels from \a begin to \a end exclusive of vertical pass taking
+  * four pixels of two rows at once.
+  */
+void verticalRangeSse2(const QRgb *const *rows, const qint16 *weights,
+                       int count, QRgb *target, int begin, int end) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = begin;
+    for (; x + 4 <= end; x += 4) {
+        __m128i sums[4];
+        for (int j=0; j<4; j++)
+            sums[j] = _mm_set1_epi32(half);
+        for (int i=0; i<count; i += 2) {
+            const bool pair = (i + 1 < count);
+            const __m128i weight = weightPair(weights[i],
+                                              pair ? weights[i + 1] : 0);
+            const __m128i first = _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(rows[i] + x));
+            const __m128i second = pair ? _mm_loadu_si128(
+                        reinterpret_cast<const __m128i *>(rows[i + 1] + x))
+                                        : zero;
+            // channels of both rows in adjacent lanes
+            const __m128i low = _mm_unpacklo_epi8(first, second);
+            const __m128i high = _mm_unpackhi_epi8(first, second);
+            sums[0] = _mm_add_epi32(sums[0], _mm_madd_epi16(
+                                        _mm_unpacklo_epi8(low, zero), weight));
+            sums[1] = _mm_add_epi32(sums[1], _mm_madd_epi16(
+                                        _mm_unpackhi_epi8(low, zero), weight));
+            sums[2] = _mm_add_epi32(sums[2], _mm_madd_epi16(
+                                        _mm_unpacklo_epi8(high, zero), weight));
+            sums[3] = _mm_add_epi32(sums[3], _mm_madd_epi16(
+                                        _mm_unpackhi_epi8(high, zero), weight));
+        }
+        for (int j=0; j<4; j++)
+            sums[j] = _mm_srai_epi32(sums[j], Resampler::precisionBits);
+        const __m128i pixels = _mm_packus_epi16(
+                    _mm_packs_epi32(sums[0], sums[1]),
+                    _mm_packs_epi32(sums[2], sums[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + x),
+                         clampToAlpha(pixels));
+    }
+    verticalRangeGeneric(rows, weights, count, target, x, end);
+}
+
+void verticalSse2(const QRgb *const *rows, const qint16 *weights,
+                  int count, QRgb *target, int width) {
+    verticalRangeSse2(rows, weights, count, target, 0, width);
+}
+
+/** Limits colors of premultiplied \a pixels to their alpha. */
+SIR_TARGET_AVX2
+inline __m256i clampToAlphaAvx2(__m256i pixels) {
+    __m256i alpha = _mm256_srli_epi32(pixels, 24);
+    alpha = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 8));
+    alpha = _mm256_or_si256(alpha, _mm256_slli_epi32(alpha, 16));
+    return _mm256_min_epu8(pixels, alpha);
+}
+
+/** Scales row taking four source pixels at once. */
+SIR_TARGET_AVX2
+void horizontalAvx2(const QRgb *source, QRgb *target, int width,
+                    const FilterTable &table) {
+    // channels of pixel pairs in adjacent bytes
+    const __m128i shuffle = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7,
+                                          8, 12, 9, 13, 10, 14, 11, 15);
+    for (int x=0; x<width; x++) {
+        const QRgb *pixel = source + table.firsts.at(x);
+        const qint16 *weights = table.weights.constData() + x * table.taps;
+        const int count = table.counts.at(x);
+        __m256i wideSums = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128i pixels = _mm_shuffle_epi8(
+                        _mm_loadu_si128(
+                            reinterpret_cast<const __m128i *>(pixel + i)),
+                        shuffle);
+            const __m256i weight = _mm256_inserti128_si256(
+                        _mm256_castsi128_si256(
+                            weightPair(weights[i], weights[i + 1])),
+                        weightPair(weights[i + 2], weights[i + 3]), 1);
+            wideSums = _mm256_add_epi32(wideSums, _mm256_madd_epi16(
+                                            _mm256_cvtepu8_epi16(pixels),
+                                            weight));
+        }
+        __m128i sums = _mm_add_epi32(
+                    _mm_set1_epi32(half),
+                    _mm_add_epi32(_mm256_castsi256_si128(wideSums),
+                                  _mm256_extracti128_si256(wideSums, 1)));
+        sums = addPixelsSse2(sums, pixel, weights, i, count);
+        target[x] = packPixelSse2(sums);
+    }
+}
+
+/** Computes row of vertical pass taking eight pixels of two rows at once. */
+SIR_TARGET_AVX2
+void verticalAvx2(const QRgb *const *rows, const qint16 *weights,
+                  int count, QRgb *target, int width) {
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m256i sums[4];
+        for (int j=0; j<4; j++)
+            sums[j] = _mm256_set1_epi32(half);
+        for (int i=0; i<count; i += 2) {
+            const bool pair = (i + 1 < count);
+            const __m256i weight = _mm256_set1_epi32(
+                        weightBits(weights[i], pair ? weights[i + 1] : 0));
+            const __m256i first = _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(rows[i] + x));
+            const __m256i second = pair ? _mm256_loadu_si256(
+                        reinterpret_cast<const __m256i *>(rows[i + 1] + x))
+                                        : zero;
+            // 128-bit lanes keep pixels 0-3 and 4-7 apart
+            const __m256i low = _mm256_unpacklo_epi8(first, second);
+            const __m256i high = _mm256_unpackhi_epi8(first, second);
+            sums[0] = _mm256_add_epi32(sums[0], _mm256_madd_epi16(
+                                    _mm256_unpacklo_epi8(low, zero), weight));
+            sums[1] = _mm256_add_epi32(sums[1], _mm256_madd_epi16(
+                                    _mm256_unpackhi_epi8(low, zero), weight));
+            sums[2] = _mm256_add_epi32(sums[2], _mm256_madd_epi16(
+                                    _mm256_unpacklo_epi8(high, zero), weight));
+            sums[3] = _mm256_add_epi32(sums[3], _mm256_madd_epi16(
+                                    _mm256_unpackhi_epi8(high, zero), weight));
+        }
+        for (int j=0; j<4; j++)
+            sums[j] = _mm256_srai_epi32(sums[j], Resampler::precisionBits);
+        const __m256i pixels = _mm256_packus_epi16(
+                    _mm256_packs_epi32(sums[0], sums[1]),
+                    _mm256_packs_epi32(sums[2], sums[3]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + x),
+                            clampToAlphaAvx2(pixels));
+    }
+    verticalRangeSse2(rows, weights, count, target, x, width);
+}
+
+/** Returns the best instruction set supported by CPU and operating system. */
+Resampler::InstructionSet detectInstructionSet() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Resampler::Avx2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        // AVX registers must be saved by the operating system
+        const bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+        if (avx && (_xgetbv(0) & 6) == 6) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5))
+                return Resampler::Avx2;
+        }
+    }
+#endif
+    return Resampler::Sse2;
+}
+#endif // SIR_SIMD
+
+/** Returns horizontal pass function of instruction \a set. */
+HorizontalFunction horizontalFunction(Resampler::InstructionSet set) {
+    switch (set) {
+#ifdef SIR_SIMD
+    case Resampler::Avx2:
+        return horizontalAvx2;
+    case Resampler::Sse2:
+        return horizontalSse2;
+#endif // SIR_SIMD
+    default:
+        return horizontalGeneric;
+    }
+}
+
+/** Returns vertical pass function of instruction \a set. */
+VerticalFunction verticalFunction(Resampler::InstructionSet set) {
+    switch (set) {
+#ifdef SIR_SIMD
+    case Resampler::Avx2:
+        return verticalAvx2;
+    case Resampler::Sse2:
+        return verticalSse2;
+#endif // SIR_SIMD
+    default:
+        return verticalGeneric;
+    }
+}
+
+/** Scales row bands of source image to target width. */
+class HorizontalTask : public ConvertBandTask {
+public:
+    HorizontalTask(HorizontalFunction function, const FilterTable &table,
+                   const QImage &source, QImage *target)
+        : function(function), table(table), source(source), target(target),
+          bits(target->bits()) {}
+
+    void run(int begin, int end) {
+        const int bytesPerLine = target->bytesPerLine();
+        for (int y=begin; y<end && !isCancelled(); y++)
+            function(reinterpret_cast<const QRgb *>(source.constScanLine(y)),
+                     reinterpret_cast<QRgb *>(bits + y * bytesPerLine),
+                     target->width(), table);
+    }
+
+private:
+    HorizontalFunction function;
+    const FilterTable &table;
+    const QImage &source;
+    QImage *target;
+    uchar *bits;
+};
+
+/** Scales source image to target height computing row bands of target. */
+class VerticalTask : public ConvertBandTask {
+public:
+    VerticalTask(VerticalFunction function, const FilterTable &table,
+                 const QImage &source, QImage *target)
+        : function(function), table(table), source(source), target(target),
+          bits(target->bits()) {}
+
+    void run(int begin, int end) {
+        const int bytesPerLine = target->bytesPerLine();
+        QVector<const QRgb *> rows(table.taps);
+        for (int y=begin; y<end && !isCancelled(); y++) {
+            const int first = table.firsts.at(y);
+            const int count = table.counts.at(y);
+            for (int i=0; i<count; i++)
+                rows[i] = reinterpret_cast<const QRgb *>(
+                            source.constScanLine(first + i));
+            function(rows.constData(),
+                     table.weights.constData() + y * table.taps, count,
+                     reinterpret_cast<QRgb *>(bits + y * bytesPerLine),
+                     target->width());
+        }
+    }
+
+private:
+    VerticalFunction function;
+    const FilterTable &table;
+    const QImage &source;
+    QImage *target;
+    uchar *bits;
+};
+
+}
+
+
+/** Creates resampler using \a filter kernel and the best supported
+  * instruction set.
+  */
+Resampler::Resampler(Filter filter)
+    : kernel(filter), instructions(supportedInstructionSet()),
+      bandExecutor(0), cancellation(0), pool(0) {}
+
+/** Returns filter kernel of the resampler. */
+Resampler::Filter Resampler::filter() const {
+    return kernel;
+}
+
+/** Sets instruction \a set of resampling loops. Unsupported instruction set
+  * is replaced by supportedInstructionSet().
+  */
+void Resampler::setInstructionSet(InstructionSet set) {
+    instructions = qMin(set, supportedInstructionSet());
+}
+
+/** Returns instruction set of resampling loops. */
+Resampler::InstructionSet Resampler::instructionSet() const {
+    return instructions;
+}
+
+/** Sets threads scaling row bands of large images. Null \a executor means
+  * images are scaled in the calling thread.
+  */
+void Resampler::setBandExecutor(ConvertBandExecutor *executor) {
+    bandExecutor = executor;
+}
+
+/** Sets token stopping the resampling. Cancelled scaled() call returns null
+  * image.
+  */
+void Resampler::setCancellationToken(const CancellationToken *token) {
+    cancellation = token;
+}
+
+/** Sets \a pool of pixel buffers of scaled and intermediate images. */
+void Resampler::setBufferPool(PixelBufferPool *pool) {
+    this->pool = pool;
+}
+
+/** Returns \a image scaled to \a size ignoring aspect ratio.
+  *
+  * Images with alpha channel are scaled in premultiplied ARGB32 format,
+  * other images in RGB32 format. Not scaled dimension is skipped and the
+  * image of the same size is only converted.
+  *
+  * \return Scaled image or null image if \a image or \a size is empty, the
+  *         resampling was cancelled or the memory can't be allocated.
+  */
+QImage Resampler::scaled(const QImage &image, const QSize &size) const {
+    if (image.isNull() || size.isEmpty())
+        return QImage();
+    const QImage::Format format = image.hasAlphaChannel()
+            ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    QImage result = image.convertToFormat(format);
+    if (result.size() == size)
+        return result;
+    if (result.width() == size.width())
+        return scaledVertically(result, size.height());
+    if (result.height() == size.height())
+        return scaledHorizontally(result, size.width());
+    // count of products of both passes in both orders
+    const QSize source = result.size();
+    const double support = 2. * filterSupport(kernel);
+    const double columnTaps = support
+            * qMax(1., double(source.width()) / size.width());
+    const double rowTaps = support
+            * qMax(1., double(source.height()) / size.height());
+    const double horizontalFirst = columnTaps * size.width() * source.height()
+            + rowTaps * size.width() * size.height();
+    const double verticalFirst = rowTaps * source.width() * size.height()
+            + columnTaps * size.width() * size.height();
+    if (horizontalFirst <= verticalFirst) {
+        result = scaledHorizontally(result, size.width());
+        if (!result.isNull())
+            result = scaledVertically(result, size.height());
+    }
+    else {
+        result = scaledVertically(result, size.height());
+        if (!result.isNull())
+            result = scaledHorizontally(result, size.width());
+    }
+    return result;
+}
+
+/** Converts \a value read from settings into filter. Invalid values are
+  * replaced by the default filter.
+  */
+Resampler::Filter Resampler::toFilter(int value) {
+    if (value < 0 || value >= FilterCount)
+        return Bicubic;
+    return Filter(value);
+}
+
+/** Returns radius of \a filter kernel in source pixels of not downscaled
+  * image.
+  */
+double Resampler::filterSupport(Filter filter) {
+    switch (filter) {
+    case Box:
+        return 0.5;
+    case Bicubic:
+        return 2.;
+    case Lanczos3:
+        return 3.;
+    default:
+        return 1.;
+    }
+}
+
+/** Returns weight of \a filter kernel at \a x distance from the center.
+  * Box filter includes its right edge only, so each target pixel of enlarged
+  * image is copied from exactly one source pixel.
+  */
+double Resampler::filterWeight(Filter filter, double x) {
+    switch (filter) {
+    case Box:
+        return (x > -0.5 && x <= 0.5) ? 1. : 0.;
+    case Bicubic: {
+        // cubic convolution with a = -0.5
+        const double a = -0.5;
+        x = std::fabs(x);
+        if (x < 1.)
+            return ((a + 2.) * x - (a + 3.)) * x * x + 1.;
+        if (x < 2.)
+            return (((x - 5.) * x + 8.) * x - 4.) * a;
+        return 0.;
+    }
+    case Lanczos3:
+        x = std::fabs(x);
+        if (x < 3.)
+            return sinc(x) * sinc(x / 3.);
+        return 0.;
+    default:
+        x = std::fabs(x);
+        return x < 1. ? 1. - x : 0.;
+    }
+}
+
+/** Computes weights of \a filter for each of \a targetLength target pixels
+  * scaled from \a sourceLength source pixels. Downscaling filter is widened
+  * by the scale factor, so it averages all covered source pixels.
+  */
+Resampler::FilterTable Resampler::filterTable(Filter filter,
+                                             int sourceLength,
+                                             int targetLength) {
+    FilterTable table;
+    const double scale = double(sourceLength) / targetLength;
+    const double filterScale = qMax(scale, 1.);
+    const double support = filterSupport(filter) * filterScale;
+    table.taps = qMin(int(std::ceil(support)) * 2 + 1, sourceLength);
+    table.firsts.resize(targetLength);
+    table.counts.resize(targetLength);
+    table.weights.fill(0, targetLength * table.taps);
+    QVector<double> values(table.taps);
+    for (int i=0; i<targetLength; i++) {
+        const double center = (i + 0.5) * scale;
+        int first = qMax(0, int(std::floor(center - support + 0.5)));
+        const int last = qMin(sourceLength,
+                              int(std::floor(center + support + 0.5)));
+        int count = qMin(last - first, table.taps);
+        double total = 0.;
+        for (int j=0; j<count; j++) {
+            values[j] = filterWeight(
+                        filter, (first + j - center + 0.5) / filterScale);
+            total += values[j];
+        }
+        if (count <= 0 || total == 0.) {
+            // the nearest source pixel
+            first = qBound(0, int(center), sourceLength - 1);
+            count = 1;
+            values[0] = total = 1.;
+        }
+        // fixed point weights; rounding error goes to the largest weight
+        qint16 *weights = table.weights.data() + i * table.taps;
+        int sum = 0;
+        int largest = 0;
+        for (int j=0; j<count; j++) {
+            weights[j] = qint16(qRound(values[j] / total
+                                       * (1 << precisionBits)));
+            sum += weights[j];
+            if (weights[j] > weights[largest])
+                largest = j;
+        }
+        weights[largest] += qint16((1 << precisionBits) - sum);
+        // skip zero weights at both ends of the range
+        int leading = 0;
+        while (leading < count - 1 && weights[leading] == 0)
+            leading++;
+        if (leading > 0) {
+            for (int j=leading; j<count; j++)
+                weights[j - leading] = weights[j];
+            for (int j=count - leading; j<count; j++)
+                weights[j] = 0;
+            first += leading;
+            count -= leading;
+        }
+        while (count > 1 && weights[count - 1] == 0)
+            count--;
+        table.firsts[i] = first;
+        table.counts[i] = count;
+    }
+    return table;
+}
+
+/** Returns the best instruction set supported by CPU. It's detected once. */
+Resampler::InstructionSet Resampler::supportedInstructionSet() {
+#ifdef SIR_SIMD
+    static const InstructionSet supported = detectInstructionSet();
+    return supported;
+#else
+    return Generic;
+#endif // SIR_SIMD
+}
+
+/** Returns uninitialized image of \a size and \a format allocated from the
+  * buffer pool if it's set.
+  */
+QImage Resampler::createImage(const QSize &size, QImage::Format format) const {
+    if (pool)
+        return pool->image(size, format);
+    return QImage(size, format);
+}
+
+/** Scales \a source row into \a target row of table length pixels using
+  * weights of \a table computed by filterTable().
+  */
+void Resampler::scaleRow(const QRgb *source, QRgb *target,
+                         const FilterTable &table) const {
+    horizontalFunction(instructions)(source, target, table.firsts.size(),
+                                     table);
+}
+
+/** Computes \a width pixels of \a target row as sum of \a count \a rows
+  * multiplied by fixed point \a weights of single target row of
+  * filterTable().
+  */
+void Resampler::sumRows(const QRgb *const *rows, const qint16 *weights,
+                        int count, QRgb *target, int width) const {
+    verticalFunction(instructions)(rows, weights, count, target, width);
+}
+
+/** Returns \a source image scaled horizontally to \a width. */
+QImage Resampler::scaledHorizontally(const QImage &source, int width) const {
+    const FilterTable table = filterTable(kernel, source.width(), width);
+    QImage target = createImage(QSize(width, source.height()),
+                                source.format());
+    if (target.isNull())
+        return QImage();
+    HorizontalTask task(horizontalFunction(instructions), table, source,
+                        &target);
+    task.setCancellationToken(cancellation);
+    ConvertBands::run(bandExecutor, &task, target.height(),
+                      qint64(source.width()) * source.height());
+    if (task.isCancelled())
+        return QImage();
+    return target;
+}
+
+/** Returns \a source image scaled vertically to \a height. */
+QImage Resampler::scaledVertically(const QImage &source, int height) const {
+    const FilterTable table = filterTable(kernel, source.height(), height);
+    QImage target = createImage(QSize(source.width(), height),
+                                source.format());
+    if (target.isNull())
+        return QImage();
+    VerticalTask task(verticalFunction(instructions), table, source, &target);
+    task.setCancellationToken(cancellation);
+    ConvertBands::run(bandExecutor, &task, target.height(),
+                      qint64(source.width()) * source.height());
+    if (task.isCancelled())
+        return QImage();
+    return target;
+}
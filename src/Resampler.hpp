@@ -0,0 +1,124 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef RESAMPLER_HPP
+#define RESAMPLER_HPP
+
+#include <QImage>
+#include <QVector>
+
+class CancellationToken;
+class ConvertBandExecutor;
+class PixelBufferPool;
+
+/** \brief Separable image resampler with selectable filter kernel.
+  *
+  * Images are scaled in two passes: each row is scaled horizontally and
+  * each column is scaled vertically, whichever order needs less work. Filter
+  * weights of each target pixel are computed once per pass into a table of
+  * 14-bit fixed point weights, so both passes are plain sums of products.
+  *
+  * The sums are computed by SSE2 or AVX2 code chosen at run time basing on
+  * CPU features, see supportedInstructionSet(). All instruction sets give
+  * exactly the same pixels.
+  *
+  * Large images are split into row bands processed in parallel by band
+  * executor threads, see setBandExecutor(). Images read row by row are
+  * scaled by StripResampler sharing filter tables and row loops with this
+  * class, see filterTable(), scaleRow() and sumRows().
+  *
+  * \sa StripResampler ConvertBands
+  */
+class Resampler {
+    friend class ResamplerTest;
+
+public:
+    //! Filter kernel. Values are indexes of filter combo box in the Size tab.
+    enum Filter {
+        Box, /**< Nearest pixel or average of covered pixels. */
+        Bilinear, /**< Triangle filter. */
+        Bicubic, /**< Cubic convolution with a = -0.5. */
+        Lanczos3, /**< Lanczos windowed sinc of 3 lobes. */
+        FilterCount
+    };
+    //! Instruction set of resampling loops.
+    enum InstructionSet {
+        Generic, /**< Portable C++ code. */
+        Sse2,
+        Avx2
+    };
+
+    //! Fixed point weights of source pixels contributing to target pixels.
+    struct FilterTable {
+        FilterTable() : taps(0) {}
+
+        /** Maximal count of source pixels contributing to single target
+          * pixel.
+          */
+        int taps;
+        QVector<int> firsts; /**< Index of the first source pixel. */
+        QVector<int> counts; /**< Count of contributing source pixels. */
+        /** #taps weights of each target pixel; their sum is 1 in fixed
+          * point.
+          */
+        QVector<qint16> weights;
+    };
+
+    explicit Resampler(Filter filter = Bicubic);
+    Filter filter() const;
+    void setInstructionSet(InstructionSet set);
+    InstructionSet instructionSet() const;
+    void setBandExecutor(ConvertBandExecutor *executor);
+    void setCancellationToken(const CancellationToken *token);
+    void setBufferPool(PixelBufferPool *pool);
+    QImage scaled(const QImage &image, const QSize &size) const;
+    void scaleRow(const QRgb *source, QRgb *target,
+                  const FilterTable &table) const;
+    void sumRows(const QRgb *const *rows, const qint16 *weights, int count,
+                 QRgb *target, int width) const;
+
+    static Filter toFilter(int value);
+    static double filterSupport(Filter filter);
+    static double filterWeight(Filter filter, double x);
+    static FilterTable filterTable(Filter filter, int sourceLength,
+                                   int targetLength);
+    static InstructionSet supportedInstructionSet();
+
+    /** Count of fraction bits of fixed point weights. */
+    static const int precisionBits = 14;
+
+private:
+    Filter kernel; /**< Filter kernel. \sa filter() */
+    InstructionSet instructions; /**< \sa setInstructionSet() */
+    /** Threads processing row bands or null pointer.
+      * \sa setBandExecutor()
+      */
+    ConvertBandExecutor *bandExecutor;
+    const CancellationToken *cancellation; /**< Stops the passes. */
+    PixelBufferPool *pool; /**< Pool of scaled images or null pointer. */
+
+    QImage createImage(const QSize &size, QImage::Format format) const;
+    QImage scaledHorizontally(const QImage &source, int width) const;
+    QImage scaledVertically(const QImage &source, int height) const;
+};
+
+#endif // RESAMPLER_HPP
@@ -76,7 +76,7 @@ Rgb &Rgb::operator +=(const Rgb &other) {
     return *this;
 }
 
-RgbF Rgb::operator /(int div) {
+RgbF Rgb::operator /(qint64 div) {
     double d(div);
     RgbF result(*this);
 
@@ -41,7 +41,7 @@ public:
     Rgb & operator =(const RgbF &other);
     Rgb operator +(const Rgb &other);
     Rgb & operator +=(const Rgb &other);
-    RgbF operator /(int div);
+    RgbF operator /(qint64 div);
     int red;
     int green;
     int blue;
@@ -138,6 +138,17 @@ void Session::save(const QString &fileName) {
     writer.writeCharacters(QString::number(sizeArea->fileSizeSpinBox->value())
                            + ' ' + sizeArea->fileSizeComboBox->currentText() );
     writer.writeEndElement(); // bytes
+    writer.writeStartElement("crop");
+    writer.writeAttribute("mode",   sizeArea->cropModeComboBox->currentIndex());
+    writer.writeAttribute("x",      sizeArea->cropXSpinBox->value());
+    writer.writeAttribute("y",      sizeArea->cropYSpinBox->value());
+    writer.writeAttribute("width",  sizeArea->cropWidthSpinBox->value());
+    writer.writeAttribute("height", sizeArea->cropHeightSpinBox->value());
+    writer.writeEndElement(); // crop
+    writer.writeStartElement("filter");
+    writer.writeCharacters(QString::number(
+                               sizeArea->filterComboBox->currentIndex()));
+    writer.writeEndElement(); // filter
     writer.writeEndElement(); // size
 
     writer.writeStartElement("options");
@@ -267,6 +278,18 @@ void Session::restore(const QString &fileName) {
         x = sizeArea->sizeUnitComboBox->findText('(' + elem.attribute("unit") + ')',
                                                  Qt::MatchContains);
         sizeArea->sizeUnitComboBox->setCurrentIndex(x);
+        el = elem.firstChildElement("crop");
+        if (!el.isNull()) {
+            sizeArea->cropModeComboBox->setCurrentIndex(
+                        el.attribute("mode").toInt());
+            sizeArea->cropXSpinBox->setValue(el.attribute("x").toDouble());
+            sizeArea->cropYSpinBox->setValue(el.attribute("y").toDouble());
+            sizeArea->cropWidthSpinBox->setValue(el.attribute("width").toDouble());
+            sizeArea->cropHeightSpinBox->setValue(el.attribute("height").toDouble());
+        }
+        el = elem.firstChildElement("filter");
+        if (!el.isNull())
+            sizeArea->filterComboBox->setCurrentIndex(el.text().toInt());
     }
 
     elem = session.firstChildElement("options");
@@ -103,6 +103,15 @@ void Settings::readSettings() {
     settings.lastDir            = value("lastDir",QDir::homePath()).toString();
     settings.quality            = value("quality",100).toInt();
     settings.cores              = value("cores",0).toInt();
+    settings.readingThreads     = value("readingThreads",1).toInt();
+    settings.writingThreads     = value("writingThreads",1).toInt();
+    settings.memoryLimit        = value("memoryLimit",0).toInt();
+    settings.threadAffinity     = value("threadAffinity",0).toInt();
+    settings.processIsolation   = value("processIsolation",false).toBool();
+    settings.backgroundMode     = value("backgroundMode",false).toBool();
+    settings.readLimit          = value("readLimit",0).toInt();
+    settings.writeLimit         = value("writeLimit",0).toInt();
+    settings.cpuShare           = value("cpuShare",100).toInt();
     settings.maxHistoryCount    = value("maxHistoryCount",5).toInt();
     endGroup(); // Settings
     beginGroup("Size");
@@ -114,6 +123,12 @@ void Settings::readSettings() {
     size.fileSizeUnit       = value("fileSizeUnit",0).toInt();
     size.sizeUnit           = value("sizeUnit",0).toInt();
     size.keepAspectRatio    = value("keepAspectRatio",true).toBool();
+    size.cropMode           = value("cropMode",0).toInt();
+    size.cropX              = value("cropX",0.f).toFloat();
+    size.cropY              = value("cropY",0.f).toFloat();
+    size.cropWidth          = value("cropWidth",0.f).toFloat();
+    size.cropHeight         = value("cropHeight",0.f).toFloat();
+    size.resamplingFilter   = value("resamplingFilter",2).toInt();
     endGroup(); // Size
     beginGroup("TreeWidget");
     // all columns are visible by default
@@ -218,6 +233,15 @@ void Settings::writeSettings() {
     setValue("lastDir",             settings.lastDir);
     setValue("quality",             settings.quality);
     setValue("cores",               settings.cores);
+    setValue("readingThreads",      settings.readingThreads);
+    setValue("writingThreads",      settings.writingThreads);
+    setValue("memoryLimit",         settings.memoryLimit);
+    setValue("threadAffinity",      settings.threadAffinity);
+    setValue("processIsolation",    settings.processIsolation);
+    setValue("backgroundMode",      settings.backgroundMode);
+    setValue("readLimit",           settings.readLimit);
+    setValue("writeLimit",          settings.writeLimit);
+    setValue("cpuShare",            settings.cpuShare);
     setValue("maxHistoryCount",     settings.maxHistoryCount);
     endGroup(); // Settings
     beginGroup("Size");
@@ -229,6 +253,12 @@ void Settings::writeSettings() {
     setValue("fileSizeUnit",    size.fileSizeUnit);
     setValue("sizeUnit",        size.sizeUnit);
     setValue("keepAspectRatio", size.keepAspectRatio);
+    setValue("cropMode",        size.cropMode);
+    setValue("cropX",           size.cropX);
+    setValue("cropY",           size.cropY);
+    setValue("cropWidth",       size.cropWidth);
+    setValue("cropHeight",      size.cropHeight);
+    setValue("resamplingFilter", size.resamplingFilter);
     endGroup(); // Size
     beginGroup("TreeWidget");
     setValue("columns", treeWidget.columns);
@@ -79,6 +79,15 @@ public:
         QString lastDir;
         int quality;
         int cores;
+        int readingThreads;
+        int writingThreads;
+        int memoryLimit; /**< In MiB, 0 means half of physical memory. */
+        int threadAffinity; /**< ConvertAffinity::Policy value. */
+        bool processIsolation; /**< Convert in worker processes. */
+        bool backgroundMode; /**< Throttle convertion. */
+        int readLimit; /**< In MiB/s, 0 means unlimited. */
+        int writeLimit; /**< In MiB/s, 0 means unlimited. */
+        int cpuShare; /**< In percent of all logical CPUs. */
         int maxHistoryCount;
     } settings;
     struct SizeGroup {
@@ -90,6 +99,12 @@ public:
         int     fileSizeUnit;
         int     sizeUnit;
         bool    keepAspectRatio;
+        int     cropMode;
+        float   cropX;
+        float   cropY;
+        float   cropWidth;
+        float   cropHeight;
+        int     resamplingFilter;
     } size;
     struct TreeWidgetGroup {
         int columns;
@@ -21,6 +21,9 @@
 
 #include "SharedInformation.hpp"
 
+#include <QDataStream>
+
+#include "Resampler.hpp"
 #include "Settings.hpp"
 #include "metadata/MetadataUtils.hpp"
 
@@ -31,7 +34,6 @@ SharedInformation::SharedInformation()
     overwriteAll = false;
     noOverwriteAll = false;
     overwriteResult = 1;
-    abort = false;
     enlargeAll = false;
     noEnlargeAll = false;
     enlargeResult = 1;
@@ -44,15 +46,24 @@ SharedInformation::SharedInformation()
     maintainAspect = true;
     sizeBytes = 0;
     sizeUnit = 0;
+    cropMode = 0;
+    resamplingFilter = Resampler::Bicubic;
     quality = 100;
     rotate = false;
     angle = 0.;
+    flip = 0;
+
+    // SVG settings
+    svgModifiersEnabled = false;
+    svgRemoveEmptyGroup = false;
+    svgSave = false;
 
     // file settings
     format = "";
 
 #ifdef SIR_METADATA_SUPPORT
     // metadata settings
+    metadataEnabled = false;
     saveMetadata = true;
     realRotate = false;
     updateThumbnail = true;
@@ -82,6 +93,10 @@ void SharedInformation::swap(const SharedInformation &other)
     sizeBytes = other.sizeBytes;
     sizeUnit = other.sizeUnit;
 
+    cropMode = other.cropMode;
+    cropRect = other.cropRect;
+    resamplingFilter = other.resamplingFilter;
+
     destFolder = other.destFolder;
     prefix = other.prefix;
     suffix = other.suffix;
@@ -110,7 +125,6 @@ void SharedInformation::swap(const SharedInformation &other)
     rotateThumbnail = other.rotateThumbnail;
 #endif // SIR_METADATA_SUPPORT
 
-    abort = other.abort;
     overwriteAll = other.overwriteAll;
     noOverwriteAll = other.noOverwriteAll;
     overwriteResult = other.overwriteResult;
@@ -152,6 +166,29 @@ void SharedInformation::setDesiredSize(quint32 bytes) {
     sizeUnit = 2;
 }
 
+/** Sets desired region of source image cropped before scaling.
+  * \param mode Index of crop mode combo box. Supported values:
+  * \li 0 <c>None</c>; \a rect is ignored
+  * \li 1 <c>Pixels</c>; \a rect is the region in pixels
+  * \li 2 <c>Percent</c>; \a rect is the region in percent of image size
+  * \li 3 <c>Aspect ratio</c>; the largest centered region of \a rect size
+  *     aspect ratio is cropped
+  * \param rect Crop rectangle. Zero width or height of pixels and percent
+  *     region means the region reaches the image edge.
+  * \sa ConvertPreflight::cropRect()
+  */
+void SharedInformation::setDesiredCrop(int mode, const QRectF &rect) {
+    cropMode = mode;
+    cropRect = rect;
+}
+
+/** Sets kernel of image scaling to \a filter Resampler::Filter code.
+  * \sa Resampler::toFilter()
+  */
+void SharedInformation::setResamplingFilter(int filter) {
+    resamplingFilter = Resampler::toFilter(filter);
+}
+
 /** Sets desired format string without point prefix.
   * \note Call this function after calling #setSaveMetadata.
   */
@@ -303,3 +340,68 @@ void SharedInformation::setRotateThumbnail(bool rotate) {
     this->rotateThumbnail = rotate;
 }
 #endif // SIR_METADATA_SUPPORT
+
+/** Writes \a info into \a stream. It's used to pass the information to
+  * worker processes.
+  * \sa ConvertWorker
+  */
+QDataStream &operator<<(QDataStream &stream, const SharedInformation &info)
+{
+    stream << qint32(info.width) << qint32(info.height) << info.hasWidth
+           << info.hasHeight << info.maintainAspect << info.sizeBytes
+           << qint8(info.sizeUnit);
+    stream << qint8(info.cropMode) << info.cropRect
+           << qint8(info.resamplingFilter);
+    stream << info.destFolder.path() << info.prefix << info.suffix
+           << info.format << qint32(info.quality);
+    stream << info.rotate << info.angle << qint32(info.flip);
+    stream << info.backgroundColor << info.effectsConf;
+    stream << info.svgModifiersEnabled << info.svgRemoveTextString
+           << info.svgRemoveEmptyGroup << info.svgSave;
+    stream << info.rawModel;
+#ifdef SIR_METADATA_SUPPORT
+    stream << info.metadataEnabled << info.saveMetadata << info.realRotate
+           << info.updateThumbnail << info.rotateThumbnail;
+#endif // SIR_METADATA_SUPPORT
+    stream << info.overwriteAll << info.noOverwriteAll
+           << qint32(info.overwriteResult) << info.enlargeAll
+           << info.noEnlargeAll << qint32(info.enlargeResult);
+    return stream;
+}
+
+/** Reads \a info from \a stream.
+  * \sa ConvertWorker
+  */
+QDataStream &operator>>(QDataStream &stream, SharedInformation &info)
+{
+    qint32 width, height, quality, flip, overwriteResult, enlargeResult;
+    qint8 sizeUnit, cropMode, resamplingFilter;
+    QString destFolder;
+    stream >> width >> height >> info.hasWidth >> info.hasHeight
+           >> info.maintainAspect >> info.sizeBytes >> sizeUnit;
+    stream >> cropMode >> info.cropRect >> resamplingFilter;
+    stream >> destFolder >> info.prefix >> info.suffix >> info.format
+           >> quality;
+    stream >> info.rotate >> info.angle >> flip;
+    stream >> info.backgroundColor >> info.effectsConf;
+    stream >> info.svgModifiersEnabled >> info.svgRemoveTextString
+           >> info.svgRemoveEmptyGroup >> info.svgSave;
+    stream >> info.rawModel;
+#ifdef SIR_METADATA_SUPPORT
+    stream >> info.metadataEnabled >> info.saveMetadata >> info.realRotate
+           >> info.updateThumbnail >> info.rotateThumbnail;
+#endif // SIR_METADATA_SUPPORT
+    stream >> info.overwriteAll >> info.noOverwriteAll >> overwriteResult
+           >> info.enlargeAll >> info.noEnlargeAll >> enlargeResult;
+    info.width = width;
+    info.height = height;
+    info.sizeUnit = sizeUnit;
+    info.cropMode = cropMode;
+    info.resamplingFilter = resamplingFilter;
+    info.destFolder = QDir(destFolder);
+    info.quality = quality;
+    info.flip = flip;
+    info.overwriteResult = overwriteResult;
+    info.enlargeResult = enlargeResult;
+    return stream;
+}
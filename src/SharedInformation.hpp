@@ -22,15 +22,16 @@
 #ifndef SHAREDINFORMATION_H
 #define SHAREDINFORMATION_H
 
-#include <QMutex>
 #include <QString>
 #include <QDir>
 #include <QColor>
 #include <QImage>
+#include <QRectF>
 
 #include "raw/RawModel.hpp"
 #include "shared/EffectsConfiguration.hpp"
 
+class QDataStream;
 
 //! ConvertThread threads shared information.
 class SharedInformation
@@ -41,6 +42,11 @@ class SharedInformation
     friend class ConvertDialogTest;
     friend class ConvertEffects;
     friend class ConvertEffectsTest;
+    friend class ConvertPreflight;
+    friend QDataStream &operator<<(QDataStream &stream,
+                                   const SharedInformation &info);
+    friend QDataStream &operator>>(QDataStream &stream,
+                                   SharedInformation &info);
 
 public:
     SharedInformation();
@@ -56,6 +62,8 @@ public:
                         bool widthSet = false, bool heightSet = false,
                         bool keepAspect = true);
     void setDesiredSize(quint32 bytes);
+    void setDesiredCrop(int mode, const QRectF &rect = QRectF());
+    void setResamplingFilter(int filter);
     void setDesiredFormat(const QString& format);
     void setDesiredRotation(bool rotate, double angle = 0.0);
     void setDesiredFlip(int flip);
@@ -100,6 +108,17 @@ private:
     /** Size unit code based on size unit combo box index into ConvertDialog. */
     char sizeUnit;
 
+    // destinated region
+    /** Crop mode code based on crop mode combo box index into SizeScrollArea.
+      * \sa setDesiredCrop()
+      */
+    char cropMode;
+    QRectF cropRect; /**< Crop rectangle or aspect ratio, see #cropMode. */
+    /** Resampler::Filter code based on filter combo box index into
+      * SizeScrollArea.
+      */
+    char resamplingFilter;
+
     // destinated image file parameters
     QDir destFolder; /**< Destination directory. */
     QString prefix; /**< Target file prefix. */
@@ -142,15 +161,7 @@ private:
     bool rotateThumbnail; /**< Rotate thumbnail of target image indicator. */
 #endif // SIR_METADATA_SUPPORT
 
-    // thread synchronization data
-    // mutexes
-    /** Mutual exclusion object using for worker threads synchronization. */
-    QMutex mutex;
-
     // user conversation data
-    // cancel
-    bool abort; /**< Abort indicator. */
-
     // overwrite
     bool overwriteAll; /**< Overwrite all conflicting files indicator. */
     bool noOverwriteAll; /**< No overwrite all conflicting files indicator. */
@@ -0,0 +1,47 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+/* Vector instructions of pixel loops.
+ *
+ * SIR_SIMD is defined if SSE2 intrinsics are available; SSE2 is the baseline
+ * of x86-64 CPUs, so the code needs no run time check. Functions marked by
+ * SIR_TARGET_AVX2 are compiled for AVX2 regardless of compiler flags and
+ * must be called only if the CPU supports AVX2, see
+ * Resampler::supportedInstructionSet().
+ */
+#if defined(__GNUC__) && defined(__SSE2__) \
+        && (defined(__x86_64__) || defined(__i386__))
+#define SIR_SIMD
+#include <immintrin.h>
+#define SIR_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) \
+        || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SIR_SIMD
+#include <immintrin.h>
+#include <intrin.h>
+#define SIR_TARGET_AVX2
+#endif
+
+#endif // SIMD_HPP
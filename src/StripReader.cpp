@@ -0,0 +1,360 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "StripReader.hpp"
+#include "TiffStripReader.hpp"
+
+#include <QtEndian>
+
+#include <climits>
+#include <cstring>
+
+
+namespace {
+
+/** Reads binary PGM (P5) and PPM (P6) images. */
+class PnmStripReader : public StripReader {
+public:
+    explicit PnmStripReader(const QString &filePath)
+        : StripReader(filePath), dataOffset(0) {}
+
+    /** Parses the header of the image and returns true if the image is
+      * supported, otherwise returns false.
+      */
+    bool readHeader() {
+        char magic[2];
+        if (file.read(magic, 2) != 2 || magic[0] != 'P'
+                || (magic[1] != '5' && magic[1] != '6'))
+            return false;
+        const int width = readNumber();
+        const int height = readNumber();
+        const int maximum = readNumber();
+        if (width <= 0 || height <= 0 || maximum <= 0 || maximum > 65535)
+            return false;
+        // single whitespace separates the header from the raster
+        dataOffset = file.pos() + 1;
+        imageSize = QSize(width, height);
+        samplesPerPixel = colorSamples = (magic[1] == '5') ? 1 : 3;
+        sampleBytes = (maximum > 255) ? 2 : 1;
+        maxValue = maximum;
+        bigEndian = true;
+        return true;
+    }
+
+protected:
+    bool readSamples(int y, uchar *samples) {
+        return readAt(dataOffset + qint64(y) * rowSize(), samples, rowSize());
+    }
+
+private:
+    qint64 dataOffset; /**< Offset of the first row in the file. */
+
+    /** Reads decimal number skipping leading whitespaces and comments.
+      * Returns -1 on error.
+      */
+    int readNumber() {
+        char c;
+        do {
+            if (!file.getChar(&c))
+                return -1;
+            if (c == '#') {
+                while (c != '\n' && c != '\r')
+                    if (!file.getChar(&c))
+                        return -1;
+            }
+        } while (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+        qint64 number = 0;
+        while (c >= '0' && c <= '9') {
+            number = number * 10 + (c - '0');
+            if (number > INT_MAX)
+                return -1;
+            if (!file.getChar(&c))
+                return -1;
+        }
+        // the last read character is the whitespace following the number
+        file.ungetChar(c);
+        return number;
+    }
+};
+
+/** Reads uncompressed 8-bit palette, 24-bit and 32-bit BMP images. */
+class BmpStripReader : public StripReader {
+public:
+    explicit BmpStripReader(const QString &filePath)
+        : StripReader(filePath), dataOffset(0), topDown(false) {}
+
+    /** Parses the header of the image and returns true if the image is
+      * supported, otherwise returns false.
+      */
+    bool readHeader() {
+        uchar header[54];
+        if (file.read(reinterpret_cast<char*>(header), sizeof(header))
+                != sizeof(header) || header[0] != 'B' || header[1] != 'M')
+            return false;
+        dataOffset = qFromLittleEndian<quint32>(header + 10);
+        const quint32 infoSize = qFromLittleEndian<quint32>(header + 14);
+        const qint32 width = qFromLittleEndian<qint32>(header + 18);
+        const qint32 height = qFromLittleEndian<qint32>(header + 22);
+        const quint16 bitCount = qFromLittleEndian<quint16>(header + 28);
+        const quint32 compression = qFromLittleEndian<quint32>(header + 30);
+        quint32 colorCount = qFromLittleEndian<quint32>(header + 46);
+        if (infoSize < 40 || width <= 0 || height == 0 || height == INT_MIN)
+            return false;
+        // BI_RGB and BI_BITFIELDS with default masks only
+        if (compression == 3) {
+            uchar masks[12];
+            const char defaultMasks[] = "\0\0\xff\0\0\xff\0\0\xff\0\0\0";
+            if (bitCount != 32 || !readAt(14 + 40, masks, sizeof(masks))
+                    || memcmp(masks, defaultMasks, sizeof(masks)) != 0)
+                return false;
+        }
+        else if (compression != 0)
+            return false;
+        topDown = height < 0;
+        imageSize = QSize(width, qAbs(height));
+        bgrOrder = true;
+        if (bitCount == 8) {
+            if (colorCount == 0 || colorCount > 256)
+                colorCount = 256;
+            QByteArray palette(4 * colorCount, '\0');
+            if (!readAt(14 + infoSize, reinterpret_cast<uchar*>(
+                            palette.data()), palette.size()))
+                return false;
+            colorTable.fill(qRgb(0, 0, 0), 256);
+            for (quint32 i=0; i<colorCount; i++) {
+                const uchar *color = reinterpret_cast<const uchar*>(
+                            palette.constData()) + 4 * i;
+                colorTable[i] = qRgb(color[2], color[1], color[0]);
+            }
+            samplesPerPixel = 1;
+        }
+        else if (bitCount == 24 || bitCount == 32)
+            samplesPerPixel = bitCount / 8;
+        else
+            return false;
+        colorSamples = (bitCount == 8) ? 1 : 3;
+        // rows are aligned to 4 bytes
+        rowPadding = (4 - width * samplesPerPixel % 4) % 4;
+        return true;
+    }
+
+protected:
+    bool readSamples(int y, uchar *samples) {
+        if (!topDown)
+            y = imageSize.height() - 1 - y;
+        return readAt(dataOffset + qint64(y) * rowSize(), samples, rowSize());
+    }
+
+private:
+    qint64 dataOffset; /**< Offset of the first stored row in the file. */
+    bool topDown; /**< Rows are stored from top to bottom. */
+};
+
+}
+
+
+/** Opens \a filePath file for reading. Subclasses read header of the image
+  * and set size and layout of samples.
+  */
+StripReader::StripReader(const QString &filePath)
+    : file(filePath), samplesPerPixel(1), colorSamples(1), alphaSample(-1),
+      sampleBytes(1), rowPadding(0), maxValue(255), bigEndian(false),
+      bgrOrder(false), whiteIsZero(false), premultiplied(false),
+      bandExecutor(0), cancellation(0), row(0) {
+    file.open(QIODevice::ReadOnly);
+}
+
+StripReader::~StripReader() {}
+
+/** Returns size of the image. */
+QSize StripReader::size() const {
+    return imageSize;
+}
+
+/** Returns true if rows contain alpha channel. */
+bool StripReader::hasAlphaChannel() const {
+    return alphaSample >= 0;
+}
+
+/** Returns index of the next row returned by readRow(). */
+int StripReader::currentRow() const {
+    return row;
+}
+
+/** Sets threads decoding blocks of rows of compressed images. Null
+  * \a executor means the rows are decoded in the calling thread only.
+  */
+void StripReader::setBandExecutor(ConvertBandExecutor *executor) {
+    bandExecutor = executor;
+}
+
+/** Sets token stopping decoding of rows. readRow() fails if the \a token is
+  * cancelled.
+  */
+void StripReader::setCancellationToken(const CancellationToken *token) {
+    cancellation = token;
+}
+
+/** Reads the next row into \a pixels buffer of size().width() pixels.
+  * Pixels are premultiplied ARGB values if the image has alpha channel,
+  * otherwise they are opaque RGB values.
+  * \return True if the row was read, false if there is no next row or the
+  *         file is corrupted.
+  */
+bool StripReader::readRow(QRgb *pixels) {
+    if (row >= imageSize.height())
+        return false;
+    buffer.resize(rowSize());
+    uchar *samples = reinterpret_cast<uchar*>(buffer.data());
+    if (!readSamples(row, samples))
+        return false;
+    packSamples(samples, pixels);
+    row++;
+    return true;
+}
+
+/** Skips \a count rows without reading them. */
+void StripReader::skipRows(int count) {
+    row = qMin(row + count, imageSize.height());
+}
+
+/** Returns true if images of \a format format may be read by strip reader.
+  * Whether particular image is supported is known after open() only.
+  */
+bool StripReader::isStreamable(const QByteArray &format) {
+    return format == "pgm" || format == "ppm" || format == "bmp"
+            || format == "tif" || format == "tiff";
+}
+
+/** Opens \a filePath image file of \a format format detected by
+  * ImageFormatRegistry.
+  * \return Strip reader owned by the caller or null pointer if the file
+  *         can't be read or the image layout isn't supported.
+  */
+StripReader *StripReader::open(const QString &filePath,
+                               const QByteArray &format) {
+    StripReader *reader = 0;
+    bool supported = false;
+    if (format == "pgm" || format == "ppm") {
+        PnmStripReader *pnm = new PnmStripReader(filePath);
+        supported = pnm->readHeader();
+        reader = pnm;
+    }
+    else if (format == "bmp") {
+        BmpStripReader *bmp = new BmpStripReader(filePath);
+        supported = bmp->readHeader();
+        reader = bmp;
+    }
+    else if (format == "tif" || format == "tiff") {
+        TiffStripReader *tiff = new TiffStripReader(filePath);
+        supported = tiff->readHeader();
+        reader = tiff;
+    }
+    if (!supported) {
+        delete reader;
+        return 0;
+    }
+    return reader;
+}
+
+/** Reads \a count bytes at \a offset position of the file into \a data.
+  * The file is seeked only if the position differs, so sequential reads are
+  * buffered by the file.
+  */
+bool StripReader::readAt(qint64 offset, uchar *data, qint64 count) {
+    if (file.pos() != offset && !file.seek(offset))
+        return false;
+    return file.read(reinterpret_cast<char*>(data), count) == count;
+}
+
+/** Returns count of bytes of single row of samples. */
+int StripReader::rowSize() const {
+    return imageSize.width() * samplesPerPixel * sampleBytes + rowPadding;
+}
+
+/** Converts row of \a samples into \a pixels. */
+void StripReader::packSamples(const uchar *samples, QRgb *pixels) const {
+    const int width = imageSize.width();
+    // the most common layouts
+    if (sampleBytes == 1 && maxValue == 255 && colorTable.isEmpty()
+            && !whiteIsZero && alphaSample < 0) {
+        if (colorSamples == 1) {
+            for (int x=0; x<width; x++, samples += samplesPerPixel)
+                pixels[x] = qRgb(samples[0], samples[0], samples[0]);
+        }
+        else if (bgrOrder) {
+            for (int x=0; x<width; x++, samples += samplesPerPixel)
+                pixels[x] = qRgb(samples[2], samples[1], samples[0]);
+        }
+        else {
+            for (int x=0; x<width; x++, samples += samplesPerPixel)
+                pixels[x] = qRgb(samples[0], samples[1], samples[2]);
+        }
+        return;
+    }
+    const int pixelBytes = samplesPerPixel * sampleBytes;
+    for (int x=0; x<width; x++, samples += pixelBytes) {
+        int values[4] = { 0, 0, 0, 255 };
+        const int count = qMin(samplesPerPixel, 4);
+        for (int i=0; i<count; i++) {
+            quint32 value;
+            if (sampleBytes == 1)
+                value = samples[i];
+            else if (bigEndian)
+                value = qFromBigEndian<quint16>(samples + 2 * i);
+            else
+                value = qFromLittleEndian<quint16>(samples + 2 * i);
+            if (maxValue != 255)
+                value = (qMin(value, maxValue) * 255 + maxValue / 2)
+                        / maxValue;
+            values[i] = value;
+        }
+        if (!colorTable.isEmpty()) {
+            pixels[x] = colorTable.at(samples[0]);
+            continue;
+        }
+        const int alpha = (alphaSample >= 0) ? values[alphaSample] : 255;
+        int red, green, blue;
+        if (colorSamples == 1) {
+            red = green = blue = whiteIsZero ? 255 - values[0] : values[0];
+            if (whiteIsZero && premultiplied)
+                red = green = blue = alpha - values[0];
+        }
+        else if (bgrOrder) {
+            red = values[2];
+            green = values[1];
+            blue = values[0];
+        }
+        else {
+            red = values[0];
+            green = values[1];
+            blue = values[2];
+        }
+        if (alphaSample < 0)
+            pixels[x] = qRgb(red, green, blue);
+        else if (premultiplied)
+            pixels[x] = qRgba(qMin(red, alpha), qMin(green, alpha),
+                              qMin(blue, alpha), alpha);
+        else
+            pixels[x] = qPremultiply(qRgba(red, green, blue, alpha));
+    }
+}
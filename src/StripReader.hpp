@@ -0,0 +1,105 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef STRIPREADER_HPP
+#define STRIPREADER_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QRgb>
+#include <QSize>
+#include <QVector>
+
+class CancellationToken;
+class ConvertBandExecutor;
+
+/** \brief Sequential reader of image rows stored in uncompressed file.
+  *
+  * Huge scans can't be decoded into QImage, because decoded image doesn't
+  * fit the memory. Strip reader reads the image file row by row, so only
+  * single row of samples is kept in memory. Rows are returned as 32-bit
+  * pixels, premultiplied if the image has an alpha channel.
+  *
+  * Supported are binary PGM and PPM images, uncompressed BMP images and
+  * TIFF images, see open(). Tiles and strips of TIFF images are decoded in
+  * parallel by band executor threads, see setBandExecutor().
+  *
+  * \sa StripResampler StripWriter ConvertThread::convertStrips()
+  */
+class StripReader {
+public:
+    virtual ~StripReader();
+    QSize size() const;
+    bool hasAlphaChannel() const;
+    int currentRow() const;
+    void setBandExecutor(ConvertBandExecutor *executor);
+    void setCancellationToken(const CancellationToken *token);
+    bool readRow(QRgb *pixels);
+    void skipRows(int count);
+
+    static bool isStreamable(const QByteArray &format);
+    static StripReader *open(const QString &filePath,
+                             const QByteArray &format);
+
+protected:
+    StripReader(const QString &filePath);
+    /** Reads samples of row \a y into \a samples buffer of rowSize()
+      * bytes. Rows are usually read in increasing order.
+      * \return True if the row was read, otherwise false.
+      */
+    virtual bool readSamples(int y, uchar *samples) = 0;
+    bool readAt(qint64 offset, uchar *data, qint64 count);
+    int rowSize() const;
+    void packSamples(const uchar *samples, QRgb *pixels) const;
+
+    QFile file;
+    QSize imageSize;
+    // layout of samples in single row
+    int samplesPerPixel; /**< Count of samples of single pixel. */
+    int colorSamples; /**< Count of color samples: 1 (gray) or 3 (RGB). */
+    int alphaSample; /**< Index of alpha sample or -1 if there isn't. */
+    int sampleBytes; /**< Size of single sample in bytes: 1 or 2. */
+    int rowPadding; /**< Count of bytes following samples of each row. */
+    quint32 maxValue; /**< Value of the sample of full intensity. */
+    bool bigEndian; /**< Byte order of 2-bytes samples. */
+    bool bgrOrder; /**< Color samples are stored as blue, green, red. */
+    bool whiteIsZero; /**< Gray samples are inverted. */
+    bool premultiplied; /**< Color samples are premultiplied by alpha. */
+    /** Colors of palette images indexed by 8-bit samples or empty vector. */
+    QVector<QRgb> colorTable;
+    /** Threads decoding blocks of rows or null pointer.
+      * \sa setBandExecutor()
+      */
+    ConvertBandExecutor *bandExecutor;
+    /** Token stopping decoding or null pointer.
+      * \sa setCancellationToken()
+      */
+    const CancellationToken *cancellation;
+
+private:
+    int row; /**< Index of the next row to read. */
+    QByteArray buffer; /**< Samples of the last read row. */
+
+    Q_DISABLE_COPY(StripReader)
+};
+
+#endif // STRIPREADER_HPP
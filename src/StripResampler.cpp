@@ -0,0 +1,95 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "StripResampler.hpp"
+
+
+/** Creates resampler of image of \a sourceSize size into \a targetSize
+  * size using \a filter kernel.
+  */
+StripResampler::StripResampler(const QSize &sourceSize,
+                               const QSize &targetSize,
+                               Resampler::Filter filter)
+    : source(sourceSize), target(targetSize), resampler(filter),
+      windowRows(1), pushed(0), taken(0) {
+    if (!source.isEmpty() && !target.isEmpty()) {
+        columns = Resampler::filterTable(filter, source.width(),
+                                         target.width());
+        rows = Resampler::filterTable(filter, source.height(),
+                                      target.height());
+    }
+    foreach (int count, rows.counts)
+        windowRows = qMax(windowRows, count);
+    // one spare row, because trimmed ranges of rows may overlap unevenly
+    windowRows++;
+    window.resize(windowRows * target.width());
+    lines.resize(windowRows);
+}
+
+/** Returns size of the source image. */
+QSize StripResampler::sourceSize() const {
+    return source;
+}
+
+/** Returns size of the target image. */
+QSize StripResampler::targetSize() const {
+    return target;
+}
+
+/** Returns count of horizontally scaled rows kept by the resampler. */
+int StripResampler::windowSize() const {
+    return windowRows;
+}
+
+/** Scales horizontally the next source row of \a pixels and stores it in the
+  * sliding window. Pixels must be premultiplied if the image has alpha
+  * channel. Take all ready target rows by takeRow() before pushing next row,
+  * otherwise source rows needed by them may be overwritten.
+  */
+void StripResampler::pushRow(const QRgb *pixels) {
+    if (pushed >= source.height() || target.isEmpty())
+        return;
+    resampler.scaleRow(pixels, window.data()
+                       + (pushed % windowRows) * target.width(), columns);
+    pushed++;
+}
+
+/** Computes the next target row into \a pixels if all source rows needed by
+  * it were pushed.
+  * \return True if the row was computed, otherwise false.
+  */
+bool StripResampler::takeRow(QRgb *pixels) {
+    if (taken >= target.height() || target.isEmpty())
+        return false;
+    const int first = rows.firsts.at(taken);
+    const int count = rows.counts.at(taken);
+    if (first + count > pushed)
+        return false;
+    for (int i=0; i<count; i++)
+        lines[i] = window.constData()
+                + ((first + i) % windowRows) * target.width();
+    resampler.sumRows(lines.constData(),
+                      rows.weights.constData() + taken * rows.taps, count,
+                      pixels, target.width());
+    taken++;
+    return true;
+}
@@ -0,0 +1,71 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef STRIPRESAMPLER_HPP
+#define STRIPRESAMPLER_HPP
+
+#include <QRgb>
+#include <QSize>
+#include <QVector>
+
+#include "Resampler.hpp"
+
+
+/** \brief Incremental resampler of images read row by row.
+  *
+  * Source rows are pushed one by one by pushRow(). Each row is scaled
+  * horizontally at once and kept in a sliding window of rows needed by
+  * the next target rows. Target rows are scaled vertically and taken by
+  * takeRow() as soon as all their source rows were pushed, so memory used
+  * by the resampler is proportional to the image width, not its area.
+  *
+  * Rows are scaled by filter tables and SIMD row loops of Resampler, so the
+  * result is exactly the same as Resampler::scaled() scaling rows first.
+  * Triangle filter is used by default.
+  *
+  * \sa StripReader StripWriter
+  */
+class StripResampler {
+public:
+    StripResampler(const QSize &sourceSize, const QSize &targetSize,
+                   Resampler::Filter filter = Resampler::Bilinear);
+    QSize sourceSize() const;
+    QSize targetSize() const;
+    int windowSize() const;
+    void pushRow(const QRgb *pixels);
+    bool takeRow(QRgb *pixels);
+
+private:
+    QSize source;
+    QSize target;
+    Resampler resampler;
+    Resampler::FilterTable columns; /**< Weights of target columns. */
+    Resampler::FilterTable rows; /**< Weights of target rows. */
+    /** Ring buffer of horizontally scaled rows of target width. */
+    QVector<QRgb> window;
+    QVector<const QRgb *> lines; /**< Window rows of the next target row. */
+    int windowRows; /**< Count of rows in #window. */
+    int pushed; /**< Count of pushed source rows. */
+    int taken; /**< Count of taken target rows. */
+};
+
+#endif // STRIPRESAMPLER_HPP
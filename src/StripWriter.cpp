@@ -0,0 +1,323 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "StripWriter.hpp"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <climits>
+#include <cstring>
+
+
+namespace {
+
+/** Base class of strip writers writing encoded rows into file. */
+class FileStripWriter : public StripWriter {
+public:
+    FileStripWriter(const QString &filePath, const QSize &size, bool alpha)
+        : StripWriter(size, alpha), file(filePath) {
+        file.open(QIODevice::WriteOnly);
+    }
+
+    /** Returns true if the file was opened, otherwise false. */
+    bool isOpen() const {
+        return file.isOpen();
+    }
+
+    bool finish() {
+        file.close();
+        return file.error() == QFile::NoError
+                && currentRow() == imageSize.height();
+    }
+
+protected:
+    QFile file;
+    QByteArray line; /**< Encoded row. */
+
+    /** Writes \a data into the file. */
+    bool write(const QByteArray &data) {
+        return file.write(data) == data.size();
+    }
+    /** Encodes \a pixels into #line as 8-bit samples of \a channels
+      * channels in \a order order. Alpha channel is written if \a channels
+      * is 4; colors are unpremultiplied if \a unpremultiply is true.
+      */
+    void encode(const QRgb *pixels, int channels, bool bgr,
+                bool unpremultiply) {
+        uchar *samples = reinterpret_cast<uchar*>(line.data());
+        for (int x=0; x<imageSize.width(); x++, samples += channels) {
+            const QRgb pixel = unpremultiply ? qUnpremultiply(pixels[x])
+                                             : pixels[x];
+            samples[0] = bgr ? qBlue(pixel) : qRed(pixel);
+            samples[1] = qGreen(pixel);
+            samples[2] = bgr ? qRed(pixel) : qBlue(pixel);
+            if (channels == 4)
+                samples[3] = qAlpha(pixel);
+        }
+    }
+};
+
+/** Writes binary PPM images. Alpha channel is dropped. */
+class PnmStripWriter : public FileStripWriter {
+public:
+    PnmStripWriter(const QString &filePath, const QSize &size, bool alpha)
+        : FileStripWriter(filePath, size, alpha) {
+        line.resize(3 * size.width());
+        write("P6\n" + QByteArray::number(size.width()) + ' '
+              + QByteArray::number(size.height()) + "\n255\n");
+    }
+
+protected:
+    bool writePixels(int, const QRgb *pixels) {
+        encode(pixels, 3, false, alpha);
+        return write(line);
+    }
+};
+
+/** Writes 24-bit BMP images stored from top to bottom. Alpha channel is
+  * dropped.
+  */
+class BmpStripWriter : public FileStripWriter {
+public:
+    BmpStripWriter(const QString &filePath, const QSize &size, bool alpha)
+        : FileStripWriter(filePath, size, alpha) {
+        // rows are aligned to 4 bytes
+        line.fill('\0', (3 * size.width() + 3) & ~3);
+        const quint32 dataSize = line.size() * size.height();
+        uchar header[54];
+        memset(header, 0, sizeof(header));
+        header[0] = 'B';
+        header[1] = 'M';
+        qToLittleEndian<quint32>(sizeof(header) + dataSize, header + 2);
+        qToLittleEndian<quint32>(sizeof(header), header + 10);
+        qToLittleEndian<quint32>(40, header + 14);
+        qToLittleEndian<qint32>(size.width(), header + 18);
+        // negative height means rows stored from top to bottom
+        qToLittleEndian<qint32>(-size.height(), header + 22);
+        qToLittleEndian<quint16>(1, header + 26);
+        qToLittleEndian<quint16>(24, header + 28);
+        qToLittleEndian<quint32>(dataSize, header + 34);
+        write(QByteArray(reinterpret_cast<const char*>(header),
+                         sizeof(header)));
+    }
+
+protected:
+    bool writePixels(int, const QRgb *pixels) {
+        encode(pixels, 3, true, alpha);
+        return write(line);
+    }
+};
+
+/** Writes uncompressed RGB or RGBA TIFF images. Colors are stored with
+  * associated alpha, so premultiplied pixels are written unchanged.
+  */
+class TiffStripWriter : public FileStripWriter {
+public:
+    TiffStripWriter(const QString &filePath, const QSize &size, bool alpha)
+        : FileStripWriter(filePath, size, alpha) {
+        line.resize((alpha ? 4 : 3) * size.width());
+        // strips of about 64 KiB
+        rowsPerStrip = qBound(1, 65536 / line.size(), size.height());
+        // little endian header followed by the offset of the directory
+        write(QByteArray("II*\0\0\0\0\0", 8));
+    }
+
+    bool finish() {
+        if (currentRow() != imageSize.height()) {
+            FileStripWriter::finish();
+            return false;
+        }
+        const quint32 channels = alpha ? 4 : 3;
+        const quint32 strips = (imageSize.height() - 1) / rowsPerStrip + 1;
+        const quint32 stripSize = rowsPerStrip * line.size();
+        const quint32 lastStripSize = line.size()
+                * (imageSize.height() - (strips - 1) * rowsPerStrip);
+        // arrays of values are written before the directory
+        quint32 offset = file.pos();
+        offset += offset & 1;
+        file.seek(offset);
+        const quint32 bitsOffset = offset;
+        QByteArray values;
+        for (quint32 i=0; i<channels; i++)
+            appendShort(&values, 8);
+        const quint32 offsetsOffset = bitsOffset + values.size();
+        for (quint32 i=0; i<strips; i++)
+            appendLong(&values, 8 + i * stripSize);
+        const quint32 countsOffset = bitsOffset + values.size();
+        for (quint32 i=0; i<strips; i++)
+            appendLong(&values, i + 1 < strips ? stripSize : lastStripSize);
+        const quint32 directoryOffset = bitsOffset + values.size();
+
+        QByteArray directory;
+        const quint16 count = alpha ? 11 : 10;
+        appendShort(&directory, count);
+        appendEntry(&directory, 256, 4, 1, imageSize.width());
+        appendEntry(&directory, 257, 4, 1, imageSize.height());
+        appendEntry(&directory, 258, 3, channels, bitsOffset);
+        appendEntry(&directory, 259, 3, 1, 1); // no compression
+        appendEntry(&directory, 262, 3, 1, 2); // RGB
+        appendEntry(&directory, 273, 4, strips,
+                    strips > 1 ? offsetsOffset : 8);
+        appendEntry(&directory, 277, 3, 1, channels);
+        appendEntry(&directory, 278, 4, 1, rowsPerStrip);
+        appendEntry(&directory, 279, 4, strips,
+                    strips > 1 ? countsOffset : lastStripSize);
+        appendEntry(&directory, 284, 3, 1, 1); // chunky
+        if (alpha)
+            appendEntry(&directory, 338, 3, 1, 1); // associated alpha
+        appendLong(&directory, 0); // no next directory
+        bool written = write(values) && write(directory);
+        uchar header[4];
+        qToLittleEndian<quint32>(directoryOffset, header);
+        written = written && file.seek(4)
+                && file.write(reinterpret_cast<const char*>(header), 4) == 4;
+        return FileStripWriter::finish() && written;
+    }
+
+protected:
+    bool writePixels(int, const QRgb *pixels) {
+        encode(pixels, alpha ? 4 : 3, false, false);
+        return write(line);
+    }
+
+private:
+    int rowsPerStrip;
+
+    static void appendShort(QByteArray *data, quint16 value) {
+        uchar bytes[2];
+        qToLittleEndian<quint16>(value, bytes);
+        data->append(reinterpret_cast<const char*>(bytes), 2);
+    }
+    static void appendLong(QByteArray *data, quint32 value) {
+        uchar bytes[4];
+        qToLittleEndian<quint32>(value, bytes);
+        data->append(reinterpret_cast<const char*>(bytes), 4);
+    }
+    /** Appends directory entry of single SHORT or LONG value or offset of
+      * values.
+      */
+    static void appendEntry(QByteArray *data, quint16 tag, quint16 type,
+                            quint32 count, quint32 value) {
+        appendShort(data, tag);
+        appendShort(data, type);
+        appendLong(data, count);
+        if (type == 3 && count == 1) {
+            appendShort(data, value);
+            appendShort(data, 0);
+        }
+        else
+            appendLong(data, value);
+    }
+};
+
+}
+
+
+/** Creates writer of image of \a size size. If \a alpha is true pixels
+  * contain alpha channel.
+  */
+StripWriter::StripWriter(const QSize &size, bool alpha)
+    : imageSize(size), alpha(alpha), row(0) {}
+
+StripWriter::~StripWriter() {}
+
+/** Returns size of the written image. */
+QSize StripWriter::size() const {
+    return imageSize;
+}
+
+/** Returns index of the next row written by writeRow(). */
+int StripWriter::currentRow() const {
+    return row;
+}
+
+/** Writes the next row of size().width() \a pixels.
+  * \return True if the row was written, otherwise false.
+  */
+bool StripWriter::writeRow(const QRgb *pixels) {
+    if (row >= imageSize.height() || !writePixels(row, pixels))
+        return false;
+    row++;
+    return true;
+}
+
+/** Completes the image after the last row was written.
+  * \return True if the image was written successfully, otherwise false.
+  */
+bool StripWriter::finish() {
+    return row == imageSize.height();
+}
+
+/** Returns true if images of \a format format may be written row by row
+  * into file.
+  */
+bool StripWriter::isStreamable(const QByteArray &format) {
+    return format == "ppm" || format == "bmp"
+            || format == "tif" || format == "tiff";
+}
+
+/** Creates writer of \a filePath file of \a format format.
+  * \return Strip writer owned by the caller or null pointer if the format
+  *         isn't supported or the file can't be opened.
+  */
+StripWriter *StripWriter::create(const QString &filePath,
+                                 const QByteArray &format, const QSize &size,
+                                 bool alpha) {
+    if (size.isEmpty())
+        return 0;
+    FileStripWriter *writer = 0;
+    // BMP and classic TIFF files are limited to 4 GiB
+    const bool fits = 4. * size.width() * size.height()
+            + 16. * size.height() + 1024. < double(UINT_MAX);
+    if (format == "ppm")
+        writer = new PnmStripWriter(filePath, size, alpha);
+    else if (format == "bmp" && fits)
+        writer = new BmpStripWriter(filePath, size, alpha);
+    else if ((format == "tif" || format == "tiff") && fits)
+        writer = new TiffStripWriter(filePath, size, alpha);
+    if (writer && !writer->isOpen()) {
+        delete writer;
+        writer = 0;
+    }
+    return writer;
+}
+
+/** Creates writer of image of \a size size assembled in memory. If \a alpha
+  * is true the image has alpha channel.
+  */
+ImageStripWriter::ImageStripWriter(const QSize &size, bool alpha)
+    : StripWriter(size, alpha),
+      target(size, alpha ? QImage::Format_ARGB32_Premultiplied
+                         : QImage::Format_RGB32) {}
+
+/** Returns the assembled image. */
+QImage ImageStripWriter::image() const {
+    return target;
+}
+
+bool ImageStripWriter::writePixels(int y, const QRgb *pixels) {
+    if (target.isNull())
+        return false;
+    memcpy(target.scanLine(y), pixels, imageSize.width() * sizeof(QRgb));
+    return true;
+}
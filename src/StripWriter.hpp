@@ -0,0 +1,84 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef STRIPWRITER_HPP
+#define STRIPWRITER_HPP
+
+#include <QByteArray>
+#include <QImage>
+#include <QRgb>
+#include <QSize>
+
+
+/** \brief Sequential writer of image rows.
+  *
+  * Rows produced by StripResampler are written as soon as they are computed.
+  * Rows written into uncompressed PPM, BMP and TIFF files are encoded and
+  * written immediately, so the target image is never kept in memory; see
+  * create(). Other formats are encoded by Qt from image assembled by
+  * ImageStripWriter.
+  *
+  * \sa StripReader
+  */
+class StripWriter {
+public:
+    virtual ~StripWriter();
+    QSize size() const;
+    int currentRow() const;
+    bool writeRow(const QRgb *pixels);
+    virtual bool finish();
+
+    static bool isStreamable(const QByteArray &format);
+    static StripWriter *create(const QString &filePath,
+                               const QByteArray &format, const QSize &size,
+                               bool alpha);
+
+protected:
+    StripWriter(const QSize &size, bool alpha);
+    /** Writes \a pixels of row \a y. Pixels are premultiplied if the image
+      * has alpha channel.
+      */
+    virtual bool writePixels(int y, const QRgb *pixels) = 0;
+
+    QSize imageSize;
+    bool alpha; /**< Rows contain alpha channel. */
+
+private:
+    int row; /**< Index of the next row to write. */
+
+    Q_DISABLE_COPY(StripWriter)
+};
+
+/** \brief Strip writer assembling rows into QImage. */
+class ImageStripWriter : public StripWriter {
+public:
+    ImageStripWriter(const QSize &size, bool alpha);
+    QImage image() const;
+
+protected:
+    bool writePixels(int y, const QRgb *pixels);
+
+private:
+    QImage target;
+};
+
+#endif // STRIPWRITER_HPP
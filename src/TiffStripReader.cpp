@@ -0,0 +1,562 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "TiffStripReader.hpp"
+#include "ConvertBands.hpp"
+
+#include <QAtomicInt>
+#include <QtEndian>
+
+#include <climits>
+#include <cstring>
+
+
+/** Decompresses blocks of single band. */
+class TiffStripReader::DecodeTask : public ConvertBandTask {
+public:
+    DecodeTask(const TiffStripReader *reader, const QVector<QByteArray> &blocks,
+               int firstBlock, uchar *bits)
+        : reader(reader), blocks(blocks), firstBlock(firstBlock), bits(bits),
+          failures(0) {}
+
+    void run(int begin, int end) {
+        for (int i=begin; i<end && !isCancelled(); i++) {
+            if (!reader->decodeBlock(blocks.at(i), firstBlock + i, bits))
+                failures.ref();
+        }
+    }
+
+    /** Returns true if all blocks were decoded. */
+    bool isDecoded() const {
+        return failures.load() == 0 && !isCancelled();
+    }
+
+private:
+    const TiffStripReader *reader;
+    const QVector<QByteArray> &blocks;
+    int firstBlock;
+    uchar *bits;
+    QAtomicInt failures;
+};
+
+
+/** Creates reader of \a filePath file. Call readHeader() before reading
+  * rows.
+  */
+TiffStripReader::TiffStripReader(const QString &filePath)
+    : StripReader(filePath), bigTiff(false), compression(NoCompression),
+      predictor(1), tiled(false), blockWidth(0), blockHeight(0),
+      blocksAcross(0), blocksDown(0), bandBlockRows(1), currentBand(-1) {}
+
+/** Parses the first image file directory and returns true if the image is
+  * supported, otherwise returns false.
+  */
+bool TiffStripReader::readHeader() {
+    uchar header[16];
+    if (!readAt(0, header, 8))
+        return false;
+    if (header[0] == 'I' && header[1] == 'I')
+        bigEndian = false;
+    else if (header[0] == 'M' && header[1] == 'M')
+        bigEndian = true;
+    else
+        return false;
+    quint64 directoryOffset;
+    const int version = toShort(header + 2);
+    if (version == 42)
+        directoryOffset = toLong(header + 4);
+    else if (version == 43) {
+        // BigTIFF: size of offsets, reserved word and 64-bit offset
+        if (toShort(header + 4) != 8 || !readAt(8, header + 8, 8))
+            return false;
+        bigTiff = true;
+        directoryOffset = toLong8(header + 8);
+    }
+    else
+        return false;
+    const int countSize = bigTiff ? 8 : 2;
+    const int entrySize = bigTiff ? 20 : 12;
+    uchar countData[8];
+    if (!readAt(directoryOffset, countData, countSize))
+        return false;
+    const quint64 count = bigTiff ? toLong8(countData) : toShort(countData);
+    if (count > 4096)
+        return false;
+    QByteArray directory(entrySize * count, '\0');
+    if (!readAt(directoryOffset + countSize, reinterpret_cast<uchar*>(
+                    directory.data()), directory.size()))
+        return false;
+
+    int width = 0;
+    int height = 0;
+    int bits = 0;
+    int photometric = -1;
+    int extraSample = 0;
+    int rowsPerStrip = INT_MAX;
+    int tileWidth = 0;
+    int tileLength = 0;
+    QVector<quint64> stripOffsets;
+    QVector<quint64> stripByteCounts;
+    QVector<quint64> tileOffsets;
+    QVector<quint64> tileByteCounts;
+    samplesPerPixel = 1;
+    for (quint64 i=0; i<count; i++) {
+        const uchar *entry = reinterpret_cast<const uchar*>(
+                    directory.constData()) + entrySize * i;
+        QVector<quint64> values;
+        if (!readValues(entry, &values))
+            return false;
+        if (values.isEmpty())
+            continue;
+        const quint64 value = values.first();
+        switch (toShort(entry)) {
+        case ImageWidth:
+            width = qMin<quint64>(value, INT_MAX);
+            break;
+        case ImageLength:
+            height = qMin<quint64>(value, INT_MAX);
+            break;
+        case BitsPerSample:
+            bits = value;
+            foreach (quint64 sampleBits, values)
+                if (sampleBits != value)
+                    return false;
+            break;
+        case Compression:
+            compression = value;
+            break;
+        case Photometric:
+            photometric = value;
+            break;
+        case StripOffsets:
+            stripOffsets = values;
+            break;
+        case SamplesPerPixel:
+            samplesPerPixel = qMin<quint64>(value, 16);
+            break;
+        case RowsPerStrip:
+            rowsPerStrip = qMin<quint64>(value, INT_MAX);
+            break;
+        case StripByteCounts:
+            stripByteCounts = values;
+            break;
+        case PlanarConfiguration:
+            if (value != 1)
+                return false;
+            break;
+        case Predictor:
+            predictor = value;
+            break;
+        case TileWidth:
+            tileWidth = qMin<quint64>(value, INT_MAX);
+            break;
+        case TileLength:
+            tileLength = qMin<quint64>(value, INT_MAX);
+            break;
+        case TileOffsets:
+            tileOffsets = values;
+            break;
+        case TileByteCounts:
+            tileByteCounts = values;
+            break;
+        case ExtraSamples:
+            extraSample = value;
+            break;
+        case SampleFormat:
+            if (value != 1)
+                return false;
+            break;
+        }
+    }
+
+    if (width <= 0 || height <= 0 || (bits != 8 && bits != 16))
+        return false;
+    if (compression != NoCompression && compression != LzwCompression
+            && compression != DeflateCompression
+            && compression != ObsoleteDeflateCompression
+            && compression != PackBitsCompression)
+        return false;
+    if (predictor != 1 && predictor != 2)
+        return false;
+    if (photometric == 0 || photometric == 1)
+        colorSamples = 1;
+    else if (photometric == 2)
+        colorSamples = 3;
+    else
+        return false;
+    if (samplesPerPixel < colorSamples)
+        return false;
+    imageSize = QSize(width, height);
+    sampleBytes = bits / 8;
+    maxValue = (1u << bits) - 1;
+    whiteIsZero = (photometric == 0);
+    // associated or unassociated alpha following color samples
+    if (samplesPerPixel > colorSamples && (extraSample == 1
+                                           || extraSample == 2)) {
+        alphaSample = colorSamples;
+        premultiplied = (extraSample == 1);
+    }
+
+    // layout of blocks
+    tiled = tileWidth > 0 && tileLength > 0;
+    if (tiled) {
+        blockWidth = tileWidth;
+        blockHeight = tileLength;
+        blockOffsets = tileOffsets;
+        blockByteCounts = tileByteCounts;
+    }
+    else {
+        blockWidth = width;
+        blockHeight = qBound(1, rowsPerStrip, height);
+        blockOffsets = stripOffsets;
+        blockByteCounts = stripByteCounts;
+    }
+    blocksAcross = (width - 1) / blockWidth + 1;
+    blocksDown = (height - 1) / blockHeight + 1;
+    const qint64 blocks = qint64(blocksAcross) * blocksDown;
+    if (blockOffsets.size() < blocks || blockByteCounts.size() < blocks)
+        return false;
+    // rows of uncompressed strips are read directly
+    if (!tiled && compression == NoCompression)
+        return true;
+    bandBlockRows = tiled ? 1 : qMax(1, minBandRows / blockHeight);
+    const qint64 bandRows = qint64(bandBlockRows) * blockHeight;
+    const qint64 blockSize = qint64(blockWidth) * blockHeight
+            * samplesPerPixel * sampleBytes;
+    return bandRows * rowSize() <= maxBandSize && blockSize <= maxBandSize;
+}
+
+/** Returns true if the image is stored in tiles, otherwise false. */
+bool TiffStripReader::isTiled() const {
+    return tiled;
+}
+
+bool TiffStripReader::readSamples(int y, uchar *samples) {
+    if (!tiled && compression == NoCompression) {
+        const int strip = y / blockHeight;
+        const qint64 offset = qint64(y % blockHeight) * rowSize();
+        if (offset + rowSize() > qint64(blockByteCounts.at(strip)))
+            return false;
+        return readAt(blockOffsets.at(strip) + offset, samples, rowSize());
+    }
+    const int bandRows = bandBlockRows * blockHeight;
+    const int index = y / bandRows;
+    if (index != currentBand && !decodeBand(index))
+        return false;
+    memcpy(samples, band.constData() + qint64(y - index * bandRows)
+           * rowSize(), rowSize());
+    return true;
+}
+
+/** Returns 16-bit value stored in \a data in the byte order of the file. */
+quint16 TiffStripReader::toShort(const uchar *data) const {
+    return bigEndian ? qFromBigEndian<quint16>(data)
+                     : qFromLittleEndian<quint16>(data);
+}
+
+/** Returns 32-bit value stored in \a data in the byte order of the file. */
+quint32 TiffStripReader::toLong(const uchar *data) const {
+    return bigEndian ? qFromBigEndian<quint32>(data)
+                     : qFromLittleEndian<quint32>(data);
+}
+
+/** Returns 64-bit value stored in \a data in the byte order of the file. */
+quint64 TiffStripReader::toLong8(const uchar *data) const {
+    return bigEndian ? qFromBigEndian<quint64>(data)
+                     : qFromLittleEndian<quint64>(data);
+}
+
+/** Reads BYTE, SHORT, LONG and LONG8 values of directory \a entry into
+  * \a values. Values of other types are skipped.
+  * \return False if the values couldn't be read, otherwise true.
+  */
+bool TiffStripReader::readValues(const uchar *entry,
+                                 QVector<quint64> *values) {
+    const int type = toShort(entry + 2);
+    const quint64 count = bigTiff ? toLong8(entry + 4) : toLong(entry + 4);
+    const uchar *field = entry + (bigTiff ? 12 : 8);
+    const int fieldSize = bigTiff ? 8 : 4;
+    int size;
+    switch (type) {
+    case 1: // BYTE
+        size = 1;
+        break;
+    case 3: // SHORT
+        size = 2;
+        break;
+    case 4: // LONG
+    case 13: // IFD
+        size = 4;
+        break;
+    case 16: // LONG8
+    case 18: // IFD8
+        size = 8;
+        break;
+    default:
+        values->append(0);
+        return true;
+    }
+    if (count > quint64(INT_MAX >> 3) / size)
+        return false;
+    QByteArray data;
+    const uchar *bytes = field;
+    // values longer than the field are stored at offset
+    if (count * size > quint64(fieldSize)) {
+        data.resize(count * size);
+        const quint64 offset = bigTiff ? toLong8(field) : toLong(field);
+        if (!readAt(offset, reinterpret_cast<uchar*>(data.data()),
+                    data.size()))
+            return false;
+        bytes = reinterpret_cast<const uchar*>(data.constData());
+    }
+    values->resize(count);
+    for (quint64 i=0; i<count; i++) {
+        const uchar *value = bytes + i * size;
+        if (size == 1)
+            (*values)[i] = *value;
+        else if (size == 2)
+            (*values)[i] = toShort(value);
+        else if (size == 4)
+            (*values)[i] = toLong(value);
+        else
+            (*values)[i] = toLong8(value);
+    }
+    return true;
+}
+
+/** Decodes band \a index into #band. Stored blocks are read sequentially in
+  * the calling thread and decompressed by band executor threads.
+  * \return True if the band was decoded, otherwise false.
+  */
+bool TiffStripReader::decodeBand(int index) {
+    currentBand = -1;
+    const int firstRow = index * bandBlockRows;
+    const int rows = qMin(bandBlockRows, blocksDown - firstRow);
+    if (rows <= 0)
+        return false;
+    const int firstBlock = firstRow * blocksAcross;
+    // compressed data is at most 1.5 times larger than decoded block even
+    // for LZW codes, so corrupted byte counts can't allocate huge buffers
+    const qint64 blockSize = qint64(blockWidth) * blockHeight
+            * samplesPerPixel * sampleBytes;
+    const quint64 maxStoredSize = blockSize + blockSize / 2 + 1024;
+    const quint64 fileSize = file.size();
+    QVector<QByteArray> blocks(rows * blocksAcross);
+    for (int i=0; i<blocks.size(); i++) {
+        const quint64 size = blockByteCounts.at(firstBlock + i);
+        const quint64 offset = blockOffsets.at(firstBlock + i);
+        if (size > maxStoredSize || offset > fileSize
+                || size > fileSize - offset)
+            return false;
+        blocks[i].resize(size);
+        if (!readAt(offset, reinterpret_cast<uchar*>(blocks[i].data()), size))
+            return false;
+    }
+    band.resize(bandBlockRows * blockHeight * rowSize());
+    DecodeTask task(this, blocks, firstBlock,
+                    reinterpret_cast<uchar*>(band.data()));
+    task.setCancellationToken(cancellation);
+    ConvertBands::run(bandExecutor, &task, blocks.size(),
+                      qint64(rows) * blockHeight * imageSize.width());
+    if (!task.isDecoded())
+        return false;
+    currentBand = index;
+    return true;
+}
+
+/** Decompresses block \a index stored in \a data and copies its rows into
+  * band \a bits. This function is called concurrently for distinct blocks.
+  * \return True if the block was decoded, otherwise false.
+  */
+bool TiffStripReader::decodeBlock(const QByteArray &data, int index,
+                                  uchar *bits) const {
+    const int pixelSize = samplesPerPixel * sampleBytes;
+    const int blockRowSize = blockWidth * pixelSize;
+    const int blockRow = index / blocksAcross;
+    const int x = (index % blocksAcross) * blockWidth;
+    const int y = blockRow * blockHeight;
+    // the last strip may be shorter; tiles are always padded
+    const int rows = qMin(blockHeight, imageSize.height() - y);
+    const int storedRows = tiled ? blockHeight : rows;
+    QByteArray samples = decompress(data, storedRows * blockRowSize);
+    if (samples.size() < rows * blockRowSize)
+        return false;
+    uchar *blockBits = reinterpret_cast<uchar*>(samples.data());
+    if (predictor == 2)
+        undoPredictor(blockBits, rows, blockRowSize);
+    const int copySize = qMin(blockWidth, imageSize.width() - x) * pixelSize;
+    uchar *target = bits + qint64(y % (bandBlockRows * blockHeight))
+            * rowSize() + x * pixelSize;
+    for (int i=0; i<rows; i++)
+        memcpy(target + qint64(i) * rowSize(), blockBits + i * blockRowSize,
+               copySize);
+    return true;
+}
+
+/** Returns \a data decompressed into \a size bytes or less if the data is
+  * corrupted.
+  */
+QByteArray TiffStripReader::decompress(const QByteArray &data,
+                                       int size) const {
+    switch (compression) {
+    case LzwCompression:
+        return lzwDecode(data, size);
+    case DeflateCompression:
+    case ObsoleteDeflateCompression: {
+        // qUncompress() expects zlib stream preceded by big endian size
+        QByteArray stream(4, '\0');
+        qToBigEndian<quint32>(size, reinterpret_cast<uchar*>(stream.data()));
+        stream.append(data);
+        return qUncompress(stream);
+    }
+    case PackBitsCompression:
+        return packBitsDecode(data, size);
+    default:
+        return data;
+    }
+}
+
+/** Reverts horizontal differencing of \a rows rows of \a samples. Each row
+  * contains \a rowSize bytes.
+  */
+void TiffStripReader::undoPredictor(uchar *samples, int rows,
+                                    int rowSize) const {
+    const int count = rowSize / sampleBytes;
+    for (int y=0; y<rows; y++, samples += rowSize) {
+        if (sampleBytes == 1) {
+            for (int i=samplesPerPixel; i<count; i++)
+                samples[i] += samples[i - samplesPerPixel];
+            continue;
+        }
+        for (int i=samplesPerPixel; i<count; i++) {
+            uchar *sample = samples + 2 * i;
+            const quint16 value = toShort(sample)
+                    + toShort(sample - 2 * samplesPerPixel);
+            if (bigEndian)
+                qToBigEndian<quint16>(value, sample);
+            else
+                qToLittleEndian<quint16>(value, sample);
+        }
+    }
+}
+
+/** Decodes \a data compressed by TIFF variant of LZW compression into at most
+  * \a size bytes. Code width grows one code earlier than in GIF files.
+  */
+QByteArray TiffStripReader::lzwDecode(const QByteArray &data, int size) {
+    enum {
+        ClearCode = 256,
+        EndCode = 257,
+        FirstCode = 258,
+        MaxCodes = 4096
+    };
+    QVector<quint16> prefix(MaxCodes);
+    QVector<uchar> suffix(MaxCodes);
+    QVector<uchar> first(MaxCodes);
+    QVector<int> length(MaxCodes);
+    for (int i=0; i<256; i++) {
+        suffix[i] = first[i] = i;
+        length[i] = 1;
+    }
+    QByteArray output(size, '\0');
+    uchar *out = reinterpret_cast<uchar*>(output.data());
+    int written = 0;
+    const uchar *in = reinterpret_cast<const uchar*>(data.constData());
+    const qint64 bitCount = qint64(data.size()) * 8;
+    qint64 bitPos = 0;
+    int codeWidth = 9;
+    int nextCode = FirstCode;
+    int oldCode = -1;
+    while (written < size && bitPos + codeWidth <= bitCount) {
+        // codes are packed from the most significant bit
+        int code = 0;
+        for (int i=0; i<codeWidth; i++, bitPos++)
+            code = (code << 1) | ((in[bitPos >> 3] >> (7 - (bitPos & 7))) & 1);
+        if (code == EndCode)
+            break;
+        if (code == ClearCode) {
+            codeWidth = 9;
+            nextCode = FirstCode;
+            oldCode = -1;
+            continue;
+        }
+        if (oldCode < 0) {
+            if (code > 255)
+                break;
+            out[written++] = code;
+            oldCode = code;
+            continue;
+        }
+        int firstByte;
+        if (code < nextCode)
+            firstByte = first.at(code);
+        else if (code == nextCode)
+            firstByte = first.at(oldCode);
+        else
+            break;
+        if (nextCode < MaxCodes) {
+            prefix[nextCode] = oldCode;
+            suffix[nextCode] = firstByte;
+            first[nextCode] = first.at(oldCode);
+            length[nextCode] = length.at(oldCode) + 1;
+            nextCode++;
+        }
+        // strings are written from the last byte
+        const int count = qMin(length.at(code), size - written);
+        int entry = code;
+        for (int skip = length.at(code) - count; skip > 0; skip--)
+            entry = prefix.at(entry);
+        for (int i=count-1; i>=0; i--) {
+            out[written + i] = suffix.at(entry);
+            entry = prefix.at(entry);
+        }
+        written += count;
+        oldCode = code;
+        if (nextCode + 1 >= (1 << codeWidth) && codeWidth < 12)
+            codeWidth++;
+    }
+    output.resize(written);
+    return output;
+}
+
+/** Decodes \a data compressed by PackBits compression into at most \a size
+  * bytes.
+  */
+QByteArray TiffStripReader::packBitsDecode(const QByteArray &data,
+                                           int size) {
+    QByteArray output;
+    output.reserve(size);
+    const char *in = data.constData();
+    const char *end = in + data.size();
+    while (in < end && output.size() < size) {
+        const int header = static_cast<signed char>(*in++);
+        if (header >= 0) {
+            const int count = qMin<qint64>(header + 1, end - in);
+            output.append(in, count);
+            in += count;
+        }
+        else if (header != -128 && in < end)
+            output.append(QByteArray(1 - header, *in++));
+    }
+    output.truncate(size);
+    return output;
+}
@@ -0,0 +1,120 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef TIFFSTRIPREADER_HPP
+#define TIFFSTRIPREADER_HPP
+
+#include "StripReader.hpp"
+
+
+/** \brief Strip reader of classic TIFF and BigTIFF images.
+  *
+  * The first image file directory of the file is parsed without libtiff.
+  * Supported are 8-bit and 16-bit gray and RGB images with optional alpha
+  * channel, stored as chunky strips or tiles. Blocks (strips or tiles) may
+  * be uncompressed or compressed by LZW, Deflate or PackBits compression,
+  * optionally with horizontal differencing predictor.
+  *
+  * Rows of uncompressed strips are read directly from the file. Other images
+  * are decoded in bands: compressed data of all blocks of the band is read
+  * sequentially and the blocks are decompressed in parallel by band
+  * executor threads. A band holds a row of tiles or at least minBandRows rows
+  * of strips, so memory used by the reader is proportional to the image
+  * width.
+  *
+  * \sa StripReader::open()
+  */
+class TiffStripReader : public StripReader {
+    friend class TiffStripReaderTest;
+
+public:
+    explicit TiffStripReader(const QString &filePath);
+    bool readHeader();
+    bool isTiled() const;
+
+    /** Minimal count of rows of band of strips. */
+    static const int minBandRows = 256;
+    /** Maximal size of decoded band in bytes. */
+    static const int maxBandSize = 256 * 1024 * 1024;
+
+protected:
+    bool readSamples(int y, uchar *samples);
+
+private:
+    //! TIFF tags used by the reader.
+    enum Tag {
+        ImageWidth = 256,
+        ImageLength = 257,
+        BitsPerSample = 258,
+        Compression = 259,
+        Photometric = 262,
+        StripOffsets = 273,
+        SamplesPerPixel = 277,
+        RowsPerStrip = 278,
+        StripByteCounts = 279,
+        PlanarConfiguration = 284,
+        Predictor = 317,
+        TileWidth = 322,
+        TileLength = 323,
+        TileOffsets = 324,
+        TileByteCounts = 325,
+        ExtraSamples = 338,
+        SampleFormat = 339
+    };
+    //! Supported values of Compression tag.
+    enum CompressionType {
+        NoCompression = 1,
+        LzwCompression = 5,
+        DeflateCompression = 8,
+        ObsoleteDeflateCompression = 32946,
+        PackBitsCompression = 32773
+    };
+    class DecodeTask;
+
+    bool bigTiff; /**< The file is BigTIFF file with 64-bit offsets. */
+    int compression; /**< Value of Compression tag. */
+    int predictor; /**< Value of Predictor tag. */
+    bool tiled; /**< Blocks are tiles instead of strips. */
+    int blockWidth; /**< Width of single block in pixels. */
+    int blockHeight; /**< Height of single block in rows. */
+    int blocksAcross; /**< Count of blocks in single row of blocks. */
+    int blocksDown; /**< Count of rows of blocks. */
+    QVector<quint64> blockOffsets; /**< Offsets of blocks in the file. */
+    QVector<quint64> blockByteCounts; /**< Sizes of stored blocks. */
+    int bandBlockRows; /**< Count of rows of blocks in single band. */
+    int currentBand; /**< Index of band decoded in #band or -1. */
+    QByteArray band; /**< Samples of decoded band. */
+
+    quint16 toShort(const uchar *data) const;
+    quint32 toLong(const uchar *data) const;
+    quint64 toLong8(const uchar *data) const;
+    bool readValues(const uchar *entry, QVector<quint64> *values);
+    bool decodeBand(int index);
+    bool decodeBlock(const QByteArray &data, int index, uchar *bits) const;
+    QByteArray decompress(const QByteArray &data, int size) const;
+    void undoPredictor(uchar *samples, int rows, int rowSize) const;
+
+    static QByteArray lzwDecode(const QByteArray &data, int size);
+    static QByteArray packBitsDecode(const QByteArray &data, int size);
+};
+
+#endif // TIFFSTRIPREADER_HPP
@@ -0,0 +1,107 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "TokenBucket.hpp"
+
+#include <cmath>
+
+
+/** Creates bucket refilled with \a rate tokens per second. 0 means
+  * unlimited rate.
+  */
+TokenBucket::TokenBucket(qint64 rate) : perSecond(qMax<qint64>(0, rate)) {
+    tokens = perSecond;
+    clock.start();
+}
+
+/** Changes rate to \a rate tokens per second and wakes up waiting threads.
+  * 0 means unlimited rate. Debt is kept, but balance is limited to one
+  * second of tokens of the new rate.
+  */
+void TokenBucket::setRate(qint64 rate) {
+    QMutexLocker locker(&mutex);
+    refill();
+    perSecond = qMax<qint64>(0, rate);
+    tokens = (perSecond == 0) ? 0. : qMin<double>(tokens, perSecond);
+    changed.wakeAll();
+}
+
+/** Returns tokens per second or 0 if the rate is unlimited. */
+qint64 TokenBucket::rate() const {
+    QMutexLocker locker(&mutex);
+    return perSecond;
+}
+
+/** Returns current count of tokens. Negative value is the debt. */
+qint64 TokenBucket::balance() const {
+    QMutexLocker locker(&mutex);
+    refill();
+    return qint64(std::floor(tokens));
+}
+
+/** Takes \a amount tokens. The balance may become negative; call wait()
+  * to wait for the debt payoff.
+  */
+void TokenBucket::consume(qint64 amount) {
+    QMutexLocker locker(&mutex);
+    if (perSecond == 0 || amount <= 0)
+        return;
+    refill();
+    tokens -= amount;
+}
+
+/** Blocks the calling thread while the bucket is in debt, but \a time
+  * milliseconds at most.
+  * \return True if the debt is paid off or the rate is unlimited, otherwise
+  *         false.
+  * \sa consume()
+  */
+bool TokenBucket::wait(unsigned long time) {
+    QMutexLocker locker(&mutex);
+    QElapsedTimer timer;
+    timer.start();
+    forever {
+        refill();
+        if (perSecond == 0 || tokens >= 0.)
+            return true;
+        unsigned long left = ULONG_MAX;
+        if (time != ULONG_MAX) {
+            const qint64 elapsed = timer.elapsed();
+            if (elapsed >= qint64(time))
+                return false;
+            left = time - elapsed;
+        }
+        // time needed for payoff in milliseconds
+        const double payoff = std::ceil(-tokens * 1000. / perSecond);
+        changed.wait(&mutex, qMin<double>(left, qMax(1., payoff)));
+    }
+}
+
+/** Adds tokens earned since the last refill.
+  * \note Call this function with locked #mutex.
+  */
+void TokenBucket::refill() const {
+    const qint64 elapsed = clock.nsecsElapsed();
+    clock.restart();
+    if (perSecond == 0)
+        return;
+    tokens = qMin<double>(perSecond, tokens + elapsed * 1e-9 * perSecond);
+}
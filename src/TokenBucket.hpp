@@ -0,0 +1,63 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef TOKENBUCKET_HPP
+#define TOKENBUCKET_HPP
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <climits>
+
+
+/** \brief Token bucket rate limiter shared by threads.
+  *
+  * The bucket is refilled with rate() tokens per second up to one second of
+  * tokens. Threads consume() tokens for bytes read or written or for CPU
+  * time used, and wait() while the bucket is in debt, so the long-term
+  * consumption doesn't exceed the rate. Consumption above the balance is
+  * allowed, so single large file isn't blocked forever.
+  *
+  * \sa ConvertScheduler::setReadLimit() ConvertScheduler::setCpuShare()
+  */
+class TokenBucket {
+public:
+    explicit TokenBucket(qint64 rate = 0);
+    void setRate(qint64 rate);
+    qint64 rate() const;
+    qint64 balance() const;
+    void consume(qint64 amount);
+    bool wait(unsigned long time = ULONG_MAX);
+
+private:
+    mutable QMutex mutex;
+    QWaitCondition changed;
+    mutable QElapsedTimer clock; /**< Measures time since the last refill. */
+    qint64 perSecond; /**< Tokens per second or 0 if unlimited. */
+    mutable double tokens; /**< Current balance; negative means debt. */
+
+    void refill() const;
+
+    Q_DISABLE_COPY(TokenBucket)
+};
+
+#endif // TOKENBUCKET_HPP
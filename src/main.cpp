@@ -25,6 +25,7 @@
 
 #include "main.hpp"
 #include "CommandLineAssistant.hpp"
+#include "ConvertWorker.hpp"
 
 
 #if QT_VERSION >= 0x050000 || defined(Q_OS_OS2)
@@ -49,6 +50,12 @@ int main(int argc, char *argv[]) {
         args += codec->toUnicode(argv[i]);
     args.removeDuplicates();
 
+    // child process converting images for ConvertScheduler
+    if (args.contains(ConvertWorker::argument)) {
+        ConvertWorker worker;
+        return worker.exec();
+    }
+
     CommandLineAssistant cmd;
     int cmdParseResult = cmd.parse(args);
     if (cmdParseResult < 1)
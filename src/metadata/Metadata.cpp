@@ -55,13 +55,44 @@ Metadata::~Metadata() {
   * \sa lastError()
   */
 bool Metadata::read(const String& path, bool setupStructs, bool fromSvg) {
+    return readImage(path, QByteArray(), setupStructs, fromSvg);
+}
+
+/** This is overloaded function. */
+bool Metadata::read(const QString &path, bool setupStructs, bool fromSvg) {
+    return read((const String&)path, setupStructs, fromSvg);
+}
+
+/** This is overloaded function.
+  *
+  * Reads metadata from \a data containing whole file of \a path file path,
+  * e.g. memory mapping of the file, so the file isn't read again.
+  * \note Exiv2 doesn't copy \a data, so it must be valid until close() or next
+  *       read() call.
+  */
+bool Metadata::read(const QString &path, const QByteArray &data,
+                    bool setupStructs) {
+    return readImage(path, data, setupStructs, false);
+}
+
+/** Reads metadata from \a data if it isn't empty, otherwise from \a path
+  * file.
+  * \sa read()
+  */
+bool Metadata::readImage(const String &path, const QByteArray &data,
+                         bool setupStructs, bool fromSvg) {
     close();
     std::string filePath = path.toNativeStdString();
     try {
         if (fromSvg)
             image = Exiv2::ImageFactory::create(1);
         else {
-            image = Exiv2::ImageFactory::open(filePath);
+            if (data.isEmpty())
+                image = Exiv2::ImageFactory::open(filePath);
+            else
+                image = Exiv2::ImageFactory::open(
+                            reinterpret_cast<const Exiv2::byte *>(
+                                data.constData()), data.size());
             image->readMetadata();
         }
         // load Exif data
@@ -102,11 +133,6 @@ bool Metadata::read(const String& path, bool setupStructs, bool fromSvg) {
     }
 }
 
-/** This is overloaded function. */
-bool Metadata::read(const QString &path, bool setupStructs, bool fromSvg) {
-    return read((const String&)path, setupStructs, fromSvg);
-}
-
 /** Writes metadata about file corresponding with \a path file path and
   * \a qImage image, and returns read success value.
   *
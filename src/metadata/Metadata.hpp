@@ -44,6 +44,7 @@ public:
     ~Metadata();
     bool read(const sir::String& path, bool setupStructs = false, bool fromSvg = false);
     bool read(const QString& path, bool setupStructs = false, bool fromSvg = false);
+    bool read(const QString& path, const QByteArray& data, bool setupStructs = false);
     bool write(const sir::String& path, const QImage& image = QImage());
     bool write(const QString& path, const QImage& image = QImage());
     void close();
@@ -97,6 +98,8 @@ private:
     bool firstEmptyFieldSkipped;
     std::list<std::string> emptyFieldKeyList;
     // methods
+    bool readImage(const sir::String &path, const QByteArray &data,
+                   bool setupStructs, bool fromSvg);
     bool setData(const QImage &img);
     void removeDatum(const std::string &key);
     void removeEmptyFields();
@@ -21,9 +21,9 @@
 
 #include "raw/RawLoader.hpp"
 
-#include <QImageReader>
 #include <QProcess>
 
+#include "ImageFormatRegistry.hpp"
 #include "raw/PaintDevice.hpp"
 
 
@@ -37,8 +37,8 @@ RawLoader::~RawLoader() {}
 
 bool RawLoader::isRawImage()
 {
-    QString extension = fileExtension();
-    if (regularImageFormatList().contains(extension)) {
+    const ImageFormatRegistry *registry = ImageFormatRegistry::instance();
+    if (registry->isReadable(registry->format(filePath))) {
         return false;
     }
 
@@ -91,21 +91,3 @@ PaintDevice *RawLoader::loadFromNormalFile()
     paintDevice->load(filePath);
     return paintDevice;
 }
-
-QStringList RawLoader::regularImageFormatList() const
-{
-    QStringList list;
-
-    foreach(QByteArray format, QImageReader::supportedImageFormats()) {
-        list << QString(format);
-    }
-    list << "jpg" << "JPG" << "JPEG" << "Jpg" << "Jpeg";
-
-    return list;
-}
-
-QString RawLoader::fileExtension() const
-{
-    int index = filePath.size() - filePath.lastIndexOf(".") - 1;
-    return filePath.right(index);
-}
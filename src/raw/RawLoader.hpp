@@ -49,9 +49,6 @@ private:
 
     PaintDevice *loadFromRawFile();
     PaintDevice *loadFromNormalFile();
-
-    QStringList regularImageFormatList() const;
-    QString fileExtension() const;
 };
 
 #endif // RAWLOADER_HPP
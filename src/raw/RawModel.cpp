@@ -21,6 +21,8 @@
 
 #include "raw/RawModel.hpp"
 
+#include <QDataStream>
+
 #include "Settings.hpp"
 #include "raw/RawModelValidator.hpp"
 #include "raw/RawToolbox.hpp"
@@ -129,3 +131,26 @@ void RawModel::setRawTab(RawModel::RawTab value)
 {
     tab = value;
 }
+
+/** Writes \a model into \a stream. \sa ConvertWorker */
+QDataStream &operator<<(QDataStream &stream, const RawModel &model)
+{
+    stream << model.isEnabled() << model.dcrawPath() << model.dcrawOptions()
+           << qint32(model.rawTab());
+    return stream;
+}
+
+/** Reads \a model from \a stream. \sa ConvertWorker */
+QDataStream &operator>>(QDataStream &stream, RawModel &model)
+{
+    bool enabled;
+    QString dcrawPath;
+    QString dcrawOptions;
+    qint32 tab;
+    stream >> enabled >> dcrawPath >> dcrawOptions >> tab;
+    model.setEnabled(enabled);
+    model.setDcrawPath(dcrawPath);
+    model.setDcrawOptions(dcrawOptions);
+    model.setRawTab(static_cast<RawModel::RawTab>(tab));
+    return stream;
+}
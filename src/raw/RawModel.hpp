@@ -24,6 +24,7 @@
 
 #include <QString>
 
+class QDataStream;
 class Settings;
 
 
@@ -64,4 +65,7 @@ private:
     RawTab tab;
 };
 
+QDataStream &operator<<(QDataStream &stream, const RawModel &model);
+QDataStream &operator>>(QDataStream &stream, RawModel &model);
+
 #endif // RAWMODEL_HPP
@@ -21,7 +21,16 @@
 
 #include "EffectsConfiguration.hpp"
 
-EffectsConfiguration::EffectsConfiguration() {}
+#include <QDataStream>
+
+/** Creates configuration with all effects disabled. */
+EffectsConfiguration::EffectsConfiguration()
+    : histogramOperation(0), filterType(NoFilter), frameWidth(0),
+      frameAddAround(false), borderInsideWidth(0), borderOutsideWidth(0),
+      textOpacity(1.), textPosModifier(UndefinedPosModifier),
+      textUnitPair(Pixel, Pixel), textFrame(false), textRotation(0),
+      imageLoadError(false), imagePosModifier(UndefinedPosModifier),
+      imageUnitPair(Pixel, Pixel), imageOpacity(1.), imageRotation(0) {}
 
 quint8 EffectsConfiguration::getHistogramOperation() const {
     return histogramOperation;
@@ -227,3 +236,87 @@ int EffectsConfiguration::getImageRotation() const {
 void EffectsConfiguration::setImageRotation(int value) {
     imageRotation = value;
 }
+
+/** Writes \a conf into \a stream. \sa ConvertWorker */
+QDataStream &operator<<(QDataStream &stream,
+                        const EffectsConfiguration &conf) {
+    stream << conf.getHistogramOperation() << qint32(conf.getFilterType())
+           << conf.getFilterBrush() << qint32(conf.getFrameWidth())
+           << conf.getFrameColor() << conf.getFrameAddAround()
+           << qint32(conf.getBorderInsideWidth())
+           << conf.getBorderInsideColor()
+           << qint32(conf.getBorderOutsideWidth())
+           << conf.getBorderOutsideColor();
+    stream << conf.getTextString() << conf.getTextFont()
+           << conf.getTextColor() << conf.getTextOpacity()
+           << qint32(conf.getTextPosModifier()) << conf.getTextPos()
+           << qint32(conf.getTextUnitPair().first)
+           << qint32(conf.getTextUnitPair().second)
+           << conf.getTextFrame() << qint32(conf.getTextRotation());
+    stream << conf.getImage() << conf.getImageLoadError()
+           << qint32(conf.getImagePosModifier()) << conf.getImagePos()
+           << qint32(conf.getImageUnitPair().first)
+           << qint32(conf.getImageUnitPair().second)
+           << conf.getImageOpacity() << qint32(conf.getImageRotation());
+    return stream;
+}
+
+/** Reads \a conf from \a stream. \sa ConvertWorker */
+QDataStream &operator>>(QDataStream &stream, EffectsConfiguration &conf) {
+    quint8 histogramOperation;
+    qint32 filterType, frameWidth, borderInsideWidth, borderOutsideWidth;
+    QBrush filterBrush;
+    QColor frameColor, borderInsideColor, borderOutsideColor;
+    bool frameAddAround;
+    stream >> histogramOperation >> filterType >> filterBrush >> frameWidth
+           >> frameColor >> frameAddAround >> borderInsideWidth
+           >> borderInsideColor >> borderOutsideWidth >> borderOutsideColor;
+    conf.setHistogramOperation(histogramOperation);
+    conf.setFilterType(filterType);
+    conf.setFilterBrush(filterBrush);
+    conf.setFrameWidth(frameWidth);
+    conf.setFrameColor(frameColor);
+    conf.setFrameAddAround(frameAddAround);
+    conf.setBorderInsideWidth(borderInsideWidth);
+    conf.setBorderInsideColor(borderInsideColor);
+    conf.setBorderOutsideWidth(borderOutsideWidth);
+    conf.setBorderOutsideColor(borderOutsideColor);
+
+    QString textString;
+    QFont textFont;
+    QColor textColor;
+    double textOpacity;
+    qint32 textPosModifier, textUnitX, textUnitY, textRotation;
+    QPoint textPos;
+    bool textFrame;
+    stream >> textString >> textFont >> textColor >> textOpacity
+           >> textPosModifier >> textPos >> textUnitX >> textUnitY
+           >> textFrame >> textRotation;
+    conf.setTextString(textString);
+    conf.setTextFont(textFont);
+    conf.setTextColor(textColor);
+    conf.setTextOpacity(textOpacity);
+    conf.setTextPosModifier(static_cast<PosModifier>(textPosModifier));
+    conf.setTextPos(textPos);
+    conf.setTextUnitPair(PosUnitPair(static_cast<PosUnit>(textUnitX),
+                                     static_cast<PosUnit>(textUnitY)));
+    conf.setTextFrame(textFrame);
+    conf.setTextRotation(textRotation);
+
+    QImage image;
+    bool imageLoadError;
+    qint32 imagePosModifier, imageUnitX, imageUnitY, imageRotation;
+    QPoint imagePos;
+    double imageOpacity;
+    stream >> image >> imageLoadError >> imagePosModifier >> imagePos
+           >> imageUnitX >> imageUnitY >> imageOpacity >> imageRotation;
+    conf.setImage(image);
+    conf.setImageLoadError(imageLoadError);
+    conf.setImagePosModifier(static_cast<PosModifier>(imagePosModifier));
+    conf.setImagePos(imagePos);
+    conf.setImageUnitPair(PosUnitPair(static_cast<PosUnit>(imageUnitX),
+                                      static_cast<PosUnit>(imageUnitY)));
+    conf.setImageOpacity(imageOpacity);
+    conf.setImageRotation(imageRotation);
+    return stream;
+}
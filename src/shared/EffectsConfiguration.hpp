@@ -27,6 +27,7 @@
 
 #include "shared/Enums.hpp"
 
+class QDataStream;
 
 class EffectsConfiguration {
 public:
@@ -202,4 +203,8 @@ private:
     int imageRotation;
 };
 
+QDataStream &operator<<(QDataStream &stream,
+                        const EffectsConfiguration &conf);
+QDataStream &operator>>(QDataStream &stream, EffectsConfiguration &conf);
+
 #endif // EFFECTSCONFIGURATION_HPP
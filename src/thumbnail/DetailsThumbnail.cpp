@@ -22,6 +22,7 @@
 #include "thumbnail/DetailsThumbnail.hpp"
 
 #include "optionsenums.h"
+#include "Resampler.hpp"
 #include "Settings.hpp"
 #include "file/FileInfo.hpp"
 #include "widgets/ConvertDialog.hpp"
@@ -65,6 +66,22 @@ qint64 DetailsThumbnail::sourceFileSize() const {
     return info.size();
 }
 
+/** Returns color statistics of the source image.
+  * \sa isStatisticsApproximate()
+  */
+ImageStatistics DetailsThumbnail::statistics() const {
+    return stats;
+}
+
+/** Returns true if statistics() were computed from downsampled image like
+  * thumbnail read from metadata, so its color range may be narrower than
+  * range of the source image.
+  */
+bool DetailsThumbnail::isStatisticsApproximate() const {
+    return stats.pixelCount()
+            < qint64(imageSize.width()) * imageSize.height();
+}
+
 #ifdef SIR_METADATA_SUPPORT
 bool DetailsThumbnail::isReadFromMetadataThumbnail() const
 {
@@ -113,6 +130,9 @@ void DetailsThumbnail::writeThumbnail(const FileInfo &fileInfo, int index,
             imageSize = metadataThumbnail.sourceImageSize();
             thumbPath = metadataThumbnail.filePath();
             thumbSize = metadataThumbnail.size();
+            // the source isn't decoded on GUI thread, so the range of
+            // metadata thumbnail is shown as approximate
+            stats = ImageStatistics::fromFile(thumbPath, maxWidth);
         }
         else {
             writeThumbnailFromImageData(maxWidth);
@@ -134,12 +154,15 @@ void DetailsThumbnail::writeThumbnailFromImageData(int maxWidth)
 
     QImage thumbnail;
     if (img.width() > maxWidth)
-        thumbnail = img.scaledToWidth(maxWidth, Qt::SmoothTransformation);
+        thumbnail = Resampler().scaled(img, img.size().scaled(
+                                           maxWidth, img.height(),
+                                           Qt::KeepAspectRatio));
     else
         thumbnail = img;
     thumbnail.save(thumbPath, thumbnailFileFormat);
 
     thumbSize = thumbnail.size();
+    stats = ImageStatistics(img);
 }
 
 void DetailsThumbnail::writeThumbnailFromSVG(int maxWidth)
@@ -156,7 +179,10 @@ void DetailsThumbnail::writeThumbnailFromSVG(int maxWidth)
     thumbnail.fill(Qt::transparent);
     QPainter painter (&thumbnail);
     renderer->render(&painter);
+    // pixels may be buffered until the painter ends
+    painter.end();
 
     thumbPath += thumbnailFileExtension;
     thumbnail.save(thumbPath, thumbnailFileFormat);
+    stats = ImageStatistics(thumbnail);
 }
@@ -22,6 +22,7 @@
 #ifndef DETAILSTHUMBNAIL_HPP
 #define DETAILSTHUMBNAIL_HPP
 
+#include "ImageStatistics.hpp"
 #include "thumbnail/MetadataThumbnail.hpp"
 
 #include <QSize>
@@ -45,6 +46,8 @@ public:
     QSize sourceImageSize() const;
     QString sourceFilePath() const;
     qint64 sourceFileSize() const;
+    ImageStatistics statistics() const;
+    bool isStatisticsApproximate() const;
 
     void writeThumbnail(const FileInfo &fileInfo, int index, int maxWidth);
 
@@ -60,6 +63,8 @@ private:
     QString imagePath;
     QSize imageSize;
     QSize thumbSize;
+    /** Color statistics of the source image or of its metadata thumbnail. */
+    ImageStatistics stats;
 
     const char *thumbnailFileExtension = ".jpg";
     const char *thumbnailFileFormat = "JPEG";
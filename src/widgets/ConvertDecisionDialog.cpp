@@ -0,0 +1,137 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "widgets/ConvertDecisionDialog.hpp"
+
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+
+/** Creates decision table of pending questions of \a jobs. */
+ConvertDecisionDialog::ConvertDecisionDialog(QList<ConvertJob> *jobs,
+                                             QWidget *parent)
+    : QDialog(parent) {
+    this->jobs = jobs;
+
+    setWindowTitle(tr("Confirm Convertion - SIR"));
+
+    QLabel *label = new QLabel(tr("Some target files already exist or some "
+                                  "images are smaller than the requested size. "
+                                  "Enlargement can cause deterioration of "
+                                  "picture quality.\nCheck actions you agree "
+                                  "on; unchecked images will be skipped."),
+                               this);
+    label->setWordWrap(true);
+
+    treeWidget = new QTreeWidget(this);
+    treeWidget->setRootIsDecorated(false);
+    treeWidget->setUniformRowHeights(true);
+    treeWidget->setHeaderLabels(QStringList() << tr("File") << tr("Action"));
+
+    QList<QTreeWidgetItem *> items;
+    for (int i=0; i<jobs->count(); i++) {
+        const ConvertJob &job = jobs->at(i);
+        for (int question=0; question<ConvertJob::QuestionCount; question++) {
+            if (job.decisions[question] != ConvertJob::Pending)
+                continue;
+            QString filePath;
+            QString action;
+            switch (question) {
+            case ConvertJob::Overwrite:
+                filePath = job.targetFilePath;
+                action = tr("Overwrite");
+                break;
+            case ConvertJob::Enlarge:
+                filePath = job.imageData.at(2) + QDir::separator()
+                        + job.imageData.at(0) + '.' + job.imageData.at(1);
+                action = tr("Enlarge");
+                break;
+            case ConvertJob::SvgOverwrite:
+                filePath = job.targetFilePath.left(
+                            job.targetFilePath.lastIndexOf('.') + 1) + "svg";
+                action = tr("Overwrite");
+                break;
+            }
+            QTreeWidgetItem *item = new QTreeWidgetItem(
+                        QStringList() << QDir::toNativeSeparators(filePath)
+                                      << action);
+            item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsUserCheckable);
+            item->setCheckState(0, Qt::Unchecked);
+            item->setData(0, JobIndexRole, i);
+            item->setData(0, QuestionRole, question);
+            items << item;
+        }
+    }
+    treeWidget->addTopLevelItems(items);
+    treeWidget->resizeColumnToContents(0);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(
+                QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    QPushButton *acceptAllButton = buttonBox->addButton(
+                tr("Check &All"), QDialogButtonBox::ActionRole);
+    QPushButton *rejectAllButton = buttonBox->addButton(
+                tr("&Uncheck All"), QDialogButtonBox::ActionRole);
+    connect(acceptAllButton, SIGNAL(clicked()), SLOT(acceptAll()));
+    connect(rejectAllButton, SIGNAL(clicked()), SLOT(rejectAll()));
+    connect(buttonBox, SIGNAL(accepted()), SLOT(accept()));
+    connect(buttonBox, SIGNAL(rejected()), SLOT(reject()));
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(label);
+    layout->addWidget(treeWidget);
+    layout->addWidget(buttonBox);
+
+    resize(640, 400);
+}
+
+/** Writes decisions into jobs list and closes the dialog. */
+void ConvertDecisionDialog::accept() {
+    for (int i=0; i<treeWidget->topLevelItemCount(); i++) {
+        QTreeWidgetItem *item = treeWidget->topLevelItem(i);
+        int index = item->data(0, JobIndexRole).toInt();
+        int question = item->data(0, QuestionRole).toInt();
+        if (item->checkState(0) == Qt::Checked)
+            (*jobs)[index].decisions[question] = ConvertJob::Accepted;
+        else
+            (*jobs)[index].decisions[question] = ConvertJob::Rejected;
+    }
+    QDialog::accept();
+}
+
+/** Checks all rows. */
+void ConvertDecisionDialog::acceptAll() {
+    setCheckState(Qt::Checked);
+}
+
+/** Unchecks all rows. */
+void ConvertDecisionDialog::rejectAll() {
+    setCheckState(Qt::Unchecked);
+}
+
+void ConvertDecisionDialog::setCheckState(Qt::CheckState state) {
+    for (int i=0; i<treeWidget->topLevelItemCount(); i++)
+        treeWidget->topLevelItem(i)->setCheckState(0, state);
+}
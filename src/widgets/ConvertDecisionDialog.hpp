@@ -0,0 +1,65 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#ifndef CONVERTDECISIONDIALOG_HPP
+#define CONVERTDECISIONDIALOG_HPP
+
+#include <QDialog>
+
+#include "ConvertQueue.hpp"
+
+class QTreeWidget;
+
+
+/** \brief Decision table of questions about convertion batch.
+  *
+  * Lists all pending questions found by ConvertPreflight, i.e. which target
+  * files will be overwritten and which images will be enlarged. Checked rows
+  * are accepted, unchecked are rejected. Decisions are written into jobs
+  * list when the dialog is accepted.
+  *
+  * \sa ConvertJob::Decision
+  */
+class ConvertDecisionDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    ConvertDecisionDialog(QList<ConvertJob> *jobs, QWidget *parent = 0);
+
+public slots:
+    void accept();
+    void acceptAll();
+    void rejectAll();
+
+private:
+    //! Item data roles.
+    enum Role {
+        JobIndexRole = Qt::UserRole,
+        QuestionRole
+    };
+
+    QList<ConvertJob> *jobs;
+    QTreeWidget *treeWidget;
+
+    void setCheckState(Qt::CheckState state);
+};
+
+#endif // CONVERTDECISIONDIALOG_HPP
@@ -22,6 +22,8 @@
 #include "widgets/ConvertDialog.hpp"
 
 #include "CommandLineAssistant.hpp"
+#include "ConvertPreflight.hpp"
+#include "ConvertScheduler.hpp"
 #include "ConvertSharedData.hpp"
 #include "EffectsCollector.hpp"
 #include "LanguageUtils.hpp"
@@ -32,6 +34,7 @@
 #include "SharedInformationBuilder.hpp"
 #include "Version.hpp"
 #include "widgets/AboutDialog.hpp"
+#include "widgets/ConvertDecisionDialog.hpp"
 #include "widgets/DetailsBrowserController.hpp"
 #include "widgets/MessageBox.hpp"
 #include "widgets/TreeWidget.hpp"
@@ -46,6 +49,7 @@
 #include <QImageReader>
 #include <QImageWriter>
 #include <QLibraryInfo>
+#include <QTimer>
 #include <QTranslator>
 #include <QUrl>
 #include <QWindowStateChangeEvent>
@@ -67,7 +71,7 @@ using namespace sir;
   */
 ConvertDialog::ConvertDialog(QWidget *parent, const QStringList &args,
                              CommandLineAssistant *cmdAssistant)
-    : QMainWindow(parent) {
+    : QMainWindow(parent), preflight(ConvertThread::sharedInfo()) {
     csd = ConvertSharedData::instance();
 
     setupUi(this);
@@ -75,6 +79,9 @@ ConvertDialog::ConvertDialog(QWidget *parent, const QStringList &args,
     this->args = args;
     net = NULL;
     sharedInfo = ConvertThread::sharedInfo();
+    scheduler = new ConvertScheduler(this);
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(100);
     effectsDir = QDir::home();
     sessionDir = QDir::home();
 
@@ -106,6 +113,7 @@ ConvertDialog::~ConvertDialog() {
     delete session;
     delete effectsCollector;
     delete detailsBrowserController;
+    delete scheduler;
 }
 
 /** Connects UI signals to corresponding slots. */
@@ -139,7 +147,21 @@ void ConvertDialog::createConnections() {
             statusWidget, SLOT(onDetailsLoadingStop()));
     connect(this, SIGNAL(convertStart(int)), statusWidget, SLOT(onConvetionStart(int)));
     connect(this, SIGNAL(convertTick(int)), statusWidget, SLOT(onConvetionTick(int)));
-    connect(this, SIGNAL(convertStop()), statusWidget, SLOT(onConvetionStop()));
+    connect(this, SIGNAL(convertExtend(int,int)),
+            statusWidget, SLOT(onConvetionExtend(int,int)));
+    connect(this, SIGNAL(convertStop(int)),
+            statusWidget, SLOT(onConvetionStop(int)));
+    connect(statusWidget, SIGNAL(throttleChanged(bool,int,int,int)),
+            SLOT(setThrottle(bool,int,int,int)));
+
+    // worker threads
+    connect(statusTimer, SIGNAL(timeout()), SLOT(collectStatus()));
+    connect(scheduler, SIGNAL(batchFinished()), SLOT(finishConvertion()),
+            Qt::QueuedConnection);
+    // images added while converting join running batch
+    connect(filesTreeWidget->model(),
+            SIGNAL(rowsInserted(QModelIndex,int,int)),
+            SLOT(queueAddedItems(QModelIndex,int,int)));
 
     // menu actions
     connect(actionExit, SIGNAL(triggered()), SLOT(close()));
@@ -302,29 +324,6 @@ void ConvertDialog::showUpdateResult(QString *result, bool error) {
     }
 }
 
-/** Setups \a numThreads worker threads. */
-void ConvertDialog::setupThreads(int numThreads) {
-    // clearing list of threads
-    while (!convertThreads.isEmpty())
-        delete convertThreads.takeFirst();
-    // setup threads
-    for(int i = 0; i < numThreads; i++) {
-        // creating new thread
-        convertThreads.append(new ConvertThread(this, i));
-        // connecting
-        connect(convertThreads[i],
-                SIGNAL(question(const QString &, int)),
-                SLOT(query(const QString &, int)),
-                Qt::BlockingQueuedConnection);
-        connect(convertThreads[i],
-                SIGNAL(imageStatus(const QStringList &, const QString &, int)),
-                SLOT(setImageStatus(const QStringList &, const QString &, int)),
-                Qt::QueuedConnection);
-        connect(convertThreads[i], SIGNAL(getNextImage(int)),
-                SLOT(giveNextImage(int)), Qt::BlockingQueuedConnection);
-    }
-}
-
 /** Creates lists of write and read supported images including raw images,
   * restore saved settings in last session, setups completers for lines edit
   * and creates connections and actions.
@@ -402,27 +401,27 @@ void ConvertDialog::browseDestination() {
     }
 }
 
-/** Gives next image for worker thread legitimazed \a threadNum thread ID. */
-void ConvertDialog::giveNextImage(int threadNum) {
-
-    QTreeWidgetItem *item = NULL;
-
-    if(convertedImages < numImages) {
-        item = itemsToConvert[convertedImages];
-        convertThreads[threadNum]->convertImage(item->text(NameColumn),
-                                                item->text(ExtColumn),
-                                                item->text(PathColumn));
-        convertedImages++;
-        emit convertTick(convertedImages);
-    }
-    else {
-        convertThreads[threadNum]->setAcceptWork(false);
-        emit convertStop();
-    }
+/** Emits convertStop() signal when all images of the batch are processed.
+  * Enables convertion push buttons disabled until cancelled batch finished.
+  * \sa ConvertScheduler::batchFinished()
+  */
+void ConvertDialog::finishConvertion() {
+    if (scheduler->isBusy())
+        return;
+    statusTimer->stop();
+    collectStatus();
+    statusWidget->setBufferStatistics(scheduler->batchBufferStatistics());
+    emit convertStop(scheduler->settledThreadCount());
+    if (!converting)
+        enableConvertButtons(filesTreeWidget->topLevelItemCount() > 0);
 }
 
-/** Enables convertion push buttons if \a enable is true; otherwise disables it. */
+/** Enables convertion push buttons if \a enable is true; otherwise disables it.
+  * The buttons stay disabled while images of cancelled batch are converting,
+  * finishConvertion() enables them.
+  */
 void ConvertDialog::enableConvertButtons(bool enable) {
+    enable = enable && !scheduler->isBusy();
     convertButton->setEnabled(enable);
     convertSelectedButton->setEnabled(enable);
 }
@@ -459,11 +458,18 @@ void ConvertDialog::convertSelected() {
     convert();
 }
 
-/** Reset answers, setups and starts convertion threads.
-  * \sa resetAnswers() ConvertThread
+/** Reset answers, runs pre-flight check of all images, asks the user about
+  * overwriting and enlarging files in single decision table, setups convertion
+  * threads and starts the batch.
+  * \sa resetAnswers() ConvertPreflight ConvertDecisionDialog ConvertScheduler
   */
 void ConvertDialog::convert()
 {
+    // images converting while previous batch was cancelled; finishConvertion()
+    // enables convert buttons again
+    if (scheduler->isBusy())
+        return;
+    collectStatus();
     resetAnswers();
     bool hasWidth = false;
     bool hasHeight = false;
@@ -503,30 +509,6 @@ void ConvertDialog::convert()
         }
     }
 
-    QTreeWidgetItem * item;
-
-    numImages = itemsToConvert.count();
-    convertedImages = 0;
-    int nt = numThreads;
-
-    emit convertStart(numImages);
-
-    quitButton->setText(tr("Cancel"));
-    converting = true;
-    this->setCursor(Qt::WaitCursor);
-
-    if(numImages < nt) {
-        nt = numImages;
-    }
-
-    //Start the worker threads
-    setupThreads(nt);
-
-    convertProgressBar->setRange(0,itemsToConvert.count());
-    convertProgressBar->setValue(0);
-
-    enableConvertButtons(false);
-
     SharedInformation shared = SharedInformation(*sharedInfo);
 
     if (sizeScrollArea->sizeUnitComboBox->currentIndex() == 2) {
@@ -542,6 +524,12 @@ void ConvertDialog::convert()
         shared.setDesiredSize(w, h, isPercent, hasWidth, hasHeight,
                                    sizeScrollArea->maintainCheckBox->isChecked());
     }
+    shared.setDesiredCrop(sizeScrollArea->cropModeComboBox->currentIndex(),
+                          QRectF(sizeScrollArea->cropXSpinBox->value(),
+                                 sizeScrollArea->cropYSpinBox->value(),
+                                 sizeScrollArea->cropWidthSpinBox->value(),
+                                 sizeScrollArea->cropHeightSpinBox->value()));
+    shared.setResamplingFilter(sizeScrollArea->filterComboBox->currentIndex());
     QString desiredFormat = targetFormatComboBox->currentText().toLower();
     shared.setDesiredFormat(desiredFormat);
     shared.setDesiredFlip(optionsScrollArea->flipComboBox->currentIndex());
@@ -582,16 +570,143 @@ void ConvertDialog::convert()
     ConvertThread::setSharedInfo(shared);
     sharedInfo = ConvertThread::sharedInfo();
 
-    //Gives a image to each thread convert
-    for(int i = 0; i < nt; i++) {
-        convertThreads[i]->setAcceptWork( true );
-        item = itemsToConvert[convertedImages];
-        convertThreads[i]->convertImage(item->text(NameColumn),
-                                        item->text(ExtColumn),
-                                        item->text(PathColumn));
-        convertedImages++;
+    // pre-flight: compute target paths and ask all questions up front
+    preflight = ConvertPreflight(sharedInfo);
+    addedItems.clear();
+    QList<ConvertJob> jobs;
+    if (!prepareJobs(itemsToConvert, 0, &jobs))
+        return;
+
+    numImages = itemsToConvert.count();
+    convertedImages = 0;
+
+    emit convertStart(numImages);
+
+    quitButton->setText(tr("Cancel"));
+    converting = true;
+    this->setCursor(Qt::WaitCursor);
+
+    // the pool is kept between batches, so it's resized only
+    scheduler->setAdaptive(adaptiveThreads);
+    if (!adaptiveThreads)
+        scheduler->setThreadCount(numThreads);
+    scheduler->setReaderCount(readingThreads);
+    scheduler->setWriterCount(writingThreads);
+    scheduler->setAffinityPolicy(
+                static_cast<ConvertAffinity::Policy>(threadAffinity));
+    scheduler->setProcessIsolation(processIsolation);
+    setThrottle(backgroundMode, readLimit, writeLimit, cpuShare);
+    if (memoryLimit > 0)
+        scheduler->setMemoryLimit(qint64(memoryLimit) << 20);
+    else
+        scheduler->setMemoryLimit(MemoryBudget::defaultCapacity());
+
+    convertProgressBar->setRange(0,itemsToConvert.count());
+    convertProgressBar->setValue(0);
+
+    enableConvertButtons(false);
+
+    // enqueue whole batch, most expensive images first; worker threads take
+    // jobs without GUI thread
+    convertingItems = itemsToConvert;
+    convertingJobs = jobs;
+    finishedJobs.fill(false, jobs.count());
+    costModel.sort(&jobs);
+    statusTimer->start();
+    scheduler->start(jobs);
+}
+
+/** Creates jobs of \a items into \a jobs list. Job identifiers start from
+  * \a firstId. Runs pre-flight check of the jobs and asks the user about
+  * overwriting and enlarging files in single decision table.
+  * \return False if the user cancelled the decision table, otherwise true.
+  * \sa ConvertPreflight ConvertDecisionDialog
+  */
+bool ConvertDialog::prepareJobs(const QList<QTreeWidgetItem *> &items,
+                                int firstId, QList<ConvertJob> *jobs) {
+    const QCursor cursor = this->cursor();
+    this->setCursor(Qt::WaitCursor);
+    bool questionsPending = false;
+    for (int i = 0; i < items.count(); i++) {
+        QTreeWidgetItem *item = items[i];
+        ConvertJob job;
+        job.id = firstId + i;
+        job.imageData << item->text(NameColumn) << item->text(ExtColumn)
+                      << item->text(PathColumn);
+        if (preflight.check(&job))
+            questionsPending = true;
+        *jobs << job;
     }
-    emit convertTick(convertedImages);
+    this->setCursor(cursor);
+    if (questionsPending) {
+        ConvertDecisionDialog decisionDialog(jobs, this);
+        if (decisionDialog.exec() != QDialog::Accepted)
+            return false;
+    }
+    return true;
+}
+
+/** Remembers files tree items inserted from \a first to \a last row while
+  * converting. The items are appended to running batch when the files
+  * loading is done.
+  * \sa appendAddedItems()
+  */
+void ConvertDialog::queueAddedItems(const QModelIndex &parent, int first,
+                                    int last) {
+    if (!converting || parent.isValid())
+        return;
+    if (addedItems.isEmpty())
+        QTimer::singleShot(0, this, SLOT(appendAddedItems()));
+    for (int i = first; i <= last; i++)
+        addedItems << filesTreeWidget->topLevelItem(i);
+}
+
+/** Appends images added to files tree while converting to running batch.
+  * The images are converted using settings of the running batch.
+  * \sa queueAddedItems() ConvertScheduler::append()
+  */
+void ConvertDialog::appendAddedItems() {
+    QList<QTreeWidgetItem *> items = addedItems;
+    addedItems.clear();
+    if (!converting || items.isEmpty())
+        return;
+
+    QList<ConvertJob> jobs;
+    if (!prepareJobs(items, convertingItems.count(), &jobs))
+        return;
+    // the batch could finish while the decision table was shown
+    if (!converting)
+        return;
+    convertingItems += items;
+    convertingJobs += jobs;
+    finishedJobs.resize(convertingJobs.count());
+    costModel.sort(&jobs);
+    numImages += scheduler->append(jobs);
+    convertProgressBar->setMaximum(numImages);
+    emit convertExtend(convertedImages, numImages);
+}
+
+/** Enables or disables \a background mode of convertion and sets its
+  * limits: \a readLimit and \a writeLimit in MiB/s (0 means unlimited) and
+  * \a cpuShare in percent of all processors. Limits of running convertion
+  * are changed immediately. The values are remembered in settings.
+  * \sa StatusWidget::throttleChanged()
+  */
+void ConvertDialog::setThrottle(bool background, int readLimit,
+                                int writeLimit, int cpuShare) {
+    backgroundMode = background;
+    this->readLimit = readLimit;
+    this->writeLimit = writeLimit;
+    this->cpuShare = cpuShare;
+    Settings::SettingsGroup &settings = Settings::instance()->settings;
+    settings.backgroundMode = background;
+    settings.readLimit = readLimit;
+    settings.writeLimit = writeLimit;
+    settings.cpuShare = cpuShare;
+
+    scheduler->setReadLimit(background ? qint64(readLimit) << 20 : 0);
+    scheduler->setWriteLimit(background ? qint64(writeLimit) << 20 : 0);
+    scheduler->setCpuShare(background ? cpuShare : 100);
 }
 
 /** Shows selection dialog.
@@ -706,8 +821,21 @@ void ConvertDialog::loadSettings() {
     optionsScrollArea->qualitySpinBox->setValue(quality);
     optionsScrollArea->qualitySlider->setValue(quality);
     numThreads =                                s->settings.cores;
+    adaptiveThreads = (numThreads < 0);
     if (numThreads == 0)
         numThreads = GeneralGroupBoxController::detectCoresCount();
+    else if (adaptiveThreads)
+        numThreads = 0;
+    readingThreads =                            s->settings.readingThreads;
+    writingThreads =                            s->settings.writingThreads;
+    memoryLimit =                               s->settings.memoryLimit;
+    threadAffinity =                            s->settings.threadAffinity;
+    processIsolation =                          s->settings.processIsolation;
+    backgroundMode =                            s->settings.backgroundMode;
+    readLimit =                                 s->settings.readLimit;
+    writeLimit =                                s->settings.writeLimit;
+    cpuShare =                                  s->settings.cpuShare;
+    statusWidget->setThrottle(backgroundMode, readLimit, writeLimit, cpuShare);
     QString selectedTranslationFile =
             QCoreApplication::applicationDirPath() + "/../share/sir/translations/";
     selectedTranslationFile +=                  s->settings.languageFileName;
@@ -745,6 +873,12 @@ void ConvertDialog::loadSettings() {
         sizeScrollArea->heightDoubleSpinBox->setValue(  s->size.heightPx);
     }
     sizeScrollArea->maintainCheckBox->setChecked(       s->size.keepAspectRatio);
+    sizeScrollArea->cropModeComboBox->setCurrentIndex(  s->size.cropMode);
+    sizeScrollArea->cropXSpinBox->setValue(             s->size.cropX);
+    sizeScrollArea->cropYSpinBox->setValue(             s->size.cropY);
+    sizeScrollArea->cropWidthSpinBox->setValue(         s->size.cropWidth);
+    sizeScrollArea->cropHeightSpinBox->setValue(        s->size.cropHeight);
+    sizeScrollArea->filterComboBox->setCurrentIndex(    s->size.resamplingFilter);
 #ifdef SIR_METADATA_SUPPORT
     // metadata
     using namespace MetadataUtils;
@@ -796,94 +930,55 @@ void ConvertDialog::changeEvent(QEvent *e) {
     }
 }
 
-/** Set converting status of image.
-  * \param imageData List of strings containing path, image name and file extension.
-  * \param status Status message.
-  * \param statusNum Status code.
+/** Drains status records of all worker threads and updates files tree,
+  * progress bar and status widget in bulk.
+  * \sa ConvertStatusRing statusTimer
   */
-void ConvertDialog::setImageStatus(const QStringList& imageData,
-                                   const QString& status, int statusNum) {
-    if (statusNum != ConvertThread::Converting) {
-        //We don't want to update the status bar if the statusValue is
-        //CONVERTING
-        convertProgressBar->setValue(convertProgressBar->value()+1);
-    }
-
-    int count = filesTreeWidget->topLevelItemCount();
-    QString fileName;
-
-    for (int i = 0; i < count; i++) {
-        QTreeWidgetItem *item = filesTreeWidget->topLevelItem(i);
-        if(item->text(NameColumn) == imageData.at(0)
-                && item->text(ExtColumn) == imageData.at(1)
-                && item->text(PathColumn) == imageData.at(2)) {
-            item->setText(StatusColumn, status);
-            fileName = item->text(PathColumn) + QDir::separator()
-                     + item->text(NameColumn) + '.' + item->text(ExtColumn);
-            filesTreeWidget->statusList->insert(fileName,statusNum);
-            break;
+void ConvertDialog::collectStatus() {
+    int finished = 0;
+    ConvertStatusRecord record;
+    foreach (ConvertThread *thread, scheduler->threads()) {
+        ConvertStatusRing *ring = thread->statusRing();
+        while (ring->pop(&record)) {
+            const bool known = record.jobId < finishedJobs.size();
+            if (record.status != ConvertThread::Converting) {
+                finished++;
+                if (known)
+                    finishedJobs.setBit(record.jobId);
+            }
+            else if (known && finishedJobs.testBit(record.jobId))
+                continue;
+            if (record.status == ConvertThread::Converted
+                    && record.jobId < convertingJobs.count())
+                costModel.addSample(convertingJobs.at(record.jobId),
+                                    record.elapsed);
+            QTreeWidgetItem *item = convertingItems.value(record.jobId);
+            if (item)
+                setImageStatus(item, record.status, record.message);
         }
     }
-    if (convertProgressBar->value() == convertProgressBar->maximum())
+    if (finished == 0)
+        return;
+
+    convertedImages += finished;
+    convertProgressBar->setValue(convertedImages);
+    emit convertTick(convertedImages);
+    if (converting && convertedImages == numImages)
         updateInterface();
 }
 
-/** Ask for users agreement of typed action on file.
-  * \param targetFile Asking file path.
-  * \param tid Worker thread ID.
-  * \param questionCode Action on target file. Support for \em overwrite and \em enlarge only.
+/** Set converting status of image.
+  * \param item Files tree item of the image.
+  * \param statusNum Status code.
+  * \param message Status message code.
+  * \sa ConvertThread::statusMessage()
   */
-void ConvertDialog::query(const QString& targetFile, int questionCode) {
-    ConvertThread::Question whatToDo = static_cast<ConvertThread::Question>(questionCode);
-    switch (whatToDo) {
-    case ConvertThread::Enlarge:
-        if (sharedInfo->noEnlargeAll)
-            sharedInfo->enlargeResult = QMessageBox::NoToAll;
-        else if (sharedInfo->abort)
-            sharedInfo->enlargeResult = QMessageBox::Cancel;
-        else if (!sharedInfo->enlargeAll) {
-            int result = MessageBox::question(
-                        this,
-                        tr("Enlarge File? - SIR"),
-                        tr("A file called %1 is smaller than the requested size. "
-                           "Enlargement can cause deterioration of picture quality. "
-                           "Do you want enlarge it?").arg(targetFile) );
-            if (result == MessageBox::YesToAll)
-                sharedInfo->enlargeAll = true;
-            else if (result == MessageBox::NoToAll)
-                sharedInfo->noEnlargeAll = true;
-            else if (result == MessageBox::Cancel)
-                sharedInfo->abort = true;
-            sharedInfo->enlargeResult = result;
-        }
-        else
-            sharedInfo->enlargeResult = QMessageBox::YesToAll;
-        break;
-    case ConvertThread::Overwrite:
-        if (sharedInfo->noOverwriteAll)
-            sharedInfo->overwriteResult = QMessageBox::NoToAll;
-        else if(sharedInfo->abort)
-            sharedInfo->overwriteResult = QMessageBox::Cancel;
-        else if(!sharedInfo->overwriteAll) {
-            int result = MessageBox::question(
-                             this,
-                             tr("Overwrite File? -- SIR"),
-                             tr("A file called %1 already exists."
-                                "Do you want to overwrite it?").arg(targetFile) );
-            if (result == QMessageBox::YesToAll)
-                sharedInfo->overwriteAll = true;
-            else if (result == QMessageBox::NoToAll)
-                sharedInfo->noOverwriteAll = true;
-            else if (result == QMessageBox::Cancel)
-                sharedInfo->abort = true;
-            sharedInfo->overwriteResult = result;
-        }
-        else
-            sharedInfo->overwriteResult = QMessageBox::YesToAll;
-        break;
-    default:
-        break;
-    }
+void ConvertDialog::setImageStatus(QTreeWidgetItem *item, int statusNum,
+                                   int message) {
+    item->setText(StatusColumn, ConvertThread::statusMessage(message));
+    QString fileName = item->text(PathColumn) + QDir::separator()
+            + item->text(NameColumn) + '.' + item->text(ExtColumn);
+    filesTreeWidget->statusList->insert(fileName, statusNum);
 }
 
 /** Retranslates GUI. */
@@ -936,17 +1031,17 @@ void ConvertDialog::closeOrCancel() {
         close();
 }
 
-/** Terminates all worker threads. */
+/** Cancels convertion. Worker threads stop converting images at the next
+  * checkpoint and remove partial files; the pool is kept for next batch.
+  */
 void ConvertDialog::stopConvertThreads() {
-    for (int i=0; i<convertThreads.length(); i++)
-        convertThreads[i]->terminate();
+    scheduler->cancel();
 }
 
 /** Updates user interface after convering. */
 void ConvertDialog::updateInterface() {
     converting = false;
-    convertSelectedButton->setEnabled(true);
-    convertButton->setEnabled(true);
+    enableConvertButtons();
     filesTreeWidget->resizeColumnsToContents();
     setCursor(Qt::ArrowCursor);
     quitButton->setText(tr("Quit"));
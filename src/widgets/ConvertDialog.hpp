@@ -22,15 +22,21 @@
 #ifndef CONVERTDIALOG_HPP
 #define CONVERTDIALOG_HPP
 
+#include <QBitArray>
+
 #include "ui_ConvertDialog.h"
+#include "ConvertCostModel.hpp"
+#include "ConvertPreflight.hpp"
 #include "ConvertThread.hpp"
 #include "Settings.hpp"
 
 class NetworkUtils;
+class ConvertScheduler;
 class ConvertSharedData;
 class Session;
 class CommandLineAssistant;
 class EffectsCollector;
+class QTimer;
 
 //! Main window class provides images convertion dialog.
 class ConvertDialog : public QMainWindow, public Ui::ConvertDialog {
@@ -52,13 +58,55 @@ public:
 
 private:
     SharedInformation *sharedInfo;
-    QList<ConvertThread*> convertThreads;
+    ConvertScheduler *scheduler;
     QStringList args;
     QString targetFile;
-    quint8 numThreads;
+    /** Count of convertion threads or 0 if adaptiveThreads is true. */
+    int numThreads;
+    /** Adapt threads count while converting.
+      * \sa ConvertScheduler::setAdaptive()
+      */
+    bool adaptiveThreads;
+    int readingThreads; /**< Count of threads prefetching source files. */
+    int writingThreads; /**< Count of threads writing target files. */
+    /** Memory limit of decoded images in MiB or 0 for automatic limit. */
+    int memoryLimit;
+    /** CPU affinity policy of convertion threads.
+      * \sa ConvertAffinity::Policy
+      */
+    int threadAffinity;
+    bool processIsolation; /**< Convert images in worker processes. */
+    /** Background mode indicator. \sa setThrottle() */
+    bool backgroundMode;
+    int readLimit; /**< Read limit of background mode in MiB/s. */
+    int writeLimit; /**< Write limit of background mode in MiB/s. */
+    int cpuShare; /**< CPU share of background mode in percent. */
     int convertedImages;
     int numImages;
     QList<QTreeWidgetItem *> itemsToConvert;
+    /** Items of running batch indexed by ConvertJob::id.
+      * \sa collectStatus()
+      */
+    QList<QTreeWidgetItem *> convertingItems;
+    QList<ConvertJob> convertingJobs; /**< Jobs of running batch by ConvertJob::id. */
+    /** Bits set for jobs with final status. Pipeline stages report statuses
+      * into separate rings, so late \em Converting status is ignored.
+      * \sa collectStatus()
+      */
+    QBitArray finishedJobs;
+    /** Orders jobs and learns convertion time from finished jobs.
+      * \sa collectStatus()
+      */
+    ConvertCostModel costModel;
+    /** Checks jobs of running batch, including images added while
+      * converting.
+      */
+    ConvertPreflight preflight;
+    /** Items added to files tree while converting, waiting for preflight.
+      * \sa queueAddedItems() appendAddedItems()
+      */
+    QList<QTreeWidgetItem *> addedItems;
+    QTimer *statusTimer; /**< Triggers collectStatus() while converting. */
     bool converting;
     bool rawEnabled;
     bool alreadySent;
@@ -80,7 +128,10 @@ private:
     inline void writeWindowProperties();
     inline void resetAnswers();
     void convert();
+    bool prepareJobs(const QList<QTreeWidgetItem *> &items, int firstId,
+                     QList<ConvertJob> *jobs);
     inline void clearTempDir();
+    void setImageStatus(QTreeWidgetItem *item, int statusNum, int message);
 
 protected:
     virtual void changeEvent(QEvent *e);
@@ -93,10 +144,12 @@ public slots:
     void about();
     void setOptions();
     void loadSettings();
-    void setImageStatus(const QStringList& imageData, const QString& status, int statusNum);
-    void query(const QString& targetFile, int questionCode);
-    void giveNextImage(int tid);
-    void setupThreads(int numThreads);
+    void collectStatus();
+    void finishConvertion();
+    void queueAddedItems(const QModelIndex &parent, int first, int last);
+    void appendAddedItems();
+    void setThrottle(bool background, int readLimit, int writeLimit,
+                     int cpuShare);
     void closeOrCancel();
     void updateInterface();
     void setCanceled();
@@ -114,7 +167,8 @@ public slots:
 signals:
     void convertStart(int totalQuantity);
     void convertTick(int partQuantity);
-    void convertStop();
+    void convertExtend(int partQuantity, int totalQuantity);
+    void convertStop(int threadCount);
 };
 
 /** Saves window maximized status, possition on screen and size and last
@@ -138,15 +192,14 @@ void ConvertDialog::writeWindowProperties() {
     s->mainWindow.verticalSplitter   = verticalSplitter->saveState();
 }
 
-/** Resets user ansers about overwrite file, enlarge image and abort convertion
-  * variables. This function is useful when convertion is starting for reset
-  * user-anser data after last convertion.
+/** Resets user ansers about overwrite file and enlarge image variables.
+  * This function is useful when convertion is starting for reset user-anser
+  * data after last convertion.
   */
 void ConvertDialog::resetAnswers() {
     sharedInfo->overwriteResult = 1;
     sharedInfo->overwriteAll = false;
     sharedInfo->noOverwriteAll = false;
-    sharedInfo->abort = false;
     sharedInfo->enlargeResult = 1;
     sharedInfo->enlargeAll = false;
     sharedInfo->noEnlargeAll = false;
@@ -82,6 +82,21 @@ void DetailsBrowserController::addItem(QTreeWidgetItem *item, int index) {
     htmlContent += convertDialog->fileSizeString(thumb.sourceFileSize())
             + RichTextVisitor::htmlBr;
 
+    const ImageStatistics statistics = thumb.statistics();
+    if (!statistics.isNull()) {
+        const QColor minimum = statistics.minimum();
+        const QColor maximum = statistics.maximum();
+        if (thumb.isStatisticsApproximate())
+            htmlContent += tr("Approximate color range: ");
+        else
+            htmlContent += tr("Color range: ");
+        htmlContent += QString("R %1-%2, G %3-%4, B %5-%6")
+                .arg(minimum.red()).arg(maximum.red())
+                .arg(minimum.green()).arg(maximum.green())
+                .arg(minimum.blue()).arg(maximum.blue())
+                + RichTextVisitor::htmlBr;
+    }
+
 #ifdef SIR_METADATA_SUPPORT
     if (thumb.isReadFromMetadataThumbnail())
         htmlContent += addMetadataToContent(thumb.exifStruct(),
@@ -29,8 +29,21 @@ StatusWidget::StatusWidget(QWidget *parent) : QWidget(parent) {
     totalLabel->setText("");
 
     statusWidgetState = StatusReady;
+    convertionTotalQuantity = 0;
+    convertionElapsedSeconds = 0;
+    convertionThreadCount = 0;
 
     retranslateStrings();
+    enableThrottleLimits(backgroundCheckBox->isChecked());
+
+    connect(backgroundCheckBox, SIGNAL(toggled(bool)),
+            this, SLOT(onThrottleEdited()));
+    connect(readLimitSpinBox, SIGNAL(valueChanged(int)),
+            this, SLOT(onThrottleEdited()));
+    connect(writeLimitSpinBox, SIGNAL(valueChanged(int)),
+            this, SLOT(onThrottleEdited()));
+    connect(cpuShareSpinBox, SIGNAL(valueChanged(int)),
+            this, SLOT(onThrottleEdited()));
 
     tickTimer.start();
 }
@@ -56,6 +69,37 @@ void StatusWidget::setStatus(StatusWidgetState status, int partQuantity,
     }
 }
 
+/** Shows background mode state and its limits without emitting
+  * throttleChanged() signal.
+  * \sa throttleChanged()
+  */
+void StatusWidget::setThrottle(bool background, int readLimit,
+                               int writeLimit, int cpuShare) {
+    blockSignals(true);
+    backgroundCheckBox->setChecked(background);
+    readLimitSpinBox->setValue(readLimit);
+    writeLimitSpinBox->setValue(writeLimit);
+    cpuShareSpinBox->setValue(cpuShare);
+    enableThrottleLimits(background);
+    blockSignals(false);
+}
+
+/** Emits throttleChanged() signal after the user changed background mode
+  * or its limits. It's possible while converting.
+  */
+void StatusWidget::onThrottleEdited() {
+    bool background = backgroundCheckBox->isChecked();
+    enableThrottleLimits(background);
+    emit throttleChanged(background, readLimitSpinBox->value(),
+                         writeLimitSpinBox->value(), cpuShareSpinBox->value());
+}
+
+void StatusWidget::enableThrottleLimits(bool enabled) {
+    readLimitSpinBox->setEnabled(enabled);
+    writeLimitSpinBox->setEnabled(enabled);
+    cpuShareSpinBox->setEnabled(enabled);
+}
+
 void StatusWidget::onFilesLoadingStart(int totalQuantity) {
     setStatus(StatusFilesLoading, 0, totalQuantity);
     QCoreApplication::processEvents();
@@ -91,8 +135,6 @@ void StatusWidget::onDetailsLoadingStop()
 void StatusWidget::onConvetionStart(int totalQuantity) {
     setStatus(StatusConvertionProgress, 0, totalQuantity);
 
-    QCoreApplication::processEvents();
-
     convertionTotalQuantity = totalQuantity;
 
     convertionTimer.start();
@@ -107,14 +149,39 @@ void StatusWidget::onConvetionTick(int partQuantity) {
     }
 }
 
-void StatusWidget::onConvetionStop() {
+/** Updates \a totalQuantity of running convertion extended with new images
+  * and shows its progress again.
+  */
+void StatusWidget::onConvetionExtend(int partQuantity, int totalQuantity) {
+    convertionTotalQuantity = totalQuantity;
+
+    setStatus(StatusConvertionProgress, partQuantity, totalQuantity);
+}
+
+/** Shows convertion summary. If \a threadCount is positive the summary
+  * contains count of threads used for convertion.
+  */
+void StatusWidget::onConvetionStop(int threadCount) {
     qint64 elapsedMiliseconds = convertionTimer.elapsed();
     convertionElapsedSeconds = elapsedMiliseconds / 1000 + 1;
+    convertionThreadCount = threadCount;
 
     setStatus(StatusConvertionSummary);
 }
 
+/** Sets pixel buffer counters of finished convertion shown in tool tip of
+  * convertion summary, so reuse of the buffers can be confirmed.
+  * \sa ConvertScheduler::batchBufferStatistics()
+  */
+void StatusWidget::setBufferStatistics(
+        const PixelBufferPool::Statistics &statistics) {
+    bufferStatistics = statistics;
+    if (statusWidgetState == StatusConvertionSummary)
+        setTextMessageLabel(statusWidgetState);
+}
+
 void StatusWidget::setTextMessageLabel(StatusWidgetState statusWidgetState) {
+    messageLabel->setToolTip(QString());
     switch (statusWidgetState) {
     case StatusReady:
         messageLabel->setText(tr("Ready"));
@@ -129,10 +196,24 @@ void StatusWidget::setTextMessageLabel(StatusWidgetState statusWidgetState) {
         messageLabel->setText(tr("Converting images..."));
         break;
     case StatusConvertionSummary:
-        QString summaryMessage = tr("%1 images converted in %2 seconds")
-                .arg(convertionTotalQuantity)
-                .arg(convertionElapsedSeconds);
+        QString summaryMessage;
+        if (convertionThreadCount > 0)
+            summaryMessage = tr("%1 images converted in %2 seconds "
+                                "using %3 threads")
+                    .arg(convertionTotalQuantity)
+                    .arg(convertionElapsedSeconds)
+                    .arg(convertionThreadCount);
+        else
+            summaryMessage = tr("%1 images converted in %2 seconds")
+                    .arg(convertionTotalQuantity)
+                    .arg(convertionElapsedSeconds);
         messageLabel->setText(summaryMessage);
+        messageLabel->setToolTip(
+                    tr("Pixel buffers: %1 allocated, %2 reused\n"
+                       "Page faults: %3")
+                    .arg(bufferStatistics.allocations)
+                    .arg(bufferStatistics.reuses)
+                    .arg(bufferStatistics.pageFaults));
         break;
     }
     messageLabel->update();
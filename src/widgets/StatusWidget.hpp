@@ -23,6 +23,7 @@
 #define STATUSWIDGET_HPP
 
 #include "ui_StatusWidget.h"
+#include "PixelBufferPool.hpp"
 
 #include <QElapsedTimer>
 
@@ -45,7 +46,19 @@ public:
     void retranslateStrings();
 
     void setStatus(StatusWidgetState status, int partQuantity = 0, int totalQuantity = 0);
-
+    void setThrottle(bool background, int readLimit, int writeLimit,
+                     int cpuShare);
+    void setBufferStatistics(const PixelBufferPool::Statistics &statistics);
+
+signals:
+    /** Emitted when the user changes background mode or its limits.
+      * \param background Background mode indicator.
+      * \param readLimit Read limit in MiB/s or 0 if it's unlimited.
+      * \param writeLimit Write limit in MiB/s or 0 if it's unlimited.
+      * \param cpuShare CPU share limit in percent of all processors.
+      */
+    void throttleChanged(bool background, int readLimit, int writeLimit,
+                         int cpuShare);
 
 public slots:
     void onFilesLoadingStart(int totalQuantity);
@@ -57,8 +70,11 @@ public slots:
 
     void onConvetionStart(int totalQuantity);
     void onConvetionTick(int partQuantity);
-    void onConvetionStop();
+    void onConvetionExtend(int partQuantity, int totalQuantity);
+    void onConvetionStop(int threadCount = 0);
 
+private slots:
+    void onThrottleEdited();
 
 private:
     StatusWidgetState statusWidgetState;
@@ -68,9 +84,13 @@ private:
 
     int convertionTotalQuantity;
     qint64 convertionElapsedSeconds;
+    int convertionThreadCount;
+    /** Pixel buffer counters of the last convertion. */
+    PixelBufferPool::Statistics bufferStatistics;
 
     void setTextMessageLabel(StatusWidgetState statusWidgetState);
     void setTextOfLabel(StatusWidgetState statusWidgetState);
+    void enableThrottleLimits(bool enabled);
 };
 
 #endif // STATUSWIDGET_HPP
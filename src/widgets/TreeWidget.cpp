@@ -277,6 +277,8 @@ void TreeWidget::removeAll() {
     // clear list
     if (topLevelItemCount() > 0)
         this->clear();
+    // items are deleted, so statuses of running convertion are ignored
+    convertDialog->convertingItems.clear();
     // update convert widgets
     convertDialog->enableConvertButtons(false);
     convertDialog->convertProgressBar->reset();
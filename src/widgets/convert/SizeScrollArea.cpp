@@ -31,6 +31,9 @@ SizeScrollArea::SizeScrollArea(QWidget *parent) : QScrollArea(parent) {
             this, SLOT(setSizeUnit(int)));
     connect(maintainCheckBox, SIGNAL(toggled(bool)),
             this, SLOT(maintainCheckBoxChecked(bool)));
+    connect(cropModeComboBox, SIGNAL(currentIndexChanged(int)),
+            this, SLOT(setCropMode(int)));
+    setCropMode(cropModeComboBox->currentIndex());
 
     if (maintainCheckBox->isChecked()) {
         switch (sizeUnitComboBox->currentIndex()) {
@@ -46,6 +49,7 @@ SizeScrollArea::SizeScrollArea(QWidget *parent) : QScrollArea(parent) {
 
 void SizeScrollArea::retranslateStrings() {
     retranslateUi(this);
+    setCropMode(cropModeComboBox->currentIndex());
 }
 
 /** Shows size values corresponding index of size unit combo box. */
@@ -114,6 +118,54 @@ void SizeScrollArea::setSizeUnit(int index) {
     lastIndex = index;
 }
 
+/** Shows crop region values corresponding index of crop mode combo box.
+  * \sa SharedInformation::setDesiredCrop()
+  */
+void SizeScrollArea::setCropMode(int index) {
+    if (index < 0)
+        return;
+    const bool hasOffset = (index == 1 || index == 2);
+    cropXLabel->setVisible(hasOffset);
+    cropXSpinBox->setVisible(hasOffset);
+    cropYLabel->setVisible(hasOffset);
+    cropYSpinBox->setVisible(hasOffset);
+    cropWidthSpinBox->setEnabled(index > 0);
+    cropHeightSpinBox->setEnabled(index > 0);
+
+    QString suffix;
+    int decimals;
+    double max;
+    QString edgeText = tr("to edge");
+    switch (index) {
+    case 2: // %
+        suffix = " %";
+        decimals = 2;
+        max = 100.;
+        break;
+    case 3: // aspect ratio
+        decimals = 2;
+        max = 1000.;
+        edgeText.clear();
+        break;
+    default: // px
+        suffix = " px";
+        decimals = 0;
+        max = 100000.;
+        break;
+    }
+    QList<QDoubleSpinBox*> spinBoxes;
+    spinBoxes << cropXSpinBox << cropYSpinBox
+              << cropWidthSpinBox << cropHeightSpinBox;
+    foreach (QDoubleSpinBox *spinBox, spinBoxes) {
+        spinBox->setSuffix(suffix);
+        spinBox->setDecimals(decimals);
+        spinBox->setMaximum(max);
+    }
+    // zero width or height of the region reaches the image edge
+    cropWidthSpinBox->setSpecialValueText(edgeText);
+    cropHeightSpinBox->setSpecialValueText(edgeText);
+}
+
 /** If it keeps aspect ratio, this function will be change width or heigth value
   * following the user change in adjacent spin box. Otherwise does nothing.
   * \sa maintainCheckBoxChecked()
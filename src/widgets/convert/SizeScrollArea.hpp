@@ -41,6 +41,7 @@ private:
 
 public slots:
     void setSizeUnit(int index);
+    void setCropMode(int index);
 
 private slots:
     void sizeChanged(double value);
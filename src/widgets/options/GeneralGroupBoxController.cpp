@@ -25,7 +25,7 @@
 #include "widgets/options/GeneralGroupBoxView.hpp"
 #include "widgets/options/CommonOptions.hpp"
 
-quint8 GeneralGroupBoxController::maxCoresCount_ = 50;
+int GeneralGroupBoxController::maxCoresCount_ = 1024;
 
 GeneralGroupBoxController::GeneralGroupBoxController(
         Settings::SettingsGroup *settingsModel, Settings::SizeGroup *sizeModel,
@@ -47,25 +47,25 @@ void GeneralGroupBoxController::saveSettings() {
     saveSizeSettings();
 }
 
-/** Returns CPU cores count. */
-quint8 GeneralGroupBoxController::detectCoresCount() {
+/** Returns logical CPU cores count. */
+int GeneralGroupBoxController::detectCoresCount() {
     int cores = QThread::idealThreadCount();
     if (cores == -1) {
         qWarning("GeneralGroupBoxView: cores count detect failed");
         return 1;
     }
-    return qMin((quint8)cores, maxCoresCount_);
+    return qMin(cores, maxCoresCount_);
 }
 
-quint8 GeneralGroupBoxController::maxCoresCount() {
+int GeneralGroupBoxController::maxCoresCount() {
     return GeneralGroupBoxController::maxCoresCount_;
 }
 
-quint8 GeneralGroupBoxController::coresCount() {
+int GeneralGroupBoxController::coresCount() {
     return coresCount_;
 }
 
-void GeneralGroupBoxController::setCoresCount(quint8 cores) {
+void GeneralGroupBoxController::setCoresCount(int cores) {
     coresCount_ = cores;
 }
 
@@ -84,8 +84,10 @@ void GeneralGroupBoxController::loadSettingsSettings() {
                 view->languagesComboBox->findText(modelSettings->languageNiceName,
                                             Qt::MatchExactly));
 
+    // 0 means detect cores count, -1 means adapt threads count while converting
     coresCount_ = modelSettings->cores;
-    if (coresCount_ == 0) {
+    view->coresAdaptiveCheckBox->setChecked(coresCount_ < 0);
+    if (coresCount_ <= 0) {
         view->coresCheckBox->setChecked(true);
         view->coresSpinBoxChecked(true);
     }
@@ -94,6 +96,14 @@ void GeneralGroupBoxController::loadSettingsSettings() {
         view->coresSpinBoxChecked(false);
     }
 
+    view->readingThreadsSpinBox->setValue(modelSettings->readingThreads);
+    view->writingThreadsSpinBox->setValue(modelSettings->writingThreads);
+    view->memoryLimitSpinBox->setValue(modelSettings->memoryLimit);
+    view->threadAffinityComboBox->setCurrentIndex(
+                modelSettings->threadAffinity);
+    view->processIsolationCheckBox->setChecked(
+                modelSettings->processIsolation);
+
     view->dateDisplayFormatLineEdit->setText(modelSettings->dateDisplayFormat);
     view->timeDisplayFormatLineEdit->setText(modelSettings->timeDisplayFormat);
 
@@ -134,11 +144,21 @@ void GeneralGroupBoxController::saveSettingsSettings() {
     modelSettings->dateDisplayFormat    = view->dateDisplayFormatLineEdit->text();
     modelSettings->timeDisplayFormat    = view->timeDisplayFormatLineEdit->text();
 
-    if (view->coresCheckBox->isChecked())
+    if (view->coresAdaptiveCheckBox->isChecked())
+        modelSettings->cores            = -1;
+    else if (view->coresCheckBox->isChecked())
         modelSettings->cores            = 0;
     else
         modelSettings->cores            = view->coresSpinBox->value();
 
+    modelSettings->readingThreads       = view->readingThreadsSpinBox->value();
+    modelSettings->writingThreads       = view->writingThreadsSpinBox->value();
+    modelSettings->memoryLimit          = view->memoryLimitSpinBox->value();
+    modelSettings->threadAffinity       =
+            view->threadAffinityComboBox->currentIndex();
+    modelSettings->processIsolation     =
+            view->processIsolationCheckBox->isChecked();
+
     modelSettings->maxHistoryCount      = view->historySpinBox->value();
 }
 
@@ -38,10 +38,10 @@ public:
     void loadSettings();
     void saveSettings();
 
-    static quint8 detectCoresCount();
-    static quint8 maxCoresCount();
-    quint8 coresCount();
-    void setCoresCount(quint8 cores);
+    static int detectCoresCount();
+    static int maxCoresCount();
+    int coresCount();
+    void setCoresCount(int cores);
 
 private:
     Settings::SettingsGroup *modelSettings;
@@ -51,11 +51,11 @@ private:
     /** Count of threads created for convertion. It's mean count of images
       * converted at the same moment.
       */
-    quint8 coresCount_;
+    int coresCount_;
     /** Maximum count of threads created for convertion.
       * \sa coresCount
       */
-    static quint8 maxCoresCount_;
+    static int maxCoresCount_;
 
     void loadSettingsSettings();
     void loadSizeSettings();
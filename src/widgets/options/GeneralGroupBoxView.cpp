@@ -66,6 +66,8 @@ GeneralGroupBoxView::GeneralGroupBoxView(QWidget *parent) : AbstractOptionsGroup
             this, SLOT(browseDestination()));
     connect(coresCheckBox, SIGNAL(toggled(bool)),
             this, SLOT(coresSpinBoxChecked(bool)));
+    connect(coresAdaptiveCheckBox, SIGNAL(toggled(bool)),
+            this, SLOT(coresAdaptiveCheckBoxChecked(bool)));
 
     delete dir;
     delete completer;
@@ -123,6 +125,16 @@ void GeneralGroupBoxView::coresSpinBoxChecked(bool checked) {
     }
 }
 
+/** Checks and disables coresCheckBox if \a checked is true, because adaptive
+  * threads count starts from detected cores count.
+  * Otherwise enables coresCheckBox.
+  */
+void GeneralGroupBoxView::coresAdaptiveCheckBoxChecked(bool checked) {
+    if (checked)
+        coresCheckBox->setChecked(true);
+    coresCheckBox->setEnabled(!checked);
+}
+
 /** Sets up language combo box. */
 void GeneralGroupBoxView::createLanguageMenu() {
     foreach (QString qmFile, languages->fileNames()) {
@@ -48,6 +48,7 @@ public:
 public slots:
     void browseDestination();
     void coresSpinBoxChecked(bool checked);
+    void coresAdaptiveCheckBoxChecked(bool checked);
 
 private:
     GeneralGroupBoxController *controller;
@@ -0,0 +1,100 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/BoundedQueueTest.hpp"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+
+class ProducerThread : public QThread {
+public:
+    ProducerThread(BoundedQueue<int> *queue, int count)
+        : queue(queue), count(count) {}
+
+protected:
+    void run() {
+        for (int i=0; i<count; i++)
+            queue->push(i);
+    }
+
+private:
+    BoundedQueue<int> *queue;
+    int count;
+};
+
+void BoundedQueueTest::push_tryPop() {
+    BoundedQueue<int> queue(4);
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.capacity(), 4);
+
+    int item = -1;
+    QVERIFY(!queue.tryPop(&item));
+
+    for (int i=0; i<4; i++)
+        queue.push(i);
+    QCOMPARE(queue.count(), 4);
+
+    for (int i=0; i<4; i++) {
+        QVERIFY(queue.tryPop(&item));
+        QCOMPARE(item, i);
+    }
+    QVERIFY(queue.isEmpty());
+}
+
+void BoundedQueueTest::clear() {
+    BoundedQueue<int> queue(4);
+    queue.push(1);
+    queue.push(2);
+    QCOMPARE(queue.clear(), 2);
+    QVERIFY(queue.isEmpty());
+}
+
+void BoundedQueueTest::waitForItems_timeout() {
+    BoundedQueue<int> queue;
+    QVERIFY(!queue.waitForItems(10));
+    queue.push(1);
+    QVERIFY(queue.waitForItems(10));
+}
+
+void BoundedQueueTest::push_blocksWhileFull() {
+    BoundedQueue<int> queue(2);
+    const int count = 100;
+    ProducerThread producer(&queue, count);
+    producer.start();
+
+    // the producer can't run ahead of the consumer more than capacity
+    QVERIFY(!producer.wait(50));
+    QVERIFY(queue.count() <= 2);
+
+    int item = -1;
+    for (int i=0; i<count; i++) {
+        QVERIFY(queue.waitForItems(5000));
+        QVERIFY(queue.tryPop(&item));
+        QCOMPARE(item, i);
+        QVERIFY(queue.count() <= 2);
+    }
+    QVERIFY(producer.wait(5000));
+    QVERIFY(queue.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(BoundedQueueTest)
+#include "BoundedQueueTest.moc"
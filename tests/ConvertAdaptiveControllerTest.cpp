@@ -0,0 +1,84 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertAdaptiveControllerTest.hpp"
+
+
+/** Returns synthetic throughput of \a threadCount threads with the highest
+  * value for \a peakCount threads.
+  */
+double ConvertAdaptiveControllerTest::throughput(int threadCount,
+                                                 int peakCount) {
+    const int distance = threadCount - peakCount;
+    return qMax(1., 100. - 10. * distance * distance);
+}
+
+void ConvertAdaptiveControllerTest::start_bounds() {
+    ConvertAdaptiveController controller;
+    controller.start(8, 4);
+    QCOMPARE(controller.threadCount(), 4);
+    controller.start(0, 4);
+    QCOMPARE(controller.threadCount(), 1);
+    QCOMPARE(controller.isSettled(), false);
+}
+
+void ConvertAdaptiveControllerTest::update_findsPeak() {
+    ConvertAdaptiveController controller;
+    controller.start(4, 16);
+    for (int i=0; i<20; i++)
+        controller.update(throughput(controller.threadCount(), 6));
+
+    QCOMPARE(controller.isSettled(), true);
+    QCOMPARE(controller.settledCount(), 6);
+    QVERIFY(qAbs(controller.threadCount() - 6) <= 1);
+}
+
+void ConvertAdaptiveControllerTest::update_lowCpuUsage() {
+    ConvertAdaptiveController controller;
+    controller.start(4, 16);
+    controller.update(100., 0.85);
+    // first probe goes up; going down is forced by failed probe only
+    QCOMPARE(controller.threadCount(), 5);
+    controller.update(50., 0.3);
+    QCOMPARE(controller.threadCount(), 4);
+    // I/O bound workers: probe more threads again
+    controller.update(100., 0.3);
+    QCOMPARE(controller.threadCount(), 5);
+}
+
+void ConvertAdaptiveControllerTest::update_maximum() {
+    ConvertAdaptiveController controller;
+    controller.start(1, 3);
+    for (int i=0; i<10; i++) {
+        controller.update(100. * controller.threadCount());
+        QVERIFY(controller.threadCount() <= 3);
+    }
+    QCOMPARE(controller.settledCount(), 3);
+}
+
+void ConvertAdaptiveControllerTest::physicalCoreCount() {
+    const int cores = ConvertAdaptiveController::physicalCoreCount();
+    QVERIFY(cores >= 1);
+    QVERIFY(cores <= ConvertAdaptiveController::logicalCpuCount());
+}
+
+QTEST_APPLESS_MAIN(ConvertAdaptiveControllerTest)
+#include "ConvertAdaptiveControllerTest.moc"
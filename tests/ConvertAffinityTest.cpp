@@ -0,0 +1,132 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertAffinityTest.hpp"
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif // Q_OS_LINUX
+
+
+/** Returns 2 packages by 2 cores by 2 hardware threads topology numbered
+  * like by Linux kernel; each package is a NUMA node.
+  */
+QList<ConvertAffinity::Cpu> ConvertAffinityTest::twoPackages() const {
+    QList<ConvertAffinity::Cpu> cpus;
+    for (int id=0; id<8; id++) {
+        int package = (id / 2) % 2;
+        cpus << ConvertAffinity::Cpu(id, package, id % 2, package);
+    }
+    return cpus;
+}
+
+QList<int> ConvertAffinityTest::ids(
+        const QList<ConvertAffinity::Cpu> &cpus) const {
+    QList<int> result;
+    foreach (const ConvertAffinity::Cpu &cpu, cpus)
+        result << cpu.id;
+    return result;
+}
+
+void ConvertAffinityTest::order_noAffinity() {
+    QVERIFY(ConvertAffinity::order(ConvertAffinity::NoAffinity,
+                                   twoPackages()).isEmpty());
+}
+
+void ConvertAffinityTest::order_compact() {
+    QList<int> expected;
+    expected << 0 << 4 << 1 << 5 << 2 << 6 << 3 << 7;
+    QCOMPARE(ids(ConvertAffinity::order(ConvertAffinity::Compact,
+                                        twoPackages())), expected);
+}
+
+void ConvertAffinityTest::order_spread() {
+    QList<int> expected;
+    expected << 0 << 2 << 1 << 3 << 4 << 6 << 5 << 7;
+    QCOMPARE(ids(ConvertAffinity::order(ConvertAffinity::Spread,
+                                        twoPackages())), expected);
+}
+
+void ConvertAffinityTest::cpuForThread() {
+    ConvertAffinity affinity;
+    affinity.setPolicy(ConvertAffinity::Spread, twoPackages());
+    QCOMPARE(affinity.policy(), ConvertAffinity::Spread);
+    QCOMPARE(affinity.cpuCount(), 8);
+    QCOMPARE(affinity.cpuForThread(0), 0);
+    QCOMPARE(affinity.nodeForThread(0), 0);
+    QCOMPARE(affinity.cpuForThread(1), 2);
+    QCOMPARE(affinity.nodeForThread(1), 1);
+    // wrap around
+    QCOMPARE(affinity.cpuForThread(9), 2);
+    QCOMPARE(affinity.nodeForThread(9), 1);
+}
+
+void ConvertAffinityTest::cpuForThread_notPinned() {
+    ConvertAffinity affinity;
+    QCOMPARE(affinity.policy(), ConvertAffinity::NoAffinity);
+    QCOMPARE(affinity.cpuForThread(0), -1);
+    QCOMPARE(affinity.nodeForThread(0), -1);
+    affinity.setPolicy(ConvertAffinity::Compact, twoPackages());
+    QCOMPARE(affinity.cpuForThread(-1), -1);
+}
+
+void ConvertAffinityTest::setPolicy_emptyTopology() {
+    ConvertAffinity affinity;
+    affinity.setPolicy(ConvertAffinity::Compact,
+                       QList<ConvertAffinity::Cpu>());
+    QCOMPARE(affinity.policy(), ConvertAffinity::NoAffinity);
+    QCOMPARE(affinity.cpuCount(), 0);
+}
+
+void ConvertAffinityTest::topology_allowedCpus() {
+    const QList<int> allowed = ConvertAffinity::allowedCpus();
+    if (allowed.isEmpty())
+        QSKIP("process affinity mask is unknown");
+    foreach (const ConvertAffinity::Cpu &cpu, ConvertAffinity::topology())
+        QVERIFY(allowed.contains(cpu.id));
+}
+
+void ConvertAffinityTest::pinCurrentThread_notAllowed() {
+    const QList<int> allowed = ConvertAffinity::allowedCpus();
+    if (allowed.isEmpty())
+        QSKIP("process affinity mask is unknown");
+    QVERIFY(!ConvertAffinity::pinCurrentThread(allowed.last() + 1));
+}
+
+void ConvertAffinityTest::pinCurrentThread_unpin() {
+    const QList<int> allowed = ConvertAffinity::allowedCpus();
+    if (allowed.isEmpty())
+        QSKIP("process affinity mask is unknown");
+    QVERIFY(ConvertAffinity::pinCurrentThread(allowed.first()));
+    QVERIFY(ConvertAffinity::pinCurrentThread(-1));
+#ifdef Q_OS_LINUX
+    // unpinned thread gets the startup mask, not all online CPUs
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    QCOMPARE(sched_getaffinity(0, sizeof(set), &set), 0);
+    QCOMPARE(CPU_COUNT(&set), allowed.count());
+    foreach (int id, allowed)
+        QVERIFY(CPU_ISSET(id, &set));
+#endif // Q_OS_LINUX
+}
+
+QTEST_APPLESS_MAIN(ConvertAffinityTest)
+#include "ConvertAffinityTest.moc"
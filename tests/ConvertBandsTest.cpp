@@ -0,0 +1,171 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertBandsTest.hpp"
+
+#include "ConvertEffects.hpp"
+#include "ConvertScheduler.hpp"
+#include "SharedInformation.hpp"
+#include "tests/TestHelpers.hpp"
+
+
+/** Counts visits of each row. */
+class CountingTask : public ConvertBandTask {
+public:
+    explicit CountingTask(int count) : hits(count) {}
+
+    void run(int begin, int end) {
+        for (int i=begin; i<end; i++)
+            hits[i].ref();
+    }
+
+    QVector<QAtomicInt> hits;
+};
+
+void ConvertBandsTest::bandRange_data() {
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("bands");
+
+    QTest::newRow("even") << 1000 << 4;
+    QTest::newRow("odd") << 1001 << 3;
+    QTest::newRow("band per row") << 7 << 7;
+}
+
+void ConvertBandsTest::bandRange() {
+    QFETCH(int, count);
+    QFETCH(int, bands);
+
+    int previousEnd = 0;
+    for (int i=0; i<bands; i++) {
+        int begin;
+        int end;
+        ConvertBands::bandRange(count, bands, i, &begin, &end);
+        QCOMPARE(begin, previousEnd);
+        QVERIFY(end > begin);
+        previousEnd = end;
+    }
+    QCOMPARE(previousEnd, count);
+}
+
+void ConvertBandsTest::bandCount() {
+    SerialBandExecutor executor;
+    QCOMPARE(ConvertBands::bandCount(0, 4000, 4000 * 4000), 1);
+    QCOMPARE(ConvertBands::bandCount(&executor, 100, 100 * 100), 1);
+    QCOMPARE(ConvertBands::bandCount(&executor, 4000, 4000 * 4000), 4);
+    executor.idleCount = 0;
+    QCOMPARE(ConvertBands::bandCount(&executor, 4000, 4000 * 4000), 1);
+}
+
+void ConvertBandsTest::rgb32Image() {
+    const QImage image = TestImages::gradient(40, 30);
+    QVERIFY(ConvertBands::isRgb32(image));
+    // 32-bit image is shared, not copied
+    QCOMPARE(ConvertBands::rgb32Image(image).cacheKey(), image.cacheKey());
+
+    const QImage indexed = image.convertToFormat(QImage::Format_Indexed8);
+    QVERIFY(!ConvertBands::isRgb32(indexed));
+    const QImage converted = ConvertBands::rgb32Image(indexed);
+    QCOMPARE(converted.format(), QImage::Format_RGB32);
+    QCOMPARE(converted.pixel(7, 5), indexed.pixel(7, 5));
+    QCOMPARE(ConvertBands::rgb32Image(
+                 image.convertToFormat(QImage::Format_ARGB4444_Premultiplied))
+             .format(), QImage::Format_ARGB32);
+}
+
+void ConvertBandsTest::effects_grayscale() {
+    SharedInformation shared;
+    EffectsConfiguration configuration = shared.effectsConfiguration();
+    configuration.setFilterType(BlackAndWhite);
+    shared.setEffectsConfiguration(configuration);
+
+    const QImage image = TestImages::gradient(1200, 1000);
+    SerialBandExecutor executor;
+
+    QImage serial(image);
+    ConvertEffects serialEffects(&serial, &shared);
+    serialEffects.filtrate();
+
+    QImage banded(image);
+    ConvertEffects bandedEffects(&banded, &shared);
+    bandedEffects.setBandExecutor(&executor);
+    bandedEffects.filtrate();
+
+    QVERIFY(executor.calls > 0);
+    QCOMPARE(banded, serial);
+    QVERIFY(serial != image);
+}
+
+void ConvertBandsTest::effects_histogram() {
+    SharedInformation shared;
+    EffectsConfiguration configuration = shared.effectsConfiguration();
+    configuration.setHistogramOperation(2); // equalize
+    shared.setEffectsConfiguration(configuration);
+
+    const QImage image = TestImages::gradient(1200, 1000);
+    SerialBandExecutor executor;
+
+    QImage serial(image);
+    ConvertEffects serialEffects(&serial, &shared);
+    serialEffects.modifyHistogram();
+
+    QImage banded(image);
+    ConvertEffects bandedEffects(&banded, &shared);
+    bandedEffects.setBandExecutor(&executor);
+    bandedEffects.modifyHistogram();
+
+    QVERIFY(executor.calls > 0);
+    QCOMPARE(banded, serial);
+}
+
+void ConvertBandsTest::scheduler_runBands() {
+    ConvertScheduler scheduler;
+    scheduler.setThreadCount(4);
+
+    const int count = 10000;
+    CountingTask task(count);
+    scheduler.runBands(&task, count, 16);
+
+    for (int i=0; i<count; i++)
+        QCOMPARE(task.hits[i].load(), 1);
+}
+
+void ConvertBandsTest::scheduler_runBands_cancelled() {
+    ConvertScheduler scheduler;
+    scheduler.setThreadCount(4);
+    scheduler.cancel();
+    QVERIFY(scheduler.cancellationToken()->isCancelled());
+
+    const int count = 10000;
+    CountingTask task(count);
+    task.setCancellationToken(scheduler.cancellationToken());
+    scheduler.runBands(&task, count, 16);
+    ConvertBands::run(&scheduler, &task, count, qint64(count) * count);
+
+    for (int i=0; i<count; i++)
+        QCOMPARE(task.hits[i].load(), 0);
+
+    // next batch resets the token
+    scheduler.start(QList<ConvertJob>());
+    QVERIFY(!scheduler.cancellationToken()->isCancelled());
+}
+
+QTEST_MAIN(ConvertBandsTest)
+#include "ConvertBandsTest.moc"
@@ -0,0 +1,100 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertCostModelTest.hpp"
+
+
+ConvertJob ConvertCostModelTest::createJob(int id, const QString &extension,
+                                           qint64 fileSize, qint64 pixels) {
+    ConvertJob job;
+    job.id = id;
+    job.imageData << QString::number(id) << extension << "/tmp";
+    job.fileSize = fileSize;
+    job.pixels = pixels;
+    return job;
+}
+
+void ConvertCostModelTest::formatClass_data() {
+    QTest::addColumn<QString>("extension");
+    QTest::addColumn<int>("formatClass");
+
+    QTest::newRow("jpg") << "jpg" << int(ConvertCostModel::RegularFormat);
+    QTest::newRow("JPG") << "JPG" << int(ConvertCostModel::RegularFormat);
+    QTest::newRow("png") << "png" << int(ConvertCostModel::RegularFormat);
+    QTest::newRow("svg") << "svg" << int(ConvertCostModel::SvgFormat);
+    QTest::newRow("svgz") << "SVGZ" << int(ConvertCostModel::SvgFormat);
+    QTest::newRow("nef") << "nef" << int(ConvertCostModel::RawFormat);
+}
+
+void ConvertCostModelTest::formatClass() {
+    QFETCH(QString, extension);
+    QFETCH(int, formatClass);
+
+    QCOMPARE(int(ConvertCostModel::formatClass(extension)), formatClass);
+}
+
+void ConvertCostModelTest::sort_largestFirst() {
+    QList<ConvertJob> jobs;
+    jobs << createJob(0, "png", 1024, 640 * 480);
+    jobs << createJob(1, "png", 1024 * 1024, 20000 * 10000);
+    jobs << createJob(2, "png", 1024, 640 * 480);
+    jobs << createJob(3, "png", 100 * 1024, 0);
+
+    ConvertCostModel model;
+    model.sort(&jobs);
+
+    QCOMPARE(jobs[0].id, 1);
+    QCOMPARE(jobs[1].id, 3);
+    // equal cost keeps order
+    QCOMPARE(jobs[2].id, 0);
+    QCOMPARE(jobs[3].id, 2);
+    QVERIFY(jobs[0].cost > jobs[1].cost);
+}
+
+void ConvertCostModelTest::sort_formatWeight() {
+    QList<ConvertJob> jobs;
+    jobs << createJob(0, "jpg", 1024 * 1024, 4000 * 3000);
+    jobs << createJob(1, "nef", 1024 * 1024, 4000 * 3000);
+
+    ConvertCostModel model;
+    model.sort(&jobs);
+
+    QCOMPARE(jobs[0].id, 1);
+}
+
+void ConvertCostModelTest::addSample() {
+    ConvertCostModel model;
+    ConvertJob job = createJob(0, "jpg", 0, 2000 * 1000);
+    QCOMPARE(ConvertCostModel::workUnits(job), 2.);
+
+    model.addSample(job, 100.);
+    QCOMPARE(model.factor(ConvertCostModel::RegularFormat), 50.);
+    QCOMPARE(model.estimate(job), 100.);
+    // not measured class is scaled by regular images factor
+    QCOMPARE(model.factor(ConvertCostModel::RawFormat), 200.);
+
+    model.addSample(job, 200.);
+    QVERIFY(model.factor(ConvertCostModel::RegularFormat) > 50.);
+    QVERIFY(model.factor(ConvertCostModel::RegularFormat) < 100.);
+}
+
+QTEST_MAIN(ConvertCostModelTest)
+#include "ConvertCostModelTest.moc"
@@ -20,6 +20,7 @@
  */
 
 #include "tests/ConvertEffectsTest.hpp"
+#include "tests/TestHelpers.hpp"
 #include <cstdlib>
 #include <ctime>
 #include <QPainter>
@@ -42,6 +43,13 @@ ConvertEffectsTest::ConvertEffectsTest() : testImg(300, 500, QImage::Format_ARGB
     effects = ConvertEffects(&info);
 }
 
+/** Sets filter type of effects configuration used by #effects. */
+void ConvertEffectsTest::setFilterType(int type) {
+    EffectsConfiguration configuration = info.effectsConfiguration();
+    configuration.setFilterType(type);
+    info.setEffectsConfiguration(configuration);
+}
+
 void ConvertEffectsTest::initTestCase() {
     QImage img(testImg);
     QCOMPARE(img.size(), testImg.size());
@@ -317,5 +325,259 @@ void ConvertEffectsTest::addText_middleBottomEdge() {
     QCOMPARE(result, expected);
 }
 
+void ConvertEffectsTest::combine_color_alpha() {
+    QImage img(4, 1, QImage::Format_ARGB32_Premultiplied);
+    img.setPixel(0, 0, qRgba(0, 0, 0, 0));
+    img.setPixel(1, 0, qRgba(100, 50, 0, 255));
+    img.setPixel(2, 0, qPremultiply(qRgba(200, 0, 0, 128)));
+    img.setPixel(3, 0, qRgba(255, 255, 255, 255));
+    QImage painted(img);
+    effects.setImage(&img);
+    effects.combine(QColor(0, 0, 255));
+    QPainter painter(&painted);
+    painter.setOpacity(0.5);
+    painter.fillRect(painted.rect(), QColor(0, 0, 255));
+    painter.end();
+    // 50% blend matches QPainter except rounding
+    for (int x=0; x<img.width(); x++) {
+        const QRgb a = img.pixel(x, 0);
+        const QRgb b = painted.pixel(x, 0);
+        QVERIFY(qAbs(qRed(a) - qRed(b)) <= 2);
+        QVERIFY(qAbs(qGreen(a) - qGreen(b)) <= 2);
+        QVERIFY(qAbs(qBlue(a) - qBlue(b)) <= 2);
+        QVERIFY(qAbs(qAlpha(a) - qAlpha(b)) <= 1);
+    }
+}
+
+void ConvertEffectsTest::grayscale_loop() {
+    QImage img(testImg);
+    effects.setImage(&img);
+
+    QBENCHMARK_ONCE {
+        effects.grayscaleLoop();
+    }
+}
+
+void ConvertEffectsTest::grayscale_scanline() {
+    QImage img(testImg);
+    effects.setImage(&img);
+    setFilterType(BlackAndWhite);
+
+    QBENCHMARK_ONCE {
+        effects.filtrate();
+    }
+}
+
+void ConvertEffectsTest::grayscale_compare() {
+    QImage expected(testImg);
+    effects.setImage(&expected);
+    effects.grayscaleLoop();
+
+    QImage img(testImg);
+    effects.setImage(&img);
+    setFilterType(BlackAndWhite);
+    effects.filtrate();
+    QCOMPARE(img, expected);
+}
+
+void ConvertEffectsTest::grayscale_alpha() {
+    QImage img(5, 1, QImage::Format_ARGB32_Premultiplied);
+    for (int x=0; x<img.width(); x++)
+        img.setPixel(x, 0, qPremultiply(qRgba(200, 100, x * 50, x * 60)));
+    effects.setImage(&img);
+    setFilterType(BlackAndWhite);
+    effects.filtrate();
+    for (int x=0; x<img.width(); x++) {
+        const QRgb rgb = img.pixel(x, 0);
+        QCOMPARE(qAlpha(rgb), x * 60);
+        QCOMPARE(qRed(rgb), qGreen(rgb));
+        QCOMPARE(qGreen(rgb), qBlue(rgb));
+    }
+}
+
+void ConvertEffectsTest::histogram_loop() {
+    QImage img(testImg);
+    effects.setImage(&img);
+
+    QBENCHMARK_ONCE {
+        effects.histogramLoop();
+    }
+}
+
+void ConvertEffectsTest::histogram_scanline() {
+    QImage img(testImg);
+    effects.setImage(&img);
+
+    QBENCHMARK_ONCE {
+        effects.histogram();
+    }
+}
+
+void ConvertEffectsTest::histogram_compare() {
+    QImage img(testImg);
+    effects.setImage(&img);
+    const QVector<Rgb> expected = effects.histogramLoop();
+    const QVector<Rgb> result = effects.histogram();
+    QCOMPARE(result.size(), expected.size());
+    for (int i=0; i<result.size(); i++) {
+        QCOMPARE(result[i].red, expected[i].red);
+        QCOMPARE(result[i].green, expected[i].green);
+        QCOMPARE(result[i].blue, expected[i].blue);
+    }
+}
+
+void ConvertEffectsTest::histogram_cached() {
+    // converted indexed image is scanned once
+    QImage img = TestImages::gradient(1200, 1000, QImage::Format_Indexed8);
+    SerialBandExecutor executor;
+    effects.setImage(&img);
+    effects.setBandExecutor(&executor);
+    const QVector<Rgb> h = effects.histogram();
+    effects.colorRange();
+    effects.distribution();
+    effects.setBandExecutor(0);
+    QCOMPARE(executor.calls, 1);
+    QCOMPARE(img.format(), QImage::Format_RGB32);
+    QCOMPARE(h.size(), 256);
+}
+
+void ConvertEffectsTest::colorRange() {
+    QImage img(testImg);
+    img.setPixel(7, 9, qRgb(10, 250, 20));
+    img.setPixel(299, 499, qRgb(250, 5, 255));
+    int min[3] = { 255, 255, 255 };
+    int max[3] = { 0, 0, 0 };
+    for (int y=0; y<img.height(); y++) {
+        for (int x=0; x<img.width(); x++) {
+            const QRgb rgb = img.pixel(x, y);
+            const int value[3] = { qRed(rgb), qGreen(rgb), qBlue(rgb) };
+            for (int i=0; i<3; i++) {
+                min[i] = qMin(min[i], value[i]);
+                max[i] = qMax(max[i], value[i]);
+            }
+        }
+    }
+    effects.setImage(&img);
+    const QPair<QColor, QColor> range = effects.colorRange();
+    QCOMPARE(range.first, QColor(min[0], min[1], min[2]));
+    QCOMPARE(range.second, QColor(max[0], max[1], max[2]));
+}
+
+void ConvertEffectsTest::stretchHistogram() {
+    QImage img(3, 1, QImage::Format_RGB32);
+    img.setPixel(0, 0, qRgb(50, 10, 7));
+    img.setPixel(1, 0, qRgb(100, 20, 7));
+    img.setPixel(2, 0, qRgb(150, 30, 7));
+    effects.setImage(&img);
+    effects.stretchHistogram();
+    QCOMPARE(img.pixel(0, 0), qRgb(0, 0, 7));
+    QCOMPARE(img.pixel(1, 0), qRgb(127, 127, 7));
+    QCOMPARE(img.pixel(2, 0), qRgb(255, 255, 7));
+}
+
+void ConvertEffectsTest::equalizeHistogram() {
+    QImage img(testImg);
+    effects.setImage(&img);
+    const QVector<Rgb> lut = effects.lookUpTable();
+    effects.equalizeHistogram();
+    for (int y=0; y<img.height(); y+=7) {
+        for (int x=0; x<img.width(); x+=5) {
+            const QRgb source = testImg.pixel(x, y);
+            const QRgb result = img.pixel(x, y);
+            QCOMPARE(qRed(result), lut[qRed(source)].red);
+            QCOMPARE(qGreen(result), lut[qGreen(source)].green);
+            QCOMPARE(qBlue(result), lut[qBlue(source)].blue);
+        }
+    }
+}
+
+void ConvertEffectsTest::modifyColors_data() {
+    QTest::addColumn<int>("histogramOperation");
+    QTest::addColumn<int>("filterType");
+    QTest::addColumn<QColor>("color");
+
+    const char *histograms[] = { "none", "stretch", "equalize" };
+    for (int i=0; i<3; i++) {
+        const QByteArray name(histograms[i]);
+        QTest::newRow(QByteArray(name + " no filter").constData())
+                << i << int(NoFilter) << QColor();
+        QTest::newRow(QByteArray(name + " black and white").constData())
+                << i << int(BlackAndWhite) << QColor();
+        QTest::newRow(QByteArray(name + " sepia").constData())
+                << i << int(Sepia) << QColor();
+        QTest::newRow(QByteArray(name + " custom color").constData())
+                << i << int(CustomColor) << QColor(Qt::green);
+        QTest::newRow(QByteArray(name + " transparent color").constData())
+                << i << int(CustomColor) << QColor(0, 255, 0, 100);
+        QTest::newRow(QByteArray(name + " gradient").constData())
+                << i << int(Gradient) << QColor();
+    }
+}
+
+void ConvertEffectsTest::modifyColors() {
+    QFETCH(int, histogramOperation);
+    QFETCH(int, filterType);
+    QFETCH(QColor, color);
+
+    EffectsConfiguration configuration = info.effectsConfiguration();
+    configuration.setHistogramOperation(histogramOperation);
+    configuration.setFilterType(filterType);
+    if (filterType == Gradient) {
+        QLinearGradient gradient(0, 0, testImg.width(), testImg.height());
+        gradient.setColorAt(0.0, QColor(Qt::red));
+        gradient.setColorAt(1.0, QColor(Qt::yellow));
+        configuration.setFilterBrush(QBrush(gradient));
+    }
+    else
+        configuration.setFilterBrush(QBrush(color));
+    info.setEffectsConfiguration(configuration);
+
+    QImage expected(testImg);
+    effects.setImage(&expected);
+    effects.modifyHistogram();
+    if (filterType != NoFilter)
+        effects.filtrate();
+
+    QImage img(testImg);
+    effects.setImage(&img);
+    effects.modifyColors();
+    QCOMPARE(img, expected);
+
+    configuration.setHistogramOperation(0);
+    configuration.setFilterType(NoFilter);
+    info.setEffectsConfiguration(configuration);
+}
+
+void ConvertEffectsTest::modifyColors_separate() {
+    EffectsConfiguration configuration = info.effectsConfiguration();
+    configuration.setHistogramOperation(1);
+    configuration.setFilterType(BlackAndWhite);
+    info.setEffectsConfiguration(configuration);
+    QImage img(testImg);
+    effects.setImage(&img);
+
+    QBENCHMARK_ONCE {
+        effects.modifyHistogram();
+        effects.filtrate();
+    }
+}
+
+void ConvertEffectsTest::modifyColors_fused() {
+    EffectsConfiguration configuration = info.effectsConfiguration();
+    configuration.setHistogramOperation(1);
+    configuration.setFilterType(BlackAndWhite);
+    info.setEffectsConfiguration(configuration);
+    QImage img(testImg);
+    effects.setImage(&img);
+
+    QBENCHMARK_ONCE {
+        effects.modifyColors();
+    }
+
+    configuration.setHistogramOperation(0);
+    configuration.setFilterType(NoFilter);
+    info.setEffectsConfiguration(configuration);
+}
+
 QTEST_MAIN(ConvertEffectsTest)
 #include "ConvertEffectsTest.moc"
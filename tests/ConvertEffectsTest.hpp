@@ -37,6 +37,8 @@ private:
     SharedInformation info;
     ConvertEffects effects;
 
+    void setFilterType(int type);
+
 private slots:
     void initTestCase();
     void cleanupTestCase();
@@ -45,6 +47,22 @@ private slots:
     void combine_color_painter();
     void combine_color_compare();
     void combine_brush();
+    void combine_color_alpha();
+    void grayscale_loop();
+    void grayscale_scanline();
+    void grayscale_compare();
+    void grayscale_alpha();
+    void histogram_loop();
+    void histogram_scanline();
+    void histogram_compare();
+    void histogram_cached();
+    void colorRange();
+    void stretchHistogram();
+    void equalizeHistogram();
+    void modifyColors_data();
+    void modifyColors();
+    void modifyColors_separate();
+    void modifyColors_fused();
     void getTransformOriginPoint_pixels_zero();
     void getTransformOriginPoint_pixels_positive();
     void getTransformOriginPoint_pixels_negative();
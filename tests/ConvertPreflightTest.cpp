@@ -0,0 +1,186 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertPreflightTest.hpp"
+
+
+ConvertPreflightTest::ConvertPreflightTest() {
+    shared.setDesiredFormat("png");
+    shared.setDestFolder(QDir::temp());
+    shared.setDestPrefix("pre");
+    shared.setDestSuffix("suf");
+}
+
+void ConvertPreflightTest::targetFilePath() {
+    ConvertPreflight preflight(&shared);
+    QStringList imageData;
+    imageData << "image" << "JPG" << "/home/user";
+    QString expected = QDir::temp().absolutePath() + QDir::separator()
+            + "pre_image_suf.png";
+    QCOMPARE(preflight.targetFilePath(imageData), expected);
+}
+
+void ConvertPreflightTest::isEnlarging_px_data() {
+    QTest::addColumn<QSize>("sourceSize");
+    QTest::addColumn<bool>("result");
+
+    QTest::newRow("bigger landscape") << QSize(1024, 768) << false;
+    QTest::newRow("smaller landscape") << QSize(320, 240) << true;
+    QTest::newRow("smaller portrait") << QSize(240, 320) << true;
+    QTest::newRow("equal") << QSize(800, 600) << false;
+    QTest::newRow("unknown") << QSize() << false;
+}
+
+void ConvertPreflightTest::isEnlarging_px() {
+    QFETCH(QSize, sourceSize);
+    QFETCH(bool, result);
+
+    shared.setDesiredSize(800, 600, false, true, true);
+    ConvertPreflight preflight(&shared);
+    QCOMPARE(preflight.isEnlarging(sourceSize, 0), result);
+}
+
+void ConvertPreflightTest::isEnlarging_percent() {
+    shared.setDesiredSize(50, 50, true, true, true);
+    QVERIFY(!ConvertPreflight(&shared).isEnlarging(QSize(800, 600), 0));
+
+    shared.setDesiredSize(150, 150, true, true, true);
+    QVERIFY(ConvertPreflight(&shared).isEnlarging(QSize(800, 600), 0));
+}
+
+void ConvertPreflightTest::isEnlarging_bytes() {
+    shared.setDesiredSize(100 * 1024);
+    ConvertPreflight preflight(&shared);
+    // file size ratio estimate for non-linear formats
+    QVERIFY(preflight.isEnlarging(QSize(), 10 * 1024));
+    QVERIFY(!preflight.isEnlarging(QSize(), 1024 * 1024));
+}
+
+void ConvertPreflightTest::check_duplicatedTarget() {
+    shared.setDesiredSize(0, 0, false, false, false);
+    ConvertPreflight preflight(&shared);
+
+    ConvertJob first;
+    first.imageData << "sir_preflight_test_image" << "jpg" << "/nonexistent";
+    ConvertJob second;
+    second.imageData << "sir_preflight_test_image" << "bmp" << "/nonexistent";
+
+    QVERIFY(!preflight.check(&first));
+    QVERIFY(preflight.check(&second));
+    QCOMPARE(int(second.decisions[ConvertJob::Overwrite]),
+             int(ConvertJob::Pending));
+    QCOMPARE(int(second.decisions[ConvertJob::Enlarge]),
+             int(ConvertJob::NotAsked));
+}
+
+void ConvertPreflightTest::decodeSize_data() {
+    QTest::addColumn<QSize>("source");
+    QTest::addColumn<QSize>("target");
+    QTest::addColumn<QSize>("result");
+
+    QTest::newRow("24 Mpx to thumbnail")
+            << QSize(6000, 4000) << QSize(800, 533) << QSize(3000, 2000);
+    QTest::newRow("divisor limit")
+            << QSize(6000, 4000) << QSize(100, 67) << QSize(750, 500);
+    QTest::newRow("odd dimensions")
+            << QSize(4001, 3001) << QSize(500, 375) << QSize(1001, 751);
+    QTest::newRow("small reduction")
+            << QSize(1024, 768) << QSize(800, 600) << QSize(1024, 768);
+    QTest::newRow("narrow target")
+            << QSize(4000, 4000) << QSize(2000, 100) << QSize(4000, 4000);
+    QTest::newRow("enlarging")
+            << QSize(320, 240) << QSize(800, 600) << QSize(320, 240);
+    QTest::newRow("unknown target")
+            << QSize(1024, 768) << QSize() << QSize(1024, 768);
+}
+
+void ConvertPreflightTest::decodeSize() {
+    QFETCH(QSize, source);
+    QFETCH(QSize, target);
+    QFETCH(QSize, result);
+
+    QCOMPARE(ConvertPreflight::decodeSize(source, target), result);
+}
+
+void ConvertPreflightTest::cropRect_data() {
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<QRectF>("crop");
+    QTest::addColumn<QSize>("sourceSize");
+    QTest::addColumn<QRect>("result");
+
+    QTest::newRow("none") << 0 << QRectF(10, 10, 100, 100)
+                          << QSize(1000, 800) << QRect();
+    QTest::newRow("px") << 1 << QRectF(100, 50, 400, 300)
+                        << QSize(1000, 800) << QRect(100, 50, 400, 300);
+    QTest::newRow("px limited") << 1 << QRectF(800, 600, 400, 400)
+                                << QSize(1000, 800) << QRect(800, 600, 200, 200);
+    QTest::newRow("px to edge") << 1 << QRectF(100, 100, 0, 0)
+                                << QSize(1000, 800) << QRect(100, 100, 900, 700);
+    QTest::newRow("px outside") << 1 << QRectF(1200, 0, 100, 100)
+                                << QSize(1000, 800) << QRect();
+    QTest::newRow("percent") << 2 << QRectF(10, 20, 50, 50)
+                             << QSize(1000, 800) << QRect(100, 160, 500, 400);
+    QTest::newRow("16:9 landscape") << 3 << QRectF(0, 0, 16, 9)
+                                    << QSize(4000, 3000) << QRect(0, 375, 4000, 2250);
+    QTest::newRow("square") << 3 << QRectF(0, 0, 1, 1)
+                            << QSize(4000, 3000) << QRect(500, 0, 3000, 3000);
+    QTest::newRow("no ratio") << 3 << QRectF()
+                              << QSize(4000, 3000) << QRect();
+    QTest::newRow("unknown size") << 1 << QRectF(100, 50, 400, 300)
+                                  << QSize() << QRect();
+}
+
+void ConvertPreflightTest::cropRect() {
+    QFETCH(int, mode);
+    QFETCH(QRectF, crop);
+    QFETCH(QSize, sourceSize);
+    QFETCH(QRect, result);
+
+    shared.setDesiredCrop(mode, crop);
+    QCOMPARE(ConvertPreflight(&shared).cropRect(sourceSize), result);
+    shared.setDesiredCrop(0);
+}
+
+void ConvertPreflightTest::check_croppedEnlarging() {
+    QImage image(1000, 800, QImage::Format_RGB32);
+    image.fill(Qt::white);
+    const QString imagePath = QDir::temp().filePath("sir_crop_test_image.png");
+    QVERIFY(image.save(imagePath));
+    shared.setDesiredSize(800, 600, false, true, true);
+
+    ConvertJob job;
+    job.imageData << "sir_crop_test_image" << "png" << QDir::tempPath();
+    QVERIFY(!ConvertPreflight(&shared).check(&job));
+
+    // the cropped region is smaller than desired size
+    shared.setDesiredCrop(1, QRectF(0, 0, 400, 300));
+    ConvertJob croppedJob;
+    croppedJob.imageData = job.imageData;
+    QVERIFY(ConvertPreflight(&shared).check(&croppedJob));
+    QCOMPARE(int(croppedJob.decisions[ConvertJob::Enlarge]),
+             int(ConvertJob::Pending));
+
+    shared.setDesiredCrop(0);
+    QFile::remove(imagePath);
+}
+
+QTEST_MAIN(ConvertPreflightTest)
+#include "ConvertPreflightTest.moc"
@@ -0,0 +1,124 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertQueueTest.hpp"
+
+#include <QThread>
+#include <QVector>
+
+
+class ConsumerThread : public QThread {
+public:
+    ConsumerThread(ConvertQueue *queue, QAtomicInt *hits)
+        : queue(queue), hits(hits) {}
+
+protected:
+    void run() {
+        ConvertJob job;
+        while (queue->dequeue(&job))
+            hits[job.id].ref();
+    }
+
+private:
+    ConvertQueue *queue;
+    QAtomicInt *hits;
+};
+
+void ConvertQueueTest::enqueue_dequeue() {
+    ConvertQueue queue;
+    QVERIFY(queue.isEmpty());
+
+    ConvertJob job;
+    QVERIFY(!queue.dequeue(&job));
+
+    for (int i=0; i<3; i++) {
+        job.id = i;
+        job.imageData = QStringList() << QString::number(i) << "jpg" << "/tmp";
+        QVERIFY(queue.enqueue(job));
+    }
+    QCOMPARE(queue.count(), 3);
+
+    for (int i=0; i<3; i++) {
+        QVERIFY(queue.dequeue(&job));
+        QCOMPARE(job.id, i);
+        QCOMPARE(job.imageData.first(), QString::number(i));
+    }
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.takenCount(), 3);
+    QVERIFY(!queue.dequeue(&job));
+}
+
+void ConvertQueueTest::clear() {
+    ConvertQueue queue;
+    ConvertJob job;
+    job.id = 1;
+    queue.enqueue(job);
+    queue.clear();
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.count(), 0);
+
+    job.id = 2;
+    queue.enqueue(job);
+    QVERIFY(queue.dequeue(&job));
+    QCOMPARE(job.id, 2);
+}
+
+void ConvertQueueTest::segments() {
+    ConvertQueue queue;
+    ConvertJob job;
+    const int count = 3000;
+    for (int i=0; i<count; i++) {
+        job.id = i;
+        QVERIFY(queue.enqueue(job));
+    }
+    for (int i=0; i<count; i++) {
+        QVERIFY(queue.dequeue(&job));
+        QCOMPARE(job.id, i);
+    }
+}
+
+void ConvertQueueTest::concurrentConsumers() {
+    ConvertQueue queue;
+    const int count = 20000;
+    QVector<QAtomicInt> hits(count);
+
+    QList<ConsumerThread*> consumers;
+    for (int i=0; i<4; i++)
+        consumers << new ConsumerThread(&queue, hits.data());
+
+    ConvertJob job;
+    for (int i=0; i<count; i++) {
+        job.id = i;
+        queue.enqueue(job);
+    }
+    foreach (ConsumerThread *thread, consumers)
+        thread->start();
+    foreach (ConsumerThread *thread, consumers)
+        thread->wait();
+    qDeleteAll(consumers);
+
+    // every job is taken exactly once
+    for (int i=0; i<count; i++)
+        QCOMPARE(hits[i].load(), 1);
+}
+
+QTEST_APPLESS_MAIN(ConvertQueueTest)
+#include "ConvertQueueTest.moc"
@@ -0,0 +1,151 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertSchedulerTest.hpp"
+
+#include <QDir>
+#include <QImage>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "ConvertThread.hpp"
+
+
+/** Returns \a count jobs of not existing files. Such jobs fail quickly. */
+QList<ConvertJob> ConvertSchedulerTest::missingFileJobs(int firstId,
+                                                        int count) {
+    QList<ConvertJob> jobs;
+    for (int i=0; i<count; i++) {
+        ConvertJob job;
+        job.id = firstId + i;
+        job.imageData << QString("sir_missing_%1").arg(job.id) << "png"
+                      << QDir::tempPath();
+        jobs << job;
+    }
+    return jobs;
+}
+
+void ConvertSchedulerTest::append_runningBatch() {
+    ConvertScheduler scheduler;
+    scheduler.setThreadCount(2);
+    QSignalSpy finished(&scheduler, SIGNAL(batchFinished()));
+
+    scheduler.start(missingFileJobs(0, 10));
+    QCOMPARE(scheduler.append(missingFileJobs(10, 5)), 5);
+    QCOMPARE(scheduler.jobsCount(), 15);
+
+    QVERIFY(scheduler.waitForDone(5000));
+    QCOMPARE(scheduler.finishedJobsCount(), 15);
+    QVERIFY(finished.count() >= 1);
+}
+
+void ConvertSchedulerTest::append_finishedBatch() {
+    ConvertScheduler scheduler;
+    scheduler.setThreadCount(2);
+
+    scheduler.start(missingFileJobs(0, 3));
+    QVERIFY(scheduler.waitForDone(5000));
+
+    // warm threads take jobs appended to finished batch
+    QCOMPARE(scheduler.append(missingFileJobs(3, 3)), 3);
+    QVERIFY(scheduler.waitForDone(5000));
+    QCOMPARE(scheduler.finishedJobsCount(), 6);
+    QVERIFY(!scheduler.isBusy());
+}
+
+void ConvertSchedulerTest::bufferStatistics_reuse() {
+    QTemporaryDir sourceDir;
+    QTemporaryDir targetDir;
+    QVERIFY(sourceDir.isValid());
+    QVERIFY(targetDir.isValid());
+    // images large enough for pooled buffers
+    const int count = 5;
+    QImage image(400, 300, QImage::Format_RGB32);
+    image.fill(Qt::darkCyan);
+    QList<ConvertJob> jobs;
+    for (int i=0; i<count; i++) {
+        const QString name = QString("sir_buffers_%1").arg(i);
+        QVERIFY(image.save(sourceDir.path() + "/" + name + ".bmp"));
+        ConvertJob job;
+        job.id = i;
+        job.imageData << name << "bmp" << sourceDir.path();
+        jobs << job;
+    }
+    SharedInformation shared;
+    shared.setDesiredFormat("bmp");
+    shared.setDestFolder(QDir(targetDir.path()));
+    ConvertThread::setSharedInfo(shared);
+
+    ConvertScheduler scheduler;
+    scheduler.setThreadCount(1);
+    scheduler.start(jobs);
+    QVERIFY(scheduler.waitForDone(10000));
+    QCOMPARE(scheduler.finishedJobsCount(), count);
+    QCOMPARE(QDir(targetDir.path()).entryList(QDir::Files).count(), count);
+
+    // single thread decodes each image into buffer of previous one
+    const PixelBufferPool::Statistics statistics =
+            scheduler.batchBufferStatistics();
+    QVERIFY(statistics.reuses >= count - 1);
+    QVERIFY(statistics.allocations < count);
+}
+
+void ConvertSchedulerTest::processIsolation_batchFinished() {
+    QTemporaryDir sourceDir;
+    QTemporaryDir targetDir;
+    QVERIFY(sourceDir.isValid());
+    QVERIFY(targetDir.isValid());
+    const int count = 3;
+    QImage image(40, 30, QImage::Format_RGB32);
+    image.fill(Qt::darkRed);
+    QList<ConvertJob> jobs;
+    for (int i=0; i<count; i++) {
+        const QString name = QString("sir_isolated_%1").arg(i);
+        QVERIFY(image.save(sourceDir.path() + "/" + name + ".png"));
+        ConvertJob job;
+        job.id = i;
+        job.imageData << name << "png" << sourceDir.path();
+        jobs << job;
+    }
+    // failed jobs must be finished too
+    jobs << missingFileJobs(count, 2);
+    SharedInformation shared;
+    shared.setDesiredFormat("png");
+    shared.setDestFolder(QDir(targetDir.path()));
+    ConvertThread::setSharedInfo(shared);
+
+    ConvertScheduler scheduler;
+    scheduler.setThreadCount(1);
+    scheduler.setProcessIsolation(true);
+    scheduler.setWorkerProgram(QCoreApplication::applicationDirPath()
+                               + "/sir_convertworker_fixture");
+    QSignalSpy finished(&scheduler, SIGNAL(batchFinished()));
+
+    scheduler.start(jobs);
+    QVERIFY(scheduler.waitForDone(30000));
+    QCOMPARE(scheduler.finishedJobsCount(), jobs.count());
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(!scheduler.isBusy());
+    QCOMPARE(QDir(targetDir.path()).entryList(QDir::Files).count(), count);
+}
+
+QTEST_MAIN(ConvertSchedulerTest)
+#include "ConvertSchedulerTest.moc"
@@ -0,0 +1,74 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertStatusRingTest.hpp"
+
+
+void ConvertStatusRingTest::push_pop() {
+    ConvertStatusRing ring;
+    ConvertStatusRecord record;
+    QVERIFY(ring.isEmpty());
+    QVERIFY(!ring.pop(&record));
+
+    record.jobId = 7;
+    record.status = 1;
+    record.message = 2;
+    QVERIFY(ring.push(record));
+    QCOMPARE(ring.count(), 1);
+
+    ConvertStatusRecord result;
+    QVERIFY(ring.pop(&result));
+    QCOMPARE(result.jobId, 7);
+    QCOMPARE(int(result.status), 1);
+    QCOMPARE(int(result.message), 2);
+    QVERIFY(ring.isEmpty());
+}
+
+void ConvertStatusRingTest::full() {
+    ConvertStatusRing ring;
+    ConvertStatusRecord record;
+    for (int i=0; i<ConvertStatusRing::Capacity; i++) {
+        record.jobId = i;
+        QVERIFY(ring.push(record));
+    }
+    QVERIFY(!ring.push(record));
+    QCOMPARE(ring.count(), int(ConvertStatusRing::Capacity));
+
+    QVERIFY(ring.pop(&record));
+    QCOMPARE(record.jobId, 0);
+    QVERIFY(ring.push(record));
+}
+
+void ConvertStatusRingTest::wrapAround() {
+    ConvertStatusRing ring;
+    ConvertStatusRecord record;
+    const int count = ConvertStatusRing::Capacity * 3 + 5;
+    for (int i=0; i<count; i++) {
+        record.jobId = i;
+        QVERIFY(ring.push(record));
+        QVERIFY(ring.pop(&record));
+        QCOMPARE(record.jobId, i);
+    }
+    QVERIFY(ring.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(ConvertStatusRingTest)
+#include "ConvertStatusRingTest.moc"
@@ -0,0 +1,146 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ConvertWorkerTest.hpp"
+
+#include <QCoreApplication>
+#include <QDataStream>
+
+#include "ConvertThread.hpp"
+
+
+void ConvertWorkerTest::initTestCase() {
+    QVERIFY(dir.isValid());
+    fixturePath = QCoreApplication::applicationDirPath()
+            + "/sir_convertworker_fixture";
+    SharedInformation info;
+    info.setDesiredFormat("png");
+    info.setDestFolder(QDir(dir.path()));
+    ConvertThread::setSharedInfo(info);
+}
+
+/** Returns job item of \a name PNG file in temporary directory. */
+ConvertPipelineItem ConvertWorkerTest::item(int id,
+                                            const QString &name) const {
+    ConvertPipelineItem result;
+    result.job.id = id;
+    result.job.imageData << name << "png" << dir.path();
+    result.job.targetFilePath = dir.path() + "/target_" + name + ".png";
+    return result;
+}
+
+QByteArray ConvertWorkerTest::noise(int size) const {
+    QByteArray data(size, '\0');
+    for (int i=0; i<size; i++)
+        data[i] = char(qrand());
+    return data;
+}
+
+void ConvertWorkerTest::sharedInformation_stream() {
+    SharedInformation info;
+    info.setDesiredSize(640, 480, false, true, true, false);
+    info.setDesiredFormat("jpg");
+    info.setQuality(75);
+    info.setDestPrefix("pre_");
+    info.setDestSuffix("_suf");
+    info.setDesiredRotation(true, 90.);
+    info.setDesiredFlip(1);
+    info.setSvgModifiersEnabled(true, true, "remove me");
+    info.setRawModel(RawModel(true, "/usr/bin/dcraw", "-q 3"));
+
+    QByteArray written;
+    QDataStream out(&written, QIODevice::WriteOnly);
+    out << info;
+
+    SharedInformation read;
+    QDataStream in(written);
+    in >> read;
+    QCOMPARE(in.status(), QDataStream::Ok);
+
+    QByteArray rewritten;
+    QDataStream rewrite(&rewritten, QIODevice::WriteOnly);
+    rewrite << read;
+    QCOMPARE(rewritten, written);
+}
+
+void ConvertWorkerTest::convert_missingFile() {
+    ConvertWorkerProcess worker;
+    worker.setProgram(fixturePath);
+    QList<ConvertStatusRecord> records =
+            worker.convert(item(7, "missing"), 1);
+    QVERIFY(!records.isEmpty());
+    QCOMPARE(records.last().jobId, 7);
+    QCOMPARE(int(records.last().status), int(ConvertThread::Failed));
+    QCOMPARE(int(records.last().message),
+             int(ConvertThread::OpenFailedMessage));
+    QVERIFY(worker.isRunning());
+    QCOMPARE(worker.crashCount(), 0);
+}
+
+void ConvertWorkerTest::convert_crash() {
+    ConvertWorkerProcess worker;
+    worker.setProgram(fixturePath);
+    QList<ConvertStatusRecord> records = worker.convert(item(1, "crash"), 1);
+    QCOMPARE(records.count(), 1);
+    QCOMPARE(records.first().jobId, 1);
+    QCOMPARE(int(records.first().status), int(ConvertThread::Failed));
+    QCOMPARE(int(records.first().message),
+             int(ConvertThread::WorkerFailedMessage));
+    QCOMPARE(worker.crashCount(), 1);
+    QVERIFY(!QFile::exists(item(1, "crash").job.targetFilePath
+                           + ConvertThread::partFileSuffix));
+
+    // next job respawns the worker
+    records = worker.convert(item(2, "missing"), 1);
+    QVERIFY(!records.isEmpty());
+    QCOMPARE(records.last().jobId, 2);
+    QCOMPARE(int(records.last().message),
+             int(ConvertThread::OpenFailedMessage));
+    QVERIFY(worker.isRunning());
+    QCOMPARE(worker.crashCount(), 1);
+}
+
+void ConvertWorkerTest::convert_sharedMemory() {
+    ConvertWorkerProcess worker;
+    worker.setProgram(fixturePath);
+    ConvertPipelineItem copy = item(3, "copy");
+    copy.sourceData = noise(4 * ConvertWorkerProcess::inlineDataLimit);
+    worker.convert(copy, 1);
+
+    QFile target(copy.job.targetFilePath);
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    QCOMPARE(target.readAll(), copy.sourceData);
+}
+
+void ConvertWorkerTest::convert_inlineData() {
+    ConvertWorkerProcess worker;
+    worker.setProgram(fixturePath);
+    ConvertPipelineItem copy = item(4, "copy_inline");
+    copy.sourceData = noise(ConvertWorkerProcess::inlineDataLimit / 2);
+    worker.convert(copy, 1);
+
+    QFile target(copy.job.targetFilePath);
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    QCOMPARE(target.readAll(), copy.sourceData);
+}
+
+QTEST_MAIN(ConvertWorkerTest)
+#include "ConvertWorkerTest.moc"
@@ -0,0 +1,130 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/ImageFormatRegistryTest.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QImage>
+
+
+void ImageFormatRegistryTest::isReadable() {
+    const ImageFormatRegistry *registry = ImageFormatRegistry::instance();
+    QCOMPARE(ImageFormatRegistry::instance(), registry);
+    QVERIFY(registry->isReadable("png"));
+    QVERIFY(registry->isReadable("jpg"));
+    QVERIFY(registry->formats().contains("bmp"));
+    QVERIFY(!registry->isReadable("nef"));
+    QVERIFY(!registry->isReadable(QByteArray()));
+}
+
+void ImageFormatRegistryTest::detectFormat_data() {
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<QByteArray>("format");
+
+    QTest::newRow("jpeg") << QByteArray("\xFF\xD8\xFF\xE0\0\x10JFIF", 10)
+                          << QByteArray("jpeg");
+    QTest::newRow("png") << QByteArray("\x89PNG\r\n\x1A\n\0\0\0\rIHDR", 16)
+                         << QByteArray("png");
+    QTest::newRow("gif") << QByteArray("GIF89a") << QByteArray("gif");
+    QTest::newRow("tiff little endian") << QByteArray("II*\0\x08\0\0\0", 8)
+                                        << QByteArray("tiff");
+    QTest::newRow("tiff big endian") << QByteArray("MM\0*\0\0\0\x08", 8)
+                                     << QByteArray("tiff");
+    QTest::newRow("webp") << QByteArray("RIFF\0\0\0\0WEBPVP8 ", 16)
+                          << QByteArray("webp");
+    QTest::newRow("bmp") << QByteArray("BM6\0\0\0") << QByteArray("bmp");
+    QTest::newRow("ico") << QByteArray("\0\0\1\0\1\0", 6) << QByteArray("ico");
+    QTest::newRow("ppm") << QByteArray("P6\n640 480\n255\n") << QByteArray("ppm");
+    QTest::newRow("pgm") << QByteArray("P5 8 8 255") << QByteArray("pgm");
+    QTest::newRow("pbm") << QByteArray("P4\n8 8\n") << QByteArray("pbm");
+    QTest::newRow("xpm") << QByteArray("/* XPM */\nstatic") << QByteArray("xpm");
+    QTest::newRow("riff not webp") << QByteArray("RIFF\0\0\0\0WAVEfmt ", 16)
+                                   << QByteArray();
+    QTest::newRow("text") << QByteArray("Plain text file") << QByteArray();
+    QTest::newRow("empty") << QByteArray() << QByteArray();
+}
+
+void ImageFormatRegistryTest::detectFormat() {
+    QFETCH(QByteArray, header);
+    QFETCH(QByteArray, format);
+
+    QCOMPARE(ImageFormatRegistry::detectFormat(header), format);
+}
+
+void ImageFormatRegistryTest::extensionFormat() {
+    QCOMPARE(ImageFormatRegistry::extensionFormat("/home/user/image.JPG"),
+             QByteArray("jpg"));
+    QCOMPARE(ImageFormatRegistry::extensionFormat("archive.tar.GZ"),
+             QByteArray("gz"));
+    QCOMPARE(ImageFormatRegistry::extensionFormat("/home/user.name/image"),
+             QByteArray());
+    QCOMPARE(ImageFormatRegistry::extensionFormat("image"), QByteArray());
+}
+
+void ImageFormatRegistryTest::format_data() {
+    const ImageFormatRegistry *registry = ImageFormatRegistry::instance();
+    const QByteArray png("\x89PNG\r\n\x1A\n\0\0\0\rIHDR", 16);
+    const QByteArray tiff("II*\0\x08\0\0\0", 8);
+
+    // prefetched data is used instead of the file
+    QCOMPARE(registry->format("/nonexistent/image.jpg", png), QByteArray("png"));
+    QCOMPARE(registry->format("/nonexistent/image.jpg", "Unknown data"),
+             QByteArray("jpg"));
+    QCOMPARE(registry->format("/nonexistent/image.tif", tiff), QByteArray("tiff"));
+    QCOMPARE(registry->format("/nonexistent/image.jpg", tiff), QByteArray("tiff"));
+    // SVG files are recognized by extension
+    QCOMPARE(registry->format("/nonexistent/image.svgz", png), QByteArray("svgz"));
+}
+
+void ImageFormatRegistryTest::format_mislabelledFile() {
+    QImage image(8, 8, QImage::Format_RGB32);
+    image.fill(Qt::red);
+    const QString filePath = QDir::temp().filePath("sir_registry_test.jpg");
+    QVERIFY(image.save(filePath, "PNG"));
+
+    QCOMPARE(ImageFormatRegistry::instance()->format(filePath),
+             QByteArray("png"));
+
+    QFile::remove(filePath);
+}
+
+void ImageFormatRegistryTest::format_rawTiffContainer() {
+    // many RAW formats are TIFF containers decoded by dcraw
+    const QString filePath = QDir::temp().filePath("sir_registry_test.nef");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray("II*\0\x08\0\0\0", 8));
+    file.close();
+
+    QCOMPARE(ImageFormatRegistry::instance()->format(filePath),
+             QByteArray("nef"));
+
+    file.remove();
+}
+
+void ImageFormatRegistryTest::format_missingFile() {
+    QCOMPARE(ImageFormatRegistry::instance()->format("test_file.raw"),
+             QByteArray("raw"));
+}
+
+QTEST_MAIN(ImageFormatRegistryTest)
+#include "ImageFormatRegistryTest.moc"
@@ -0,0 +1,169 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+
+#include "tests/ImageStatisticsTest.hpp"
+
+#include "tests/TestHelpers.hpp"
+
+#include <QDir>
+
+
+QVector<Rgb> ImageStatisticsTest::histogramLoop(const QImage &image) {
+    QVector<Rgb> h(256);
+    for (int y=0; y<image.height(); y++) {
+        for (int x=0; x<image.width(); x++) {
+            const QRgb rgb = image.pixel(x, y);
+            h[qRed(rgb)].red++;
+            h[qGreen(rgb)].green++;
+            h[qBlue(rgb)].blue++;
+        }
+    }
+    return h;
+}
+
+void ImageStatisticsTest::compare(const QVector<Rgb> &result,
+                                  const QVector<Rgb> &expected) {
+    QCOMPARE(result.size(), expected.size());
+    for (int i=0; i<result.size(); i++) {
+        QCOMPARE(result[i].red, expected[i].red);
+        QCOMPARE(result[i].green, expected[i].green);
+        QCOMPARE(result[i].blue, expected[i].blue);
+    }
+}
+
+void ImageStatisticsTest::null() {
+    QVERIFY(ImageStatistics().isNull());
+    QVERIFY(ImageStatistics(QImage()).isNull());
+    QVERIFY(!ImageStatistics(TestImages::gradient(3, 2)).isNull());
+}
+
+void ImageStatisticsTest::histogram() {
+    const QImage image = TestImages::gradient(300, 200);
+    const ImageStatistics statistics(image);
+    QCOMPARE(statistics.pixelCount(), qint64(300 * 200));
+    compare(statistics.histogram(), histogramLoop(image));
+}
+
+void ImageStatisticsTest::cumulativeHistogram() {
+    const ImageStatistics statistics(TestImages::gradient(300, 200));
+    const QVector<Rgb> &h = statistics.histogram();
+    const QVector<Rgb> &sum = statistics.cumulativeHistogram();
+    QCOMPARE(sum.size(), 256);
+    QCOMPARE(sum[0].red, 0);
+    Rgb expected;
+    for (int n=1; n<sum.size(); n++) {
+        expected += h[n-1];
+        QCOMPARE(sum[n].red, expected.red);
+        QCOMPARE(sum[n].green, expected.green);
+        QCOMPARE(sum[n].blue, expected.blue);
+    }
+}
+
+void ImageStatisticsTest::range() {
+    QImage image = TestImages::gradient(300, 200);
+    image.setPixel(5, 5, qRgb(7, 250, 128));
+    const ImageStatistics statistics(image);
+    int min[3] = { 255, 255, 255 };
+    int max[3] = { 0, 0, 0 };
+    for (int y=0; y<image.height(); y++) {
+        for (int x=0; x<image.width(); x++) {
+            const QRgb rgb = image.pixel(x, y);
+            const int value[3] = { qRed(rgb), qGreen(rgb), qBlue(rgb) };
+            for (int i=0; i<3; i++) {
+                min[i] = qMin(min[i], value[i]);
+                max[i] = qMax(max[i], value[i]);
+            }
+        }
+    }
+    QCOMPARE(statistics.minimum(), QColor(min[0], min[1], min[2]));
+    QCOMPARE(statistics.maximum(), QColor(max[0], max[1], max[2]));
+}
+
+void ImageStatisticsTest::premultiplied() {
+    QImage image(2, 1);
+    image.setPixel(0, 0, qRgba(200, 100, 50, 128));
+    image.setPixel(1, 0, qRgba(10, 20, 30, 255));
+    const ImageStatistics straight(image);
+    const ImageStatistics premultiplied(image.convertToFormat(
+                                            QImage::Format_ARGB32_Premultiplied));
+    // straight values are counted; premultiplying rounds them slightly
+    QVERIFY(qAbs(premultiplied.maximum().red() - 200) <= 1);
+    QCOMPARE(premultiplied.minimum(), straight.minimum());
+}
+
+void ImageStatisticsTest::indexed() {
+    const QImage image = TestImages::gradient(64, 32);
+    const QImage indexed = image.convertToFormat(QImage::Format_Indexed8);
+    const ImageStatistics statistics(indexed);
+    compare(statistics.histogram(), histogramLoop(indexed));
+}
+
+void ImageStatisticsTest::bands() {
+    const QImage image = TestImages::gradient(1200, 1000);
+    SerialBandExecutor executor;
+    const ImageStatistics statistics(image, &executor);
+    QVERIFY(executor.calls > 0);
+    compare(statistics.histogram(), ImageStatistics(image).histogram());
+}
+
+void ImageStatisticsTest::cached() {
+    QImage image = TestImages::gradient(1200, 1000);
+    SerialBandExecutor executor;
+    const ImageStatistics first = ImageStatistics::cached(image, &executor);
+    QCOMPARE(executor.calls, 1);
+    const ImageStatistics second = ImageStatistics::cached(image, &executor);
+    QCOMPARE(executor.calls, 1);
+    compare(second.histogram(), first.histogram());
+
+    // modified image must be scanned again
+    image.setPixel(0, 0, qRgb(255, 255, 255));
+    const ImageStatistics modified = ImageStatistics::cached(image);
+    QCOMPARE(modified.maximum(), QColor(255, 255, 255));
+    compare(modified.histogram(), histogramLoop(image));
+}
+
+void ImageStatisticsTest::fromFile() {
+    const QString path = QDir::tempPath() + QDir::separator()
+            + "sir_ImageStatisticsTest.png";
+    const QImage image = TestImages::gradient(400, 200);
+    QVERIFY(image.save(path));
+    const ImageStatistics full = ImageStatistics::fromFile(path, 400);
+    QCOMPARE(full.pixelCount(), qint64(400 * 200));
+    compare(full.histogram(), histogramLoop(image));
+    const ImageStatistics sampled = ImageStatistics::fromFile(path, 100);
+    QCOMPARE(sampled.pixelCount(), qint64(100 * 50));
+    QVERIFY(QFile::remove(path));
+    QVERIFY(ImageStatistics::fromFile(path, 100).isNull());
+}
+
+void ImageStatisticsTest::histogram_benchmark() {
+    const QImage image = TestImages::gradient(3000, 2000);
+    ImageStatistics statistics;
+    QBENCHMARK {
+        statistics = ImageStatistics(image);
+    }
+    QCOMPARE(statistics.pixelCount(), qint64(3000 * 2000));
+}
+
+QTEST_APPLESS_MAIN(ImageStatisticsTest)
+#include "ImageStatisticsTest.moc"
@@ -0,0 +1,204 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/ImageTransformTest.hpp"
+
+#include "PixelBufferPool.hpp"
+#include "tests/TestHelpers.hpp"
+
+#include <QtMath>
+
+
+void ImageTransformTest::isExact_data() {
+    QTest::addColumn<QTransform>("transform");
+    QTest::addColumn<bool>("exact");
+
+    QTest::newRow("identity") << QTransform() << true;
+    QTest::newRow("90") << QTransform().rotate(90) << true;
+    QTest::newRow("180") << QTransform().rotate(180) << true;
+    QTest::newRow("-90") << QTransform().rotate(-90) << true;
+    QTest::newRow("270") << QTransform().rotate(270) << true;
+    QTest::newRow("mirror") << QTransform().scale(-1, 1) << true;
+    QTest::newRow("mirrored 90") << QTransform().scale(1, -1).rotate(90)
+                                 << true;
+    QTest::newRow("translated") << QTransform().translate(5, 3).rotate(90)
+                                << true;
+    QTest::newRow("30") << QTransform().rotate(30) << false;
+    QTest::newRow("scale") << QTransform().scale(2, 2) << false;
+    QTest::newRow("shear") << QTransform().shear(1, 0) << false;
+    QTest::newRow("project") << QTransform().rotate(90, Qt::XAxis) << false;
+}
+
+void ImageTransformTest::isExact() {
+    QFETCH(QTransform, transform);
+    QFETCH(bool, exact);
+
+    QCOMPARE(ImageTransform::isExact(transform), exact);
+}
+
+void ImageTransformTest::transformed_exact_data() {
+    QTest::addColumn<QTransform>("transform");
+
+    const int angles[] = { 90, 180, 270, -90 };
+    for (int i=0; i<4; i++) {
+        const QByteArray name = QByteArray::number(angles[i]);
+        QTest::newRow(name.constData()) << QTransform().rotate(angles[i]);
+        QTest::newRow(QByteArray(name + " vertical flip").constData())
+                << QTransform().scale(1, -1).rotate(angles[i]);
+        QTest::newRow(QByteArray(name + " horizontal flip").constData())
+                << QTransform().scale(-1, 1).rotate(angles[i]);
+        QTest::newRow(QByteArray("flipped " + name).constData())
+                << QTransform().rotate(angles[i]).scale(-1, 1);
+    }
+}
+
+void ImageTransformTest::transformed_exact() {
+    QFETCH(QTransform, transform);
+
+    // sizes not divisible by block size
+    const QImage image = TestImages::gradient(131, 77);
+    const QImage result = ImageTransform().transformed(image, transform);
+    const QTransform linear(transform.m11(), transform.m12(),
+                            transform.m21(), transform.m22(), 0., 0.);
+    const QRectF bounds = linear.mapRect(QRectF(QPointF(), image.size()));
+    QCOMPARE(result.size(), bounds.size().toSize());
+    QCOMPARE(result.format(), image.format());
+    for (int y=0; y<image.height(); y++) {
+        for (int x=0; x<image.width(); x++) {
+            const QPointF point = linear.map(QPointF(x + .5, y + .5))
+                    - bounds.topLeft();
+            QCOMPARE(result.pixel(qFloor(point.x()), qFloor(point.y())),
+                     image.pixel(x, y));
+        }
+    }
+}
+
+void ImageTransformTest::transformed_rotated90() {
+    const QImage image = TestImages::gradient(5, 3);
+    const QImage result = ImageTransform().transformed(
+                image, QTransform().rotate(90));
+    QCOMPARE(result.size(), QSize(3, 5));
+    // clockwise: the top left pixel goes to the top right corner
+    for (int y=0; y<image.height(); y++) {
+        for (int x=0; x<image.width(); x++)
+            QCOMPARE(result.pixel(image.height() - 1 - y, x),
+                     image.pixel(x, y));
+    }
+}
+
+void ImageTransformTest::transformed_mirrored() {
+    const QImage image = TestImages::gradient(100, 70);
+    ImageTransform transform;
+    QCOMPARE(transform.transformed(image, QTransform().scale(-1, 1)),
+             image.mirrored(true, false));
+    QCOMPARE(transform.transformed(image, QTransform().scale(1, -1)),
+             image.mirrored(false, true));
+    QCOMPARE(transform.transformed(image, QTransform().rotate(180)),
+             image.mirrored(true, true));
+}
+
+void ImageTransformTest::transformed_formats_data() {
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("indexed 8") << int(QImage::Format_Indexed8);
+    QTest::newRow("rgb 16") << int(QImage::Format_RGB16);
+    QTest::newRow("rgb 888") << int(QImage::Format_RGB888);
+    QTest::newRow("argb 32") << int(QImage::Format_ARGB32);
+}
+
+void ImageTransformTest::transformed_formats() {
+    QFETCH(int, format);
+
+    const QImage image = TestImages::gradient(67, 65, QImage::Format(format));
+    QCOMPARE(int(image.format()), format);
+    const QImage result = ImageTransform().transformed(
+                image, QTransform().rotate(-90));
+    QCOMPARE(result.format(), image.format());
+    QCOMPARE(result.colorTable(), image.colorTable());
+    QCOMPARE(result.size(), QSize(65, 67));
+    // counterclockwise: the top left pixel goes to the bottom left corner
+    for (int y=0; y<image.height(); y++) {
+        for (int x=0; x<image.width(); x++)
+            QCOMPARE(result.pixel(y, image.width() - 1 - x),
+                     image.pixel(x, y));
+    }
+}
+
+void ImageTransformTest::transformed_smooth() {
+    const QImage image = TestImages::gradient(60, 40);
+    const QTransform transform = QTransform().rotate(30);
+    QCOMPARE(ImageTransform().transformed(image, transform),
+             image.transformed(transform, Qt::SmoothTransformation));
+    QCOMPARE(ImageTransform().transformed(image, QTransform()), image);
+}
+
+void ImageTransformTest::transformed_bands() {
+    const QImage image = TestImages::gradient(1200, 900);
+    ImageTransform transform;
+    const QImage expected = transform.transformed(image,
+                                                  QTransform().rotate(90));
+    SerialBandExecutor executor;
+    transform.setBandExecutor(&executor);
+    QCOMPARE(transform.transformed(image, QTransform().rotate(90)), expected);
+    QVERIFY(executor.calls > 0);
+}
+
+void ImageTransformTest::transformed_bufferPool() {
+    const QImage image = TestImages::gradient(400, 300);
+    PixelBufferPool pool;
+    ImageTransform transform;
+    transform.setBufferPool(&pool);
+    const QImage result = transform.transformed(image,
+                                                QTransform().rotate(270));
+    QCOMPARE(result, ImageTransform().transformed(image,
+                                                  QTransform().rotate(270)));
+    QCOMPARE(pool.statistics().allocations, qint64(1));
+}
+
+void ImageTransformTest::transformed_benchmark_data() {
+    QTest::addColumn<bool>("exact");
+
+    QTest::newRow("qt smooth") << false;
+    QTest::newRow("exact") << true;
+}
+
+void ImageTransformTest::transformed_benchmark() {
+    QFETCH(bool, exact);
+
+    const QImage image = TestImages::gradient(3000, 2000);
+    const QTransform transform = QTransform().rotate(90);
+    QImage result;
+    if (exact) {
+        QBENCHMARK {
+            result = ImageTransform().transformed(image, transform);
+        }
+    }
+    else {
+        QBENCHMARK {
+            result = image.transformed(transform, Qt::SmoothTransformation);
+        }
+    }
+    QCOMPARE(result.size(), QSize(2000, 3000));
+}
+
+QTEST_APPLESS_MAIN(ImageTransformTest)
+#include "ImageTransformTest.moc"
@@ -0,0 +1,91 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/MappedFileTest.hpp"
+
+#include <QBuffer>
+#include <QDir>
+#include <QImage>
+#include <QImageReader>
+#include <QSharedPointer>
+
+
+void MappedFileTest::init() {
+    filePath = QDir::temp().filePath("sir_mapped_file_test.png");
+}
+
+void MappedFileTest::cleanup() {
+    QFile::remove(filePath);
+}
+
+void MappedFileTest::data() {
+    QImage image(16, 8, QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    QVERIFY(image.save(filePath));
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray content = file.readAll();
+
+    MappedFile mapping(filePath);
+    QVERIFY(mapping.isMapped());
+    QCOMPARE(mapping.size(), qint64(content.size()));
+    QByteArray data = mapping.data();
+    QCOMPARE(data, content);
+
+    // the image is decoded from the mapping
+    QBuffer buffer(&data);
+    QImageReader reader(&buffer);
+    QCOMPARE(reader.read().pixel(1, 1), QColor(Qt::blue).rgb());
+}
+
+void MappedFileTest::data_sharedAfterFileClosed() {
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("mapped file content");
+    file.close();
+
+    // pipeline stages share the mapping
+    QSharedPointer<MappedFile> mapping(new MappedFile(filePath));
+    QSharedPointer<MappedFile> copy = mapping;
+    mapping.clear();
+    copy->prefetch();
+    QCOMPARE(copy->data(), QByteArray("mapped file content"));
+}
+
+void MappedFileTest::emptyFile() {
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+
+    MappedFile mapping(filePath);
+    QVERIFY(!mapping.isMapped());
+    QCOMPARE(mapping.size(), qint64(0));
+    QVERIFY(mapping.data().isEmpty());
+}
+
+void MappedFileTest::missingFile() {
+    MappedFile mapping(QDir::temp().filePath("sir_mapped_file_missing.png"));
+    QVERIFY(!mapping.isMapped());
+    QVERIFY(mapping.data().isEmpty());
+}
+
+QTEST_MAIN(MappedFileTest)
+#include "MappedFileTest.moc"
@@ -0,0 +1,99 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/MemoryBudgetTest.hpp"
+
+#include <QThread>
+
+
+class ReleasingThread : public QThread {
+public:
+    ReleasingThread(MemoryBudget *budget, qint64 bytes)
+        : budget(budget), bytes(bytes) {}
+
+protected:
+    void run() {
+        msleep(50);
+        budget->release(bytes);
+    }
+
+private:
+    MemoryBudget *budget;
+    qint64 bytes;
+};
+
+void MemoryBudgetTest::acquire_release() {
+    MemoryBudget budget(100);
+    QCOMPARE(budget.capacity(), qint64(100));
+    QVERIFY(budget.acquire(60));
+    QVERIFY(budget.acquire(40));
+    QCOMPARE(budget.usedBytes(), qint64(100));
+    budget.release(60);
+    QCOMPARE(budget.usedBytes(), qint64(40));
+    budget.release(40);
+    QCOMPARE(budget.usedBytes(), qint64(0));
+}
+
+void MemoryBudgetTest::acquire_unlimited() {
+    MemoryBudget budget;
+    QVERIFY(budget.fits(Q_INT64_C(1) << 50));
+    QVERIFY(budget.acquire(Q_INT64_C(1) << 50, 0));
+}
+
+void MemoryBudgetTest::acquire_neverFits() {
+    MemoryBudget budget(100);
+    QVERIFY(!budget.fits(101));
+    // returns immediately instead of waiting forever
+    QVERIFY(!budget.acquire(101));
+    QCOMPARE(budget.usedBytes(), qint64(0));
+}
+
+void MemoryBudgetTest::acquire_timeout() {
+    MemoryBudget budget(100);
+    QVERIFY(budget.acquire(80));
+    QVERIFY(budget.fits(50));
+    QVERIFY(!budget.acquire(50, 10));
+    QCOMPARE(budget.usedBytes(), qint64(80));
+}
+
+void MemoryBudgetTest::acquire_waitsForRelease() {
+    MemoryBudget budget(100);
+    QVERIFY(budget.acquire(80));
+    ReleasingThread thread(&budget, 80);
+    thread.start();
+    QVERIFY(budget.acquire(50, 5000));
+    QVERIFY(thread.wait(5000));
+    QCOMPARE(budget.usedBytes(), qint64(50));
+}
+
+void MemoryBudgetTest::reservation() {
+    MemoryBudget budget(100);
+    {
+        MemoryReservation reservation(&budget);
+        QVERIFY(budget.acquire(30));
+        reservation.reserved(30);
+        QCOMPARE(budget.usedBytes(), qint64(30));
+    }
+    QCOMPARE(budget.usedBytes(), qint64(0));
+}
+
+QTEST_APPLESS_MAIN(MemoryBudgetTest)
+#include "MemoryBudgetTest.moc"
@@ -0,0 +1,175 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/PixelBufferPoolTest.hpp"
+
+#include <QBuffer>
+#include <QImageReader>
+
+
+void PixelBufferPoolTest::sizeClass_data() {
+    QTest::addColumn<qint64>("bytes");
+    QTest::addColumn<qint64>("result");
+
+    const qint64 min = PixelBufferPool::minPooledBytes;
+    QTest::newRow("tiny") << qint64(1) << min;
+    QTest::newRow("minimum") << min << min;
+    QTest::newRow("above minimum") << min + 1 << min + min / 4;
+    QTest::newRow("power of two") << 4 * min << 4 * min;
+    QTest::newRow("quarter") << 4 * min + 1 << 5 * min;
+    QTest::newRow("three quarters") << 7 * min - 1 << 7 * min;
+    QTest::newRow("large") << (Q_INT64_C(3) << 30) + 1
+                           << (Q_INT64_C(7) << 29);
+}
+
+void PixelBufferPoolTest::sizeClass() {
+    QFETCH(qint64, bytes);
+    QFETCH(qint64, result);
+    QCOMPARE(PixelBufferPool::sizeClass(bytes), result);
+}
+
+void PixelBufferPoolTest::image_reused() {
+    PixelBufferPool pool;
+    const uchar *bits = 0;
+    {
+        QImage image = pool.image(QSize(512, 512), QImage::Format_ARGB32);
+        QCOMPARE(image.size(), QSize(512, 512));
+        QCOMPARE(image.format(), QImage::Format_ARGB32);
+        image.fill(Qt::red);
+        bits = image.constBits();
+    }
+    QCOMPARE(pool.statistics().allocations, qint64(1));
+    QCOMPARE(pool.statistics().cachedBytes,
+             PixelBufferPool::sizeClass(512 * 512 * 4));
+
+    // slightly smaller image of the same size class
+    QImage image = pool.image(QSize(500, 510), QImage::Format_RGB32);
+    QCOMPARE(image.constBits(), bits);
+    QCOMPARE(image.bytesPerLine(), 500 * 4);
+    image.fill(Qt::blue);
+    QCOMPARE(image.pixel(499, 509), QColor(Qt::blue).rgb());
+    QCOMPARE(pool.statistics().allocations, qint64(1));
+    QCOMPARE(pool.statistics().reuses, qint64(1));
+    QCOMPARE(pool.statistics().cachedBytes, qint64(0));
+}
+
+void PixelBufferPoolTest::image_shared() {
+    PixelBufferPool pool;
+    QImage image = pool.image(QSize(256, 256), QImage::Format_RGB32);
+    QImage copy = image;
+    image = QImage();
+    // the buffer is still used by the copy
+    QImage other = pool.image(QSize(256, 256), QImage::Format_RGB32);
+    QVERIFY(other.constBits() != copy.constBits());
+    QCOMPARE(pool.statistics().allocations, qint64(2));
+    copy = QImage();
+    QCOMPARE(pool.statistics().cachedBytes, qint64(256 * 256 * 4));
+}
+
+void PixelBufferPoolTest::image_small() {
+    PixelBufferPool pool;
+    QImage image = pool.image(QSize(16, 16), QImage::Format_ARGB32);
+    QCOMPARE(image.size(), QSize(16, 16));
+    QCOMPARE(pool.statistics().allocations, qint64(0));
+    QVERIFY(pool.image(QSize(), QImage::Format_RGB32).isNull());
+    QVERIFY(pool.image(QSize(512, 512), QImage::Format_Invalid).isNull());
+}
+
+void PixelBufferPoolTest::image_outlivesPool() {
+    QImage image;
+    {
+        PixelBufferPool pool;
+        image = pool.image(QSize(300, 300), QImage::Format_RGB32);
+    }
+    image.fill(Qt::green);
+    QCOMPARE(image.pixel(299, 299), QColor(Qt::green).rgb());
+}
+
+void PixelBufferPoolTest::capacity() {
+    const qint64 bytes = 512 * 512 * 4;
+    PixelBufferPool pool(bytes);
+    QCOMPARE(pool.capacity(), bytes);
+    {
+        QImage first = pool.image(QSize(512, 512), QImage::Format_RGB32);
+        QImage second = pool.image(QSize(512, 512), QImage::Format_RGB32);
+    }
+    // the second buffer doesn't fit the capacity
+    QCOMPARE(pool.statistics().cachedBytes, bytes);
+    pool.setCapacity(0);
+    QCOMPARE(pool.statistics().cachedBytes, qint64(0));
+    pool.image(QSize(512, 512), QImage::Format_RGB32);
+    QCOMPARE(pool.statistics().allocations, qint64(3));
+    QCOMPARE(pool.statistics().cachedBytes, qint64(0));
+}
+
+void PixelBufferPoolTest::trim() {
+    PixelBufferPool pool;
+    pool.image(QSize(512, 512), QImage::Format_RGB32);
+    QVERIFY(pool.statistics().cachedBytes > 0);
+    pool.trim();
+    QCOMPARE(pool.statistics().cachedBytes, qint64(0));
+    QCOMPARE(pool.capacity(), PixelBufferPool::defaultCapacity);
+}
+
+void PixelBufferPoolTest::read() {
+    QImage source(400, 300, QImage::Format_RGB32);
+    for (int y=0; y<source.height(); y++)
+        for (int x=0; x<source.width(); x++)
+            source.setPixel(x, y, qRgb(x % 256, y % 256, 128));
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(source.save(&buffer, "png"));
+    buffer.close();
+
+    PixelBufferPool pool;
+    for (int i=0; i<2; i++) {
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader(&buffer, "png");
+        QImage image = pool.image(reader.size(), reader.imageFormat());
+        QVERIFY(reader.read(&image));
+        QCOMPARE(image.size(), source.size());
+        QCOMPARE(image.pixel(399, 299), source.pixel(399, 299));
+        QCOMPARE(image.pixel(100, 200), source.pixel(100, 200));
+        buffer.close();
+    }
+    QCOMPARE(pool.statistics().allocations, qint64(1));
+    QCOMPARE(pool.statistics().reuses, qint64(1));
+}
+
+void PixelBufferPoolTest::pageFaults() {
+    PixelBufferPool pool;
+    pool.addPageFaults(10);
+    pool.addPageFaults(-5);
+    pool.addPageFaults(2);
+    QCOMPARE(pool.statistics().pageFaults, qint64(12));
+#ifdef Q_OS_LINUX
+    QVERIFY(PixelBufferPool::threadPageFaults() >= 0);
+#endif // Q_OS_LINUX
+
+    PixelBufferPool::Statistics sum = pool.statistics();
+    sum += pool.statistics();
+    QCOMPARE(sum.pageFaults, qint64(24));
+}
+
+QTEST_APPLESS_MAIN(PixelBufferPoolTest)
+#include "PixelBufferPoolTest.moc"
@@ -0,0 +1,322 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/ResamplerTest.hpp"
+
+#include "CancellationToken.hpp"
+#include "PixelBufferPool.hpp"
+#include "tests/TestHelpers.hpp"
+
+
+void ResamplerTest::filterWeight_data() {
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<double>("x");
+    QTest::addColumn<double>("weight");
+
+    QTest::newRow("box center") << int(Resampler::Box) << 0. << 1.;
+    QTest::newRow("box right edge") << int(Resampler::Box) << .5 << 1.;
+    QTest::newRow("box left edge") << int(Resampler::Box) << -.5 << 0.;
+    QTest::newRow("bilinear") << int(Resampler::Bilinear) << -.25 << .75;
+    QTest::newRow("bilinear support") << int(Resampler::Bilinear) << 1. << 0.;
+    QTest::newRow("bicubic center") << int(Resampler::Bicubic) << 0. << 1.;
+    QTest::newRow("bicubic half") << int(Resampler::Bicubic) << .5 << .5625;
+    QTest::newRow("bicubic lobe") << int(Resampler::Bicubic) << -1.5
+                                  << -.0625;
+    QTest::newRow("bicubic support") << int(Resampler::Bicubic) << 2. << 0.;
+    QTest::newRow("lanczos3 center") << int(Resampler::Lanczos3) << 0. << 1.;
+    QTest::newRow("lanczos3 half") << int(Resampler::Lanczos3) << .5
+                                   << .607927;
+    QTest::newRow("lanczos3 zero") << int(Resampler::Lanczos3) << 2. << 0.;
+    QTest::newRow("lanczos3 support") << int(Resampler::Lanczos3) << 3.5
+                                      << 0.;
+}
+
+void ResamplerTest::filterWeight() {
+    QFETCH(int, filter);
+    QFETCH(double, x);
+    QFETCH(double, weight);
+
+    const Resampler::Filter kernel = Resampler::toFilter(filter);
+    QVERIFY(qAbs(Resampler::filterWeight(kernel, x) - weight) < 1e-5);
+    QVERIFY(qAbs(x) < Resampler::filterSupport(kernel) || weight == 0.);
+}
+
+void ResamplerTest::toFilter() {
+    QCOMPARE(Resampler::toFilter(0), Resampler::Box);
+    QCOMPARE(Resampler::toFilter(3), Resampler::Lanczos3);
+    QCOMPARE(Resampler::toFilter(-1), Resampler::Bicubic);
+    QCOMPARE(Resampler::toFilter(Resampler::FilterCount), Resampler::Bicubic);
+    QCOMPARE(Resampler().filter(), Resampler::Bicubic);
+}
+
+void ResamplerTest::scaled_sameSize() {
+    const QImage image = TestImages::edges(31, 17);
+    QCOMPARE(Resampler(Resampler::Lanczos3).scaled(image, image.size()),
+             image);
+    QVERIFY(Resampler().scaled(image, QSize(0, 10)).isNull());
+    QVERIFY(Resampler().scaled(QImage(), QSize(10, 10)).isNull());
+}
+
+void ResamplerTest::scaled_boxUpscale() {
+    const QImage image = TestImages::edges(5, 4);
+    const QImage result = Resampler(Resampler::Box).scaled(image,
+                                                           QSize(10, 8));
+    QCOMPARE(result.size(), QSize(10, 8));
+    for (int y=0; y<result.height(); y++) {
+        for (int x=0; x<result.width(); x++)
+            QCOMPARE(result.pixel(x, y), image.pixel(x / 2, y / 2));
+    }
+}
+
+void ResamplerTest::scaled_boxAverage() {
+    QImage image(4, 2, QImage::Format_RGB32);
+    const int reds[8] = { 0, 100, 10, 10, 0, 100, 30, 50 };
+    for (int i=0; i<8; i++)
+        image.setPixel(i % 4, i / 4, qRgb(reds[i], 0, 0));
+    const QImage result = Resampler(Resampler::Box).scaled(image,
+                                                           QSize(2, 1));
+    QCOMPARE(qRed(result.pixel(0, 0)), 50);
+    QCOMPARE(qRed(result.pixel(1, 0)), 25);
+}
+
+void ResamplerTest::scaled_solidColor_data() {
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<QSize>("size");
+
+    const char *names[Resampler::FilterCount] = {
+        "box", "bilinear", "bicubic", "lanczos3"
+    };
+    for (int i=0; i<Resampler::FilterCount; i++) {
+        const QByteArray name(names[i]);
+        QTest::newRow(QByteArray(name + " downscale").constData())
+                << i << QSize(20, 9);
+        QTest::newRow(QByteArray(name + " upscale").constData())
+                << i << QSize(101, 77);
+        QTest::newRow(QByteArray(name + " mixed").constData())
+                << i << QSize(13, 90);
+    }
+}
+
+void ResamplerTest::scaled_solidColor() {
+    QFETCH(int, filter);
+    QFETCH(QSize, size);
+
+    // negative lobes of sharp filters don't change solid color
+    QImage image(57, 31, QImage::Format_RGB32);
+    image.fill(qRgb(200, 100, 50));
+    Resampler resampler(Resampler::toFilter(filter));
+    const QImage result = resampler.scaled(image, size);
+    QCOMPARE(result.size(), size);
+    for (int y=0; y<result.height(); y++) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(
+                    result.constScanLine(y));
+        for (int x=0; x<result.width(); x++)
+            QCOMPARE(line[x], qRgb(200, 100, 50));
+    }
+}
+
+void ResamplerTest::scaled_instructionSets_data() {
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<bool>("alpha");
+    QTest::addColumn<QSize>("sourceSize");
+    QTest::addColumn<QSize>("targetSize");
+
+    const char *names[Resampler::FilterCount] = {
+        "box", "bilinear", "bicubic", "lanczos3"
+    };
+    for (int i=0; i<Resampler::FilterCount; i++) {
+        const QByteArray name(names[i]);
+        QTest::newRow(QByteArray(name + " odd downscale").constData())
+                << i << false << QSize(637, 481) << QSize(123, 77);
+        QTest::newRow(QByteArray(name + " upscale").constData())
+                << i << true << QSize(37, 23) << QSize(80, 51);
+        QTest::newRow(QByteArray(name + " narrow").constData())
+                << i << true << QSize(9, 200) << QSize(31, 20);
+    }
+}
+
+void ResamplerTest::scaled_instructionSets() {
+    QFETCH(int, filter);
+    QFETCH(bool, alpha);
+    QFETCH(QSize, sourceSize);
+    QFETCH(QSize, targetSize);
+
+    const QImage image = TestImages::edges(sourceSize.width(),
+                                           sourceSize.height(), alpha);
+    Resampler resampler(Resampler::toFilter(filter));
+    resampler.setInstructionSet(Resampler::Generic);
+    QCOMPARE(resampler.instructionSet(), Resampler::Generic);
+    const QImage expected = resampler.scaled(image, targetSize);
+    QCOMPARE(expected.size(), targetSize);
+    // SIMD code gives exactly the same pixels
+    for (int set=Resampler::Sse2; set<=Resampler::supportedInstructionSet();
+         set++) {
+        resampler.setInstructionSet(Resampler::InstructionSet(set));
+        QCOMPARE(resampler.scaled(image, targetSize), expected);
+    }
+}
+
+void ResamplerTest::scaled_alpha() {
+    const QImage image = TestImages::edges(64, 48, true);
+    const QImage result = Resampler(Resampler::Lanczos3).scaled(
+                image, QSize(150, 20));
+    QCOMPARE(result.format(), QImage::Format_ARGB32_Premultiplied);
+    // ringing of premultiplied colors never exceeds alpha
+    for (int y=0; y<result.height(); y++) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(
+                    result.constScanLine(y));
+        for (int x=0; x<result.width(); x++) {
+            QVERIFY(qRed(line[x]) <= qAlpha(line[x]));
+            QVERIFY(qGreen(line[x]) <= qAlpha(line[x]));
+            QVERIFY(qBlue(line[x]) <= qAlpha(line[x]));
+        }
+    }
+}
+
+void ResamplerTest::scaled_passOrder() {
+    const QImage image = TestImages::edges(120, 90);
+    Resampler resampler(Resampler::Bilinear);
+    const QImage horizontalFirst = resampler.scaledVertically(
+                resampler.scaledHorizontally(image, 50), 70);
+    const QImage verticalFirst = resampler.scaledHorizontally(
+                resampler.scaledVertically(image, 70), 50);
+    QCOMPARE(resampler.scaled(image, QSize(50, 70)).size(), QSize(50, 70));
+    // both orders differ by rounding of intermediate image only
+    for (int y=0; y<70; y++) {
+        for (int x=0; x<50; x++) {
+            const QRgb a = horizontalFirst.pixel(x, y);
+            const QRgb b = verticalFirst.pixel(x, y);
+            QVERIFY(qAbs(qRed(a) - qRed(b)) <= 1);
+            QVERIFY(qAbs(qGreen(a) - qGreen(b)) <= 1);
+            QVERIFY(qAbs(qBlue(a) - qBlue(b)) <= 1);
+        }
+    }
+}
+
+void ResamplerTest::scaled_bands() {
+    const QImage image = TestImages::edges(2000, 1500);
+    const QSize size(640, 480);
+    Resampler resampler;
+    const QImage expected = resampler.scaled(image, size);
+    SerialBandExecutor executor;
+    resampler.setBandExecutor(&executor);
+    QCOMPARE(resampler.scaled(image, size), expected);
+    QVERIFY(executor.calls > 0);
+}
+
+void ResamplerTest::scaled_qtSmooth() {
+    // sharp edges are filter specific
+    const QImage image = TestImages::smooth(2000, 1500);
+    const QSize size(640, 480);
+    Resampler resampler(Resampler::Box);
+    SerialBandExecutor executor;
+    resampler.setBandExecutor(&executor);
+    const QImage result = resampler.scaled(image, size);
+    const QImage expected = image.scaled(size, Qt::IgnoreAspectRatio,
+                                         Qt::SmoothTransformation);
+    QVERIFY(executor.calls > 0);
+    QCOMPARE(result.size(), size);
+
+    // both average source area, only rounding differs
+    const int tolerance = 2;
+    for (int y=0; y<size.height(); y++) {
+        for (int x=0; x<size.width(); x++) {
+            QRgb a = result.pixel(x, y);
+            QRgb b = expected.pixel(x, y);
+            QVERIFY(qAbs(qRed(a) - qRed(b)) <= tolerance);
+            QVERIFY(qAbs(qGreen(a) - qGreen(b)) <= tolerance);
+            QVERIFY(qAbs(qBlue(a) - qBlue(b)) <= tolerance);
+        }
+    }
+}
+
+void ResamplerTest::scaled_cancelled() {
+    const QImage image = TestImages::edges(2000, 1500);
+    SerialBandExecutor executor;
+    CancellationToken token;
+    token.cancel();
+    Resampler resampler;
+    resampler.setBandExecutor(&executor);
+    resampler.setCancellationToken(&token);
+    QVERIFY(resampler.scaled(image, QSize(640, 480)).isNull());
+    QCOMPARE(executor.calls, 0);
+}
+
+void ResamplerTest::scaled_bufferPool() {
+    const QImage image = TestImages::edges(800, 600);
+    PixelBufferPool pool;
+    Resampler resampler;
+    resampler.setBufferPool(&pool);
+    QImage result = resampler.scaled(image, QSize(640, 480));
+    QCOMPARE(result, Resampler().scaled(image, QSize(640, 480)));
+    QVERIFY(pool.statistics().allocations > 0);
+    result = QImage();
+    resampler.scaled(image, QSize(640, 480));
+    QVERIFY(pool.statistics().reuses > 0);
+}
+
+void ResamplerTest::scaled_benchmark_data() {
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<int>("instructionSet");
+
+    // -1 filter is the QImage::scaled() baseline
+    QTest::newRow("qt smooth") << -1 << int(Resampler::Generic);
+    QTest::newRow("bilinear generic") << int(Resampler::Bilinear)
+                                      << int(Resampler::Generic);
+    QTest::newRow("bicubic generic") << int(Resampler::Bicubic)
+                                     << int(Resampler::Generic);
+    QTest::newRow("box") << int(Resampler::Box) << int(Resampler::Avx2);
+    QTest::newRow("bilinear") << int(Resampler::Bilinear)
+                              << int(Resampler::Avx2);
+    QTest::newRow("bicubic") << int(Resampler::Bicubic)
+                             << int(Resampler::Avx2);
+    QTest::newRow("lanczos3") << int(Resampler::Lanczos3)
+                              << int(Resampler::Avx2);
+}
+
+void ResamplerTest::scaled_benchmark() {
+    QFETCH(int, filter);
+    QFETCH(int, instructionSet);
+
+    const QImage image = TestImages::edges(3000, 2000);
+    const QSize size(1024, 683);
+    QImage result;
+    if (filter < 0) {
+        QBENCHMARK {
+            result = image.scaled(size, Qt::IgnoreAspectRatio,
+                                  Qt::SmoothTransformation);
+        }
+    }
+    else {
+        Resampler resampler(Resampler::toFilter(filter));
+        // unsupported instruction set falls back to the best supported one
+        resampler.setInstructionSet(
+                    Resampler::InstructionSet(instructionSet));
+        QBENCHMARK {
+            result = resampler.scaled(image, size);
+        }
+    }
+    QCOMPARE(result.size(), size);
+}
+
+QTEST_APPLESS_MAIN(ResamplerTest)
+#include "ResamplerTest.moc"
@@ -0,0 +1,55 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef RESAMPLERTEST_HPP
+#define RESAMPLERTEST_HPP
+
+#include <QtTest/QTest>
+
+#include "Resampler.hpp"
+
+
+class ResamplerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void filterWeight_data();
+    void filterWeight();
+    void toFilter();
+    void scaled_sameSize();
+    void scaled_boxUpscale();
+    void scaled_boxAverage();
+    void scaled_solidColor_data();
+    void scaled_solidColor();
+    void scaled_instructionSets_data();
+    void scaled_instructionSets();
+    void scaled_alpha();
+    void scaled_passOrder();
+    void scaled_bands();
+    void scaled_qtSmooth();
+    void scaled_cancelled();
+    void scaled_bufferPool();
+    void scaled_benchmark_data();
+    void scaled_benchmark();
+};
+
+#endif // RESAMPLERTEST_HPP
@@ -0,0 +1,150 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/StripReaderTest.hpp"
+#include "StripWriter.hpp"
+
+#include <QDir>
+#include <QImage>
+#include <QScopedPointer>
+#include <QVector>
+
+
+/** Returns test image with distinct colors of each pixel. */
+static QImage testImage(int width, int height) {
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y=0; y<height; y++)
+        for (int x=0; x<width; x++)
+            image.setPixel(x, y, qRgb(x * 20, y * 30, (x + y) * 10));
+    return image;
+}
+
+void StripReaderTest::init() {
+    filePath = QDir::temp().filePath("sir_strip_reader_test");
+}
+
+void StripReaderTest::cleanup() {
+    QFile::remove(filePath);
+}
+
+void StripReaderTest::readRow_data() {
+    QTest::addColumn<QByteArray>("format");
+
+    QTest::newRow("ppm") << QByteArray("ppm");
+    QTest::newRow("bmp") << QByteArray("bmp");
+}
+
+void StripReaderTest::readRow() {
+    QFETCH(QByteArray, format);
+
+    const QImage image = testImage(7, 5);
+    QVERIFY(image.save(filePath, format.constData()));
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, format));
+    QVERIFY(reader);
+    QCOMPARE(reader->size(), image.size());
+    QVERIFY(!reader->hasAlphaChannel());
+    QVector<QRgb> row(image.width());
+    for (int y=0; y<image.height(); y++) {
+        QCOMPARE(reader->currentRow(), y);
+        QVERIFY(reader->readRow(row.data()));
+        for (int x=0; x<image.width(); x++)
+            QCOMPARE(row.at(x), image.pixel(x, y));
+    }
+    QVERIFY(!reader->readRow(row.data()));
+}
+
+void StripReaderTest::pgm16Bit() {
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("P5\n# comment\n3 1\n65535\n");
+    file.write(QByteArray("\xFF\xFF\x80\x80\0\0", 6));
+    file.close();
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "pgm"));
+    QVERIFY(reader);
+    QCOMPARE(reader->size(), QSize(3, 1));
+    QVector<QRgb> row(3);
+    QVERIFY(reader->readRow(row.data()));
+    QCOMPARE(row.at(0), qRgb(255, 255, 255));
+    QCOMPARE(row.at(1), qRgb(128, 128, 128));
+    QCOMPARE(row.at(2), qRgb(0, 0, 0));
+}
+
+void StripReaderTest::tiffAlpha() {
+    const QSize size(300, 500);
+    QScopedPointer<StripWriter> writer(
+                StripWriter::create(filePath, "tif", size, true));
+    QVERIFY(writer);
+    QVector<QRgb> row(size.width());
+    for (int y=0; y<size.height(); y++) {
+        for (int x=0; x<size.width(); x++)
+            row[x] = qPremultiply(qRgba(x % 256, y % 256, 50, y % 256));
+        QVERIFY(writer->writeRow(row.constData()));
+    }
+    QVERIFY(writer->finish());
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "tiff"));
+    QVERIFY(reader);
+    QCOMPARE(reader->size(), size);
+    QVERIFY(reader->hasAlphaChannel());
+    // rows of several strips
+    for (int y=0; y<size.height(); y++) {
+        QVERIFY(reader->readRow(row.data()));
+        for (int x=0; x<size.width(); x += 37)
+            QCOMPARE(row.at(x), qPremultiply(qRgba(x % 256, y % 256, 50,
+                                                   y % 256)));
+    }
+}
+
+void StripReaderTest::skipRows() {
+    const QImage image = testImage(4, 6);
+    QVERIFY(image.save(filePath, "bmp"));
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "bmp"));
+    QVERIFY(reader);
+    reader->skipRows(4);
+    QCOMPARE(reader->currentRow(), 4);
+    QVector<QRgb> row(image.width());
+    QVERIFY(reader->readRow(row.data()));
+    QCOMPARE(row.at(3), image.pixel(3, 4));
+    reader->skipRows(10);
+    QCOMPARE(reader->currentRow(), image.height());
+    QVERIFY(!reader->readRow(row.data()));
+}
+
+void StripReaderTest::unsupported() {
+    QVERIFY(StripReader::isStreamable("tiff"));
+    QVERIFY(!StripReader::isStreamable("png"));
+
+    QImage image = testImage(4, 4);
+    QVERIFY(image.save(filePath, "png"));
+    QVERIFY(!StripReader::open(filePath, "png"));
+    // PNG file isn't valid BMP nor TIFF file
+    QVERIFY(!StripReader::open(filePath, "bmp"));
+    QVERIFY(!StripReader::open(filePath, "tiff"));
+    QVERIFY(!StripReader::open(QDir::temp().filePath("sir_missing.ppm"),
+                               "ppm"));
+}
+
+QTEST_MAIN(StripReaderTest)
+#include "StripReaderTest.moc"
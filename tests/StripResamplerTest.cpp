@@ -0,0 +1,209 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/StripResamplerTest.hpp"
+
+#include "tests/TestHelpers.hpp"
+
+#include <QVector>
+
+
+void StripResamplerTest::sameSize() {
+    const QSize size(5, 4);
+    StripResampler resampler(size, size);
+    QVector<QRgb> row(size.width());
+    for (int y=0; y<size.height(); y++) {
+        for (int x=0; x<size.width(); x++)
+            row[x] = qRgb(x * 40, y * 60, 7);
+        resampler.pushRow(row.constData());
+        QVERIFY(resampler.takeRow(row.data()));
+        for (int x=0; x<size.width(); x++)
+            QCOMPARE(row.at(x), qRgb(x * 40, y * 60, 7));
+        QVERIFY(!resampler.takeRow(row.data()));
+    }
+}
+
+void StripResamplerTest::constantColor_data() {
+    QTest::addColumn<QSize>("sourceSize");
+    QTest::addColumn<QSize>("targetSize");
+
+    QTest::newRow("downscale") << QSize(1000, 10) << QSize(37, 3);
+    QTest::newRow("upscale") << QSize(3, 2) << QSize(17, 11);
+    QTest::newRow("mixed") << QSize(40, 3) << QSize(7, 9);
+}
+
+void StripResamplerTest::constantColor() {
+    QFETCH(QSize, sourceSize);
+    QFETCH(QSize, targetSize);
+
+    StripResampler resampler(sourceSize, targetSize);
+    QCOMPARE(resampler.sourceSize(), sourceSize);
+    QCOMPARE(resampler.targetSize(), targetSize);
+    const QVector<QRgb> source(sourceSize.width(), qRgb(200, 100, 50));
+    QVector<QRgb> target(targetSize.width());
+    int taken = 0;
+    for (int y=0; y<sourceSize.height(); y++) {
+        resampler.pushRow(source.constData());
+        while (resampler.takeRow(target.data())) {
+            foreach (QRgb pixel, target)
+                QCOMPARE(pixel, qRgb(200, 100, 50));
+            taken++;
+        }
+    }
+    QCOMPARE(taken, targetSize.height());
+}
+
+void StripResamplerTest::incrementalRows() {
+    // memory of the resampler depends on scale factor, not image height
+    const QSize sourceSize(64, 100000);
+    const QSize targetSize(16, 1000);
+    StripResampler resampler(sourceSize, targetSize);
+    QVERIFY(resampler.windowSize() <= 2 * 100 + 3);
+
+    const QVector<QRgb> source(sourceSize.width(), qRgb(1, 2, 3));
+    QVector<QRgb> target(targetSize.width());
+    int taken = 0;
+    for (int y=0; y<sourceSize.height(); y++) {
+        resampler.pushRow(source.constData());
+        while (resampler.takeRow(target.data()))
+            taken++;
+        // target rows are produced before the whole image is read
+        if (y == sourceSize.height() / 2)
+            QVERIFY(taken >= targetSize.height() / 2 - 2);
+    }
+    QCOMPARE(taken, targetSize.height());
+}
+
+void StripResamplerTest::premultipliedAlpha() {
+    StripResampler resampler(QSize(4, 1), QSize(2, 1));
+    const QRgb source[4] = {
+        qRgba(255, 0, 0, 255), 0,
+        qRgba(255, 0, 0, 255), qPremultiply(qRgba(0, 0, 255, 64))
+    };
+    resampler.pushRow(source);
+    QRgb target[2];
+    QVERIFY(resampler.takeRow(target));
+    for (int x=0; x<2; x++) {
+        QVERIFY(qRed(target[x]) <= qAlpha(target[x]));
+        QVERIFY(qGreen(target[x]) <= qAlpha(target[x]));
+        QVERIFY(qBlue(target[x]) <= qAlpha(target[x]));
+    }
+    // transparent pixel doesn't darken colors
+    QCOMPARE(qRed(qUnpremultiply(target[0])), 255);
+    QCOMPARE(qGreen(qUnpremultiply(target[0])), 0);
+}
+
+void StripResamplerTest::averageOfCoveredPixels() {
+    // pixels of 2x2 downscaled checkerboard are gray
+    StripResampler resampler(QSize(8, 8), QSize(4, 4));
+    QVector<QRgb> row(8);
+    QVector<QRgb> target(4);
+    for (int y=0; y<8; y++) {
+        for (int x=0; x<8; x++)
+            row[x] = ((x + y) % 2) ? qRgb(255, 255, 255) : qRgb(0, 0, 0);
+        resampler.pushRow(row.constData());
+        while (resampler.takeRow(target.data())) {
+            foreach (QRgb pixel, target)
+                QVERIFY(qAbs(qGray(pixel) - 128) <= 32);
+        }
+    }
+}
+
+void StripResamplerTest::filters_data() {
+    QTest::addColumn<int>("filter");
+
+    QTest::newRow("box") << int(Resampler::Box);
+    QTest::newRow("bilinear") << int(Resampler::Bilinear);
+    QTest::newRow("bicubic") << int(Resampler::Bicubic);
+    QTest::newRow("lanczos3") << int(Resampler::Lanczos3);
+}
+
+void StripResamplerTest::filters() {
+    QFETCH(int, filter);
+
+    // negative lobes of sharp filters don't change solid color
+    const QSize sourceSize(40, 9);
+    const QSize targetSize(13, 31);
+    StripResampler resampler(sourceSize, targetSize,
+                             Resampler::toFilter(filter));
+    const QVector<QRgb> source(sourceSize.width(), qRgb(200, 100, 50));
+    QVector<QRgb> target(targetSize.width());
+    int taken = 0;
+    for (int y=0; y<sourceSize.height(); y++) {
+        resampler.pushRow(source.constData());
+        while (resampler.takeRow(target.data())) {
+            foreach (QRgb pixel, target)
+                QCOMPARE(pixel, qRgb(200, 100, 50));
+            taken++;
+        }
+    }
+    QCOMPARE(taken, targetSize.height());
+}
+
+void StripResamplerTest::sameAsResampler_data() {
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<QSize>("targetSize");
+    QTest::addColumn<bool>("alpha");
+
+    const QSize down(97, 61);
+    const QSize up(582, 366);
+    for (int i=0; i<Resampler::FilterCount; i++) {
+        const QByteArray name = QByteArray::number(i);
+        QTest::newRow(QByteArray("downscale " + name).constData())
+                << i << down << false;
+        QTest::newRow(QByteArray("upscale " + name).constData())
+                << i << up << false;
+        QTest::newRow(QByteArray("alpha " + name).constData())
+                << i << down << true;
+    }
+}
+
+void StripResamplerTest::sameAsResampler() {
+    QFETCH(int, filter);
+    QFETCH(QSize, targetSize);
+    QFETCH(bool, alpha);
+
+    // the same scale factor of both dimensions makes Resampler scale rows
+    // first like StripResampler
+    const QImage image = TestImages::edges(291, 183, alpha);
+    const Resampler::Filter kernel = Resampler::toFilter(filter);
+    const QImage expected = Resampler(kernel).scaled(image, targetSize);
+
+    StripResampler resampler(image.size(), targetSize, kernel);
+    QVector<QRgb> target(targetSize.width());
+    int taken = 0;
+    for (int y=0; y<image.height(); y++) {
+        resampler.pushRow(reinterpret_cast<const QRgb *>(
+                              image.constScanLine(y)));
+        while (resampler.takeRow(target.data())) {
+            const QRgb *line = reinterpret_cast<const QRgb *>(
+                        expected.constScanLine(taken));
+            for (int x=0; x<targetSize.width(); x++)
+                QCOMPARE(target.at(x), line[x]);
+            taken++;
+        }
+    }
+    QCOMPARE(taken, targetSize.height());
+}
+
+QTEST_APPLESS_MAIN(StripResamplerTest)
+#include "StripResamplerTest.moc"
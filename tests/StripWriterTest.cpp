@@ -0,0 +1,115 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/StripWriterTest.hpp"
+
+#include <QDir>
+#include <QImageReader>
+#include <QScopedPointer>
+#include <QVector>
+
+
+/** Returns color of test image pixel. */
+static QRgb testPixel(int x, int y) {
+    return qRgb(x * 20, y * 30, (x + y) * 10);
+}
+
+void StripWriterTest::init() {
+    filePath = QDir::temp().filePath("sir_strip_writer_test");
+}
+
+void StripWriterTest::cleanup() {
+    QFile::remove(filePath);
+}
+
+void StripWriterTest::writeRow_data() {
+    QTest::addColumn<QByteArray>("format");
+
+    QTest::newRow("ppm") << QByteArray("ppm");
+    QTest::newRow("bmp") << QByteArray("bmp");
+    QTest::newRow("tiff") << QByteArray("tiff");
+}
+
+void StripWriterTest::writeRow() {
+    QFETCH(QByteArray, format);
+    if (!QImageReader::supportedImageFormats().contains(format))
+        QSKIP("The format isn't supported by Qt image plugins");
+
+    const QSize size(7, 5);
+    QScopedPointer<StripWriter> writer(
+                StripWriter::create(filePath, format, size, false));
+    QVERIFY(writer);
+    QCOMPARE(writer->size(), size);
+    QVector<QRgb> row(size.width());
+    for (int y=0; y<size.height(); y++) {
+        for (int x=0; x<size.width(); x++)
+            row[x] = testPixel(x, y);
+        QVERIFY(writer->writeRow(row.constData()));
+    }
+    QVERIFY(!writer->writeRow(row.constData()));
+    QVERIFY(writer->finish());
+
+    // written file is readable by Qt
+    QImageReader reader(filePath, format);
+    const QImage image = reader.read();
+    QCOMPARE(image.size(), size);
+    for (int y=0; y<size.height(); y++)
+        for (int x=0; x<size.width(); x++)
+            QCOMPARE(image.pixel(x, y), testPixel(x, y));
+}
+
+void StripWriterTest::imageWriter() {
+    ImageStripWriter writer(QSize(3, 2), true);
+    const QRgb row[3] = { qRgba(10, 0, 0, 10), 0, qRgba(0, 0, 0, 255) };
+    QVERIFY(writer.writeRow(row));
+    QVERIFY(!writer.finish());
+    QVERIFY(writer.writeRow(row));
+    QVERIFY(writer.finish());
+
+    const QImage image = writer.image();
+    QCOMPARE(image.format(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(image.pixel(0, 1), qUnpremultiply(row[0]));
+    QCOMPARE(image.pixel(1, 1), row[1]);
+    QCOMPARE(image.pixel(2, 0), row[2]);
+}
+
+void StripWriterTest::incompleteImage() {
+    QScopedPointer<StripWriter> writer(
+                StripWriter::create(filePath, "tif", QSize(4, 4), false));
+    QVERIFY(writer);
+    QVector<QRgb> row(4, qRgb(1, 2, 3));
+    QVERIFY(writer->writeRow(row.constData()));
+    QCOMPARE(writer->currentRow(), 1);
+    QVERIFY(!writer->finish());
+}
+
+void StripWriterTest::unsupported() {
+    QVERIFY(StripWriter::isStreamable("bmp"));
+    QVERIFY(!StripWriter::isStreamable("jpg"));
+    QVERIFY(!StripWriter::create(filePath, "jpg", QSize(4, 4), false));
+    QVERIFY(!StripWriter::create(filePath, "ppm", QSize(), false));
+    // classic BMP and TIFF files are limited to 4 GiB
+    QVERIFY(!StripWriter::create(filePath, "tif", QSize(40000, 40000), true));
+}
+
+QTEST_MAIN(StripWriterTest)
+#include "StripWriterTest.moc"
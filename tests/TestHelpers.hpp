@@ -0,0 +1,109 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#ifndef TESTHELPERS_HPP
+#define TESTHELPERS_HPP
+
+#include <QImage>
+
+#include "ConvertBands.hpp"
+
+
+/** \brief Band executor running bands one by one in the calling thread.
+  *
+  * Bands run in reverse order, so tasks depending on order of bands fail.
+  */
+class SerialBandExecutor : public ConvertBandExecutor {
+public:
+    explicit SerialBandExecutor(int idleCount = 3)
+        : idleCount(idleCount), calls(0) {}
+
+    int idleThreadCount() const {
+        return idleCount;
+    }
+
+    void runBands(ConvertBandTask *task, int count, int bands) {
+        calls++;
+        for (int i=bands-1; i>=0; i--) {
+            int begin;
+            int end;
+            ConvertBands::bandRange(count, bands, i, &begin, &end);
+            task->run(begin, end);
+        }
+    }
+
+    int idleCount; /**< Count of threads reported by idleThreadCount(). */
+    int calls; /**< Count of runBands() calls. */
+};
+
+/** \brief Factory of synthetic images used by image processing tests. */
+class TestImages {
+public:
+    /** Returns image of \a format containing red and green gradients and
+      * repeated blue pattern.
+      */
+    static QImage gradient(int width, int height,
+                           QImage::Format format = QImage::Format_RGB32) {
+        QImage image(width, height, QImage::Format_RGB32);
+        for (int y=0; y<height; y++) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            for (int x=0; x<width; x++)
+                line[x] = qRgb(x * 255 / width, y * 255 / height,
+                               (x * y) % 256);
+        }
+        return image.convertToFormat(format);
+    }
+
+    /** Returns RGB32 image containing gradients only, so any smooth scaling
+      * gives nearly the same pixels.
+      */
+    static QImage smooth(int width, int height) {
+        QImage image(width, height, QImage::Format_RGB32);
+        for (int y=0; y<height; y++) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            for (int x=0; x<width; x++)
+                line[x] = qRgb(x * 255 / width, y * 255 / height,
+                               (x + y) * 255 / (width + height));
+        }
+        return image;
+    }
+
+    /** Returns image containing sharp edges, which make ringing of sharp
+      * filters visible. Image with \a alpha channel is premultiplied.
+      */
+    static QImage edges(int width, int height, bool alpha = false) {
+        QImage image(width, height,
+                     alpha ? QImage::Format_ARGB32_Premultiplied
+                           : QImage::Format_RGB32);
+        for (int y=0; y<height; y++) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            for (int x=0; x<width; x++) {
+                const int a = alpha ? (x * 7 + y * 3) % 256 : 255;
+                const int edge = ((x / 5 + y / 3) % 2) ? a : 0;
+                line[x] = qRgba(x * a / width, edge, (x * y) % (a + 1), a);
+            }
+        }
+        return image;
+    }
+};
+
+#endif // TESTHELPERS_HPP
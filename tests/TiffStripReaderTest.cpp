@@ -0,0 +1,348 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+
+#include "tests/TiffStripReaderTest.hpp"
+
+#include <QDir>
+#include <QScopedPointer>
+#include <QtEndian>
+#include <QtAlgorithms>
+
+
+namespace {
+
+//! Directory entry of test TIFF file.
+struct Entry {
+    Entry(quint16 tag, quint16 type, const QVector<quint64> &values)
+        : tag(tag), type(type), values(values) {}
+    Entry(quint16 tag, quint64 value)
+        : tag(tag), type(4), values(1, value) {}
+
+    quint16 tag;
+    quint16 type;
+    QVector<quint64> values;
+
+    bool operator<(const Entry &other) const { return tag < other.tag; }
+};
+
+/** Appends \a value of \a size bytes in little endian byte order. */
+void appendValue(QByteArray *data, quint64 value, int size) {
+    for (int i=0; i<size; i++)
+        data->append(char(value >> (8 * i)));
+}
+
+/** Returns little endian TIFF file containing \a entries and \a blocks.
+  * Offsets of the blocks are stored in \a offsetsTag and their sizes in the
+  * matching byte counts tag.
+  */
+QByteArray tiffFile(bool bigTiff, QList<Entry> entries,
+                    const QList<QByteArray> &blocks, quint16 offsetsTag) {
+    const int offsetSize = bigTiff ? 8 : 4;
+    QByteArray file;
+    if (bigTiff)
+        file = QByteArray("II\x2B\0\x08\0\0\0", 8);
+    else
+        file = QByteArray("II\x2A\0", 4);
+    const int headerSize = bigTiff ? 16 : 8;
+    QVector<quint64> offsets;
+    QVector<quint64> sizes;
+    quint64 offset = headerSize;
+    foreach (const QByteArray &block, blocks) {
+        offsets.append(offset);
+        sizes.append(block.size());
+        offset += block.size();
+    }
+    const quint16 offsetType = bigTiff ? 16 : 4;
+    entries.append(Entry(offsetsTag, offsetType, offsets));
+    const quint16 countsTag = (offsetsTag == 273) ? 279 : offsetsTag + 1;
+    entries.append(Entry(countsTag, offsetType, sizes));
+    qSort(entries.begin(), entries.end());
+    // directory follows blocks and its long values follow the directory
+    const quint64 directoryOffset = offset;
+    appendValue(&file, directoryOffset, offsetSize);
+    foreach (const QByteArray &block, blocks)
+        file.append(block);
+    const int entrySize = bigTiff ? 20 : 12;
+    const quint64 valuesOffset = directoryOffset + (bigTiff ? 8 : 2)
+            + entries.size() * entrySize + offsetSize;
+    QByteArray values;
+    appendValue(&file, entries.size(), bigTiff ? 8 : 2);
+    foreach (const Entry &entry, entries) {
+        const int size = (entry.type == 3) ? 2 : (entry.type == 4) ? 4 : 8;
+        appendValue(&file, entry.tag, 2);
+        appendValue(&file, entry.type, 2);
+        appendValue(&file, entry.values.size(), offsetSize);
+        QByteArray field;
+        foreach (quint64 value, entry.values)
+            appendValue(&field, value, size);
+        if (field.size() <= offsetSize)
+            file.append(field.leftJustified(offsetSize, '\0'));
+        else {
+            appendValue(&file, valuesOffset + values.size(), offsetSize);
+            values.append(field);
+        }
+    }
+    appendValue(&file, 0, offsetSize);
+    file.append(values);
+    return file;
+}
+
+/** Returns \a data compressed by PackBits compression using literal runs. */
+QByteArray packBits(const QByteArray &data) {
+    QByteArray result;
+    for (int i=0; i<data.size(); i += 128) {
+        const QByteArray run = data.mid(i, 128);
+        result.append(char(run.size() - 1));
+        result.append(run);
+    }
+    return result;
+}
+
+/** Returns \a data compressed by Deflate compression. */
+QByteArray deflate(const QByteArray &data) {
+    // qCompress() prepends size of uncompressed data
+    return qCompress(data).mid(4);
+}
+
+/** Returns gray value of test image pixel. */
+uchar grayValue(int x, int y) {
+    return x * 40 + y * 10 + 5;
+}
+
+}
+
+
+void TiffStripReaderTest::init() {
+    filePath = QDir::temp().filePath("sir_tiff_strip_reader_test.tif");
+}
+
+void TiffStripReaderTest::cleanup() {
+    QFile::remove(filePath);
+}
+
+void TiffStripReaderTest::tiles_data() {
+    QTest::addColumn<bool>("bigTiff");
+    QTest::addColumn<int>("compression");
+    QTest::addColumn<int>("predictor");
+
+    QTest::newRow("uncompressed") << false << 1 << 1;
+    QTest::newRow("packbits bigtiff") << true << 32773 << 1;
+    QTest::newRow("deflate") << false << 8 << 1;
+    QTest::newRow("deflate predictor bigtiff") << true << 8 << 2;
+}
+
+void TiffStripReaderTest::tiles() {
+    QFETCH(bool, bigTiff);
+    QFETCH(int, compression);
+    QFETCH(int, predictor);
+
+    // 5x3 gray image in 2x2 tiles of 4x2 pixels padded by zeros
+    const QSize size(5, 3);
+    const QSize tile(4, 2);
+    QList<QByteArray> blocks;
+    for (int ty=0; ty<2; ty++) {
+        for (int tx=0; tx<2; tx++) {
+            QByteArray block(tile.width() * tile.height(), '\0');
+            for (int y=0; y<tile.height(); y++) {
+                for (int x=tile.width()-1; x>=0; x--) {
+                    const int imageX = tx * tile.width() + x;
+                    const int imageY = ty * tile.height() + y;
+                    uchar value = 0;
+                    if (imageX < size.width() && imageY < size.height())
+                        value = grayValue(imageX, imageY);
+                    block[y * tile.width() + x] = value;
+                }
+                // horizontal differencing
+                for (int x=tile.width()-1; predictor == 2 && x>0; x--)
+                    block[y * tile.width() + x] = block.at(y * tile.width() + x)
+                            - block.at(y * tile.width() + x - 1);
+            }
+            if (compression == 32773)
+                block = packBits(block);
+            else if (compression == 8)
+                block = deflate(block);
+            blocks.append(block);
+        }
+    }
+    QList<Entry> entries;
+    entries << Entry(256, size.width()) << Entry(257, size.height())
+            << Entry(258, 8) << Entry(259, compression) << Entry(262, 1)
+            << Entry(277, 1) << Entry(317, predictor)
+            << Entry(322, tile.width()) << Entry(323, tile.height());
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(tiffFile(bigTiff, entries, blocks, 324));
+    file.close();
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "tiff"));
+    QVERIFY(reader);
+    QCOMPARE(reader->size(), size);
+    QVERIFY(static_cast<TiffStripReader*>(reader.data())->isTiled());
+    QVector<QRgb> row(size.width());
+    for (int y=0; y<size.height(); y++) {
+        QVERIFY(reader->readRow(row.data()));
+        for (int x=0; x<size.width(); x++)
+            QCOMPARE(row.at(x), qRgb(grayValue(x, y), grayValue(x, y),
+                                     grayValue(x, y)));
+    }
+    QVERIFY(!reader->readRow(row.data()));
+}
+
+void TiffStripReaderTest::compressedStrips() {
+    // strips of single row decoded in several bands
+    const QSize size(3, 2 * TiffStripReader::minBandRows + 10);
+    QList<QByteArray> blocks;
+    for (int y=0; y<size.height(); y++) {
+        QByteArray strip;
+        for (int x=0; x<size.width(); x++)
+            strip.append(char(y % 256));
+        blocks.append(deflate(strip));
+    }
+    QList<Entry> entries;
+    entries << Entry(256, size.width()) << Entry(257, size.height())
+            << Entry(258, 8) << Entry(259, 32946) << Entry(262, 1)
+            << Entry(277, 1) << Entry(278, 1);
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(tiffFile(false, entries, blocks, 273));
+    file.close();
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "tif"));
+    QVERIFY(reader);
+    QVERIFY(!static_cast<TiffStripReader*>(reader.data())->isTiled());
+    QVector<QRgb> row(size.width());
+    reader->skipRows(5);
+    for (int y=5; y<size.height(); y++) {
+        QVERIFY(reader->readRow(row.data()));
+        QCOMPARE(row.at(2), qRgb(y % 256, y % 256, y % 256));
+    }
+}
+
+void TiffStripReaderTest::rgb16BitPredictor() {
+    // single strip of 2x1 RGBA image with unassociated alpha
+    const quint16 samples[8] = { 65535, 0, 0, 65535, 0, 65535, 0, 32768 };
+    QByteArray strip;
+    for (int i=0; i<8; i++) {
+        // horizontal differencing of samples of the second pixel
+        quint16 value = samples[i];
+        if (i >= 4)
+            value -= samples[i - 4];
+        appendValue(&strip, value, 2);
+    }
+    QList<Entry> entries;
+    entries << Entry(256, 2) << Entry(257, 1)
+            << Entry(258, 3, QVector<quint64>(4, 16)) << Entry(259, 8)
+            << Entry(262, 2) << Entry(277, 4) << Entry(278, 1)
+            << Entry(317, 2) << Entry(338, 2);
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(tiffFile(true, entries, QList<QByteArray>() << deflate(strip),
+                        273));
+    file.close();
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "tiff"));
+    QVERIFY(reader);
+    QVERIFY(reader->hasAlphaChannel());
+    QRgb row[2];
+    QVERIFY(reader->readRow(row));
+    QCOMPARE(row[0], qRgba(255, 0, 0, 255));
+    QCOMPARE(row[1], qPremultiply(qRgba(0, 255, 0, 128)));
+}
+
+void TiffStripReaderTest::unsupportedCompression() {
+    QList<Entry> entries;
+    // JPEG compression
+    entries << Entry(256, 1) << Entry(257, 1) << Entry(258, 8)
+            << Entry(259, 7) << Entry(262, 1) << Entry(277, 1);
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(tiffFile(false, entries, QList<QByteArray>() << "x", 273));
+    file.close();
+
+    QVERIFY(!StripReader::open(filePath, "tiff"));
+}
+
+void TiffStripReaderTest::corruptedByteCount_data() {
+    QTest::addColumn<quint64>("byteCount");
+
+    QTest::newRow("larger than block") << quint64(64 * 1024);
+    QTest::newRow("larger than file") << quint64(1000);
+    QTest::newRow("huge") << quint64(0x7fffffff);
+}
+
+void TiffStripReaderTest::corruptedByteCount() {
+    QFETCH(quint64, byteCount);
+
+    QList<Entry> entries;
+    entries << Entry(256, 4) << Entry(257, 4) << Entry(258, 8)
+            << Entry(259, 32773) << Entry(262, 1) << Entry(277, 1)
+            << Entry(278, 4);
+    QByteArray data = tiffFile(false, entries, QList<QByteArray>()
+                               << packBits(QByteArray(16, 'x')), 273);
+    // overwrite value of StripByteCounts entry
+    const int directory = qFromLittleEndian<quint32>(
+                reinterpret_cast<const uchar*>(data.constData() + 4));
+    const int count = qFromLittleEndian<quint16>(
+                reinterpret_cast<const uchar*>(data.constData() + directory));
+    bool found = false;
+    for (int i=0; i<count; i++) {
+        uchar *entry = reinterpret_cast<uchar*>(data.data()) + directory + 2
+                + i * 12;
+        if (qFromLittleEndian<quint16>(entry) == 279) {
+            qToLittleEndian<quint32>(byteCount, entry + 8);
+            found = true;
+        }
+    }
+    QVERIFY(found);
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(data);
+    file.close();
+
+    QScopedPointer<StripReader> reader(StripReader::open(filePath, "tiff"));
+    QVERIFY(reader);
+    QRgb row[4];
+    QVERIFY(!reader->readRow(row));
+}
+
+void TiffStripReaderTest::lzwDecode() {
+    const QByteArray data("\x80\x15\x09\xE4\x22\x29\x3C\xA4\x4E\x27\x95\x20"
+                          "\x50\x48\x34\x2E\x0B\x07\x84\xC0\x40", 21);
+    const QByteArray text("TOBEORNOTTOBEORTOBEORNOT");
+    QCOMPARE(TiffStripReader::lzwDecode(data, text.size()), text);
+    // decoding stops at desired size
+    QCOMPARE(TiffStripReader::lzwDecode(data, 10), text.left(10));
+    QVERIFY(TiffStripReader::lzwDecode(QByteArray(), 10).isEmpty());
+}
+
+void TiffStripReaderTest::packBitsDecode() {
+    const QByteArray data("\xFE\xAA\x02\x80\x00\x2A\xFD\xAA\x03\x80\x00\x2A"
+                          "\x22\xF7\xAA", 15);
+    const QByteArray expected("\xAA\xAA\xAA\x80\x00\x2A\xAA\xAA\xAA\xAA\x80"
+                              "\x00\x2A\x22\xAA\xAA\xAA\xAA\xAA\xAA\xAA\xAA"
+                              "\xAA\xAA", 24);
+    QCOMPARE(TiffStripReader::packBitsDecode(data, 24), expected);
+    QCOMPARE(TiffStripReader::packBitsDecode(data, 5), expected.left(5));
+}
+
+QTEST_APPLESS_MAIN(TiffStripReaderTest)
+#include "TiffStripReaderTest.moc"
@@ -0,0 +1,96 @@
+/* This file is part of SIR, an open-source cross-platform Image tool
+ * 2007-2010  Rafael Sachetto <rsachetto@gmail.com>
+ * 2011-2016  Marek Jędryka   <jedryka89@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Program URL: http://marek629.github.io/SIR/
+ */
+
+#include "tests/TokenBucketTest.hpp"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+
+class RateChangingThread : public QThread {
+public:
+    RateChangingThread(TokenBucket *bucket, qint64 rate)
+        : bucket(bucket), rate(rate) {}
+
+protected:
+    void run() {
+        msleep(50);
+        bucket->setRate(rate);
+    }
+
+private:
+    TokenBucket *bucket;
+    qint64 rate;
+};
+
+void TokenBucketTest::unlimited() {
+    TokenBucket bucket;
+    QCOMPARE(bucket.rate(), qint64(0));
+    bucket.consume(Q_INT64_C(1) << 40);
+    QVERIFY(bucket.wait(0));
+}
+
+void TokenBucketTest::consume_withinBurst() {
+    TokenBucket bucket(1000);
+    bucket.consume(600);
+    QVERIFY(bucket.balance() <= 400);
+    QVERIFY(bucket.wait(0));
+}
+
+void TokenBucketTest::consume_debt() {
+    TokenBucket bucket(1000);
+    bucket.consume(3000);
+    QVERIFY(bucket.balance() < 0);
+    QVERIFY(!bucket.wait(0));
+    QVERIFY(!bucket.wait(20));
+}
+
+void TokenBucketTest::wait_paysOffDebt() {
+    TokenBucket bucket(1000);
+    bucket.consume(1200); // 200 tokens of debt take 200 ms
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(bucket.wait(5000));
+    QVERIFY(timer.elapsed() >= 150);
+    QVERIFY(timer.elapsed() < 2000);
+}
+
+void TokenBucketTest::setRate_unlimitedWakesWaiting() {
+    TokenBucket bucket(10);
+    bucket.consume(1000); // debt of 99 seconds
+    RateChangingThread thread(&bucket, 0);
+    thread.start();
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(bucket.wait(5000));
+    QVERIFY(timer.elapsed() < 2000);
+    thread.wait();
+}
+
+void TokenBucketTest::setRate_limitsBalance() {
+    TokenBucket bucket(1000);
+    bucket.setRate(100);
+    QCOMPARE(bucket.rate(), qint64(100));
+    QVERIFY(bucket.balance() <= 100);
+}
+
+QTEST_APPLESS_MAIN(TokenBucketTest)
+#include "TokenBucketTest.moc"
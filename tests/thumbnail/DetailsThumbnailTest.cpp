@@ -26,6 +26,7 @@
 
 // includes required by Qt4 build
 #include <QDir>
+#include <QImage>
 
 
 DetailsThumbnailTest::DetailsThumbnailTest()
@@ -182,5 +183,29 @@ void DetailsThumbnailTest::test_writeThumbnailFromMetadata_metadataDisabled()
     QVERIFY(isThumbnailSaved(thumbnail, expectedResult));
 }
 
+void DetailsThumbnailTest::test_writeThumbnailFromImageData_sourceStatistics()
+{
+    cleanupTestCase();
+
+    QString testImagePath = temporaryPath + fileNamePrefix;
+    testImagePath += "_test_statistics.png";
+
+    // single bright pixel is averaged out of the thumbnail
+    QImage image(400, 100, QImage::Format_RGB32);
+    image.fill(qRgb(100, 100, 100));
+    image.setPixel(0, 0, qRgb(255, 255, 255));
+    QVERIFY(image.save(testImagePath));
+
+    DetailsThumbnail thumbnail = DetailsThumbnail(Settings::instance());
+    thumbnail.imagePath = testImagePath;
+    thumbnail.thumbPath = temporaryPath + fileNamePrefix;
+    thumbnail.writeThumbnailFromImageData(50);
+
+    QCOMPARE(thumbnail.size(), QSize(50, 12));
+    QCOMPARE(thumbnail.statistics().minimum(), QColor(100, 100, 100));
+    QCOMPARE(thumbnail.statistics().maximum(), QColor(255, 255, 255));
+    QVERIFY(!thumbnail.isStatisticsApproximate());
+}
+
 QTEST_MAIN(DetailsThumbnailTest)
 #include "DetailsThumbnailTest.moc"
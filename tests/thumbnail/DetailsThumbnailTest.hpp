@@ -59,6 +59,7 @@ private slots:
     void test_writeThumbnailFromMetadata_metadataEnabled_invalidMetadata();
 #endif // SIR_METADATA_SUPPORT
     void test_writeThumbnailFromMetadata_metadataDisabled();
+    void test_writeThumbnailFromImageData_sourceStatistics();
 };
 
 #endif // DETAILSTHUMBNAILTEST_HPP
@@ -62,6 +62,11 @@ void GeneralGroupBoxTest::setModelSettings() {
     modelSettings.targetSuffix = "ut";
     modelSettings.quality = 50;
     modelSettings.maxHistoryCount = 50;
+    modelSettings.readingThreads = 2;
+    modelSettings.writingThreads = 0;
+    modelSettings.memoryLimit = 4096;
+    modelSettings.threadAffinity = 2;
+    modelSettings.processIsolation = true;
     modelSettings.languageNiceName = "Polish";
     modelSettings.timeDisplayFormat = "HH:mm:ss";
     modelSettings.dateDisplayFormat = "dd.MM.yyyy";
@@ -93,6 +98,11 @@ void GeneralGroupBoxTest::setViewModelSettingsWidgets() {
 
     view->qualitySpinBox->setValue(62);
     view->historySpinBox->setValue(5);
+    view->readingThreadsSpinBox->setValue(3);
+    view->writingThreadsSpinBox->setValue(1);
+    view->memoryLimitSpinBox->setValue(0);
+    view->threadAffinityComboBox->setCurrentIndex(1);
+    view->processIsolationCheckBox->setChecked(false);
 
     idx = view->languagesComboBox->findText("Portuguese");
     view->languagesComboBox->setCurrentIndex(idx);
@@ -132,6 +142,13 @@ void GeneralGroupBoxTest::checkSavedModelSettings() {
 
     QCOMPARE(modelSettings.quality, view->qualitySpinBox->value());
     QCOMPARE(modelSettings.maxHistoryCount, view->historySpinBox->value());
+    QCOMPARE(modelSettings.readingThreads, view->readingThreadsSpinBox->value());
+    QCOMPARE(modelSettings.writingThreads, view->writingThreadsSpinBox->value());
+    QCOMPARE(modelSettings.memoryLimit, view->memoryLimitSpinBox->value());
+    QCOMPARE(modelSettings.threadAffinity,
+             view->threadAffinityComboBox->currentIndex());
+    QCOMPARE(modelSettings.processIsolation,
+             view->processIsolationCheckBox->isChecked());
 
     QCOMPARE(modelSettings.languageNiceName, view->languagesComboBox->currentText());
     QCOMPARE(modelSettings.languageFileName, QString("sir_pt.qm"));
@@ -170,6 +187,13 @@ void GeneralGroupBoxTest::checkLoadedModelSettings() {
 
     QCOMPARE(view->qualitySpinBox->value(), modelSettings.quality);
     QCOMPARE(view->historySpinBox->value(), modelSettings.maxHistoryCount);
+    QCOMPARE(view->readingThreadsSpinBox->value(), modelSettings.readingThreads);
+    QCOMPARE(view->writingThreadsSpinBox->value(), modelSettings.writingThreads);
+    QCOMPARE(view->memoryLimitSpinBox->value(), modelSettings.memoryLimit);
+    QCOMPARE(view->threadAffinityComboBox->currentIndex(),
+             modelSettings.threadAffinity);
+    QCOMPARE(view->processIsolationCheckBox->isChecked(),
+             modelSettings.processIsolation);
 
     QCOMPARE(view->languagesComboBox->currentText(), modelSettings.languageNiceName);
 
@@ -268,5 +292,45 @@ void GeneralGroupBoxTest::saveSettings_type_cores_count() {
     QCOMPARE(modelSettings.cores, view->coresSpinBox->value());
 }
 
+void GeneralGroupBoxTest::loadSettings_cores_adaptive() {
+    Settings::SettingsGroup &modelSettings = Settings::instance()->settings;
+
+    setModelSettings();
+    setModelSize();
+
+    modelSettings.cores = -1;
+
+    controller->loadSettings();
+
+    checkLoadedModelSettings();
+    checkLoadedModelSize();
+
+    QCOMPARE(view->coresAdaptiveCheckBox->isChecked(), true);
+    QCOMPARE(view->coresCheckBox->isChecked(), true);
+    QCOMPARE(view->coresSpinBox->value(), QThread::idealThreadCount());
+}
+
+void GeneralGroupBoxTest::saveSettings_adaptive_cores_count() {
+    Settings::SettingsGroup &modelSettings = Settings::instance()->settings;
+
+    setViewModelSettingsWidgets();
+    setViewModelSizeWidgets();
+
+    view->coresAdaptiveCheckBox->setChecked(true);
+
+    controller->saveSettings();
+
+    checkSavedModelSettings();
+    checkSavedModelSize();
+
+    QCOMPARE(modelSettings.cores, -1);
+
+    // saved value is loaded back as adaptive
+    controller->loadSettings();
+    QCOMPARE(view->coresAdaptiveCheckBox->isChecked(), true);
+
+    view->coresAdaptiveCheckBox->setChecked(false);
+}
+
 QTEST_MAIN(GeneralGroupBoxTest)
 #include "GeneralGroupBoxTest.moc"
@@ -58,6 +58,9 @@ private slots:
 
     void saveSettings_detect_cores_count();
     void saveSettings_type_cores_count();
+
+    void loadSettings_cores_adaptive();
+    void saveSettings_adaptive_cores_count();
 };
 
 #endif // GENERALGROPBOXTEST_H